@@ -1,6 +1,8 @@
 #include <iostream>
 #include <iomanip>
 #include <vector>
+#include <map>
+#include <algorithm>
 #include <exception>
 
 #include <boost/program_options.hpp>
@@ -8,8 +10,12 @@
 #include <boost/filesystem/fstream.hpp>
 
 #include <components/bsa/bsa_file.hpp>
+#ifdef OPENMW_USE_LZ4
+#include <components/bsa/package_file.hpp>
+#endif
+#include <components/misc/stringops.hpp>
 
-#define BSATOOL_VERSION 1.1
+#define BSATOOL_VERSION 1.2
 
 // Create local aliases for brevity
 namespace bpo = boost::program_options;
@@ -21,6 +27,8 @@ struct Arguments
     std::string filename;
     std::string extractfile;
     std::string outdir;
+    std::string outfile;
+    std::string orderfile;
 
     bool longformat;
     bool fullpath;
@@ -46,6 +54,8 @@ bool parseOptions (int argc, char** argv, Arguments &info)
             "      Extract a file from the input archive.\n\n"
             "  bsatool extractall archivefile [output_directory]\n"
             "      Extract all files from the input archive.\n\n"
+            "  bsatool pack [-o orderfile] input_directory|archivefile packagefile\n"
+            "      Create a compressed OpenMW package (.omwpkg) from a directory or a BSA archive.\n\n"
             "Allowed options");
 
     desc.add_options()
@@ -54,6 +64,8 @@ bool parseOptions (int argc, char** argv, Arguments &info)
         ("long,l", "Include extra information in archive listing.")
         ("full-path,f", "Create directory hierarchy on file extraction "
          "(always true for extractall).")
+        ("order,o", bpo::value<std::string>(), "Text file listing files to pack first, one per line, in the order "
+         "they should be stored. Files that are used together should be listed next to each other.")
         ;
 
     // input-file is hidden and used as a positional argument
@@ -105,7 +117,7 @@ bool parseOptions (int argc, char** argv, Arguments &info)
     }
 
     info.mode = variables["mode"].as<std::string>();
-    if (!(info.mode == "list" || info.mode == "extract" || info.mode == "extractall"))
+    if (!(info.mode == "list" || info.mode == "extract" || info.mode == "extractall" || info.mode == "pack"))
     {
         std::cout << std::endl << "ERROR: invalid mode \"" << info.mode << "\"\n\n"
             << desc << std::endl;
@@ -136,9 +148,22 @@ bool parseOptions (int argc, char** argv, Arguments &info)
         if (variables["input-file"].as< std::vector<std::string> >().size() > 2)
             info.outdir = variables["input-file"].as< std::vector<std::string> >()[2];
     }
+    else if (info.mode == "pack")
+    {
+        if (variables["input-file"].as< std::vector<std::string> >().size() < 2)
+        {
+            std::cout << "\nERROR: package file unspecified\n\n"
+                << desc << std::endl;
+            return false;
+        }
+        info.outfile = variables["input-file"].as< std::vector<std::string> >()[1];
+    }
     else if (variables["input-file"].as< std::vector<std::string> >().size() > 1)
         info.outdir = variables["input-file"].as< std::vector<std::string> >()[1];
 
+    if (variables.count("order"))
+        info.orderfile = variables["order"].as<std::string>();
+
     info.longformat = variables.count("long") != 0;
     info.fullpath = variables.count("full-path") != 0;
 
@@ -148,6 +173,7 @@ bool parseOptions (int argc, char** argv, Arguments &info)
 int list(Bsa::BSAFile& bsa, Arguments& info);
 int extract(Bsa::BSAFile& bsa, Arguments& info);
 int extractAll(Bsa::BSAFile& bsa, Arguments& info);
+int pack(Arguments& info);
 
 int main(int argc, char** argv)
 {
@@ -157,6 +183,9 @@ int main(int argc, char** argv)
         if(!parseOptions (argc, argv, info))
             return 1;
 
+        if (info.mode == "pack")
+            return pack(info);
+
         // Open file
         Bsa::BSAFile bsa;
         bsa.open(info.filename);
@@ -290,3 +319,125 @@ int extractAll(Bsa::BSAFile& bsa, Arguments& info)
 
     return 0;
 }
+
+#ifdef OPENMW_USE_LZ4
+
+/// Sort the file names into the order they will be stored in the package: files from the order
+/// file first, in the order given there, then all other files grouped by directory.
+void sortForPacking(std::vector<std::string>& names, const std::string& orderfile)
+{
+    std::map<std::string, size_t> rank;
+    if (!orderfile.empty())
+    {
+        bfs::ifstream order(orderfile);
+        if (!order.is_open())
+            throw std::runtime_error("Failed to open order file " + orderfile);
+
+        std::string line;
+        while (std::getline(order, line))
+        {
+            if (!line.empty() && line[line.size()-1] == '\r')
+                line.erase(line.size()-1);
+            replaceAll(line, "/", "\\");
+            Misc::StringUtils::lowerCaseInPlace(line);
+            if (!line.empty())
+                rank.insert(std::make_pair(line, rank.size()));
+        }
+    }
+
+    std::vector<std::pair<std::pair<size_t, std::string>, std::string> > sorted;
+    for (std::vector<std::string>::const_iterator it = names.begin(); it != names.end(); ++it)
+    {
+        std::string key = Misc::StringUtils::lowerCase(*it);
+        std::map<std::string, size_t>::const_iterator found = rank.find(key);
+        size_t position = found != rank.end() ? found->second : rank.size();
+        sorted.push_back(std::make_pair(std::make_pair(position, key), *it));
+    }
+    std::sort(sorted.begin(), sorted.end());
+
+    names.clear();
+    for (size_t i = 0; i < sorted.size(); ++i)
+        names.push_back(sorted[i].second);
+}
+
+void readStream(std::istream& stream, std::vector<char>& data)
+{
+    data.clear();
+    char buffer[65536];
+    while (stream.read(buffer, sizeof(buffer)) || stream.gcount() > 0)
+        data.insert(data.end(), buffer, buffer + stream.gcount());
+}
+
+int pack(Arguments& info)
+{
+    bfs::path source (info.filename);
+    bool fromArchive = !bfs::is_directory(source);
+
+    Bsa::BSAFile bsa;
+    std::vector<std::string> names;
+    if (fromArchive)
+    {
+        bsa.open(info.filename);
+        const Bsa::BSAFile::FileList &files = bsa.getList();
+        for (Bsa::BSAFile::FileList::const_iterator it = files.begin(); it != files.end(); ++it)
+            names.push_back(it->name);
+    }
+    else
+    {
+        for (bfs::recursive_directory_iterator it (source), end; it != end; ++it)
+        {
+            if (bfs::is_directory(*it))
+                continue;
+
+            std::string name = it->path().string().substr(source.string().size());
+            replaceAll(name, "/", "\\");
+            if (!name.empty() && name[0] == '\\')
+                name.erase(0, 1);
+            names.push_back(name);
+        }
+    }
+
+    sortForPacking(names, info.orderfile);
+
+    Bsa::PackageWriter writer (info.outfile, names);
+
+    std::vector<char> data;
+    size_t totalSize = 0;
+    for (std::vector<std::string>::const_iterator it = names.begin(); it != names.end(); ++it)
+    {
+        if (fromArchive)
+            readStream(*bsa.getFile(it->c_str()), data);
+        else
+        {
+            std::string path = *it;
+            replaceAll(path, "\\", "/");
+            bfs::ifstream file (source / path, std::ios::binary);
+            if (!file.is_open())
+            {
+                std::cout << "ERROR: failed to open " << (source / path) << std::endl;
+                return 3;
+            }
+            readStream(file, data);
+        }
+
+        totalSize += data.size();
+        writer.addFile(data);
+    }
+
+    writer.finish();
+
+    std::cout << "Packed " << names.size() << " files (" << totalSize << " bytes) into "
+              << info.outfile << " (" << bfs::file_size(info.outfile) << " bytes)" << std::endl;
+
+    return 0;
+}
+
+#else
+
+int pack(Arguments& /*info*/)
+{
+    std::cout << "ERROR: bsatool was built without LZ4 support, packing is not available" << std::endl;
+    return 1;
+}
+
+#endif
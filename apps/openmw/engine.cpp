@@ -2,9 +2,12 @@
 
 #include <stdexcept>
 #include <iomanip>
+#include <sstream>
 
 #include <boost/filesystem/fstream.hpp>
 
+#include <OpenThreads/Thread>
+
 #include <osgViewer/ViewerEventHandlers>
 #include <osgDB/ReadFile>
 #include <osgDB/WriteFile>
@@ -15,6 +18,7 @@
 
 #include <components/vfs/manager.hpp>
 #include <components/vfs/registerarchives.hpp>
+#include <components/vfs/iostats.hpp>
 
 #include <components/sdlutil/sdlgraphicswindow.hpp>
 #include <components/sdlutil/imagetosurface.hpp>
@@ -34,6 +38,8 @@
 #include "mwgui/windowmanagerimp.hpp"
 
 #include "mwscript/scriptmanagerimp.hpp"
+#include "mwscript/scriptcache.hpp"
+#include "mwscript/scriptprofiler.hpp"
 #include "mwscript/extensions.hpp"
 #include "mwscript/interpretercontext.hpp"
 
@@ -68,12 +74,15 @@ void OMW::Engine::executeLocalScripts()
 {
     MWWorld::LocalScripts& localScripts = mEnvironment.getWorld()->getLocalScripts();
 
-    localScripts.startIteration();
+    localScripts.startIteration(mEnvironment.getFrameDuration(),
+        mEnvironment.getWorld()->getPlayerPtr().getRefData().getPosition().asVec3());
     std::pair<std::string, MWWorld::Ptr> script;
-    while (localScripts.getNext(script))
+    float secondsPassed = 0;
+    while (localScripts.getNext(script, secondsPassed))
     {
         MWScript::InterpreterContext interpreterContext (
             &script.second.getRefData().getLocals(), script.second);
+        interpreterContext.setSecondsPassed(secondsPassed);
         mEnvironment.getScriptManager()->run (script.first, interpreterContext);
     }
 }
@@ -181,6 +190,34 @@ void OMW::Engine::frame(float frametime)
         stats->setAttribute(frameNumber, "physics_time_taken", osg::Timer::instance()->delta_s(beforePhysicsTick, afterPhysicsTick));
         stats->setAttribute(frameNumber, "physics_time_end", osg::Timer::instance()->delta_s(mStartTick, afterPhysicsTick));
 
+        if (const VFS::IOStats* ioStats = mVFS->getIOStats())
+        {
+            // Includes the I/O done by background threads, e.g. the cell preloader
+            VFS::IOCounters total = ioStats->getTotal();
+            stats->setAttribute(frameNumber, "io_time_taken", total.mLatency - mLastIOLatency);
+            stats->setAttribute(frameNumber, "io_kb_read", (total.mBytesRead - mLastIOBytesRead) / 1024.0);
+            mLastIOLatency = total.mLatency;
+            mLastIOBytesRead = total.mBytesRead;
+        }
+
+        VFS::PrefetchStats prefetchStats = mVFS->getPrefetchStats();
+        if (prefetchStats.mRequested)
+        {
+            stats->setAttribute(frameNumber, "prefetch_hits", prefetchStats.mHits - mLastPrefetchHits);
+            stats->setAttribute(frameNumber, "prefetch_cache_kb", prefetchStats.mCachedBytes / 1024.0);
+            mLastPrefetchHits = prefetchStats.mHits;
+        }
+
+        MWScript::ScriptProfiler& scriptProfiler = mEnvironment.getScriptManager()->getProfiler();
+        if (scriptProfiler.isEnabled())
+        {
+            unsigned long scriptRuns = 0;
+            double slowestScript = 0;
+            scriptProfiler.getFrameStats(scriptRuns, slowestScript);
+            stats->setAttribute(frameNumber, "script_runs", scriptRuns);
+            stats->setAttribute(frameNumber, "script_slowest", slowestScript);
+        }
+
     }
     catch (const std::exception& e)
     {
@@ -206,6 +243,9 @@ OMW::Engine::Engine(Files::ConfigurationManager& configurationManager)
   , mFSStrict (false)
   , mScriptBlacklistUse (true)
   , mNewGame (false)
+  , mLastIOBytesRead (0)
+  , mLastIOLatency (0.0)
+  , mLastPrefetchHits (0)
   , mCfgMgr(configurationManager)
 {
     Misc::Rng::init();
@@ -443,7 +483,19 @@ void OMW::Engine::prepareEngine (Settings::Manager & settings)
 
     mVFS.reset(new VFS::Manager(mFSStrict));
 
-    VFS::registerArchives(mVFS.get(), mFileCollections, mArchives, true);
+    std::string indexCacheDir;
+    if (Settings::Manager::getBool("cache file index", "General"))
+        indexCacheDir = mCfgMgr.getCachePath().string();
+
+    VFS::registerArchives(mVFS.get(), mFileCollections, mArchives, true,
+        Settings::Manager::getBool("memory map archives", "General"), indexCacheDir);
+
+    if (Settings::Manager::getBool("io statistics", "General"))
+        mVFS->enableIOStats();
+
+    int prefetchCacheSize = Settings::Manager::getInt("preload file cache size", "Cells");
+    if (Settings::Manager::getBool("preload enabled", "Cells") && prefetchCacheSize > 0)
+        mVFS->enablePrefetch(static_cast<size_t>(prefetchCacheSize) * 1024 * 1024);
 
     mResourceSystem.reset(new Resource::ResourceSystem(mVFS.get()));
     mResourceSystem->getSceneManager()->setUnRefImageDataAfterApply(false); // keep to Off for now to allow better state sharing
@@ -503,12 +555,33 @@ void OMW::Engine::prepareEngine (Settings::Manager & settings)
     }
 
     // Create the world
+    std::string contentSnapshotFile;
+    if (Settings::Manager::getBool("content snapshot", "General"))
+        contentSnapshotFile = (mCfgMgr.getCachePath() / "content.snapshot").string();
+
     mEnvironment.setWorld( new MWWorld::World (mViewer, rootNode, mResourceSystem.get(),
         mFileCollections, mContentFiles, mEncoder, mFallbackMap,
-        mActivationDistanceOverride, mCellName, mStartupScript, mResDir.string()));
+        mActivationDistanceOverride, mCellName, mStartupScript, mResDir.string(), contentSnapshotFile));
     mEnvironment.getWorld()->setupPlayer();
     input->setPlayer(&mEnvironment.getWorld()->getPlayer());
 
+    std::vector<std::string> everyFrameScripts;
+    std::istringstream everyFrameStream(Settings::Manager::getString("local scripts every frame", "General"));
+    std::string everyFrameScript;
+    while (std::getline(everyFrameStream, everyFrameScript, ','))
+    {
+        std::string::size_type begin = everyFrameScript.find_first_not_of(" \t");
+        if (begin!=std::string::npos)
+            everyFrameScripts.push_back(everyFrameScript.substr(begin,
+                everyFrameScript.find_last_not_of(" \t") - begin + 1));
+    }
+
+    mEnvironment.getWorld()->getLocalScripts().setSchedule(
+        Settings::Manager::getFloat("local script full rate distance", "General"),
+        Settings::Manager::getFloat("local script max interval", "General"),
+        Settings::Manager::getFloat("local script time budget", "General") / 1000.0,
+        everyFrameScripts);
+
     window->setStore(mEnvironment.getWorld()->getStore());
     window->initUI();
     window->renderWorldMap();
@@ -524,9 +597,39 @@ void OMW::Engine::prepareEngine (Settings::Manager & settings)
     mScriptContext = new MWScript::CompilerContext (MWScript::CompilerContext::Type_Full);
     mScriptContext->setExtensions (&mExtensions);
 
-    mEnvironment.setScriptManager (new MWScript::ScriptManager (mEnvironment.getWorld()->getStore(),
+    MWScript::ScriptManager* scriptManager = new MWScript::ScriptManager (mEnvironment.getWorld()->getStore(),
         mVerboseScripts, *mScriptContext, mWarningsMode,
-        mScriptBlacklistUse ? mScriptBlacklist : std::vector<std::string>()));
+        mScriptBlacklistUse ? mScriptBlacklist : std::vector<std::string>());
+    mEnvironment.setScriptManager (scriptManager);
+
+    scriptManager->getProfiler().setExportFile(mCfgMgr.getLogPath() / "scriptprofile.csv");
+    scriptManager->getProfiler().setEnabled(Settings::Manager::getBool("script profiler", "General"));
+
+    bool optimizeScripts = Settings::Manager::getBool("optimize scripts", "General");
+    scriptManager->setOptimize(optimizeScripts);
+
+    if (Settings::Manager::getBool("script cache", "General"))
+    {
+        // The world has made sure that the content files exist
+        std::vector<boost::filesystem::path> contentPaths;
+        for (std::vector<std::string>::const_iterator it = mContentFiles.begin(); it != mContentFiles.end(); ++it)
+            contentPaths.push_back(mFileCollections.getCollection(boost::filesystem::path(*it).extension().string()).getPath(*it));
+
+        MWScript::ScriptCache* scriptCache = new MWScript::ScriptCache(mCfgMgr.getCachePath() / "scripts.cache",
+            contentPaths, mExtensions, optimizeScripts);
+        scriptCache->load();
+        scriptManager->setCache(scriptCache);
+    }
+
+    int scriptCompileThreads = Settings::Manager::getInt("script compile threads", "General");
+    if (scriptCompileThreads < 0)
+        scriptCompileThreads = OpenThreads::GetNumberOfProcessors();
+    if (scriptCompileThreads > 0)
+    {
+        std::pair<int, int> result = scriptManager->precompile(scriptCompileThreads, *window->getLoadingScreen());
+        if (result.first != result.second)
+            std::cout << "compiled " << result.second << " of " << result.first << " scripts" << std::endl;
+    }
 
     // Create game mechanics system
     MWMechanics::MechanicsManager* mechanics = new MWMechanics::MechanicsManager;
@@ -624,6 +727,18 @@ void OMW::Engine::go()
                                    "mechanics_time_taken", 1000.0, true, false, "mechanics_time_begin", "mechanics_time_end", 10000);
     statshandler->addUserStatsLine("Physics", osg::Vec4f(1.f, 1.f, 1.f, 1.f), osg::Vec4f(1.f, 1.f, 1.f, 1.f),
                                    "physics_time_taken", 1000.0, true, false, "physics_time_begin", "physics_time_end", 10000);
+    statshandler->addUserStatsLine("I/O ms", osg::Vec4f(1.f, 1.f, 1.f, 1.f), osg::Vec4f(1.f, 1.f, 1.f, 1.f),
+                                   "io_time_taken", 1000.0, true, false, "", "", 10000);
+    statshandler->addUserStatsLine("I/O KB", osg::Vec4f(1.f, 1.f, 1.f, 1.f), osg::Vec4f(1.f, 1.f, 1.f, 1.f),
+                                   "io_kb_read", 1.0, true, false, "", "", 10000);
+    statshandler->addUserStatsLine("Prefetch hits", osg::Vec4f(1.f, 1.f, 1.f, 1.f), osg::Vec4f(1.f, 1.f, 1.f, 1.f),
+                                   "prefetch_hits", 1.0, true, false, "", "", 10000);
+    statshandler->addUserStatsLine("Prefetch KB", osg::Vec4f(1.f, 1.f, 1.f, 1.f), osg::Vec4f(1.f, 1.f, 1.f, 1.f),
+                                   "prefetch_cache_kb", 1.0, true, false, "", "", 10000);
+    statshandler->addUserStatsLine("Script runs", osg::Vec4f(1.f, 1.f, 1.f, 1.f), osg::Vec4f(1.f, 1.f, 1.f, 1.f),
+                                   "script_runs", 1.0, true, false, "", "", 10000);
+    statshandler->addUserStatsLine("Slowest script", osg::Vec4f(1.f, 1.f, 1.f, 1.f), osg::Vec4f(1.f, 1.f, 1.f, 1.f),
+                                   "script_slowest", 1000.0, true, false, "", "", 10000);
 
     mViewer->addEventHandler(statshandler);
 
@@ -107,6 +107,13 @@ namespace OMW
 
             osg::Timer_t mStartTick;
 
+            // I/O statistics totals at the end of the previous frame
+            unsigned long long mLastIOBytesRead;
+            double mLastIOLatency;
+
+            // Prefetch cache hits at the end of the previous frame
+            unsigned int mLastPrefetchHits;
+
             // not implemented
             Engine (const Engine&);
             Engine& operator= (const Engine&);
@@ -2,6 +2,7 @@
 #define GAME_MWBASE_SCRIPTMANAGER_H
 
 #include <string>
+#include <utility>
 
 namespace Interpreter
 {
@@ -16,6 +17,7 @@ namespace Compiler
 namespace MWScript
 {
     class GlobalScripts;
+    class ScriptProfiler;
 }
 
 namespace MWBase
@@ -49,7 +51,13 @@ namespace MWBase
             virtual const Compiler::Locals& getLocals (const std::string& name) = 0;
             ///< Return locals for script \a name.
 
+            virtual std::pair<char, int> getLocalSlot (const std::string& name, const std::string& variable) = 0;
+            ///< Return type ('s', 'l', 'f' or ' ' for none) and index of local \a variable of script \a name.
+            /// Each script and variable is only looked up once.
+
             virtual MWScript::GlobalScripts& getGlobalScripts() = 0;
+
+            virtual MWScript::ScriptProfiler& getProfiler() = 0;
    };
 }
 
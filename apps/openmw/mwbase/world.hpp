@@ -71,6 +71,11 @@ namespace Fallback
     class Map;
 }
 
+namespace VFS
+{
+    class Manager;
+}
+
 namespace MWBase
 {
     /// \brief Interface for the World (implemented in MWWorld)
@@ -110,7 +115,8 @@ namespace MWBase
             virtual void readRecord (ESM::ESMReader& reader, uint32_t type,
                 const std::map<int, int>& contentFileMap) = 0;
 
-            virtual MWWorld::CellStore *getExterior (int x, int y) = 0;
+            virtual MWWorld::CellStore *getExterior (int x, int y, bool load = true) = 0;
+            ///< @param load Load the references of the cell? If false, the cell may be returned in any state.
 
             virtual MWWorld::CellStore *getInterior (const std::string& name) = 0;
 
@@ -184,6 +190,11 @@ namespace MWBase
             virtual MWWorld::Ptr searchPtrViaActorId (int actorId) = 0;
             ///< Search is limited to the active cells.
 
+            virtual unsigned int getReferenceGeneration() const = 0;
+            ///< Changes whenever searchPtr may find a different reference than before, i.e. when the active
+            /// cells change or references are placed, deleted or moved to another cell. Enabling or disabling
+            /// a reference doesn't change it.
+
             virtual MWWorld::Ptr findContainer (const MWWorld::ConstPtr& ptr) = 0;
             ///< Return a pointer to a liveCellRef which contains \a ptr.
             /// \note Search is limited to the active cells.
@@ -474,6 +485,8 @@ namespace MWBase
             virtual bool toggleScripts() = 0;
             virtual bool getScriptsEnabled() const = 0;
 
+            virtual const VFS::Manager* getVFS() const = 0;
+
             /**
              * @brief startSpellCast attempt to start casting a spell. Might fail immediately if conditions are not met.
              * @param actor
@@ -153,6 +153,7 @@ namespace MWClass
         const MWWorld::LiveCellRef<ESM::Book> *ref = ptr.get<ESM::Book>();
 
         ESM::Book newItem = *ref->mBase;
+        newItem.mText = MWBase::Environment::get().getWorld()->getStore().getPayloads().getBookText(*ref->mBase);
         newItem.mId="";
         newItem.mName=newName;
         newItem.mData.mIsScroll = 1;
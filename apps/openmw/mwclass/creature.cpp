@@ -1,6 +1,7 @@
 #include "creature.hpp"
 
 #include <components/misc/rng.hpp>
+#include <components/misc/stringatom.hpp>
 
 #include <components/esm/loadcrea.hpp>
 #include <components/esm/creaturestate.hpp>
@@ -246,7 +247,8 @@ namespace MWClass
         float dist = 200.f;
         if (!weapon.isEmpty())
         {
-            const float fCombatDistance = gmst.find("fCombatDistance")->getFloat();
+            static const Misc::StringAtom fCombatDistanceId ("fCombatDistance");
+            const float fCombatDistance = gmst.find(fCombatDistanceId)->getFloat();
             dist = fCombatDistance * weapon.get<ESM::Weapon>()->mBase->mData.mReach;
         }
         std::pair<MWWorld::Ptr, osg::Vec3f> result = MWBase::Environment::get().getWorld()->getHitContact(ptr, dist);
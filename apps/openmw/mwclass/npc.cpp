@@ -34,6 +34,7 @@
 #include "../mwworld/customdata.hpp"
 #include "../mwphysics/physicssystem.hpp"
 #include "../mwworld/cellstore.hpp"
+#include "../mwworld/esmstore.hpp"
 
 #include "../mwrender/objects.hpp"
 #include "../mwrender/renderinginterface.hpp"
@@ -374,7 +375,17 @@ namespace MWClass
                 data->mNpcStats.setReputation(iAutoRepFacMod * (rank+1) + iAutoRepLevMod * (data->mNpcStats.getLevel()-1));
             }
 
-            data->mNpcStats.getAiSequence().fill(ref->mBase->mAiPackage);
+            // The AI packages may have to be read from the content file again, which can fail
+            ESM::AIPackageList aiPackages;
+            try
+            {
+                aiPackages = MWBase::Environment::get().getWorld()->getStore().getPayloads().getAiPackages(*ref->mBase);
+            }
+            catch (const std::exception& e)
+            {
+                std::cerr << "Warning: ignoring AI packages of NPC '" << ref->mBase->mId << "': " << e.what() << std::endl;
+            }
+            data->mNpcStats.getAiSequence().fill(aiPackages);
 
             data->mNpcStats.setAiSetting (MWMechanics::CreatureStats::AI_Hello, ref->mBase->mAiData.mHello);
             data->mNpcStats.setAiSetting (MWMechanics::CreatureStats::AI_Fight, ref->mBase->mAiData.mFight);
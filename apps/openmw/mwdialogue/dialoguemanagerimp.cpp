@@ -46,6 +46,14 @@
 #include "filter.hpp"
 #include "hypertextparser.hpp"
 
+namespace
+{
+    const MWWorld::RecordPayloads& getPayloads()
+    {
+        return MWBase::Environment::get().getWorld()->getStore().getPayloads();
+    }
+}
+
 namespace MWDialogue
 {
     DialogueManager::DialogueManager (const Compiler::Extensions& extensions, bool scriptVerbose, Translation::Storage& translationDataStorage) :
@@ -167,11 +175,12 @@ namespace MWDialogue
                     // first topics update so that parseText knows the keywords to highlight
                     updateTopics();
 
-                    parseText (info->mResponse);
+                    std::string response = getPayloads().getResponse (*info);
+                    parseText (response);
 
                     MWScript::InterpreterContext interpreterContext(&mActor.getRefData().getLocals(),mActor);
-                    win->addResponse (Interpreter::fixDefinesDialog(info->mResponse, interpreterContext));
-                    executeScript (info->mResultScript);
+                    win->addResponse (Interpreter::fixDefinesDialog(response, interpreterContext));
+                    executeScript (getPayloads().getResultScript (*info));
                     mLastTopic = Misc::StringUtils::lowerCase(it->mId);
 
                     // update topics again to accomodate changes resulting from executeScript
@@ -277,7 +286,8 @@ namespace MWDialogue
         const ESM::DialInfo* info = filter.search(dialogue, true);
         if (info)
         {
-            parseText (info->mResponse);
+            std::string response = getPayloads().getResponse (*info);
+            parseText (response);
 
             std::string title;
             if (dialogue.mType==ESM::Dialogue::Persuasion)
@@ -298,7 +308,7 @@ namespace MWDialogue
                 title = topic;
 
             MWScript::InterpreterContext interpreterContext(&mActor.getRefData().getLocals(),mActor);
-            win->addResponse (Interpreter::fixDefinesDialog(info->mResponse, interpreterContext), title);
+            win->addResponse (Interpreter::fixDefinesDialog(response, interpreterContext), title);
 
             if (dialogue.mType == ESM::Dialogue::Topic)
             {
@@ -315,7 +325,7 @@ namespace MWDialogue
                 }
             }
 
-            executeScript (info->mResultScript);
+            executeScript (getPayloads().getResultScript (*info));
 
             mLastTopic = topic;
         }
@@ -471,7 +481,7 @@ namespace MWDialogue
             {
                 if (const ESM::DialInfo *info = filter.search (mDialogueMap[mLastTopic], true))
                 {
-                    std::string text = info->mResponse;
+                    std::string text = getPayloads().getResponse (*info);
                     parseText (text);
 
                     mChoice = -1;
@@ -493,7 +503,7 @@ namespace MWDialogue
                         }
                     }
 
-                    executeScript (info->mResultScript);
+                    executeScript (getPayloads().getResultScript (*info));
                 }
                 else
                 {
@@ -601,17 +611,18 @@ namespace MWDialogue
         {
             const ESM::DialInfo* info = infos[0];
 
-            parseText (info->mResponse);
+            std::string response = getPayloads().getResponse (*info);
+            parseText (response);
 
             const MWWorld::Store<ESM::GameSetting>& gmsts =
                 MWBase::Environment::get().getWorld()->getStore().get<ESM::GameSetting>();
 
             MWScript::InterpreterContext interpreterContext(&mActor.getRefData().getLocals(),mActor);
 
-            win->addResponse (Interpreter::fixDefinesDialog(info->mResponse, interpreterContext),
+            win->addResponse (Interpreter::fixDefinesDialog(response, interpreterContext),
                               gmsts.find ("sServiceRefusal")->getString());
 
-            executeScript (info->mResultScript);
+            executeScript (getPayloads().getResultScript (*info));
             return true;
         }
         return false;
@@ -636,7 +647,7 @@ namespace MWDialogue
         {
             MWBase::WindowManager *winMgr = MWBase::Environment::get().getWindowManager();
             if(winMgr->getSubtitlesEnabled())
-                winMgr->messageBox(info->mResponse);
+                winMgr->messageBox(store.getPayloads().getResponse(*info));
             if (!info->mSound.empty())
                 sndMgr->say(actor, info->mSound);
         }
@@ -1,7 +1,5 @@
 #include "filter.hpp"
 
-#include <components/compiler/locals.hpp>
-
 #include "../mwbase/environment.hpp"
 #include "../mwbase/world.hpp"
 #include "../mwbase/journal.hpp"
@@ -200,19 +198,15 @@ bool MWDialogue::Filter::testSelectStructNumeric (const SelectWrapper& select) c
             if (scriptName.empty())
                 return false; // no script
 
-            std::string name = Misc::StringUtils::lowerCase (select.getName());
-
-            const Compiler::Locals& localDefs =
-                MWBase::Environment::get().getScriptManager()->getLocals (scriptName);
+            std::pair<char, int> slot =
+                MWBase::Environment::get().getScriptManager()->getLocalSlot (scriptName, select.getName());
 
-            char type = localDefs.getType (name);
+            char type = slot.first;
 
             if (type==' ')
                 return false; // script does not have a variable of this name.
 
-            int index = localDefs.getIndex (name);
-            if (index < 0)
-                return false; // shouldn't happen, we checked that variable has a type above, so must exist
+            int index = slot.second;
 
             const MWScript::Locals& locals = mActor.getRefData().getLocals();
 
@@ -475,10 +469,8 @@ bool MWDialogue::Filter::getSelectStructBoolean (const SelectWrapper& select) co
                 // This actor has no attached script, so there is no local variable
                 return true;
 
-            const Compiler::Locals& localDefs =
-                MWBase::Environment::get().getScriptManager()->getLocals (scriptName);
-
-            return localDefs.getIndex (Misc::StringUtils::lowerCase (select.getName()))==-1;
+            return MWBase::Environment::get().getScriptManager()->getLocalSlot (
+                scriptName, select.getName()).first==' ';
         }
 
         case SelectWrapper::Function_SameGender:
@@ -601,6 +593,33 @@ MWDialogue::Filter::Filter (const MWWorld::Ptr& actor, int choice, bool talkedTo
 : mActor (actor), mChoice (choice), mTalkedToPlayer (talkedToPlayer)
 {}
 
+void MWDialogue::Filter::getCandidates (const ESM::Dialogue& dialogue, bool anyCell,
+    std::vector<const ESM::DialInfo *>& candidates) const
+{
+    MWWorld::DialogueIndex::Query query;
+
+    query.mActor = mActor.getCellRef().getRefId();
+    query.mCreature = (mActor.getTypeName() != typeid (ESM::NPC).name());
+    query.mAnyCell = anyCell;
+
+    if (!query.mCreature)
+    {
+        MWWorld::LiveCellRef<ESM::NPC> *cellRef = mActor.get<ESM::NPC>();
+
+        query.mRace = cellRef->mBase->mRace;
+        query.mClass = cellRef->mBase->mClass;
+        query.mFaction = mActor.getClass().getPrimaryFaction (mActor);
+
+        if (!anyCell)
+        {
+            const MWWorld::Ptr player = MWMechanics::getPlayer();
+            query.mCell = MWBase::Environment::get().getWorld()->getCellName (player.getCell());
+        }
+    }
+
+    MWBase::Environment::get().getWorld()->getStore().getDialogueIndex().getCandidates (dialogue, query, candidates);
+}
+
 const ESM::DialInfo* MWDialogue::Filter::search (const ESM::Dialogue& dialogue, const bool fallbackToInfoRefusal) const
 {
     std::vector<const ESM::DialInfo *> suitableInfos = list (dialogue, fallbackToInfoRefusal, false);
@@ -613,11 +632,14 @@ const ESM::DialInfo* MWDialogue::Filter::search (const ESM::Dialogue& dialogue,
 
 std::vector<const ESM::DialInfo *> MWDialogue::Filter::listAll (const ESM::Dialogue& dialogue) const
 {
+    std::vector<const ESM::DialInfo *> candidates;
+    getCandidates (dialogue, true, candidates);
+
     std::vector<const ESM::DialInfo *> infos;
-    for (ESM::Dialogue::InfoContainer::const_iterator iter = dialogue.mInfo.begin(); iter!=dialogue.mInfo.end(); ++iter)
+    for (std::vector<const ESM::DialInfo *>::const_iterator iter = candidates.begin(); iter!=candidates.end(); ++iter)
     {
-        if (testActor (*iter))
-            infos.push_back(&*iter);
+        if (testActor (**iter))
+            infos.push_back(*iter);
     }
     return infos;
 }
@@ -629,14 +651,17 @@ std::vector<const ESM::DialInfo *> MWDialogue::Filter::list (const ESM::Dialogue
 
     bool infoRefusal = false;
 
+    std::vector<const ESM::DialInfo *> candidates;
+    getCandidates (dialogue, false, candidates);
+
     // Iterate over topic responses to find a matching one
-    for (ESM::Dialogue::InfoContainer::const_iterator iter = dialogue.mInfo.begin();
-        iter!=dialogue.mInfo.end(); ++iter)
+    for (std::vector<const ESM::DialInfo *>::const_iterator iter = candidates.begin();
+        iter!=candidates.end(); ++iter)
     {
-        if (testActor (*iter) && testPlayer (*iter) && testSelectStructs (*iter))
+        if (testActor (**iter) && testPlayer (**iter) && testSelectStructs (**iter))
         {
-            if (testDisposition (*iter, invertDisposition)) {
-                infos.push_back(&*iter);
+            if (testDisposition (**iter, invertDisposition)) {
+                infos.push_back(*iter);
                 if (!searchAll)
                     break;
             }
@@ -655,10 +680,12 @@ std::vector<const ESM::DialInfo *> MWDialogue::Filter::list (const ESM::Dialogue
 
         const ESM::Dialogue& infoRefusalDialogue = *dialogues.find ("Info Refusal");
 
-        for (ESM::Dialogue::InfoContainer::const_iterator iter = infoRefusalDialogue.mInfo.begin();
-            iter!=infoRefusalDialogue.mInfo.end(); ++iter)
-            if (testActor (*iter) && testPlayer (*iter) && testSelectStructs (*iter) && testDisposition(*iter, invertDisposition)) {
-                infos.push_back(&*iter);
+        getCandidates (infoRefusalDialogue, false, candidates);
+
+        for (std::vector<const ESM::DialInfo *>::const_iterator iter = candidates.begin();
+            iter!=candidates.end(); ++iter)
+            if (testActor (**iter) && testPlayer (**iter) && testSelectStructs (**iter) && testDisposition(**iter, invertDisposition)) {
+                infos.push_back(*iter);
                 if (!searchAll)
                     break;
             }
@@ -669,10 +696,13 @@ std::vector<const ESM::DialInfo *> MWDialogue::Filter::list (const ESM::Dialogue
 
 bool MWDialogue::Filter::responseAvailable (const ESM::Dialogue& dialogue) const
 {
-    for (ESM::Dialogue::InfoContainer::const_iterator iter = dialogue.mInfo.begin();
-        iter!=dialogue.mInfo.end(); ++iter)
+    std::vector<const ESM::DialInfo *> candidates;
+    getCandidates (dialogue, false, candidates);
+
+    for (std::vector<const ESM::DialInfo *>::const_iterator iter = candidates.begin();
+        iter!=candidates.end(); ++iter)
     {
-        if (testActor (*iter) && testPlayer (*iter) && testSelectStructs (*iter))
+        if (testActor (**iter) && testPlayer (**iter) && testSelectStructs (**iter))
             return true;
     }
 
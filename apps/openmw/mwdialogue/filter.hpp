@@ -21,6 +21,11 @@ namespace MWDialogue
             int mChoice;
             bool mTalkedToPlayer;
 
+            void getCandidates (const ESM::Dialogue& dialogue, bool anyCell,
+                std::vector<const ESM::DialInfo *>& candidates) const;
+            ///< Responses of \a dialogue that may match the actor and, unless \a anyCell is set, the
+            /// player's cell. See MWWorld::DialogueIndex.
+
             bool testActor (const ESM::DialInfo& info) const;
             ///< Is this the right actor for this \a info?
 
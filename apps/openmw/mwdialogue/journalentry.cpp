@@ -21,22 +21,24 @@ namespace MWDialogue
     Entry::Entry (const std::string& topic, const std::string& infoId, const MWWorld::Ptr& actor)
     : mInfoId (infoId)
     {
-        const ESM::Dialogue *dialogue =
-            MWBase::Environment::get().getWorld()->getStore().get<ESM::Dialogue>().find (topic);
+        const MWWorld::ESMStore& store = MWBase::Environment::get().getWorld()->getStore();
+        const ESM::Dialogue *dialogue = store.get<ESM::Dialogue>().find (topic);
 
         for (ESM::Dialogue::InfoContainer::const_iterator iter (dialogue->mInfo.begin());
             iter!=dialogue->mInfo.end(); ++iter)
             if (iter->mId == mInfoId)
             {
+                std::string response = store.getPayloads().getResponse (*iter);
+
                 if (actor.isEmpty())
                 {
                     MWScript::InterpreterContext interpreterContext(NULL,MWWorld::Ptr());
-                    mText = Interpreter::fixDefinesDialog(iter->mResponse, interpreterContext);
+                    mText = Interpreter::fixDefinesDialog(response, interpreterContext);
                 }
                 else
                 {
                     MWScript::InterpreterContext interpreterContext(&actor.getRefData().getLocals(),actor);
-                    mText = Interpreter::fixDefinesDialog(iter->mResponse, interpreterContext);
+                    mText = Interpreter::fixDefinesDialog(response, interpreterContext);
                 }
 
                 return;
@@ -5,13 +5,22 @@
 #include <cctype>
 #include <stdexcept>
 #include <vector>
-#include <algorithm>    // std::reverse
+#include <algorithm>    // std::sort
 
 #include <components/misc/stringops.hpp>
 
 namespace MWDialogue
 {
 
+/// \brief Finds keywords (e.g. topic names) in a text, ignoring case
+///
+/// Keywords are matched at the beginning of words only. Where matches overlap, the longest keyword
+/// wins.
+///
+/// The keywords are compiled into an Aho-Corasick automaton on the first search after they have
+/// been changed, so that a search reads the text once, however many keywords there are. The
+/// automaton is a table of the next state by state and character; it takes about four bytes per
+/// state and distinct character of the keywords.
 template <typename string_t, typename value_t>
 class KeywordSearch
 {
@@ -26,46 +35,37 @@ public:
         value_t mValue;
     };
 
+    KeywordSearch() : mCompiled (false), mClassCount (0) {}
+
     void seed (string_t keyword, value_t value)
     {
         if (keyword.empty())
             return;
-        seed_impl  (/*std::move*/ (keyword), /*std::move*/ (value), 0, mRoot);
+
+        if (!mKeywords.insert (std::make_pair (lowerCase (keyword), value)).second)
+            throw std::runtime_error ("duplicate keyword inserted");
+
+        mCompiled = false;
     }
 
     void clear ()
     {
-        mRoot.mChildren.clear ();
-        mRoot.mKeyword.clear ();
+        mKeywords.clear ();
+        mTransitions.clear ();
+        mStateOutputs.clear ();
+        mOutputs.clear ();
+        mCompiled = false;
     }
 
     bool containsKeyword (string_t keyword, value_t& value)
     {
-        typename Entry::childen_t::iterator current;
-        typename Entry::childen_t::iterator next;
+        typename KeywordMap::const_iterator found = mKeywords.find (lowerCase (keyword));
 
-        current = mRoot.mChildren.find (Misc::StringUtils::toLower (*keyword.begin()));
-        if (current == mRoot.mChildren.end())
+        if (found == mKeywords.end())
             return false;
-        else if (current->second.mKeyword.size() && Misc::StringUtils::ciEqual(current->second.mKeyword, keyword))
-        {
-            value = current->second.mValue;
-            return true;
-        }
 
-        for (Point i = ++keyword.begin(); i != keyword.end(); ++i)
-        {
-            next = current->second.mChildren.find(Misc::StringUtils::toLower (*i));
-            if (next == current->second.mChildren.end())
-                return false;
-            if (Misc::StringUtils::ciEqual(next->second.mKeyword, keyword))
-            {
-                value = next->second.mValue;
-                return true;
-            }
-            current = next;
-        }
-        return false;
+        value = found->second;
+        return true;
     }
 
     static bool sortMatches(const Match& left, const Match& right)
@@ -75,86 +75,49 @@ public:
 
     void highlightKeywords (Point beg, Point end, std::vector<Match>& out)
     {
-        std::vector<Match> matches;
-        for (Point i = beg; i != end; ++i)
-        {
-            // check if previous character marked start of new word
-            if (i != beg)
-            {
-                Point prev = i;
-                --prev;
-                if(isalpha(*prev))
-                    continue;
-            }
-
+        compile();
 
-            // check first character
-            typename Entry::childen_t::iterator candidate = mRoot.mChildren.find (Misc::StringUtils::toLower (*i));
+        // longest keyword starting at each position of the text (-1: none)
+        std::vector<int> longest (end - beg, -1);
 
-            // no match, on to next character
-            if (candidate == mRoot.mChildren.end ())
-                continue;
-
-            // see how far the match goes
-            Point j = i;
-
-            // some keywords might be longer variations of other keywords, so we definitely need a list of candidates
-            // the first element in the pair is length of the match, i.e. depth from the first character on
-            std::vector< typename std::pair<int, typename Entry::childen_t::iterator> > candidates;
+        size_t state = 0;
+        for (Point i = beg; i != end; ++i)
+        {
+            state = mTransitions[state*mClassCount + getClass (*i)];
 
-            while ((j + 1) != end)
+            // all keywords ending here, longest first
+            for (int output = mStateOutputs[state]; output!=-1; output = mOutputs[output].mNext)
             {
-                typename Entry::childen_t::iterator next = candidate->second.mChildren.find (Misc::StringUtils::toLower (*++j));
+                size_t length = mOutputs[output].mLength;
+                Point start = i + 1 - length;
 
-                if (next == candidate->second.mChildren.end ())
+                // keywords must start a word
+                if (start != beg)
                 {
-                    if (candidate->second.mKeyword.size() > 0)
-                        candidates.push_back(std::make_pair((j-i), candidate));
-                    break;
+                    Point prev = start;
+                    --prev;
+                    if(isalpha(*prev))
+                        continue;
                 }
 
-                candidate = next;
-
-                if (candidate->second.mKeyword.size() > 0)
-                    candidates.push_back(std::make_pair((j-i), candidate));
+                // a keyword found later is longer than one found before at the same start
+                longest[start - beg] = output;
             }
+        }
 
-            if (candidates.empty())
-                continue; // didn't match enough to disambiguate, on to next character
-
-            // shorter candidates will be added to the vector first. however, we want to check against longer candidates first
-            std::reverse(candidates.begin(), candidates.end());
-
-            for (typename std::vector< std::pair<int, typename Entry::childen_t::iterator> >::iterator it = candidates.begin();
-                 it != candidates.end(); ++it)
-            {
-                candidate = it->second;
-                // try to match the rest of the keyword
-                Point k = i + it->first;
-                typename string_t::const_iterator t = candidate->second.mKeyword.begin () + (k - i);
-
-
-                while (k != end && t != candidate->second.mKeyword.end ())
-                {
-                    if (Misc::StringUtils::toLower (*k) != Misc::StringUtils::toLower (*t))
-                        break;
-
-                    ++k, ++t;
-                }
+        std::vector<Match> matches;
+        for (size_t i = 0; i<longest.size(); ++i)
+        {
+            if (longest[i]==-1)
+                continue;
 
-                // didn't match full keyword, try the next candidate
-                if (t != candidate->second.mKeyword.end ())
-                    continue;
+            const Output& output = mOutputs[longest[i]];
 
-                // found a keyword, but there might still be longer keywords that start somewhere _within_ this keyword
-                // we will resolve these overlapping keywords later, choosing the longest one in case of conflict
-                Match match;
-                match.mValue = candidate->second.mValue;
-                match.mBeg = i;
-                match.mEnd = k;
-                matches.push_back(match);
-                break;
-            }
+            Match match;
+            match.mBeg = beg + i;
+            match.mEnd = beg + i + output.mLength;
+            match.mValue = output.mValue;
+            matches.push_back (match);
         }
 
         // resolve overlapping keywords
@@ -201,54 +164,179 @@ public:
 
 private:
 
-    struct Entry
-    {
-        typedef std::map <wchar_t, Entry> childen_t;
+    typedef typename string_t::value_type char_t;
+    typedef typename string_t::traits_type traits_t;
+
+    /// Lower case keyword, value
+    typedef std::map<string_t, value_t> KeywordMap;
 
-        string_t mKeyword;
+    /// Element of the linked lists of keywords ending in a state
+    struct Output
+    {
+        size_t mLength;
         value_t mValue;
-        childen_t mChildren;
+        int mNext;
     };
 
-    void seed_impl (string_t keyword, value_t value, size_t depth, Entry  & entry)
+    static string_t lowerCase (const string_t& string)
     {
-        int ch = Misc::StringUtils::toLower (keyword.at (depth));
+        string_t lower (string);
+        for (typename string_t::iterator i = lower.begin(); i != lower.end(); ++i)
+            *i = Misc::StringUtils::toLower (*i);
+        return lower;
+    }
 
-        typename Entry::childen_t::iterator j = entry.mChildren.find (ch);
+    /// \return Column of \a ch in the transition table, the same for upper and lower case. Characters
+    /// that don't occur in any keyword have column 0.
+    size_t getClass (char_t ch) const
+    {
+        typename traits_t::int_type code = traits_t::to_int_type (ch);
 
-        if (j == entry.mChildren.end ())
+        if (code>=0 && code<256)
+            return mByteClasses[code];
+
+        typename std::map<char_t, size_t>::const_iterator found = mWideClasses.find (ch);
+        return found==mWideClasses.end() ? 0 : found->second;
+    }
+
+    /// Assign a column to \a ch, if it doesn't have one already.
+    void addClass (char_t ch)
+    {
+        typename traits_t::int_type code = traits_t::to_int_type (ch);
+
+        size_t& column = (code>=0 && code<256) ? mByteClasses[code] : mWideClasses[ch];
+
+        if (column==0)
+            column = mClassCount++;
+    }
+
+    void compile()
+    {
+        if (mCompiled)
+            return;
+
+        mTransitions.clear ();
+        mStateOutputs.clear ();
+        mOutputs.clear ();
+        mByteClasses.assign (256, 0);
+        mWideClasses.clear ();
+        mClassCount = 1;
+
+        std::vector<typename KeywordMap::const_iterator> keywords;
+        for (typename KeywordMap::const_iterator iter = mKeywords.begin(); iter != mKeywords.end(); ++iter)
+        {
+            keywords.push_back (iter);
+
+            for (typename string_t::const_iterator ch = iter->first.begin(); ch != iter->first.end(); ++ch)
+                addClass (*ch);
+        }
+
+        // upper case characters share the column of their lower case version
+        for (int code = 0; code<256; ++code)
         {
-            entry.mChildren [ch].mValue = /*std::move*/ (value);
-            entry.mChildren [ch].mKeyword = /*std::move*/ (keyword);
+            char_t ch = traits_t::to_char_type (code);
+            char_t lower = Misc::StringUtils::toLower (ch);
+            if (lower!=ch)
+                mByteClasses[code] = mByteClasses[traits_t::to_int_type (lower)];
         }
-        else
+
+        // Build the trie breadth first. Each state stands for the keywords in a range of the sorted
+        // list, that share the state's string as a prefix. -1 marks a missing edge for now.
+        std::vector<std::pair<size_t, size_t> > ranges;
+        std::vector<size_t> depths;
+
+        ranges.push_back (std::make_pair (0, keywords.size()));
+        depths.push_back (0);
+        mTransitions.resize (mClassCount, -1);
+        mStateOutputs.push_back (-1);
+
+        for (size_t state = 0; state<ranges.size(); ++state)
         {
-            if (j->second.mKeyword.size () > 0)
+            size_t begin = ranges[state].first;
+            size_t end = ranges[state].second;
+            size_t depth = depths[state];
+
+            // a keyword ending in this state is sorted before the longer ones
+            if (begin!=end && keywords[begin]->first.size()==depth)
             {
-                if (keyword == j->second.mKeyword)
-                    throw std::runtime_error ("duplicate keyword inserted");
+                Output output;
+                output.mLength = depth;
+                output.mValue = keywords[begin]->second;
+                output.mNext = -1;
+                mStateOutputs[state] = static_cast<int> (mOutputs.size());
+                mOutputs.push_back (output);
+                ++begin;
+            }
 
-                value_t pushValue = /*std::move*/ (j->second.mValue);
-                string_t pushKeyword = /*std::move*/ (j->second.mKeyword);
+            while (begin!=end)
+            {
+                char_t ch = keywords[begin]->first[depth];
+
+                size_t next = begin+1;
+                while (next!=end && keywords[next]->first[depth]==ch)
+                    ++next;
+
+                mTransitions[state*mClassCount + getClass (ch)] = static_cast<int> (ranges.size());
+
+                ranges.push_back (std::make_pair (begin, next));
+                depths.push_back (depth+1);
+                mTransitions.resize (mTransitions.size() + mClassCount, -1);
+                mStateOutputs.push_back (-1);
+
+                begin = next;
+            }
+        }
+
+        // Failure links and missing transitions, in breadth first order so that the states for
+        // shorter strings are done already. A missing transition is the one of the failure state,
+        // i.e. of the longest proper suffix of the state's string that is also a state. A state
+        // also reports the keywords of its failure state.
+        std::vector<int> fail (ranges.size(), 0);
+
+        for (size_t state = 0; state<ranges.size(); ++state)
+        {
+            int *row = &mTransitions[state*mClassCount];
+            const int *failRow = &mTransitions[fail[state]*mClassCount];
 
-                if (depth >= pushKeyword.size ())
-                    throw std::runtime_error ("unexpected");
+            for (size_t column = 0; column<mClassCount; ++column)
+            {
+                int child = row[column];
 
-                if (depth+1 < pushKeyword.size())
+                if (child==-1)
                 {
-                    seed_impl (/*std::move*/ (pushKeyword), /*std::move*/ (pushValue), depth+1, j->second);
-                    j->second.mKeyword.clear ();
+                    row[column] = state==0 ? 0 : failRow[column];
+                    continue;
                 }
+
+                fail[child] = state==0 ? 0 : failRow[column];
+
+                int inherited = mStateOutputs[fail[child]];
+
+                if (mStateOutputs[child]==-1)
+                    mStateOutputs[child] = inherited;
+                else
+                    mOutputs[mStateOutputs[child]].mNext = inherited;
             }
-            if (depth+1 == keyword.size())
-                j->second.mKeyword = value;
-            else // depth+1 < keyword.size()
-                seed_impl (/*std::move*/ (keyword), /*std::move*/ (value), depth+1, j->second);
         }
 
+        mCompiled = true;
     }
 
-    Entry mRoot;
+    KeywordMap mKeywords;
+    bool mCompiled;
+
+    /// Columns of the transition table by character, see getClass()
+    std::vector<size_t> mByteClasses;
+    std::map<char_t, size_t> mWideClasses;
+    size_t mClassCount;
+
+    /// Next state by state (row) and character (column)
+    std::vector<int> mTransitions;
+
+    /// First of the keywords that end in each state, i.e. that are suffixes of its string (-1: none)
+    std::vector<int> mStateOutputs;
+
+    std::vector<Output> mOutputs;
 };
 
 }
@@ -23,13 +23,13 @@ namespace MWDialogue
 
     std::string Quest::getName() const
     {
-        const ESM::Dialogue *dialogue =
-            MWBase::Environment::get().getWorld()->getStore().get<ESM::Dialogue>().find (mTopic);
+        const MWWorld::ESMStore& store = MWBase::Environment::get().getWorld()->getStore();
+        const ESM::Dialogue *dialogue = store.get<ESM::Dialogue>().find (mTopic);
 
         for (ESM::Dialogue::InfoContainer::const_iterator iter (dialogue->mInfo.begin());
             iter!=dialogue->mInfo.end(); ++iter)
             if (iter->mQuestStatus==ESM::DialInfo::QS_Name)
-                return iter->mResponse;
+                return store.getPayloads().getResponse (*iter);
 
         return "";
     }
@@ -34,7 +34,8 @@ void test(const MWWorld::Ptr& actor, int &compiled, int &total, const Compiler::
     Compiler::StreamErrorHandler errorHandler(errorStream);
     errorHandler.setWarningsMode (warningsMode);
 
-    const MWWorld::Store<ESM::Dialogue>& dialogues = MWBase::Environment::get().getWorld()->getStore().get<ESM::Dialogue>();
+    const MWWorld::ESMStore& store = MWBase::Environment::get().getWorld()->getStore();
+    const MWWorld::Store<ESM::Dialogue>& dialogues = store.get<ESM::Dialogue>();
     for (MWWorld::Store<ESM::Dialogue>::iterator it = dialogues.begin(); it != dialogues.end(); ++it)
     {
         std::vector<const ESM::DialInfo*> infos = filter.listAll(*it);
@@ -42,7 +43,8 @@ void test(const MWWorld::Ptr& actor, int &compiled, int &total, const Compiler::
         for (std::vector<const ESM::DialInfo*>::iterator it = infos.begin(); it != infos.end(); ++it)
         {
             const ESM::DialInfo* info = *it;
-            if (!info->mResultScript.empty())
+            std::string resultScript = store.getPayloads().getResultScript(*info);
+            if (!resultScript.empty())
             {
                 bool success = true;
                 ++total;
@@ -50,7 +52,7 @@ void test(const MWWorld::Ptr& actor, int &compiled, int &total, const Compiler::
                 {
                     errorHandler.reset();
 
-                    std::istringstream input (info->mResultScript + "\n");
+                    std::istringstream input (resultScript + "\n");
 
                     Compiler::Scanner scanner (errorHandler, input, extensions);
 
@@ -88,7 +90,7 @@ void test(const MWWorld::Ptr& actor, int &compiled, int &total, const Compiler::
                 {
                     std::cerr
                         << "compiling failed (dialogue script)" << std::endl
-                        << info->mResultScript
+                        << resultScript
                         << std::endl << std::endl;
                 }
             }
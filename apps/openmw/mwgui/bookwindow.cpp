@@ -12,6 +12,7 @@
 #include "../mwmechanics/actorutil.hpp"
 
 #include "../mwworld/actiontake.hpp"
+#include "../mwworld/esmstore.hpp"
 
 #include "formatting.hpp"
 
@@ -86,9 +87,11 @@ namespace MWGui
 
         MWWorld::LiveCellRef<ESM::Book> *ref = mBook.get<ESM::Book>();
 
+        std::string text = MWBase::Environment::get().getWorld()->getStore().getPayloads().getBookText(*ref->mBase);
+
         Formatting::BookFormatter formatter;
-        mPages = formatter.markupToWidget(mLeftPage, ref->mBase->mText);
-        formatter.markupToWidget(mRightPage, ref->mBase->mText);
+        mPages = formatter.markupToWidget(mLeftPage, text);
+        formatter.markupToWidget(mRightPage, text);
 
         updatePages();
 
@@ -13,6 +13,7 @@
 #include "../mwmechanics/actorutil.hpp"
 
 #include "../mwworld/actiontake.hpp"
+#include "../mwworld/esmstore.hpp"
 
 #include "formatting.hpp"
 
@@ -60,7 +61,8 @@ namespace MWGui
         MWWorld::LiveCellRef<ESM::Book> *ref = mScroll.get<ESM::Book>();
 
         Formatting::BookFormatter formatter;
-        formatter.markupToWidget(mTextView, ref->mBase->mText, 390, mTextView->getHeight());
+        formatter.markupToWidget(mTextView, MWBase::Environment::get().getWorld()->getStore().getPayloads().getBookText(*ref->mBase),
+                                 390, mTextView->getHeight());
         MyGUI::IntSize size = mTextView->getChildAt(0)->getSize();
 
         // Canvas size must be expressed with VScroll disabled, otherwise MyGUI would expand the scroll area when the scrollbar is hidden
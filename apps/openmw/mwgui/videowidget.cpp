@@ -33,7 +33,7 @@ void VideoWidget::playVideo(const std::string &video)
     Files::IStreamPtr videoStream;
     try
     {
-        videoStream = mVFS->get(video);
+        videoStream = mVFS->get(video, VFS::IOCategory_Video);
     }
     catch (std::exception& e)
     {
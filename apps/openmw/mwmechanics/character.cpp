@@ -29,6 +29,7 @@
 #include "actorutil.hpp"
 
 #include <components/misc/rng.hpp>
+#include <components/misc/stringatom.hpp>
 
 #include <components/settings/settings.hpp>
 
@@ -1714,8 +1715,10 @@ void CharacterController::update(float duration)
 
                 // decrease fatigue
                 const MWWorld::Store<ESM::GameSetting> &gmst = world->getStore().get<ESM::GameSetting>();
-                const float fatigueJumpBase = gmst.find("fFatigueJumpBase")->getFloat();
-                const float fatigueJumpMult = gmst.find("fFatigueJumpMult")->getFloat();
+                static const Misc::StringAtom fFatigueJumpBaseId ("fFatigueJumpBase");
+                static const Misc::StringAtom fFatigueJumpMultId ("fFatigueJumpMult");
+                const float fatigueJumpBase = gmst.find(fFatigueJumpBaseId)->getFloat();
+                const float fatigueJumpMult = gmst.find(fFatigueJumpMultId)->getFloat();
                 float normalizedEncumbrance = mPtr.getClass().getNormalizedEncumbrance(mPtr);
                 if (normalizedEncumbrance > 1)
                     normalizedEncumbrance = 1;
@@ -34,7 +34,7 @@ namespace MWScript
     {
         if (!id.empty())
         {
-            return MWBase::Environment::get().getWorld()->getPtr (id, activeOnly);
+            return getReference (id, true, activeOnly);
         }
         else
         {
@@ -54,7 +54,10 @@ namespace MWScript
     {
         if (!id.empty())
         {
-            return MWBase::Environment::get().getWorld()->getPtr (id, activeOnly);
+            MWWorld::Ptr ptr = searchPtr (id, activeOnly);
+            if (ptr.isEmpty())
+                throw std::runtime_error ("unknown ID: " + id);
+            return ptr;
         }
         else
         {
@@ -69,6 +72,43 @@ namespace MWScript
         }
     }
 
+    MWWorld::Ptr InterpreterContext::searchPtr (const std::string& id, bool activeOnly) const
+    {
+        MWBase::World *world = MWBase::Environment::get().getWorld();
+
+        if (!mLocals)
+            return world->searchPtr (id, activeOnly);
+
+        if (mLocals->mReferenceGeneration != world->getReferenceGeneration())
+        {
+            mLocals->mReferences.clear();
+            mLocals->mReferenceGeneration = world->getReferenceGeneration();
+        }
+
+        typedef std::map<std::pair<std::string, bool>, std::pair<MWWorld::LiveCellRefBase*, MWWorld::CellStore*> > References;
+        std::pair<std::string, bool> key (id, activeOnly);
+        References::iterator found = mLocals->mReferences.find (key);
+
+        if (found != mLocals->mReferences.end())
+        {
+            MWWorld::Ptr ptr (found->second.first, found->second.second);
+
+            // A reference's count can drop to 0 without going through World::deleteObject
+            if (MWWorld::CellStore::isAccessible (ptr.getRefData(), ptr.getCellRef()))
+                return ptr;
+        }
+
+        MWWorld::Ptr ptr = world->searchPtr (id, activeOnly);
+
+        // Items in containers may be stacked or removed at any time, only cache references in cells
+        if (ptr.isInCell())
+            mLocals->mReferences[key] = std::make_pair (ptr.getBase(), ptr.getCell());
+        else if (found != mLocals->mReferences.end())
+            mLocals->mReferences.erase (found);
+
+        return ptr;
+    }
+
     const Locals& InterpreterContext::getMemberLocals (std::string& id, bool global)
         const
     {
@@ -113,11 +153,10 @@ namespace MWScript
     int InterpreterContext::findLocalVariableIndex (const std::string& scriptId,
         const std::string& name, char type) const
     {
-        int index = MWBase::Environment::get().getScriptManager()->getLocals (scriptId).
-            searchIndex (type, name);
+        std::pair<char, int> slot = MWBase::Environment::get().getScriptManager()->getLocalSlot (scriptId, name);
 
-        if (index!=-1)
-            return index;
+        if (slot.first==type)
+            return slot.second;
 
         std::ostringstream stream;
 
@@ -138,7 +177,7 @@ namespace MWScript
 
     InterpreterContext::InterpreterContext (
         MWScript::Locals *locals, MWWorld::Ptr reference, const std::string& targetId)
-    : mLocals (locals), mReference (reference), mTargetId (targetId)
+    : mLocals (locals), mReference (reference), mTargetId (targetId), mSecondsPassed (-1)
     {
         // If we run on a reference (local script, dialogue script or console with object
         // selected), store the ID of that reference store it so it can be inherited by
@@ -448,7 +487,7 @@ namespace MWScript
         if (id.empty())
             ref2 = getReferenceImp();
         else
-            ref2 = MWBase::Environment::get().getWorld()->getPtr(id, false);
+            ref2 = getReferenceImp(id, false);
 
         if (ref2.getContainerStore()) // is the object contained?
         {
@@ -460,7 +499,7 @@ namespace MWScript
                 throw std::runtime_error("failed to find container ptr");
         }
 
-        const MWWorld::Ptr ref = MWBase::Environment::get().getWorld()->getPtr(name, false);
+        const MWWorld::Ptr ref = getReferenceImp(name, false);
 
         // If the objects are in different worldspaces, return a large value (just like vanilla)
         if (ref.getCell()->getCell()->getCellId().mWorldspace != ref2.getCell()->getCell()->getCellId().mWorldspace)
@@ -482,8 +521,16 @@ namespace MWScript
         action->execute (actor);
     }
 
+    void InterpreterContext::setSecondsPassed (float seconds)
+    {
+        mSecondsPassed = seconds;
+    }
+
     float InterpreterContext::getSecondsPassed() const
     {
+        if (mSecondsPassed>=0)
+            return mSecondsPassed;
+
         return MWBase::Environment::get().getFrameDuration();
     }
 
@@ -568,6 +615,16 @@ namespace MWScript
         return getReferenceImp ("", true, required);
     }
 
+    MWWorld::Ptr InterpreterContext::getReference(const std::string& id, bool required, bool activeOnly)
+    {
+        MWWorld::Ptr ptr = searchPtr (id, activeOnly);
+
+        if (ptr.isEmpty() && required)
+            throw std::runtime_error ("unknown ID: " + id);
+
+        return ptr;
+    }
+
     std::string InterpreterContext::getTargetId() const
     {
         return mTargetId;
@@ -29,6 +29,9 @@ namespace MWScript
 
             std::string mTargetId;
 
+            /// Time since the script was run the last time (negative: frame duration)
+            float mSecondsPassed;
+
             /// If \a id is empty, a reference the script is run from is returned or in case
             /// of a non-local script the reference derived from the target ID.
             MWWorld::Ptr getReferenceImp (const std::string& id = "", bool activeOnly = false,
@@ -39,6 +42,9 @@ namespace MWScript
             const MWWorld::Ptr getReferenceImp (const std::string& id = "",
                 bool activeOnly = false, bool doThrow=true) const;
 
+            /// Look up a reference by ID like MWBase::World::searchPtr, through the cache in mLocals.
+            MWWorld::Ptr searchPtr (const std::string& id, bool activeOnly) const;
+
             const Locals& getMemberLocals (std::string& id, bool global) const;
             ///< \a id is changed to the respective script ID, if \a id wasn't a script ID before
 
@@ -131,6 +137,9 @@ namespace MWScript
             void executeActivation(MWWorld::Ptr ptr, MWWorld::Ptr actor);
             ///< Execute the activation action for this ptr. If ptr is mActivated, mark activation as handled.
 
+            void setSecondsPassed (float seconds);
+            ///< For scripts that don't run every frame.
+
             virtual float getSecondsPassed() const;
 
             virtual bool isDisabled (const std::string& id = "") const;
@@ -154,6 +163,10 @@ namespace MWScript
             MWWorld::Ptr getReference(bool required=true);
             ///< Reference, that the script is running from (can be empty)
 
+            MWWorld::Ptr getReference(const std::string& id, bool required, bool activeOnly);
+            ///< Reference with the ID \a id, looked up like MWBase::World::getPtr or searchPtr if not \a required.
+            /// The result is cached per script instance.
+
             void updatePtr(const MWWorld::Ptr& base, const MWWorld::Ptr& updated);
             ///< Update the Ptr stored in mReference, if there is one stored there. Should be called after the reference has been moved to a new cell.
 
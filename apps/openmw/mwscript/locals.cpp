@@ -28,7 +28,7 @@ namespace MWScript
         }
     }
 
-    Locals::Locals() : mInitialised (false) {}
+    Locals::Locals() : mInitialised (false), mReferenceGeneration (0) {}
 
     bool Locals::configure (const ESM::Script& script)
     {
@@ -60,10 +60,7 @@ namespace MWScript
         {
             ensure (script);
 
-            const Compiler::Locals& locals =
-                MWBase::Environment::get().getScriptManager()->getLocals(script);
-            int index = locals.getIndex(var);
-            return (index != -1);
+            return MWBase::Environment::get().getScriptManager()->getLocalSlot (script, var).first!=' ';
         }
         catch (const Compiler::SourceException&)
         {
@@ -75,9 +72,9 @@ namespace MWScript
     {
         ensure (script);
 
-        const Compiler::Locals& locals = MWBase::Environment::get().getScriptManager()->getLocals(script);
-        int index = locals.getIndex(var);
-        char type = locals.getType(var);
+        std::pair<char, int> slot = MWBase::Environment::get().getScriptManager()->getLocalSlot (script, var);
+        int index = slot.second;
+        char type = slot.first;
         if(index != -1)
         {
             switch(type)
@@ -101,9 +98,9 @@ namespace MWScript
     {
         ensure (script);
 
-        const Compiler::Locals& locals = MWBase::Environment::get().getScriptManager()->getLocals(script);
-        int index = locals.getIndex(var);
-        char type = locals.getType(var);
+        std::pair<char, int> slot = MWBase::Environment::get().getScriptManager()->getLocalSlot (script, var);
+        int index = slot.second;
+        char type = slot.first;
         if(index != -1)
         {
             switch(type)
@@ -127,9 +124,9 @@ namespace MWScript
     {
         ensure (script);
 
-        const Compiler::Locals& locals = MWBase::Environment::get().getScriptManager()->getLocals(script);
-        int index = locals.getIndex(var);
-        char type = locals.getType(var);
+        std::pair<char, int> slot = MWBase::Environment::get().getScriptManager()->getLocalSlot (script, var);
+        int index = slot.second;
+        char type = slot.first;
         if(index != -1)
         {
             switch(type)
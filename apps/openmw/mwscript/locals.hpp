@@ -1,6 +1,8 @@
 #ifndef GAME_SCRIPT_LOCALS_H
 #define GAME_SCRIPT_LOCALS_H
 
+#include <map>
+#include <string>
 #include <vector>
 
 #include <components/interpreter/types.hpp>
@@ -11,6 +13,12 @@ namespace ESM
     struct Locals;
 }
 
+namespace MWWorld
+{
+    struct LiveCellRefBase;
+    class CellStore;
+}
+
 namespace MWScript
 {
     class Locals
@@ -24,6 +32,13 @@ namespace MWScript
             std::vector<Interpreter::Type_Integer> mLongs;
             std::vector<Interpreter::Type_Float> mFloats;
 
+            /// References the script looked up by ID, with or without limiting the search to the active cells.
+            /// Only valid while MWBase::World::getReferenceGeneration() returns mReferenceGeneration.
+            /// \note Maintained by InterpreterContext and not saved.
+            /// \note Stores the reference and its cell, as locals.hpp can't include ptr.hpp.
+            std::map<std::pair<std::string, bool>, std::pair<MWWorld::LiveCellRefBase*, MWWorld::CellStore*> > mReferences;
+            unsigned int mReferenceGeneration;
+
             Locals();
 
             /// Are there any locals?
@@ -1,6 +1,8 @@
 #include "miscextensions.hpp"
 
 #include <cstdlib>
+#include <iostream>
+#include <sstream>
 
 #include <components/compiler/extensions.hpp>
 #include <components/compiler/opcodes.hpp>
@@ -13,6 +15,9 @@
 #include <components/esm/loadmgef.hpp>
 #include <components/esm/loadcrea.hpp>
 
+#include <components/vfs/manager.hpp>
+#include <components/vfs/iostats.hpp>
+
 #include "../mwbase/environment.hpp"
 #include "../mwbase/windowmanager.hpp"
 #include "../mwbase/scriptmanager.hpp"
@@ -32,6 +37,7 @@
 
 #include "interpretercontext.hpp"
 #include "ref.hpp"
+#include "scriptprofiler.hpp"
 
 namespace
 {
@@ -1019,6 +1025,65 @@ namespace MWScript
             }
         };
 
+        class OpDumpIOStats : public Interpreter::Opcode0
+        {
+        public:
+            virtual void execute (Interpreter::Runtime& runtime)
+            {
+                const VFS::IOStats* stats = MWBase::Environment::get().getWorld()->getVFS()->getIOStats();
+                if (!stats)
+                {
+                    runtime.getContext().report("I/O statistics are disabled, enable the 'io statistics' setting");
+                    return;
+                }
+
+                std::ostringstream csv;
+                stats->writeCsv(csv);
+
+                std::cout << csv.str();
+                runtime.getContext().report(csv.str());
+            }
+        };
+
+        class OpToggleScriptProfiler : public Interpreter::Opcode0
+        {
+        public:
+            virtual void execute (Interpreter::Runtime& runtime)
+            {
+                ScriptProfiler& profiler = MWBase::Environment::get().getScriptManager()->getProfiler();
+                profiler.setEnabled(!profiler.isEnabled());
+
+                runtime.getContext().report(profiler.isEnabled() ? "Script Profiler -> On" : "Script Profiler -> Off");
+            }
+        };
+
+        class OpDumpScriptProfile : public Interpreter::Opcode0
+        {
+        public:
+            virtual void execute (Interpreter::Runtime& runtime)
+            {
+                const ScriptProfiler& profiler = MWBase::Environment::get().getScriptManager()->getProfiler();
+
+                std::ostringstream report;
+                profiler.report(report, 20);
+
+                std::cout << report.str();
+                runtime.getContext().report(report.str());
+
+                profiler.save();
+                runtime.getContext().report("Full profile written to " + profiler.getExportFile().string());
+            }
+        };
+
+        class OpClearScriptProfile : public Interpreter::Opcode0
+        {
+        public:
+            virtual void execute (Interpreter::Runtime& runtime)
+            {
+                MWBase::Environment::get().getScriptManager()->getProfiler().clear();
+            }
+        };
+
         class OpToggleGodMode : public Interpreter::Opcode0
         {
             public:
@@ -1334,6 +1399,10 @@ namespace MWScript
             interpreter.installSegment5 (Compiler::Misc::opcodeShowExplicit, new OpShow<ExplicitRef>);
             interpreter.installSegment5 (Compiler::Misc::opcodeToggleGodMode, new OpToggleGodMode);
             interpreter.installSegment5 (Compiler::Misc::opcodeToggleScripts, new OpToggleScripts);
+            interpreter.installSegment5 (Compiler::Misc::opcodeDumpIOStats, new OpDumpIOStats);
+            interpreter.installSegment5 (Compiler::Misc::opcodeToggleScriptProfiler, new OpToggleScriptProfiler);
+            interpreter.installSegment5 (Compiler::Misc::opcodeDumpScriptProfile, new OpDumpScriptProfile);
+            interpreter.installSegment5 (Compiler::Misc::opcodeClearScriptProfile, new OpClearScriptProfile);
             interpreter.installSegment5 (Compiler::Misc::opcodeDisableLevitation, new OpEnableLevitation<false>);
             interpreter.installSegment5 (Compiler::Misc::opcodeEnableLevitation, new OpEnableLevitation<true>);
             interpreter.installSegment5 (Compiler::Misc::opcodeCast, new OpCast<ImplicitRef>);
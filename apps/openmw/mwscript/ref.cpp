@@ -2,9 +2,6 @@
 
 #include <components/interpreter/runtime.hpp>
 
-#include "../mwbase/environment.hpp"
-#include "../mwbase/world.hpp"
-
 #include "interpretercontext.hpp"
 
 MWWorld::Ptr MWScript::ExplicitRef::operator() (Interpreter::Runtime& runtime, bool required,
@@ -13,10 +10,10 @@ MWWorld::Ptr MWScript::ExplicitRef::operator() (Interpreter::Runtime& runtime, b
     std::string id = runtime.getStringLiteral(runtime[0].mInteger);
     runtime.pop();
 
-    if (required)
-        return MWBase::Environment::get().getWorld()->getPtr(id, activeOnly);
-    else
-        return MWBase::Environment::get().getWorld()->searchPtr(id, activeOnly);
+    MWScript::InterpreterContext& context
+    = static_cast<MWScript::InterpreterContext&> (runtime.getContext());
+
+    return context.getReference(id, required, activeOnly);
 }
 
 MWWorld::Ptr MWScript::ImplicitRef::operator() (Interpreter::Runtime& runtime, bool required,
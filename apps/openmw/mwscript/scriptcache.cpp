@@ -0,0 +1,253 @@
+#include "scriptcache.hpp"
+
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+#include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
+
+#include <components/compiler/extensions.hpp>
+
+#include <components/esm/defs.hpp>
+#include <components/esm/esmreader.hpp>
+#include <components/esm/esmwriter.hpp>
+
+#include "../mwworld/contentsnapshot.hpp"
+
+namespace
+{
+    /// Increase when the compiler or the interpreter change the meaning of bytecode, so that older caches are ignored.
+    const int sCacheVersion = 1;
+
+    const int sKeyRecord = ESM::FourCC<'S','C','K','Y'>::value;
+    const int sScriptRecord = ESM::FourCC<'S','C','P','C'>::value;
+
+    /// FNV-1a, which unlike boost::hash gives the same value in every build
+    boost::uint64_t hashText (const std::string& text)
+    {
+        boost::uint64_t hash = 14695981039346656037ull;
+
+        for (std::string::const_iterator iter (text.begin()); iter!=text.end(); ++iter)
+        {
+            hash ^= static_cast<unsigned char> (*iter);
+            hash *= 1099511628211ull;
+        }
+
+        return hash;
+    }
+
+    void writeLocals (ESM::ESMWriter& writer, const Compiler::Locals& locals, char type, const std::string& name)
+    {
+        const std::vector<std::string>& names = locals.get (type);
+
+        for (std::vector<std::string>::const_iterator iter (names.begin()); iter!=names.end(); ++iter)
+            writer.writeHNString (name, *iter);
+    }
+}
+
+namespace MWScript
+{
+    ScriptCache::ScriptCache (const boost::filesystem::path& file,
+        const std::vector<boost::filesystem::path>& contentFiles, const Compiler::Extensions& extensions,
+        bool optimize)
+    : mFile (file), mModified (false)
+    {
+        std::ostringstream extensionsStream;
+        extensions.write (extensionsStream);
+
+        std::ostringstream key;
+        key << "version " << sCacheVersion << "\n";
+        key << "extensions " << hashText (extensionsStream.str()) << "\n";
+        key << "optimize " << optimize << "\n";
+        mRecentlyModified = MWWorld::describeContentFiles (contentFiles, key);
+
+        mKey = key.str();
+    }
+
+    void ScriptCache::load()
+    {
+        mEntries.clear();
+        mModified = false;
+
+        if (!boost::filesystem::exists (mFile))
+            return;
+
+        try
+        {
+            ESM::ESMReader esm;
+            esm.open (mFile.string());
+
+            if (!esm.hasMoreRecs() || esm.getRecName().intval!=static_cast<uint32_t> (sKeyRecord))
+                return;
+
+            esm.getRecHeader();
+            if (esm.getHNString ("KEYS")!=mKey)
+            {
+                std::cout << "Script cache " << mFile << " is outdated" << std::endl;
+                return;
+            }
+
+            while (esm.hasMoreRecs())
+            {
+                if (esm.getRecName().intval!=static_cast<uint32_t> (sScriptRecord))
+                    esm.fail ("Unknown record");
+
+                esm.getRecHeader();
+
+                std::string name = esm.getHNString ("NAME");
+
+                Entry entry;
+                esm.getHNT (entry.mTextHash, "HASH");
+
+                boost::uint64_t textSize = 0;
+                esm.getHNT (textSize, "SIZE");
+                entry.mTextSize = static_cast<std::size_t> (textSize);
+
+                while (esm.hasMoreSubs())
+                {
+                    esm.getSubName();
+                    switch (esm.retSubName().intval)
+                    {
+                        case ESM::FourCC<'S','H','R','T'>::value:
+                            entry.mLocals.declare ('s', esm.getHString());
+                            break;
+                        case ESM::FourCC<'L','O','N','G'>::value:
+                            entry.mLocals.declare ('l', esm.getHString());
+                            break;
+                        case ESM::FourCC<'F','L','O','T'>::value:
+                            entry.mLocals.declare ('f', esm.getHString());
+                            break;
+                        case ESM::FourCC<'C','O','D','E'>::value:
+                        {
+                            esm.getSubHeader();
+                            if (esm.getSubSize()==0 || esm.getSubSize() % sizeof (Interpreter::Type_Code))
+                                esm.fail ("Bad bytecode size");
+
+                            entry.mByteCode.resize (esm.getSubSize() / sizeof (Interpreter::Type_Code));
+                            esm.getExact (&entry.mByteCode[0], esm.getSubSize());
+                            break;
+                        }
+                        default:
+                            esm.fail ("Unknown subrecord");
+                    }
+                }
+
+                if (entry.mByteCode.empty())
+                    esm.fail ("Missing bytecode");
+
+                mEntries[name] = entry;
+            }
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "Failed to read script cache " << mFile << ": " << e.what() << std::endl;
+            mEntries.clear();
+
+            // Written again, once a script has been compiled
+            boost::system::error_code ec;
+            boost::filesystem::remove (mFile, ec);
+            return;
+        }
+
+        std::cout << "Loaded " << mEntries.size() << " compiled scripts from " << mFile << std::endl;
+    }
+
+    bool ScriptCache::get (const std::string& name, const std::string& text,
+        std::vector<Interpreter::Type_Code>& byteCode, Compiler::Locals& locals) const
+    {
+        std::map<std::string, Entry>::const_iterator iter = mEntries.find (name);
+
+        if (iter==mEntries.end() || iter->second.mTextSize!=text.size() ||
+            iter->second.mTextHash!=hashText (text))
+            return false;
+
+        byteCode = iter->second.mByteCode;
+        locals = iter->second.mLocals;
+        return true;
+    }
+
+    void ScriptCache::add (const std::string& name, const std::string& text,
+        const std::vector<Interpreter::Type_Code>& byteCode, const Compiler::Locals& locals)
+    {
+        if (byteCode.empty())
+            return;
+
+        Entry& entry = mEntries[name];
+        entry.mTextHash = hashText (text);
+        entry.mTextSize = text.size();
+        entry.mByteCode = byteCode;
+        entry.mLocals = locals;
+
+        mModified = true;
+    }
+
+    void ScriptCache::save()
+    {
+        if (!mModified)
+            return;
+
+        if (mRecentlyModified)
+        {
+            std::cout << "Not writing the script cache, the content files were modified just now" << std::endl;
+            return;
+        }
+
+        try
+        {
+            if (mFile.has_parent_path())
+                boost::filesystem::create_directories (mFile.parent_path());
+
+            // Write to a temporary file first, so that an interrupted write can not leave a truncated cache behind
+            boost::filesystem::path tempFile (mFile.string() + ".tmp");
+            {
+                boost::filesystem::ofstream stream (tempFile, std::ios_base::binary);
+                if (!stream.is_open())
+                    throw std::runtime_error ("can't open " + tempFile.string() + " for writing");
+
+                ESM::ESMWriter writer;
+                writer.setFormat (0);
+                writer.setVersion();
+                writer.setType (0);
+                writer.setAuthor ("");
+                writer.setDescription ("");
+                writer.save (stream);
+
+                writer.startRecord (sKeyRecord);
+                writer.writeHNString ("KEYS", mKey);
+                writer.endRecord (sKeyRecord);
+
+                for (std::map<std::string, Entry>::const_iterator iter (mEntries.begin());
+                    iter!=mEntries.end(); ++iter)
+                {
+                    const Entry& entry = iter->second;
+
+                    writer.startRecord (sScriptRecord);
+                    writer.writeHNString ("NAME", iter->first);
+                    writer.writeHNT ("HASH", entry.mTextHash);
+                    writer.writeHNT ("SIZE", static_cast<boost::uint64_t> (entry.mTextSize));
+                    writeLocals (writer, entry.mLocals, 's', "SHRT");
+                    writeLocals (writer, entry.mLocals, 'l', "LONG");
+                    writeLocals (writer, entry.mLocals, 'f', "FLOT");
+                    writer.startSubRecord ("CODE");
+                    writer.write (reinterpret_cast<const char *> (&entry.mByteCode[0]),
+                        entry.mByteCode.size() * sizeof (Interpreter::Type_Code));
+                    writer.endRecord ("CODE");
+                    writer.endRecord (sScriptRecord);
+                }
+
+                writer.close();
+
+                if (!stream.flush())
+                    throw std::runtime_error ("write to " + tempFile.string() + " failed");
+            }
+
+            boost::filesystem::rename (tempFile, mFile);
+            mModified = false;
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "Failed to write script cache " << mFile << ": " << e.what() << std::endl;
+        }
+    }
+}
@@ -0,0 +1,70 @@
+#ifndef GAME_SCRIPT_SCRIPTCACHE_H
+#define GAME_SCRIPT_SCRIPTCACHE_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+#include <boost/filesystem/path.hpp>
+
+#include <components/compiler/locals.hpp>
+
+#include <components/interpreter/types.hpp>
+
+namespace Compiler
+{
+    class Extensions;
+}
+
+namespace MWScript
+{
+    /// \brief Cache file holding compiled scripts, so that they don't have to be compiled again on the next start
+    ///
+    /// A script is taken from the cache while its text stays the same. What a text compiles to also depends on the
+    /// content files (IDs, globals, locals of other scripts), the registered extensions, the compiler itself and
+    /// whether the scripts are optimised, so the whole cache is dropped when one of those changes.
+    class ScriptCache
+    {
+            struct Entry
+            {
+                boost::uint64_t mTextHash;
+                std::size_t mTextSize;
+                std::vector<Interpreter::Type_Code> mByteCode;
+                Compiler::Locals mLocals;
+            };
+
+            boost::filesystem::path mFile;
+            std::string mKey;
+            bool mRecentlyModified;
+            bool mModified;
+            std::map<std::string, Entry> mEntries;
+
+        public:
+
+            /// \param file Path of the cache file.
+            /// \param contentFiles Paths of the content files, in load order.
+            /// \param optimize Are the scripts optimised after compiling?
+            ScriptCache (const boost::filesystem::path& file,
+                const std::vector<boost::filesystem::path>& contentFiles, const Compiler::Extensions& extensions,
+                bool optimize);
+
+            void load();
+            ///< Read the cache file. A missing or outdated cache file leaves the cache empty.
+
+            bool get (const std::string& name, const std::string& text,
+                std::vector<Interpreter::Type_Code>& byteCode, Compiler::Locals& locals) const;
+            ///< Look up the compiled form of script \a name.
+            /// \return Was \a text compiled before?
+
+            void add (const std::string& name, const std::string& text,
+                const std::vector<Interpreter::Type_Code>& byteCode, const Compiler::Locals& locals);
+            ///< Add a successfully compiled script, replacing an older version.
+
+            void save();
+            ///< Write the cache file, if scripts have been added since it was read.
+            /// \note Errors are reported on the console, a missing cache only makes the next start slower.
+    };
+}
+
+#endif
@@ -6,6 +6,9 @@
 #include <exception>
 #include <algorithm>
 
+#include <OpenThreads/Mutex>
+#include <OpenThreads/ScopedLock>
+
 #include <components/esm/loadscpt.hpp>
 
 #include <components/misc/stringops.hpp>
@@ -14,10 +17,146 @@
 #include <components/compiler/context.hpp>
 #include <components/compiler/exception.hpp>
 #include <components/compiler/quickfileparser.hpp>
+#include <components/compiler/optimizer.hpp>
+
+#include <components/loadinglistener/loadinglistener.hpp>
+
+#include <components/sceneutil/workqueue.hpp>
 
 #include "../mwworld/esmstore.hpp"
 
 #include "extensions.hpp"
+#include "scriptcache.hpp"
+
+namespace
+{
+    /// \return Success? Errors in the script are reported via \a errorHandler, others on \a errors.
+    bool compileText (const std::string& text, Compiler::ErrorHandler& errorHandler,
+        const Compiler::Context& context, Compiler::FileParser& parser, std::ostream& errors)
+    {
+        try
+        {
+            std::istringstream input (text);
+
+            Compiler::Scanner scanner (errorHandler, input, context.getExtensions());
+
+            scanner.scan (parser);
+
+            return errorHandler.isGood();
+        }
+        catch (const Compiler::SourceException&)
+        {
+            // error has already been reported via error handler
+            return false;
+        }
+        catch (const std::exception& error)
+        {
+            errors << "An exception has been thrown: " << error.what() << std::endl;
+            return false;
+        }
+    }
+
+    /// \brief Forwards to another context, one thread at a time
+    ///
+    /// The contexts of the game look up records and the locals of other scripts, which is not thread safe.
+    class LockedCompilerContext : public Compiler::Context
+    {
+            const Compiler::Context& mContext;
+            mutable OpenThreads::Mutex mMutex;
+
+        public:
+
+            explicit LockedCompilerContext (const Compiler::Context& context)
+            : mContext (context)
+            {
+                setExtensions (context.getExtensions());
+            }
+
+            virtual bool canDeclareLocals() const
+            {
+                OpenThreads::ScopedLock<OpenThreads::Mutex> lock (mMutex);
+                return mContext.canDeclareLocals();
+            }
+
+            virtual char getGlobalType (const std::string& name) const
+            {
+                OpenThreads::ScopedLock<OpenThreads::Mutex> lock (mMutex);
+                return mContext.getGlobalType (name);
+            }
+
+            virtual std::pair<char, bool> getMemberType (const std::string& name,
+                const std::string& id) const
+            {
+                OpenThreads::ScopedLock<OpenThreads::Mutex> lock (mMutex);
+                return mContext.getMemberType (name, id);
+            }
+
+            virtual bool isId (const std::string& name) const
+            {
+                OpenThreads::ScopedLock<OpenThreads::Mutex> lock (mMutex);
+                return mContext.isId (name);
+            }
+
+            virtual bool isJournalId (const std::string& name) const
+            {
+                OpenThreads::ScopedLock<OpenThreads::Mutex> lock (mMutex);
+                return mContext.isJournalId (name);
+            }
+    };
+
+    /// Compiles a script on a worker thread, with its own parser and error handler. Errors are
+    /// collected, so that they can be printed in order.
+    class CompileScriptItem : public SceneUtil::WorkItem
+    {
+            std::string mName;
+            std::string mText;
+            Compiler::Context& mContext;
+            int mWarningsMode;
+            bool mOptimize;
+            std::ostringstream mErrors;
+            bool mSuccess;
+            std::vector<Interpreter::Type_Code> mByteCode;
+            Compiler::Locals mLocals;
+
+        public:
+
+            CompileScriptItem (const std::string& name, const std::string& text,
+                Compiler::Context& context, int warningsMode, bool optimize)
+            : mName (name), mText (text), mContext (context), mWarningsMode (warningsMode), mOptimize (optimize),
+              mSuccess (false)
+            {}
+
+            virtual void doWork()
+            {
+                Compiler::StreamErrorHandler errorHandler (mErrors);
+                errorHandler.setWarningsMode (mWarningsMode);
+                Compiler::FileParser parser (errorHandler, mContext);
+
+                mSuccess = compileText (mText, errorHandler, mContext, parser, mErrors);
+
+                if (mSuccess)
+                {
+                    parser.getCode (mByteCode);
+                    mLocals = parser.getLocals();
+
+                    if (mOptimize)
+                        Compiler::optimize (mByteCode);
+                }
+            }
+
+            const std::string& getName() const { return mName; }
+
+            const std::string& getText() const { return mText; }
+
+            std::string getErrors() const { return mErrors.str(); }
+
+            bool getSuccess() const { return mSuccess; }
+
+            const std::vector<Interpreter::Type_Code>& getByteCode() const { return mByteCode; }
+
+            const Compiler::Locals& getLocals() const { return mLocals; }
+    };
+}
 
 namespace MWScript
 {
@@ -26,7 +165,8 @@ namespace MWScript
         const std::vector<std::string>& scriptBlacklist)
     : mErrorHandler (std::cerr), mStore (store), mVerbose (verbose),
       mCompilerContext (compilerContext), mParser (mErrorHandler, mCompilerContext),
-      mOpcodesInstalled (false), mGlobalScripts (store)
+      mOpcodesInstalled (false), mWarningsMode (warningsMode), mOptimize (false), mGlobalScripts (store),
+      mProfiler (compilerContext.getExtensions())
     {
         mErrorHandler.setWarningsMode (warningsMode);
 
@@ -37,6 +177,35 @@ namespace MWScript
         std::sort (mScriptBlacklist.begin(), mScriptBlacklist.end());
     }
 
+    ScriptManager::~ScriptManager()
+    {
+        if (mCache.get())
+            mCache->save();
+    }
+
+    void ScriptManager::setOptimize (bool optimize)
+    {
+        mOptimize = optimize;
+    }
+
+    void ScriptManager::setCache (ScriptCache *cache)
+    {
+        mCache.reset (cache);
+    }
+
+    bool ScriptManager::loadFromCache (const std::string& name, const std::string& text)
+    {
+        std::vector<Interpreter::Type_Code> code;
+        Compiler::Locals locals;
+
+        if (!mCache.get() || !mCache->get (name, text, code, locals))
+            return false;
+
+        mScripts.insert (std::make_pair (name, CompiledScript (code, locals)));
+        mLocalSlots.clear();
+        return true;
+    }
+
     bool ScriptManager::compile (const std::string& name)
     {
         mParser.reset();
@@ -44,45 +213,37 @@ namespace MWScript
 
         if (const ESM::Script *script = mStore.get<ESM::Script>().find (name))
         {
-            if (mVerbose)
-                std::cout << "compiling script: " << name << std::endl;
+            std::string text = mStore.getPayloads().getScriptText (*script);
 
-            bool Success = true;
-            try
-            {
-                std::istringstream input (script->mScriptText);
-
-                Compiler::Scanner scanner (mErrorHandler, input, mCompilerContext.getExtensions());
+            if (loadFromCache (name, text))
+                return true;
 
-                scanner.scan (mParser);
+            if (mVerbose)
+                std::cout << "compiling script: " << name << std::endl;
 
-                if (!mErrorHandler.isGood())
-                    Success = false;
-            }
-            catch (const Compiler::SourceException&)
-            {
-                // error has already been reported via error handler
-                Success = false;
-            }
-            catch (const std::exception& error)
-            {
-                std::cerr << "An exception has been thrown: " << error.what() << std::endl;
-                Success = false;
-            }
+            bool Success = compileText (text, mErrorHandler, mCompilerContext, mParser, std::cerr);
 
             if (!Success)
             {
                 std::cerr
                     << "compiling failed: " << name << std::endl;
                 if (mVerbose)
-                    std::cerr << script->mScriptText << std::endl << std::endl;
+                    std::cerr << text << std::endl << std::endl;
             }
 
             if (Success)
             {
                 std::vector<Interpreter::Type_Code> code;
                 mParser.getCode (code);
-                mScripts.insert (std::make_pair (name, std::make_pair (code, mParser.getLocals())));
+
+                if (mOptimize)
+                    Compiler::optimize (code);
+
+                mScripts.insert (std::make_pair (name, CompiledScript (code, mParser.getLocals())));
+                mLocalSlots.clear();
+
+                if (mCache.get())
+                    mCache->add (name, text, code, mParser.getLocals());
 
                 return true;
             }
@@ -102,7 +263,8 @@ namespace MWScript
             {
                 // failed -> ignore script from now on.
                 std::vector<Interpreter::Type_Code> empty;
-                mScripts.insert (std::make_pair (name, std::make_pair (empty, Compiler::Locals())));
+                mScripts.insert (std::make_pair (name, CompiledScript (empty, Compiler::Locals())));
+                mLocalSlots.clear();
                 return;
             }
 
@@ -111,7 +273,9 @@ namespace MWScript
         }
 
         // execute script
-        if (!iter->second.first.empty())
+        CompiledScript& script = iter->second;
+
+        if (!script.mByteCode.empty())
             try
             {
                 if (!mOpcodesInstalled)
@@ -120,14 +284,29 @@ namespace MWScript
                     mOpcodesInstalled = true;
                 }
 
-                mInterpreter.run (&iter->second.first[0], iter->second.first.size(), interpreterContext);
+                if (script.mDecoded.empty())
+                    mInterpreter.decode (&script.mByteCode[0], script.mByteCode.size(), script.mDecoded);
+
+                if (mProfiler.isEnabled())
+                {
+                    mInterpreter.setProfiler (&mProfiler);
+
+                    osg::Timer_t start = osg::Timer::instance()->tick();
+                    mInterpreter.run (&script.mByteCode[0], script.mByteCode.size(), script.mDecoded, interpreterContext);
+                    mProfiler.addRun (name, osg::Timer::instance()->delta_s (start, osg::Timer::instance()->tick()));
+                }
+                else
+                {
+                    mInterpreter.setProfiler (0);
+                    mInterpreter.run (&script.mByteCode[0], script.mByteCode.size(), script.mDecoded, interpreterContext);
+                }
             }
             catch (const std::exception& e)
             {
                 std::cerr << "Execution of script " << name << " failed:" << std::endl;
                 std::cerr << e.what() << std::endl;
 
-                iter->second.first.clear(); // don't execute again.
+                script.mByteCode.clear(); // don't execute again.
             }
     }
 
@@ -152,6 +331,82 @@ namespace MWScript
         return std::make_pair (count, success);
     }
 
+    std::pair<int, int> ScriptManager::precompile (int threads, Loading::Listener& listener)
+    {
+        int count = 0;
+        int success = 0;
+
+        LockedCompilerContext context (mCompilerContext);
+        std::vector<osg::ref_ptr<CompileScriptItem> > items;
+
+        const MWWorld::Store<ESM::Script>& scripts = mStore.get<ESM::Script>();
+
+        for (MWWorld::Store<ESM::Script>::iterator iter = scripts.begin();
+            iter != scripts.end(); ++iter)
+            if (mScripts.find (iter->mId)==mScripts.end() &&
+                !std::binary_search (mScriptBlacklist.begin(), mScriptBlacklist.end(),
+                Misc::StringUtils::lowerCase (iter->mId)))
+            {
+                ++count;
+
+                std::string text = mStore.getPayloads().getScriptText (*iter);
+
+                if (loadFromCache (iter->mId, text))
+                    ++success;
+                else
+                    items.push_back (new CompileScriptItem (iter->mId, text, context, mWarningsMode, mOptimize));
+            }
+
+        if (!items.empty())
+        {
+            Loading::ScopedLoad load (&listener);
+            listener.setLabel ("Compiling scripts");
+            listener.setProgressRange (items.size());
+
+            osg::ref_ptr<SceneUtil::WorkQueue> workQueue (new SceneUtil::WorkQueue (threads));
+
+            for (std::vector<osg::ref_ptr<CompileScriptItem> >::iterator iter (items.begin());
+                iter!=items.end(); ++iter)
+                workQueue->addWorkItem (*iter);
+
+            for (std::vector<osg::ref_ptr<CompileScriptItem> >::iterator iter (items.begin());
+                iter!=items.end(); ++iter)
+            {
+                (*iter)->waitTillDone();
+                listener.increaseProgress();
+            }
+        }
+
+        // The workers are done, so mScripts can be modified again
+        for (std::vector<osg::ref_ptr<CompileScriptItem> >::const_iterator iter (items.begin());
+            iter!=items.end(); ++iter)
+        {
+            const CompileScriptItem& item = **iter;
+
+            std::cerr << item.getErrors();
+
+            if (!item.getSuccess())
+            {
+                std::cerr << "compiling failed: " << item.getName() << std::endl;
+                if (mVerbose)
+                    std::cerr << item.getText() << std::endl << std::endl;
+                continue;
+            }
+
+            ++success;
+            mScripts.insert (std::make_pair (item.getName(), CompiledScript (item.getByteCode(), item.getLocals())));
+            mLocalSlots.clear();
+
+            if (mCache.get())
+                mCache->add (item.getName(), item.getText(), item.getByteCode(), item.getLocals());
+        }
+
+        if (mCache.get())
+            mCache->save();
+
+        return std::make_pair (count, success);
+    }
+
     const Compiler::Locals& ScriptManager::getLocals (const std::string& name)
     {
         std::string name2 = Misc::StringUtils::lowerCase (name);
@@ -160,7 +415,7 @@ namespace MWScript
             ScriptCollection::iterator iter = mScripts.find (name2);
 
             if (iter!=mScripts.end())
-                return iter->second.second;
+                return iter->second.mLocals;
         }
 
         {
@@ -179,7 +434,7 @@ namespace MWScript
 
             Compiler::Locals locals;
 
-            std::istringstream stream (script->mScriptText);
+            std::istringstream stream (mStore.getPayloads().getScriptText (*script));
             Compiler::QuickFileParser parser (mErrorHandler, mCompilerContext, locals);
             Compiler::Scanner scanner (mErrorHandler, stream, mCompilerContext.getExtensions());
             scanner.scan (parser);
@@ -193,8 +448,36 @@ namespace MWScript
         throw std::logic_error ("script " + name + " does not exist");
     }
 
+    std::pair<char, int> ScriptManager::getLocalSlot (const std::string& name, const std::string& variable)
+    {
+        std::map<std::string, std::map<std::string, std::pair<char, int> > >::iterator script =
+            mLocalSlots.find (name);
+
+        if (script!=mLocalSlots.end())
+        {
+            std::map<std::string, std::pair<char, int> >::const_iterator slot = script->second.find (variable);
+
+            if (slot!=script->second.end())
+                return slot->second;
+        }
+
+        const Compiler::Locals& locals = getLocals (name);
+
+        std::pair<char, int> slot (locals.getType (variable), -1);
+        if (slot.first!=' ')
+            slot.second = locals.searchIndex (slot.first, variable);
+
+        mLocalSlots[name][variable] = slot;
+        return slot;
+    }
+
     GlobalScripts& ScriptManager::getGlobalScripts()
     {
         return mGlobalScripts;
     }
+
+    ScriptProfiler& ScriptManager::getProfiler()
+    {
+        return mProfiler;
+    }
 }
@@ -2,6 +2,7 @@
 #define GAME_SCRIPT_SCRIPTMANAGER_H
 
 #include <map>
+#include <memory>
 #include <string>
 
 #include <components/compiler/streamerrorhandler.hpp>
@@ -13,6 +14,7 @@
 #include "../mwbase/scriptmanager.hpp"
 
 #include "globalscripts.hpp"
+#include "scriptprofiler.hpp"
 
 namespace MWWorld
 {
@@ -30,8 +32,15 @@ namespace Interpreter
     class Interpreter;
 }
 
+namespace Loading
+{
+    class Listener;
+}
+
 namespace MWScript
 {
+    class ScriptCache;
+
     class ScriptManager : public MWBase::ScriptManager
     {
             Compiler::StreamErrorHandler mErrorHandler;
@@ -41,14 +50,36 @@ namespace MWScript
             Compiler::FileParser mParser;
             Interpreter::Interpreter mInterpreter;
             bool mOpcodesInstalled;
+            int mWarningsMode;
+            bool mOptimize;
+            std::auto_ptr<ScriptCache> mCache;
+
+            struct CompiledScript
+            {
+                std::vector<Interpreter::Type_Code> mByteCode;
+                /// mByteCode with the opcodes looked up, filled when the script is run for the first time
+                Interpreter::DecodedCode mDecoded;
+                Compiler::Locals mLocals;
+
+                CompiledScript (const std::vector<Interpreter::Type_Code>& byteCode, const Compiler::Locals& locals)
+                : mByteCode (byteCode), mLocals (locals)
+                {}
+            };
 
-            typedef std::pair<std::vector<Interpreter::Type_Code>, Compiler::Locals> CompiledScript;
             typedef std::map<std::string, CompiledScript> ScriptCollection;
 
             ScriptCollection mScripts;
             GlobalScripts mGlobalScripts;
             std::map<std::string, Compiler::Locals> mOtherLocals;
+
+            /// Results of getLocalSlot, by script name and variable name as passed to getLocalSlot
+            /// \note Cleared when a script is added to mScripts, which can change its locals.
+            std::map<std::string, std::map<std::string, std::pair<char, int> > > mLocalSlots;
             std::vector<std::string> mScriptBlacklist;
+            ScriptProfiler mProfiler;
+
+            bool loadFromCache (const std::string& name, const std::string& text);
+            ///< Add script \a name from the cache, if \a text has been compiled before.
 
         public:
 
@@ -56,6 +87,20 @@ namespace MWScript
                 Compiler::Context& compilerContext, int warningsMode,
                 const std::vector<std::string>& scriptBlacklist);
 
+            virtual ~ScriptManager();
+
+            void setOptimize (bool optimize);
+            ///< Run Compiler::optimize on scripts compiled from now on.
+
+            void setCache (ScriptCache *cache);
+            ///< Take compiled scripts from \a cache and add newly compiled ones to it. The cache is
+            /// written by precompile() and when the script manager is destroyed.
+            /// \note Ownership of \a cache is transferred to *this.
+
+            std::pair<int, int> precompile (int threads, Loading::Listener& listener);
+            ///< Compile all scripts that are not compiled yet, on \a threads worker threads.
+            /// \return count, success
+
             virtual void run (const std::string& name, Interpreter::Context& interpreterContext);
             ///< Run the script with the given name (compile first, if not compiled yet)
 
@@ -70,7 +115,13 @@ namespace MWScript
             virtual const Compiler::Locals& getLocals (const std::string& name);
             ///< Return locals for script \a name.
 
+            virtual std::pair<char, int> getLocalSlot (const std::string& name, const std::string& variable);
+            ///< Return type ('s', 'l', 'f' or ' ' for none) and index of local \a variable of script \a name.
+            /// Each script and variable is only looked up once.
+
             virtual GlobalScripts& getGlobalScripts();
+
+            virtual ScriptProfiler& getProfiler();
     };
 }
 
@@ -0,0 +1,205 @@
+#include "scriptprofiler.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+
+#include <boost/filesystem/fstream.hpp>
+
+#include <components/compiler/extensions.hpp>
+
+namespace
+{
+    template<typename Key>
+    struct CompareTotal
+    {
+        typedef typename std::map<Key, MWScript::ScriptProfiler::Stats>::const_iterator Iterator;
+
+        bool operator() (Iterator left, Iterator right) const
+        {
+            return left->second.mTotal>right->second.mTotal;
+        }
+    };
+
+    /// \return Iterators to the elements of \a map, by total time, most first
+    template<typename Key>
+    std::vector<typename std::map<Key, MWScript::ScriptProfiler::Stats>::const_iterator> sortByTotal (
+        const std::map<Key, MWScript::ScriptProfiler::Stats>& map)
+    {
+        std::vector<typename std::map<Key, MWScript::ScriptProfiler::Stats>::const_iterator> sorted;
+
+        for (typename std::map<Key, MWScript::ScriptProfiler::Stats>::const_iterator iter (map.begin());
+            iter!=map.end(); ++iter)
+            sorted.push_back (iter);
+
+        std::stable_sort (sorted.begin(), sorted.end(), CompareTotal<Key>());
+
+        return sorted;
+    }
+
+    void writeStats (std::ostream& stream, const MWScript::ScriptProfiler::Stats& stats)
+    {
+        stream
+            << std::setw (10) << stats.mTotal * 1000
+            << std::setw (10) << stats.mCalls
+            << std::setw (10) << stats.mTotal * 1000 / stats.mCalls
+            << std::setw (10) << stats.mMax * 1000;
+    }
+
+    void writeCsv (std::ostream& stream, const std::string& type, const std::string& name,
+        const MWScript::ScriptProfiler::Stats& stats)
+    {
+        stream
+            << type << "," << name << "," << stats.mCalls << "," << stats.mTotal * 1000 << ","
+            << stats.mTotal * 1000 / stats.mCalls << "," << stats.mMax * 1000 << "\n";
+    }
+}
+
+namespace MWScript
+{
+    ScriptProfiler::Stats::Stats()
+    : mCalls (0), mTotal (0), mMax (0)
+    {}
+
+    void ScriptProfiler::Stats::add (double seconds)
+    {
+        ++mCalls;
+        mTotal += seconds;
+        mMax = std::max (mMax, seconds);
+    }
+
+    ScriptProfiler::ScriptProfiler (const Compiler::Extensions *extensions)
+    : mExtensions (extensions), mEnabled (false), mFrameRuns (0), mFrameSlowest (0)
+    {}
+
+    void ScriptProfiler::setEnabled (bool enabled)
+    {
+        mEnabled = enabled;
+    }
+
+    bool ScriptProfiler::isEnabled() const
+    {
+        return mEnabled;
+    }
+
+    void ScriptProfiler::setExportFile (const boost::filesystem::path& file)
+    {
+        mExportFile = file;
+    }
+
+    const boost::filesystem::path& ScriptProfiler::getExportFile() const
+    {
+        return mExportFile;
+    }
+
+    void ScriptProfiler::addRun (const std::string& script, double seconds)
+    {
+        mScripts[script].add (seconds);
+
+        ++mFrameRuns;
+        mFrameSlowest = std::max (mFrameSlowest, seconds);
+    }
+
+    void ScriptProfiler::beginInstruction (int segment, int opcode)
+    {
+        mInstructions.push_back (std::make_pair (Opcode (segment, opcode), osg::Timer::instance()->tick()));
+    }
+
+    void ScriptProfiler::endInstruction()
+    {
+        if (mInstructions.empty())
+            return;
+
+        osg::Timer_t end = osg::Timer::instance()->tick();
+
+        const std::pair<Opcode, osg::Timer_t>& instruction = mInstructions.back();
+        mOpcodes[instruction.first].add (osg::Timer::instance()->delta_s (instruction.second, end));
+
+        mInstructions.pop_back();
+    }
+
+    void ScriptProfiler::getFrameStats (unsigned long& runs, double& slowest)
+    {
+        runs = mFrameRuns;
+        slowest = mFrameSlowest;
+
+        mFrameRuns = 0;
+        mFrameSlowest = 0;
+    }
+
+    void ScriptProfiler::clear()
+    {
+        mScripts.clear();
+        mOpcodes.clear();
+    }
+
+    std::string ScriptProfiler::getOpcodeName (const Opcode& opcode) const
+    {
+        std::ostringstream name;
+
+        bool explicitReference = false;
+        std::string keyword = mExtensions ? mExtensions->findKeyword (opcode.first, opcode.second, explicitReference) : "";
+
+        if (!keyword.empty())
+            name << keyword << (explicitReference ? " (explicit)" : "");
+        else
+            name << "segment " << opcode.first << " opcode " << opcode.second;
+
+        return name.str();
+    }
+
+    void ScriptProfiler::report (std::ostream& stream, std::size_t lines) const
+    {
+        std::vector<std::map<std::string, Stats>::const_iterator> scripts = sortByTotal (mScripts);
+        std::vector<std::map<Opcode, Stats>::const_iterator> opcodes = sortByTotal (mOpcodes);
+
+        stream << std::fixed << std::setprecision (3);
+
+        stream
+            << "Scripts by total time (" << mScripts.size() << "):\n"
+            << std::setw (10) << "total ms" << std::setw (10) << "runs" << std::setw (10) << "avg ms"
+            << std::setw (10) << "max ms" << "  script\n";
+
+        for (std::size_t i = 0; i<scripts.size() && i<lines; ++i)
+        {
+            writeStats (stream, scripts[i]->second);
+            stream << "  " << scripts[i]->first << "\n";
+        }
+
+        stream
+            << "Opcodes by total time (" << mOpcodes.size() << "):\n"
+            << std::setw (10) << "total ms" << std::setw (10) << "calls" << std::setw (10) << "avg ms"
+            << std::setw (10) << "max ms" << "  opcode\n";
+
+        for (std::size_t i = 0; i<opcodes.size() && i<lines; ++i)
+        {
+            writeStats (stream, opcodes[i]->second);
+            stream << "  " << getOpcodeName (opcodes[i]->first) << "\n";
+        }
+    }
+
+    void ScriptProfiler::save() const
+    {
+        boost::filesystem::ofstream stream (mExportFile);
+
+        if (!stream.is_open())
+            throw std::runtime_error ("can't open " + mExportFile.string() + " for writing");
+
+        stream << "type,name,calls,total ms,average ms,max ms\n";
+
+        std::vector<std::map<std::string, Stats>::const_iterator> scripts = sortByTotal (mScripts);
+
+        for (std::size_t i = 0; i<scripts.size(); ++i)
+            writeCsv (stream, "script", scripts[i]->first, scripts[i]->second);
+
+        std::vector<std::map<Opcode, Stats>::const_iterator> opcodes = sortByTotal (mOpcodes);
+
+        for (std::size_t i = 0; i<opcodes.size(); ++i)
+            writeCsv (stream, "opcode", getOpcodeName (opcodes[i]->first), opcodes[i]->second);
+
+        if (!stream.flush())
+            throw std::runtime_error ("write to " + mExportFile.string() + " failed");
+    }
+}
@@ -0,0 +1,98 @@
+#ifndef GAME_SCRIPT_SCRIPTPROFILER_H
+#define GAME_SCRIPT_SCRIPTPROFILER_H
+
+#include <iosfwd>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/filesystem/path.hpp>
+
+#include <osg/Timer>
+
+#include <components/interpreter/interpreter.hpp>
+
+namespace Compiler
+{
+    class Extensions;
+}
+
+namespace MWScript
+{
+    /// \brief Time spent in each script and in each opcode
+    ///
+    /// The script manager reports every script it runs and, while the profiler is enabled, lets the
+    /// interpreter report every instruction.
+    class ScriptProfiler : public Interpreter::Profiler
+    {
+        public:
+
+            struct Stats
+            {
+                unsigned long mCalls;
+
+                /// In seconds
+                double mTotal;
+                double mMax;
+
+                Stats();
+
+                void add (double seconds);
+            };
+
+            /// segment, opcode
+            typedef std::pair<int, int> Opcode;
+
+        private:
+
+            const Compiler::Extensions *mExtensions;
+            bool mEnabled;
+            std::map<std::string, Stats> mScripts;
+            std::map<Opcode, Stats> mOpcodes;
+
+            /// Instructions being executed, the last one is the innermost
+            std::vector<std::pair<Opcode, osg::Timer_t> > mInstructions;
+
+            unsigned long mFrameRuns;
+            double mFrameSlowest;
+
+            boost::filesystem::path mExportFile;
+
+            std::string getOpcodeName (const Opcode& opcode) const;
+
+        public:
+
+            explicit ScriptProfiler (const Compiler::Extensions *extensions = 0);
+            ///< \param extensions For naming the opcodes of instructions and functions (0: use numbers only).
+
+            void setEnabled (bool enabled);
+
+            bool isEnabled() const;
+
+            void setExportFile (const boost::filesystem::path& file);
+
+            const boost::filesystem::path& getExportFile() const;
+
+            void addRun (const std::string& script, double seconds);
+            ///< Script \a script has been run, which took \a seconds.
+
+            virtual void beginInstruction (int segment, int opcode);
+
+            virtual void endInstruction();
+
+            void getFrameStats (unsigned long& runs, double& slowest);
+            ///< Number of script runs and the time of the slowest one since the last call.
+
+            void clear();
+
+            void report (std::ostream& stream, std::size_t lines) const;
+            ///< Write the \a lines scripts and opcodes that took the most time.
+
+            void save() const;
+            ///< Write all scripts and opcodes as CSV to the export file.
+            /// \note Throws std::runtime_error if the file can't be written.
+    };
+}
+
+#endif
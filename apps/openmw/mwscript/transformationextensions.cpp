@@ -535,7 +535,7 @@ namespace MWScript
 
                     std::string axis = runtime.getStringLiteral (runtime[0].mInteger);
                     runtime.pop();
-                    Interpreter::Type_Float rotation = osg::DegreesToRadians(runtime[0].mFloat*MWBase::Environment::get().getFrameDuration());
+                    Interpreter::Type_Float rotation = osg::DegreesToRadians(runtime[0].mFloat*runtime.getContext().getSecondsPassed());
                     runtime.pop();
 
                     float ax = ptr.getRefData().getPosition().rot[0];
@@ -564,7 +564,7 @@ namespace MWScript
 
                     std::string axis = runtime.getStringLiteral (runtime[0].mInteger);
                     runtime.pop();
-                    Interpreter::Type_Float rotation = osg::DegreesToRadians(runtime[0].mFloat*MWBase::Environment::get().getFrameDuration());
+                    Interpreter::Type_Float rotation = osg::DegreesToRadians(runtime[0].mFloat*runtime.getContext().getSecondsPassed());
                     runtime.pop();
 
                     const float *objRot = ptr.getRefData().getPosition().rot;
@@ -629,7 +629,7 @@ namespace MWScript
 
                     std::string axis = runtime.getStringLiteral (runtime[0].mInteger);
                     runtime.pop();
-                    Interpreter::Type_Float movement = (runtime[0].mFloat*MWBase::Environment::get().getFrameDuration());
+                    Interpreter::Type_Float movement = (runtime[0].mFloat*runtime.getContext().getSecondsPassed());
                     runtime.pop();
 
                     osg::Vec3f posChange;
@@ -673,7 +673,7 @@ namespace MWScript
 
                     std::string axis = runtime.getStringLiteral (runtime[0].mInteger);
                     runtime.pop();
-                    Interpreter::Type_Float movement = (runtime[0].mFloat*MWBase::Environment::get().getFrameDuration());
+                    Interpreter::Type_Float movement = (runtime[0].mFloat*runtime.getContext().getSecondsPassed());
                     runtime.pop();
 
                     const float *objPos = ptr.getRefData().getPosition().pos;
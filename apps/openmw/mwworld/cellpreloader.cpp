@@ -7,6 +7,7 @@
 #include <components/resource/bulletshapemanager.hpp>
 #include <components/resource/keyframemanager.hpp>
 #include <components/misc/resourcehelpers.hpp>
+#include <components/vfs/manager.hpp>
 #include <components/nifosg/nifloader.hpp>
 #include <components/terrain/world.hpp>
 
@@ -45,7 +46,8 @@ namespace MWWorld
     {
     public:
         /// Constructor to be called from the main thread.
-        PreloadItem(MWWorld::CellStore* cell, Resource::SceneManager* sceneManager, Resource::BulletShapeManager* bulletShapeManager, Resource::KeyframeManager* keyframeManager, Terrain::World* terrain, bool preloadInstances)
+        /// @param refs References read for \a cell if it is not loaded, may be NULL.
+        PreloadItem(MWWorld::CellStore* cell, const CellStore::ContentRefList* refs, Resource::SceneManager* sceneManager, Resource::BulletShapeManager* bulletShapeManager, Resource::KeyframeManager* keyframeManager, Terrain::World* terrain, bool preloadInstances)
             : mIsExterior(cell->getCell()->isExterior())
             , mX(cell->getCell()->getGridX())
             , mY(cell->getCell()->getGridY())
@@ -60,6 +62,26 @@ namespace MWWorld
             {
                 cell->forEach(visitor);
             }
+            else if (refs)
+            {
+                for (CellStore::ContentRefList::const_iterator it = refs->begin(); it != refs->end(); ++it)
+                {
+                    if (it->second)
+                        continue;
+
+                    try
+                    {
+                        MWWorld::ManualRef ref(MWBase::Environment::get().getWorld()->getStore(), Misc::StringUtils::lowerCase(it->first.mRefID));
+                        std::string model = ref.getPtr().getClass().getModel(ref.getPtr());
+                        if (!model.empty())
+                            mMeshes.push_back(model);
+                    }
+                    catch (std::exception& e)
+                    {
+                        // unknown IDs are reported when the cell is loaded
+                    }
+                }
+            }
             else
             {
                 const std::vector<std::string>& objectIds = cell->getPreloadedIds();
@@ -78,12 +100,24 @@ namespace MWWorld
         /// Preload work to be called from the worker thread.
         virtual void doWork()
         {
+            for (MeshList::iterator it = mMeshes.begin(); it != mMeshes.end(); ++it)
+                *it = Misc::ResourceHelpers::correctActorModelPath(*it, mSceneManager->getVFS());
+
+            // Let the I/O thread read ahead while we're busy with the first meshes. Meshes that are in the cache
+            // already won't be read again, so don't hold a second copy of them.
+            MeshList uncached;
+            for (MeshList::const_iterator it = mMeshes.begin(); it != mMeshes.end(); ++it)
+            {
+                if (!mSceneManager->isTemplateCached(*it))
+                    uncached.push_back(*it);
+            }
+            mSceneManager->getVFS()->prefetch(uncached);
+
             for (MeshList::const_iterator it = mMeshes.begin(); it != mMeshes.end(); ++it)
             {
                 try
                 {
                     std::string mesh  = *it;
-                    mesh = Misc::ResourceHelpers::correctActorModelPath(mesh, mSceneManager->getVFS());
 
                     if (mPreloadInstances)
                     {
@@ -147,6 +181,54 @@ namespace MWWorld
         std::vector<osg::ref_ptr<const osg::Object> > mPreloadedObjects;
     };
 
+    /// Worker thread item: read the references of a cell that is not loaded yet.
+    class ReadRefsItem : public SceneUtil::WorkItem
+    {
+    public:
+        /// Constructor to be called from the main thread.
+        ReadRefsItem(const ESM::Cell* cell, ESM::ReaderPool& readers)
+            : mCell(cell)
+            , mReaders(readers)
+            , mTaken(false)
+        {
+        }
+
+        virtual void doWork()
+        {
+            readContentRefs(*mCell, mReaders, mRefs);
+        }
+
+        const ESM::Cell* getCell() const
+        {
+            return mCell;
+        }
+
+        /// @note Only to be used once the work is done.
+        const CellStore::ContentRefList* getRefs() const
+        {
+            return mTaken ? NULL : &mRefs;
+        }
+
+        /// Move the references to \a refs.
+        /// @note Only to be used once the work is done.
+        bool take(CellStore::ContentRefList& refs)
+        {
+            if (mTaken)
+                return false;
+
+            refs.swap(mRefs);
+            mRefs.clear();
+            mTaken = true;
+            return true;
+        }
+
+    private:
+        const ESM::Cell* mCell;
+        ESM::ReaderPool& mReaders;
+        CellStore::ContentRefList mRefs;
+        bool mTaken;
+    };
+
     /// Worker thread item: update the resource system's cache, effectively deleting unused entries.
     class UpdateCacheItem : public SceneUtil::WorkItem
     {
@@ -171,10 +253,11 @@ namespace MWWorld
         Terrain::World* mTerrain;
     };
 
-    CellPreloader::CellPreloader(Resource::ResourceSystem* resourceSystem, Resource::BulletShapeManager* bulletShapeManager, Terrain::World* terrain)
+    CellPreloader::CellPreloader(Resource::ResourceSystem* resourceSystem, Resource::BulletShapeManager* bulletShapeManager, Terrain::World* terrain, ESM::ReaderPool& readers)
         : mResourceSystem(resourceSystem)
         , mBulletShapeManager(bulletShapeManager)
         , mTerrain(terrain)
+        , mReaders(readers)
         , mExpiryDelay(0.0)
         , mMinCacheSize(0)
         , mMaxCacheSize(0)
@@ -185,7 +268,12 @@ namespace MWWorld
     CellPreloader::~CellPreloader()
     {
         for (PreloadMap::iterator it = mPreloadCells.begin(); it != mPreloadCells.end();++it)
-            it->second.mWorkItem->waitTillDone();
+        {
+            if (it->second.mWorkItem)
+                it->second.mWorkItem->waitTillDone();
+            if (it->second.mRefsItem)
+                it->second.mRefsItem->waitTillDone();
+        }
         mPreloadCells.clear();
     }
 
@@ -196,17 +284,21 @@ namespace MWWorld
             std::cerr << "can't preload, no work queue set " << std::endl;
             return;
         }
-        if (cell->getState() == CellStore::State_Unloaded)
-        {
-            std::cerr << "can't preload objects for unloaded cell" << std::endl;
-            return;
-        }
 
         PreloadMap::iterator found = mPreloadCells.find(cell);
         if (found != mPreloadCells.end())
         {
             // already preloaded, nothing to do other than updating the timestamp
             found->second.mTimeStamp = timestamp;
+
+            // unless the references have been read in the meantime, then the objects can be preloaded now
+            PreloadEntry& entry = found->second;
+            if (!entry.mWorkItem && entry.mRefsItem->isDone())
+            {
+                const ReadRefsItem* refsItem = static_cast<const ReadRefsItem*>(entry.mRefsItem.get());
+                entry.mWorkItem = new PreloadItem(cell, refsItem->getRefs(), mResourceSystem->getSceneManager(), mBulletShapeManager, mResourceSystem->getKeyframeManager(), mTerrain, mPreloadInstances);
+                mWorkQueue->addWorkItem(entry.mWorkItem);
+            }
             return;
         }
 
@@ -231,10 +323,35 @@ namespace MWWorld
                 return;
         }
 
-        osg::ref_ptr<PreloadItem> item (new PreloadItem(cell, mResourceSystem->getSceneManager(), mBulletShapeManager, mResourceSystem->getKeyframeManager(), mTerrain, mPreloadInstances));
+        if (cell->getState() != CellStore::State_Loaded)
+        {
+            // read the references first, so that the main thread doesn't have to when the cell becomes active
+            osg::ref_ptr<ReadRefsItem> refsItem (new ReadRefsItem(cell->getCell(), mReaders));
+            mWorkQueue->addWorkItem(refsItem);
+
+            mPreloadCells[cell] = PreloadEntry(timestamp, NULL, refsItem);
+            return;
+        }
+
+        osg::ref_ptr<PreloadItem> item (new PreloadItem(cell, NULL, mResourceSystem->getSceneManager(), mBulletShapeManager, mResourceSystem->getKeyframeManager(), mTerrain, mPreloadInstances));
         mWorkQueue->addWorkItem(item);
 
-        mPreloadCells[cell] = PreloadEntry(timestamp, item);
+        mPreloadCells[cell] = PreloadEntry(timestamp, item, NULL);
+    }
+
+    bool CellPreloader::takeRefs(CellStore *cell, CellStore::ContentRefList& refs)
+    {
+        PreloadMap::iterator found = mPreloadCells.find(cell);
+        if (found == mPreloadCells.end() || !found->second.mRefsItem || !found->second.mRefsItem->isDone())
+            return false;
+
+        ReadRefsItem* refsItem = static_cast<ReadRefsItem*>(found->second.mRefsItem.get());
+
+        // the cell store could have been replaced by another one at the same address
+        if (refsItem->getCell() != cell->getCell())
+            return false;
+
+        return refsItem->take(refs);
     }
 
     void CellPreloader::notifyLoaded(CellStore *cell)
@@ -5,6 +5,8 @@
 #include <osg/ref_ptr>
 #include <components/sceneutil/workqueue.hpp>
 
+#include "cellstore.hpp"
+
 namespace Resource
 {
     class ResourceSystem;
@@ -16,20 +18,28 @@ namespace Terrain
     class World;
 }
 
-namespace MWWorld
+namespace ESM
 {
-    class CellStore;
+    class ReaderPool;
+}
 
+namespace MWWorld
+{
     class CellPreloader
     {
     public:
-        CellPreloader(Resource::ResourceSystem* resourceSystem, Resource::BulletShapeManager* bulletShapeManager, Terrain::World* terrain);
+        CellPreloader(Resource::ResourceSystem* resourceSystem, Resource::BulletShapeManager* bulletShapeManager, Terrain::World* terrain, ESM::ReaderPool& readers);
         ~CellPreloader();
 
         /// Ask a background thread to preload rendering meshes and collision shapes for objects in this cell.
-        /// @note The cell itself must be in State_Loaded or State_Preloaded.
+        /// @par If the cell is not loaded yet, the background thread reads its references from the content files first,
+        /// see takeRefs(). The objects are then preloaded by a later call for the same cell.
         void preload(MWWorld::CellStore* cell, double timestamp);
 
+        /// Take the references of \a cell that were read in the background, to load the cell with.
+        /// @return Were the references read already? If not, \a refs is left unchanged.
+        bool takeRefs(MWWorld::CellStore* cell, CellStore::ContentRefList& refs);
+
         void notifyLoaded(MWWorld::CellStore* cell);
 
         /// Removes preloaded cells that have not had a preload request for a while.
@@ -55,6 +65,7 @@ namespace MWWorld
         Resource::ResourceSystem* mResourceSystem;
         Resource::BulletShapeManager* mBulletShapeManager;
         Terrain::World* mTerrain;
+        ESM::ReaderPool& mReaders;
         osg::ref_ptr<SceneUtil::WorkQueue> mWorkQueue;
         double mExpiryDelay;
         unsigned int mMinCacheSize;
@@ -63,9 +74,10 @@ namespace MWWorld
 
         struct PreloadEntry
         {
-            PreloadEntry(double timestamp, osg::ref_ptr<SceneUtil::WorkItem> workItem)
+            PreloadEntry(double timestamp, osg::ref_ptr<SceneUtil::WorkItem> workItem, osg::ref_ptr<SceneUtil::WorkItem> refsItem)
                 : mTimeStamp(timestamp)
                 , mWorkItem(workItem)
+                , mRefsItem(refsItem)
             {
             }
             PreloadEntry()
@@ -74,7 +86,10 @@ namespace MWWorld
             }
 
             double mTimeStamp;
+            // Preloads the objects, NULL until the references of an unloaded cell have been read
             osg::ref_ptr<SceneUtil::WorkItem> mWorkItem;
+            // Reads the references of a cell that was not loaded when the preloading started, may be NULL
+            osg::ref_ptr<SceneUtil::WorkItem> mRefsItem;
         };
         typedef std::map<const MWWorld::CellStore*, PreloadEntry> PreloadMap;
 
@@ -22,7 +22,8 @@ namespace MWWorld
         /// and the build will fail with an ugly three-way cyclic header dependence
         /// so we need to pass the instantiation of the method to the linker, when
         /// all methods are known.
-        void load (ESM::CellRef &ref, bool deleted, const MWWorld::ESMStore &esmStore);
+        /// @param isNew Is the reference known not to be in the list yet? Saves searching for it.
+        void load (ESM::CellRef &ref, bool deleted, const MWWorld::ESMStore &esmStore, bool isNew = false);
 
         LiveRef &insert (const LiveRef &item)
         {
@@ -1,5 +1,6 @@
 #include "cells.hpp"
 
+#include <algorithm>
 #include <iostream>
 
 #include <components/esm/esmreader.hpp>
@@ -16,6 +17,34 @@
 #include "containerstore.hpp"
 #include "cellstore.hpp"
 
+namespace
+{
+    /// Order in which Cells::getPtr searches cells: loaded cells first, then the others. Within each group exteriors
+    /// first, in reverse grid order, then interiors by name.
+    /// Searching exteriors in reverse is a workaround for an ambiguous chargen_plank reference in the vanilla game.
+    /// There is one at -22,16 and one at -2,-9, the latter should be used.
+    bool searchOrder (const MWWorld::CellStore *left, const MWWorld::CellStore *right)
+    {
+        bool leftLoaded = left->getState()==MWWorld::CellStore::State_Loaded;
+        bool rightLoaded = right->getState()==MWWorld::CellStore::State_Loaded;
+
+        if (leftLoaded != rightLoaded)
+            return leftLoaded;
+
+        const ESM::Cell *leftCell = left->getCell();
+        const ESM::Cell *rightCell = right->getCell();
+
+        if (leftCell->isExterior() != rightCell->isExterior())
+            return leftCell->isExterior();
+
+        if (leftCell->isExterior())
+            return std::make_pair (leftCell->getGridX(), leftCell->getGridY()) >
+                   std::make_pair (rightCell->getGridX(), rightCell->getGridY());
+
+        return Misc::StringUtils::ciLess (leftCell->mName, rightCell->mName);
+    }
+}
+
 MWWorld::CellStore *MWWorld::Cells::getCellStore (const ESM::Cell *cell)
 {
     if (cell->mData.mFlags & ESM::Cell::Interior)
@@ -25,7 +54,7 @@ MWWorld::CellStore *MWWorld::Cells::getCellStore (const ESM::Cell *cell)
 
         if (result==mInteriors.end())
         {
-            result = mInteriors.insert (std::make_pair (lowerName, CellStore (cell, mStore, mReader))).first;
+            result = mInteriors.insert (std::make_pair (lowerName, CellStore (cell, mStore, mReaders, &mRefIdIndex))).first;
         }
 
         return &result->second;
@@ -38,7 +67,7 @@ MWWorld::CellStore *MWWorld::Cells::getCellStore (const ESM::Cell *cell)
         if (result==mExteriors.end())
         {
             result = mExteriors.insert (std::make_pair (
-                std::make_pair (cell->getGridX(), cell->getGridY()), CellStore (cell, mStore, mReader))).first;
+                std::make_pair (cell->getGridX(), cell->getGridY()), CellStore (cell, mStore, mReaders, &mRefIdIndex))).first;
 
         }
 
@@ -50,23 +79,26 @@ void MWWorld::Cells::clear()
 {
     mInteriors.clear();
     mExteriors.clear();
-    std::fill(mIdCache.begin(), mIdCache.end(), std::make_pair("", (MWWorld::CellStore*)0));
-    mIdCacheIndex = 0;
+    mRefIdIndex.clearDynamic();
 }
 
-MWWorld::Ptr MWWorld::Cells::getPtrAndCache (const std::string& name, CellStore& cellStore)
+void MWWorld::Cells::getCandidateCells (const std::string& name, std::vector<CellStore*>& out)
 {
-    Ptr ptr = getPtr (name, cellStore);
+    mRefIdIndex.buildPending();
 
-    if (!ptr.isEmpty() && ptr.isInCell())
-    {
-        mIdCache[mIdCacheIndex].first = name;
-        mIdCache[mIdCacheIndex].second = &cellStore;
-        if (++mIdCacheIndex>=mIdCache.size())
-            mIdCacheIndex = 0;
-    }
+    Misc::StringAtom id;
+    if (!Misc::StringAtom::find (name, id))
+        return;
+
+    if (const RefIdIndex::ContentCells *cells = mRefIdIndex.getContentCells (id))
+        for (RefIdIndex::ContentCells::const_iterator iter (cells->begin()); iter!=cells->end(); ++iter)
+            out.push_back (getCellStore (*iter));
+
+    if (const RefIdIndex::DynamicCells *cells = mRefIdIndex.getDynamicCells (id))
+        out.insert (out.end(), cells->begin(), cells->end());
 
-    return ptr;
+    std::sort (out.begin(), out.end(), searchOrder);
+    out.erase (std::unique (out.begin(), out.end()), out.end());
 }
 
 void MWWorld::Cells::writeCell (ESM::ESMWriter& writer, CellStore& cell) const
@@ -86,13 +118,16 @@ void MWWorld::Cells::writeCell (ESM::ESMWriter& writer, CellStore& cell) const
     writer.endRecord (ESM::REC_CSTA);
 }
 
-MWWorld::Cells::Cells (const MWWorld::ESMStore& store, std::vector<ESM::ESMReader>& reader)
-: mStore (store), mReader (reader),
-  mIdCache (40, std::pair<std::string, CellStore *> ("", (CellStore*)0)), /// \todo make cache size configurable
-  mIdCacheIndex (0)
+MWWorld::Cells::Cells (const MWWorld::ESMStore& store, ESM::ReaderPool& readers)
+: mStore (store), mReaders (readers)
 {}
 
-MWWorld::CellStore *MWWorld::Cells::getExterior (int x, int y)
+void MWWorld::Cells::indexRefs()
+{
+    mRefIdIndex.buildLater (mStore.get<ESM::Cell>(), mReaders);
+}
+
+MWWorld::CellStore *MWWorld::Cells::getExterior (int x, int y, bool load)
 {
     std::map<std::pair<int, int>, CellStore>::iterator result =
         mExteriors.find (std::make_pair (x, y));
@@ -116,10 +151,10 @@ MWWorld::CellStore *MWWorld::Cells::getExterior (int x, int y)
         }
 
         result = mExteriors.insert (std::make_pair (
-            std::make_pair (x, y), CellStore (cell, mStore, mReader))).first;
+            std::make_pair (x, y), CellStore (cell, mStore, mReaders, &mRefIdIndex))).first;
     }
 
-    if (result->second.getState()!=CellStore::State_Loaded)
+    if (load && result->second.getState()!=CellStore::State_Loaded)
     {
         result->second.load ();
     }
@@ -136,7 +171,7 @@ MWWorld::CellStore *MWWorld::Cells::getInterior (const std::string& name)
     {
         const ESM::Cell *cell = mStore.get<ESM::Cell>().find(lowerName);
 
-        result = mInteriors.insert (std::make_pair (lowerName, CellStore (cell, mStore, mReader))).first;
+        result = mInteriors.insert (std::make_pair (lowerName, CellStore (cell, mStore, mReaders, &mRefIdIndex))).first;
     }
 
     if (result->second.getState()!=CellStore::State_Loaded)
@@ -184,55 +219,12 @@ MWWorld::Ptr MWWorld::Cells::getPtr (const std::string& name, CellStore& cell,
 
 MWWorld::Ptr MWWorld::Cells::getPtr (const std::string& name)
 {
-    // First check the cache
-    for (std::vector<std::pair<std::string, CellStore *> >::iterator iter (mIdCache.begin());
-        iter!=mIdCache.end(); ++iter)
-        if (iter->first==name && iter->second)
-        {
-            Ptr ptr = getPtr (name, *iter->second);
-            if (!ptr.isEmpty())
-                return ptr;
-        }
+    std::vector<CellStore*> cells;
+    getCandidateCells (name, cells);
 
-    // Then check cells that are already listed
-    // Search in reverse, this is a workaround for an ambiguous chargen_plank reference in the vanilla game.
-    // there is one at -22,16 and one at -2,-9, the latter should be used.
-    for (std::map<std::pair<int, int>, CellStore>::reverse_iterator iter = mExteriors.rbegin();
-        iter!=mExteriors.rend(); ++iter)
+    for (std::vector<CellStore*>::iterator iter (cells.begin()); iter!=cells.end(); ++iter)
     {
-        Ptr ptr = getPtrAndCache (name, iter->second);
-        if (!ptr.isEmpty())
-            return ptr;
-    }
-
-    for (std::map<std::string, CellStore>::iterator iter = mInteriors.begin();
-        iter!=mInteriors.end(); ++iter)
-    {
-        Ptr ptr = getPtrAndCache (name, iter->second);
-        if (!ptr.isEmpty())
-            return ptr;
-    }
-
-    // Now try the other cells
-    const MWWorld::Store<ESM::Cell> &cells = mStore.get<ESM::Cell>();
-    MWWorld::Store<ESM::Cell>::iterator iter;
-
-    for (iter = cells.extBegin(); iter != cells.extEnd(); ++iter)
-    {
-        CellStore *cellStore = getCellStore (&(*iter));
-
-        Ptr ptr = getPtrAndCache (name, *cellStore);
-
-        if (!ptr.isEmpty())
-            return ptr;
-    }
-
-    for (iter = cells.intBegin(); iter != cells.intEnd(); ++iter)
-    {
-        CellStore *cellStore = getCellStore (&(*iter));
-
-        Ptr ptr = getPtrAndCache (name, *cellStore);
-
+        Ptr ptr = getPtr (name, **iter);
         if (!ptr.isEmpty())
             return ptr;
     }
@@ -243,12 +235,15 @@ MWWorld::Ptr MWWorld::Cells::getPtr (const std::string& name)
 
 void MWWorld::Cells::getExteriorPtrs(const std::string &name, std::vector<MWWorld::Ptr> &out)
 {
-    const MWWorld::Store<ESM::Cell> &cells = mStore.get<ESM::Cell>();
-    for (MWWorld::Store<ESM::Cell>::iterator iter = cells.extBegin(); iter != cells.extEnd(); ++iter)
+    std::vector<CellStore*> cells;
+    getCandidateCells (name, cells);
+
+    for (std::vector<CellStore*>::iterator iter (cells.begin()); iter!=cells.end(); ++iter)
     {
-        CellStore *cellStore = getCellStore (&(*iter));
+        if (!(*iter)->isExterior())
+            continue;
 
-        Ptr ptr = getPtrAndCache (name, *cellStore);
+        Ptr ptr = getPtr (name, **iter);
 
         if (!ptr.isEmpty())
             out.push_back(ptr);
@@ -257,12 +252,15 @@ void MWWorld::Cells::getExteriorPtrs(const std::string &name, std::vector<MWWorl
 
 void MWWorld::Cells::getInteriorPtrs(const std::string &name, std::vector<MWWorld::Ptr> &out)
 {
-    const MWWorld::Store<ESM::Cell> &cells = mStore.get<ESM::Cell>();
-    for (MWWorld::Store<ESM::Cell>::iterator iter = cells.intBegin(); iter != cells.intEnd(); ++iter)
+    std::vector<CellStore*> cells;
+    getCandidateCells (name, cells);
+
+    for (std::vector<CellStore*>::iterator iter (cells.begin()); iter!=cells.end(); ++iter)
     {
-        CellStore *cellStore = getCellStore (&(*iter));
+        if ((*iter)->isExterior())
+            continue;
 
-        Ptr ptr = getPtrAndCache (name, *cellStore);
+        Ptr ptr = getPtr (name, **iter);
 
         if (!ptr.isEmpty())
             out.push_back(ptr);
@@ -6,11 +6,12 @@
 #include <string>
 
 #include "ptr.hpp"
+#include "refidindex.hpp"
 
 namespace ESM
 {
-    class ESMReader;
     class ESMWriter;
+    class ReaderPool;
     struct CellId;
     struct Cell;
 }
@@ -28,18 +29,18 @@ namespace MWWorld
     class Cells
     {
             const MWWorld::ESMStore& mStore;
-            std::vector<ESM::ESMReader>& mReader;
+            ESM::ReaderPool& mReaders;
             mutable std::map<std::string, CellStore> mInteriors;
             mutable std::map<std::pair<int, int>, CellStore> mExteriors;
-            std::vector<std::pair<std::string, CellStore *> > mIdCache;
-            std::size_t mIdCacheIndex;
+            RefIdIndex mRefIdIndex;
 
             Cells (const Cells&);
             Cells& operator= (const Cells&);
 
             CellStore *getCellStore (const ESM::Cell *cell);
 
-            Ptr getPtrAndCache (const std::string& name, CellStore& cellStore);
+            /// Get the cells that may hold a reference to \a name, in the order getPtr searches them.
+            void getCandidateCells (const std::string& name, std::vector<CellStore*>& out);
 
             void writeCell (ESM::ESMWriter& writer, CellStore& cell) const;
 
@@ -47,9 +48,13 @@ namespace MWWorld
 
             void clear();
 
-            Cells (const MWWorld::ESMStore& store, std::vector<ESM::ESMReader>& reader);
+            Cells (const MWWorld::ESMStore& store, ESM::ReaderPool& readers);
 
-            CellStore *getExterior (int x, int y);
+            void indexRefs();
+            ///< List the references of all cells on the first lookup by ID. Call after the content files have been loaded.
+
+            CellStore *getExterior (int x, int y, bool load = true);
+            ///< @param load Load the references of the cell? If false, the cell may be returned in any state.
 
             CellStore *getInterior (const std::string& name);
 
@@ -63,12 +68,12 @@ namespace MWWorld
             Ptr getPtr (const std::string& name);
 
             /// Get all Ptrs referencing \a name in exterior cells
-            /// @note Due to the current implementation of getPtr this only supports one Ptr per cell.
+            /// @note Only supports one Ptr per cell.
             /// @note name must be lower case
             void getExteriorPtrs (const std::string& name, std::vector<MWWorld::Ptr>& out);
 
             /// Get all Ptrs referencing \a name in interior cells
-            /// @note Due to the current implementation of getPtr this only supports one Ptr per cell.
+            /// @note Only supports one Ptr per cell.
             /// @note name must be lower case
             void getInteriorPtrs (const std::string& name, std::vector<MWWorld::Ptr>& out);
 
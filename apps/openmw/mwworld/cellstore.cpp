@@ -6,6 +6,7 @@
 #include <components/esm/cellstate.hpp>
 #include <components/esm/cellid.hpp>
 #include <components/esm/esmreader.hpp>
+#include <components/esm/readerpool.hpp>
 #include <components/esm/esmwriter.hpp>
 #include <components/esm/objectstate.hpp>
 #include <components/esm/containerstate.hpp>
@@ -24,6 +25,8 @@
 #include "esmstore.hpp"
 #include "class.hpp"
 #include "containerstore.hpp"
+#include "refidindex.hpp"
+#include "contentrefs.hpp"
 
 namespace
 {
@@ -172,13 +175,13 @@ namespace MWWorld
 {
 
     template <typename X>
-    void CellRefList<X>::load(ESM::CellRef &ref, bool deleted, const MWWorld::ESMStore &esmStore)
+    void CellRefList<X>::load(ESM::CellRef &ref, bool deleted, const MWWorld::ESMStore &esmStore, bool isNew)
     {
         const MWWorld::Store<X> &store = esmStore.get<X>();
 
         if (const X *ptr = store.search (ref.mRefID))
         {
-            typename std::list<LiveRef>::iterator iter =
+            typename std::list<LiveRef>::iterator iter = isNew ? mList.end() :
                 std::find(mList.begin(), mList.end(), ref.mRefNum);
 
             LiveRef liveCellRef (ref, ptr);
@@ -222,6 +225,7 @@ namespace MWWorld
             mMovedHere.insert(std::make_pair(object.getBase(), from));
         }
         updateMergedRefs();
+        indexRef(object.getBase());
     }
 
     MWWorld::Ptr CellStore::moveTo(const Ptr &object, CellStore *cellToMoveTo)
@@ -317,10 +321,14 @@ namespace MWWorld
         visitor.merge();
     }
 
-    CellStore::CellStore (const ESM::Cell *cell, const MWWorld::ESMStore& esmStore, std::vector<ESM::ESMReader>& readerList)
-        : mStore(esmStore), mReader(readerList), mCell (cell), mState (State_Unloaded), mHasState (false), mLastRespawn(0,0)
+    CellStore::CellStore (const ESM::Cell *cell, const MWWorld::ESMStore& esmStore, ESM::ReaderPool& readers,
+                          RefIdIndex* refIdIndex)
+        : mStore(esmStore), mReaders(readers), mRefIdIndex(refIdIndex), mCell (cell), mState (State_Unloaded), mHasState (false), mLastRespawn(0,0)
     {
         mWaterLevel = cell->mWater;
+
+        for (ESM::MovedCellRefTracker::const_iterator it = cell->mMovedRefs.begin(); it != cell->mMovedRefs.end(); ++it)
+            mMovedRefNums.insert(it->mRefNum);
     }
 
     const ESM::Cell *CellStore::getCell() const
@@ -425,13 +433,23 @@ namespace MWWorld
     }
 
     void CellStore::load ()
+    {
+        if (mState!=State_Loaded)
+        {
+            ContentRefList refs;
+            readContentRefs (*mCell, mReaders, refs);
+            load (refs);
+        }
+    }
+
+    void CellStore::load (ContentRefList& refs)
     {
         if (mState!=State_Loaded)
         {
             if (mState==State_Preloaded)
                 mIds.clear();
 
-            loadRefs ();
+            loadRefs (refs);
 
             mState = State_Loaded;
 
@@ -453,105 +471,37 @@ namespace MWWorld
 
     void CellStore::listRefs()
     {
-        std::vector<ESM::ESMReader>& esm = mReader;
-
         assert (mCell);
 
-        if (mCell->mContextList.empty())
-            return; // this is a dynamically generated cell -> skipping.
-
-        // Load references from all plugins that do something with this cell.
-        for (size_t i = 0; i < mCell->mContextList.size(); i++)
-        {
-            try
-            {
-                // Reopen the ESM reader and seek to the right position.
-                int index = mCell->mContextList.at(i).index;
-                mCell->restore (esm[index], i);
-
-                ESM::CellRef ref;
-
-                // Get each reference in turn
-                bool deleted = false;
-                while (mCell->getNextRef (esm[index], ref, deleted))
-                {
-                    if (deleted)
-                        continue;
-
-                    // Don't list reference if it was moved to a different cell.
-                    ESM::MovedCellRefTracker::const_iterator iter =
-                        std::find(mCell->mMovedRefs.begin(), mCell->mMovedRefs.end(), ref.mRefNum);
-                    if (iter != mCell->mMovedRefs.end()) {
-                        continue;
-                    }
-
-                    mIds.push_back (Misc::StringUtils::lowerCase (ref.mRefID));
-                }
-            }
-            catch (std::exception& e)
-            {
-                std::cerr << "An error occurred listing references for cell " << getCell()->getDescription() << ": " << e.what() << std::endl;
-            }
-        }
-
-        // List moved references, from separately tracked list.
-        for (ESM::CellRefTracker::const_iterator it = mCell->mLeasedRefs.begin(); it != mCell->mLeasedRefs.end(); ++it)
-        {
-            const ESM::CellRef &ref = *it;
-
-            mIds.push_back(Misc::StringUtils::lowerCase(ref.mRefID));
-        }
-
-        std::sort (mIds.begin(), mIds.end());
+        listContentRefIds (*mCell, mReaders, mIds);
     }
 
-    void CellStore::loadRefs()
+    void CellStore::indexRef (const LiveCellRefBase* ref)
     {
-        std::vector<ESM::ESMReader>& esm = mReader;
+        if (mRefIdIndex)
+            mRefIdIndex->add (ref->mRef.getRefId(), this);
+    }
 
+    void CellStore::loadRefs (ContentRefList& refs)
+    {
         assert (mCell);
 
         if (mCell->mContextList.empty())
             return; // this is a dynamically generated cell -> skipping.
 
-        // Load references from all plugins that do something with this cell.
-        for (size_t i = 0; i < mCell->mContextList.size(); i++)
-        {
-            try
-            {
-                // Reopen the ESM reader and seek to the right position.
-                int index = mCell->mContextList.at(i).index;
-                mCell->restore (esm[index], i);
-
-                ESM::CellRef ref;
-                ref.mRefNum.mContentFile = ESM::RefNum::RefNum_NoContentFile;
+        // References loaded so far. Only references in this set can be overridden by a later content file,
+        // all others are added without searching the lists.
+        RefNumSet loaded;
 
-                // Get each reference in turn
-                bool deleted = false;
-                while(mCell->getNextRef(esm[index], ref, deleted))
-                {
-                    // Don't load reference if it was moved to a different cell.
-                    ESM::MovedCellRefTracker::const_iterator iter =
-                        std::find(mCell->mMovedRefs.begin(), mCell->mMovedRefs.end(), ref.mRefNum);
-                    if (iter != mCell->mMovedRefs.end()) {
-                        continue;
-                    }
-
-                    loadRef (ref, deleted);
-                }
-            }
-            catch (std::exception& e)
-            {
-                std::cerr << "An error occurred loading references for cell " << getCell()->getDescription() << ": " << e.what() << std::endl;
-            }
-        }
+        for (ContentRefList::iterator it = refs.begin(); it != refs.end(); ++it)
+            loadRef (it->first, it->second, loaded.insert(it->first.mRefNum).second);
 
         // Load moved references, from separately tracked list.
         for (ESM::CellRefTracker::const_iterator it = mCell->mLeasedRefs.begin(); it != mCell->mLeasedRefs.end(); ++it)
         {
             ESM::CellRef &ref = const_cast<ESM::CellRef&>(*it);
 
-            loadRef (ref, false);
+            loadRef (ref, false, loaded.insert(ref.mRefNum).second);
         }
 
         updateMergedRefs();
@@ -582,7 +532,7 @@ namespace MWWorld
         return Ptr();
     }
 
-    void CellStore::loadRef (ESM::CellRef& ref, bool deleted)
+    void CellStore::loadRef (ESM::CellRef& ref, bool deleted, bool isNew)
     {
         Misc::StringUtils::lowerCaseInPlace (ref.mRefID);
 
@@ -590,27 +540,27 @@ namespace MWWorld
 
         switch (store.find (ref.mRefID))
         {
-            case ESM::REC_ACTI: mActivators.load(ref, deleted, store); break;
-            case ESM::REC_ALCH: mPotions.load(ref, deleted,store); break;
-            case ESM::REC_APPA: mAppas.load(ref, deleted, store); break;
-            case ESM::REC_ARMO: mArmors.load(ref, deleted, store); break;
-            case ESM::REC_BOOK: mBooks.load(ref, deleted, store); break;
-            case ESM::REC_CLOT: mClothes.load(ref, deleted, store); break;
-            case ESM::REC_CONT: mContainers.load(ref, deleted, store); break;
-            case ESM::REC_CREA: mCreatures.load(ref, deleted, store); break;
-            case ESM::REC_DOOR: mDoors.load(ref, deleted, store); break;
-            case ESM::REC_INGR: mIngreds.load(ref, deleted, store); break;
-            case ESM::REC_LEVC: mCreatureLists.load(ref, deleted, store); break;
-            case ESM::REC_LEVI: mItemLists.load(ref, deleted, store); break;
-            case ESM::REC_LIGH: mLights.load(ref, deleted, store); break;
-            case ESM::REC_LOCK: mLockpicks.load(ref, deleted, store); break;
-            case ESM::REC_MISC: mMiscItems.load(ref, deleted, store); break;
-            case ESM::REC_NPC_: mNpcs.load(ref, deleted, store); break;
-            case ESM::REC_PROB: mProbes.load(ref, deleted, store); break;
-            case ESM::REC_REPA: mRepairs.load(ref, deleted, store); break;
-            case ESM::REC_STAT: mStatics.load(ref, deleted, store); break;
-            case ESM::REC_WEAP: mWeapons.load(ref, deleted, store); break;
-            case ESM::REC_BODY: mBodyParts.load(ref, deleted, store); break;
+            case ESM::REC_ACTI: mActivators.load(ref, deleted, store, isNew); break;
+            case ESM::REC_ALCH: mPotions.load(ref, deleted, store, isNew); break;
+            case ESM::REC_APPA: mAppas.load(ref, deleted, store, isNew); break;
+            case ESM::REC_ARMO: mArmors.load(ref, deleted, store, isNew); break;
+            case ESM::REC_BOOK: mBooks.load(ref, deleted, store, isNew); break;
+            case ESM::REC_CLOT: mClothes.load(ref, deleted, store, isNew); break;
+            case ESM::REC_CONT: mContainers.load(ref, deleted, store, isNew); break;
+            case ESM::REC_CREA: mCreatures.load(ref, deleted, store, isNew); break;
+            case ESM::REC_DOOR: mDoors.load(ref, deleted, store, isNew); break;
+            case ESM::REC_INGR: mIngreds.load(ref, deleted, store, isNew); break;
+            case ESM::REC_LEVC: mCreatureLists.load(ref, deleted, store, isNew); break;
+            case ESM::REC_LEVI: mItemLists.load(ref, deleted, store, isNew); break;
+            case ESM::REC_LIGH: mLights.load(ref, deleted, store, isNew); break;
+            case ESM::REC_LOCK: mLockpicks.load(ref, deleted, store, isNew); break;
+            case ESM::REC_MISC: mMiscItems.load(ref, deleted, store, isNew); break;
+            case ESM::REC_NPC_: mNpcs.load(ref, deleted, store, isNew); break;
+            case ESM::REC_PROB: mProbes.load(ref, deleted, store, isNew); break;
+            case ESM::REC_REPA: mRepairs.load(ref, deleted, store, isNew); break;
+            case ESM::REC_STAT: mStatics.load(ref, deleted, store, isNew); break;
+            case ESM::REC_WEAP: mWeapons.load(ref, deleted, store, isNew); break;
+            case ESM::REC_BODY: mBodyParts.load(ref, deleted, store, isNew); break;
 
             case 0: std::cerr << "Cell reference '" + ref.mRefID + "' not found!\n"; break;
 
@@ -871,6 +821,11 @@ namespace MWWorld
 
             moveTo(MWWorld::Ptr(movedRef, this), otherCell);
         }
+
+        // References that were placed at runtime aren't in the content files
+        for (std::vector<LiveCellRefBase*>::const_iterator it = mMergedRefs.begin(); it != mMergedRefs.end(); ++it)
+            if (!(*it)->mRef.hasContentFile())
+                indexRef(*it);
     }
 
     bool operator== (const CellStore& left, const CellStore& right)
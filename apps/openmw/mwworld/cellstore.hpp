@@ -8,6 +8,7 @@
 #include <map>
 
 #include <boost/shared_ptr.hpp>
+#include <boost/unordered_set.hpp>
 
 #include "livecellref.hpp"
 #include "cellreflist.hpp"
@@ -37,17 +38,20 @@
 
 #include "timestamp.hpp"
 #include "ptr.hpp"
+#include "contentrefs.hpp"
 
 namespace ESM
 {
     struct CellState;
     struct FogState;
     struct CellId;
+    class ReaderPool;
 }
 
 namespace MWWorld
 {
     class ESMStore;
+    class RefIdIndex;
 
     /// \brief Mutable state of a cell
     class CellStore
@@ -59,10 +63,13 @@ namespace MWWorld
                 State_Unloaded, State_Preloaded, State_Loaded
             };
 
+            typedef MWWorld::ContentRefList ContentRefList;
+
         private:
 
             const MWWorld::ESMStore& mStore;
-            std::vector<ESM::ESMReader>& mReader;
+            ESM::ReaderPool& mReaders;
+            RefIdIndex* mRefIdIndex;
 
             // Even though fog actually belongs to the player and not cells,
             // it makes sense to store it here since we need it once for each cell.
@@ -75,6 +82,10 @@ namespace MWWorld
             std::vector<std::string> mIds;
             float mWaterLevel;
 
+            typedef boost::unordered_set<ESM::RefNum> RefNumSet;
+            // References from the content files that have been moved to a different cell, from mCell->mMovedRefs
+            RefNumSet mMovedRefNums;
+
             MWWorld::TimeStamp mLastRespawn;
 
             // List of refs owned by this cell
@@ -192,13 +203,16 @@ namespace MWWorld
                 CellRefList<T>& list = get<T>();
                 LiveCellRefBase* ret = &list.insert(*ref);
                 updateMergedRefs();
+                indexRef(ret);
                 return ret;
             }
 
-            /// @param readerList The readers to use for loading of the cell on-demand.
+            /// @param readers The readers to use for loading of the cell on-demand.
+            /// @param refIdIndex Index to add references to that enter this cell other than from the content files, may be NULL.
             CellStore (const ESM::Cell *cell_,
                        const MWWorld::ESMStore& store,
-                       std::vector<ESM::ESMReader>& readerList);
+                       ESM::ReaderPool& readers,
+                       RefIdIndex* refIdIndex = NULL);
 
             const ESM::Cell *getCell() const;
 
@@ -243,6 +257,10 @@ namespace MWWorld
             void load ();
             ///< Load references from content file.
 
+            void load (ContentRefList& refs);
+            ///< Load references that were read by readContentRefs() beforehand, instead of reading the content
+            /// files. \a refs is modified.
+
             void preload ();
             ///< Build ID list from content file.
 
@@ -377,12 +395,16 @@ namespace MWWorld
             /// Run through references and store IDs
             void listRefs();
 
-            void loadRefs();
+            /// Add \a ref, which entered this cell other than from the content files, to mRefIdIndex.
+            void indexRef (const LiveCellRefBase* ref);
+
+            void loadRefs (ContentRefList& refs);
 
-            void loadRef (ESM::CellRef& ref, bool deleted);
+            void loadRef (ESM::CellRef& ref, bool deleted, bool isNew);
             ///< Make case-adjustments to \a ref and insert it into the respective container.
             ///
-            /// Invalid \a ref objects are silently dropped.
+            /// Invalid \a ref objects are silently dropped. \a isNew tells that no reference with the
+            /// same RefNum has been loaded before, so that it does not have to be searched for.
 
             MWMechanics::PathgridGraph mPathgridGraph;
     };
@@ -27,6 +27,11 @@ struct ContentLoader
       mListener.setLabel(filepath.string());
     }
 
+    /// Called after all content files have been passed to load(), to complete any loading still in progress.
+    virtual void finish()
+    {
+    }
+
     protected:
         Loading::Listener& mListener;
 };
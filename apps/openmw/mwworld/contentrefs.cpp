@@ -0,0 +1,105 @@
+#include "contentrefs.hpp"
+
+#include <iostream>
+#include <algorithm>
+
+#include <boost/unordered_set.hpp>
+
+#include <components/esm/loadcell.hpp>
+#include <components/esm/readerpool.hpp>
+#include <components/misc/stringops.hpp>
+
+namespace MWWorld
+{
+
+    void readContentRefs (const ESM::Cell& cell, ESM::ReaderPool& readers, ContentRefList& refs)
+    {
+        if (cell.mContextList.empty())
+            return; // this is a dynamically generated cell -> skipping.
+
+        boost::unordered_set<ESM::RefNum> movedRefNums;
+        for (ESM::MovedCellRefTracker::const_iterator it = cell.mMovedRefs.begin(); it != cell.mMovedRefs.end(); ++it)
+            movedRefNums.insert(it->mRefNum);
+
+        // Read references from all plugins that do something with this cell.
+        for (size_t i = 0; i < cell.mContextList.size(); i++)
+        {
+            try
+            {
+                // Take a reader for the content file from the pool and seek to the right position.
+                ESM::ReaderPool::ScopedReader esm (readers, cell.mContextList.at(i).index);
+                cell.restore (*esm, i);
+
+                ESM::CellRef ref;
+                ref.mRefNum.mContentFile = ESM::RefNum::RefNum_NoContentFile;
+
+                // Get each reference in turn
+                bool deleted = false;
+                while(cell.getNextRef(*esm, ref, deleted))
+                {
+                    // Don't load reference if it was moved to a different cell.
+                    if (movedRefNums.find(ref.mRefNum) != movedRefNums.end())
+                        continue;
+
+                    refs.push_back (std::make_pair (ref, deleted));
+                }
+            }
+            catch (std::exception& e)
+            {
+                std::cerr << "An error occurred loading references for cell " << cell.getDescription() << ": " << e.what() << std::endl;
+            }
+        }
+    }
+
+    void listContentRefIds (const ESM::Cell& cell, ESM::ReaderPool& readers, std::vector<std::string>& ids)
+    {
+        if (cell.mContextList.empty())
+            return; // this is a dynamically generated cell -> skipping.
+
+        boost::unordered_set<ESM::RefNum> movedRefNums;
+        for (ESM::MovedCellRefTracker::const_iterator it = cell.mMovedRefs.begin(); it != cell.mMovedRefs.end(); ++it)
+            movedRefNums.insert(it->mRefNum);
+
+        // Load references from all plugins that do something with this cell.
+        for (size_t i = 0; i < cell.mContextList.size(); i++)
+        {
+            try
+            {
+                // Take a reader for the content file from the pool and seek to the right position.
+                ESM::ReaderPool::ScopedReader esm (readers, cell.mContextList.at(i).index);
+                cell.restore (*esm, i);
+
+                ESM::CellRef ref;
+
+                // Get each reference in turn
+                bool deleted = false;
+                while (cell.getNextRef (*esm, ref, deleted))
+                {
+                    if (deleted)
+                        continue;
+
+                    // Don't list reference if it was moved to a different cell.
+                    if (movedRefNums.find(ref.mRefNum) != movedRefNums.end())
+                        continue;
+
+                    ids.push_back (Misc::StringUtils::lowerCase (ref.mRefID));
+                }
+            }
+            catch (std::exception& e)
+            {
+                std::cerr << "An error occurred listing references for cell " << cell.getDescription() << ": " << e.what() << std::endl;
+            }
+        }
+
+        // List moved references, from separately tracked list.
+        for (ESM::CellRefTracker::const_iterator it = cell.mLeasedRefs.begin(); it != cell.mLeasedRefs.end(); ++it)
+        {
+            const ESM::CellRef &ref = *it;
+
+            ids.push_back(Misc::StringUtils::lowerCase(ref.mRefID));
+        }
+
+        std::sort (ids.begin(), ids.end());
+    }
+
+}
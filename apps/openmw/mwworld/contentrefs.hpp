@@ -0,0 +1,32 @@
+#ifndef GAME_MWWORLD_CONTENTREFS_H
+#define GAME_MWWORLD_CONTENTREFS_H
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <components/esm/cellref.hpp>
+
+namespace ESM
+{
+    class ReaderPool;
+    struct Cell;
+}
+
+namespace MWWorld
+{
+    /// References as read from the content files, with their deleted flag. See readContentRefs().
+    typedef std::vector<std::pair<ESM::CellRef, bool> > ContentRefList;
+
+    void readContentRefs (const ESM::Cell& cell, ESM::ReaderPool& readers, ContentRefList& refs);
+    ///< Read the references of \a cell from the content files, without inserting them into a CellStore.
+    /// References moved to another cell are skipped, references leased from other cells are not included.
+    /// \note Does not touch any CellStore, so it can be used from a background thread while the
+    /// cell is in use.
+
+    void listContentRefIds (const ESM::Cell& cell, ESM::ReaderPool& readers, std::vector<std::string>& ids);
+    ///< Add the lower case IDs of the references of \a cell in the content files to \a ids and sort it.
+    /// Like readContentRefs(), but includes the references leased from other cells and skips deleted references.
+}
+
+#endif
@@ -0,0 +1,163 @@
+#include "contentsnapshot.hpp"
+
+#include <ctime>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+#include <boost/filesystem/operations.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+#include <components/esm/esmreader.hpp>
+#include <components/esm/esmwriter.hpp>
+#include <components/files/memorymappedfile.hpp>
+#include <components/files/memorystream.hpp>
+#include <components/loadinglistener/loadinglistener.hpp>
+
+#include "esmstore.hpp"
+
+namespace
+{
+
+    /// Increase when the snapshot contents change, so that older snapshots are ignored.
+    const int sSnapshotVersion = 1;
+
+    const int sRecordKey = ESM::FourCC<'S','N','A','P'>::value;
+
+    /// File modification times have a resolution of up to two seconds on some file systems.
+    const std::time_t sModificationTimeSlack = 2;
+
+}
+
+namespace MWWorld
+{
+
+    bool describeContentFiles(const std::vector<boost::filesystem::path>& contentFiles, std::ostream& key)
+    {
+        std::time_t now = std::time(NULL);
+        bool recentlyModified = false;
+
+        for (std::vector<boost::filesystem::path>::const_iterator it = contentFiles.begin(); it != contentFiles.end(); ++it)
+        {
+            std::time_t modified = boost::filesystem::last_write_time(*it);
+            if (modified + sModificationTimeSlack >= now)
+                recentlyModified = true;
+
+            key << it->string() << "\n" << boost::filesystem::file_size(*it) << " " << static_cast<long long>(modified) << "\n";
+        }
+
+        return recentlyModified;
+    }
+
+    ContentSnapshot::ContentSnapshot(const boost::filesystem::path& file, const std::vector<boost::filesystem::path>& contentFiles,
+                                     ToUTF8::FromType encoding)
+        : mFile(file)
+    {
+        std::ostringstream key;
+        key << "version " << sSnapshotVersion << "\n";
+        key << "encoding " << encoding << "\n";
+        mRecentlyModified = describeContentFiles(contentFiles, key);
+
+        mKey = key.str();
+    }
+
+    bool ContentSnapshot::load(ESMStore& store, Loading::Listener& listener) const
+    {
+        if (!boost::filesystem::exists(mFile))
+            return false;
+
+        Files::MemoryMappedFile mapping;
+        ESM::ESMReader esm;
+
+        try
+        {
+            mapping.open(mFile.string().c_str());
+
+            esm.setIndex(0);
+            esm.open(Files::IStreamPtr(new Files::IMemStream(mapping.data(), mapping.size())), mFile.string());
+
+            if (!esm.hasMoreRecs() || esm.getRecName().intval != static_cast<uint32_t>(sRecordKey))
+                return false;
+
+            esm.getRecHeader();
+            if (esm.getHNString("KEYS") != mKey)
+                return false;
+        }
+        catch (std::exception& e)
+        {
+            std::cerr << "Failed to open content snapshot " << mFile << ": " << e.what() << std::endl;
+            return false;
+        }
+
+        std::cout << "Loading content snapshot " << mFile << std::endl;
+
+        listener.setLabel("Content snapshot");
+
+        try
+        {
+            store.readStatic(esm, &listener);
+        }
+        catch (std::exception& e)
+        {
+            // The store has been modified already and can't be used any more. At least make sure the next start works.
+            boost::system::error_code ec;
+            boost::filesystem::remove(mFile, ec);
+
+            std::ostringstream error;
+            error << "Failed to load content snapshot " << mFile << ": " << e.what() << ". The snapshot has been removed, please try again.";
+            throw std::runtime_error(error.str());
+        }
+
+        return true;
+    }
+
+    void ContentSnapshot::save(const ESMStore& store) const
+    {
+        if (mRecentlyModified)
+        {
+            std::cout << "Not writing a content snapshot, the content files were modified just now" << std::endl;
+            return;
+        }
+
+        try
+        {
+            if (mFile.has_parent_path())
+                boost::filesystem::create_directories(mFile.parent_path());
+
+            // Write to a temporary file first, so that an interrupted write can not leave a truncated snapshot behind
+            boost::filesystem::path tempFile (mFile.string() + ".tmp");
+            {
+                boost::filesystem::ofstream stream (tempFile, std::ios_base::binary);
+                if (!stream.is_open())
+                    throw std::runtime_error("can't open " + tempFile.string() + " for writing");
+
+                // No encoder, the strings are kept as UTF-8
+                ESM::ESMWriter writer;
+                writer.setFormat(0);
+                writer.setVersion();
+                writer.setType(0);
+                writer.setAuthor("");
+                writer.setDescription("");
+                writer.save(stream);
+
+                writer.startRecord(sRecordKey);
+                writer.writeHNString("KEYS", mKey);
+                writer.endRecord(sRecordKey);
+
+                store.writeStatic(writer);
+
+                writer.close();
+
+                if (!stream.flush())
+                    throw std::runtime_error("write to " + tempFile.string() + " failed");
+            }
+
+            boost::filesystem::rename(tempFile, mFile);
+        }
+        catch (std::exception& e)
+        {
+            std::cerr << "Failed to write content snapshot " << mFile << ": " << e.what() << std::endl;
+        }
+    }
+
+}
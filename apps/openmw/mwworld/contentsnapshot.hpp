@@ -0,0 +1,57 @@
+#ifndef OPENMW_MWWORLD_CONTENTSNAPSHOT_H
+#define OPENMW_MWWORLD_CONTENTSNAPSHOT_H
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem/path.hpp>
+
+#include <components/to_utf8/to_utf8.hpp>
+
+namespace Loading
+{
+    class Listener;
+}
+
+namespace MWWorld
+{
+    class ESMStore;
+
+    /// Write the paths, sizes and modification times of \a contentFiles to \a key, to tell whether a cache file made
+    /// from them is still up to date.
+    /// @return Was a content file modified too recently to tell a later change by its modification time?
+    bool describeContentFiles(const std::vector<boost::filesystem::path>& contentFiles, std::ostream& key);
+
+    /// @brief Cache file holding the records of a load order, as merged into the ESMStore.
+    /// @par Reading the snapshot replaces parsing and merging every content file. It is only used while the
+    /// content files, their order, sizes and modification times and the data files encoding stay the same.
+    class ContentSnapshot
+    {
+    public:
+        /// @param file Path of the snapshot file.
+        /// @param contentFiles Paths of the content files, in load order.
+        ContentSnapshot(const boost::filesystem::path& file, const std::vector<boost::filesystem::path>& contentFiles,
+                        ToUTF8::FromType encoding);
+
+        /// Read the snapshot into \a store, which must be empty.
+        /// @return Was an up to date snapshot found? If not, the store is left unchanged.
+        /// @note The content files still have to be opened, see ESMStore::resolveMasters.
+        bool load(ESMStore& store, Loading::Listener& listener) const;
+
+        /// Write the records of \a store, that must have been loaded from the content files given to the constructor.
+        /// @note Errors are reported on the console, a missing snapshot only makes the next start slower.
+        void save(const ESMStore& store) const;
+
+    private:
+        boost::filesystem::path mFile;
+
+        /// Identifies the content files the snapshot was made from
+        std::string mKey;
+
+        /// Was a content file modified too recently to tell a later change by its modification time?
+        bool mRecentlyModified;
+    };
+}
+
+#endif
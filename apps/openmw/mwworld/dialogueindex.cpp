@@ -0,0 +1,125 @@
+#include "dialogueindex.hpp"
+
+#include <algorithm>
+
+#include <components/esm/loaddial.hpp>
+#include <components/misc/stringops.hpp>
+
+#include "store.hpp"
+
+namespace
+{
+    typedef std::vector<std::size_t> Bucket;
+    typedef boost::unordered_map<Misc::StringAtom, Bucket> BucketMap;
+
+    void addBucket(const BucketMap& buckets, const std::string& key, std::vector<std::size_t>& positions)
+    {
+        if (key.empty())
+            return;
+
+        // Don't intern the key, an ID that was never interned has no responses filed under it anyway.
+        Misc::StringAtom atom;
+        if (!Misc::StringAtom::find(key, atom))
+            return;
+
+        BucketMap::const_iterator found = buckets.find(atom);
+        if (found != buckets.end())
+            positions.insert(positions.end(), found->second.begin(), found->second.end());
+    }
+}
+
+namespace MWWorld
+{
+    DialogueIndex::Query::Query()
+        : mCreature(false), mAnyCell(false)
+    {
+    }
+
+    void DialogueIndex::build(const Store<ESM::Dialogue>& dialogues)
+    {
+        mTopics.clear();
+
+        for (Store<ESM::Dialogue>::iterator dialogue = dialogues.begin(); dialogue != dialogues.end(); ++dialogue)
+        {
+            Topic& topic = mTopics[&*dialogue];
+
+            for (ESM::Dialogue::InfoContainer::const_iterator info = dialogue->mInfo.begin();
+                 info != dialogue->mInfo.end(); ++info)
+            {
+                std::size_t position = topic.mInfos.size();
+                topic.mInfos.push_back(&*info);
+
+                if (!info->mActor.empty())
+                    topic.mActors[Misc::StringAtom(info->mActor)].push_back(position);
+                else if (!info->mRace.empty())
+                    topic.mRaces[Misc::StringAtom(info->mRace)].push_back(position);
+                else if (!info->mClass.empty())
+                    topic.mClasses[Misc::StringAtom(info->mClass)].push_back(position);
+                else if (!info->mFactionLess && !info->mFaction.empty())
+                    topic.mFactions[Misc::StringAtom(info->mFaction)].push_back(position);
+                else if (!info->mCell.empty())
+                {
+                    std::string cell = Misc::StringUtils::lowerCase(info->mCell);
+
+                    std::vector<std::pair<std::string, Bucket> >::iterator iter = topic.mCells.begin();
+                    while (iter != topic.mCells.end() && iter->first != cell)
+                        ++iter;
+
+                    if (iter == topic.mCells.end())
+                        iter = topic.mCells.insert(iter, std::make_pair(cell, Bucket()));
+
+                    iter->second.push_back(position);
+                }
+                else
+                    topic.mOther.push_back(position);
+            }
+        }
+    }
+
+    void DialogueIndex::getCandidates(const ESM::Dialogue& dialogue, const Query& query,
+                                      std::vector<const ESM::DialInfo*>& candidates) const
+    {
+        candidates.clear();
+
+        boost::unordered_map<const ESM::Dialogue*, Topic>::const_iterator found = mTopics.find(&dialogue);
+        if (found == mTopics.end())
+        {
+            for (ESM::Dialogue::InfoContainer::const_iterator info = dialogue.mInfo.begin();
+                 info != dialogue.mInfo.end(); ++info)
+                candidates.push_back(&*info);
+            return;
+        }
+
+        const Topic& topic = found->second;
+
+        std::vector<std::size_t> positions;
+
+        addBucket(topic.mActors, query.mActor, positions);
+
+        // Responses without an actor ID never match creatures
+        if (!query.mCreature)
+        {
+            addBucket(topic.mRaces, query.mRace, positions);
+            addBucket(topic.mClasses, query.mClass, positions);
+            addBucket(topic.mFactions, query.mFaction, positions);
+
+            // Partial matches, just like Filter::testPlayer
+            std::string cell = Misc::StringUtils::lowerCase(query.mCell);
+            for (std::vector<std::pair<std::string, Bucket> >::const_iterator iter = topic.mCells.begin();
+                 iter != topic.mCells.end(); ++iter)
+            {
+                if (query.mAnyCell || cell.compare(0, iter->first.size(), iter->first) == 0)
+                    positions.insert(positions.end(), iter->second.begin(), iter->second.end());
+            }
+
+            positions.insert(positions.end(), topic.mOther.begin(), topic.mOther.end());
+        }
+
+        // Each response is in one bucket only, so there are no duplicates to remove.
+        std::sort(positions.begin(), positions.end());
+
+        candidates.reserve(positions.size());
+        for (std::vector<std::size_t>::const_iterator iter = positions.begin(); iter != positions.end(); ++iter)
+            candidates.push_back(topic.mInfos[*iter]);
+    }
+}
@@ -0,0 +1,89 @@
+#ifndef OPENMW_MWWORLD_DIALOGUEINDEX_H
+#define OPENMW_MWWORLD_DIALOGUEINDEX_H
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/unordered_map.hpp>
+
+#include <components/misc/stringatom.hpp>
+
+namespace ESM
+{
+    struct Dialogue;
+    struct DialInfo;
+}
+
+namespace MWWorld
+{
+    template <class T> class Store;
+
+    /// @brief Narrows the responses of a topic down to those that may match a given actor.
+    /// @par Each response is filed under the first of its actor ID, race, class, faction and cell that is set, or
+    /// under none of them. A response filed under, e.g., a race can only match NPCs of that race, whatever its other
+    /// conditions are, so the responses filed under another race need not be tested at all.
+    /// @par The candidates are returned in the order of the topic. They still have to be tested in full, the index
+    /// only skips responses that can't match.
+    class DialogueIndex
+    {
+    public:
+        /// Actor and player to find responses for
+        struct Query
+        {
+            std::string mActor;
+
+            /// Creatures only get responses specific to their ID.
+            bool mCreature;
+
+            std::string mRace;
+            std::string mClass;
+
+            /// The actor's primary faction, empty if none
+            std::string mFaction;
+
+            /// Name of the cell the player is in
+            std::string mCell;
+
+            /// Return responses for any cell, for listing those that depend on the actor alone.
+            bool mAnyCell;
+
+            Query();
+        };
+
+        /// Index the responses of all topics in \a dialogues. Replaces the previous index.
+        /// @note The responses must not change afterwards, until the index is built again.
+        void build(const Store<ESM::Dialogue>& dialogues);
+
+        /// Responses of \a dialogue that may match \a query, in the order of the topic.
+        /// @note Returns all responses of topics that are not indexed.
+        void getCandidates(const ESM::Dialogue& dialogue, const Query& query,
+                           std::vector<const ESM::DialInfo*>& candidates) const;
+
+    private:
+        /// Positions of responses in the topic
+        typedef std::vector<std::size_t> Bucket;
+
+        typedef boost::unordered_map<Misc::StringAtom, Bucket> BucketMap;
+
+        struct Topic
+        {
+            std::vector<const ESM::DialInfo*> mInfos;
+
+            BucketMap mActors;
+            BucketMap mRaces;
+            BucketMap mClasses;
+            BucketMap mFactions;
+
+            /// Lower case cell names, matched as prefixes of the player's cell
+            std::vector<std::pair<std::string, Bucket> > mCells;
+
+            /// Responses with none of the above
+            Bucket mOther;
+        };
+
+        boost::unordered_map<const ESM::Dialogue*, Topic> mTopics;
+    };
+}
+
+#endif
@@ -1,17 +1,85 @@
 #include "esmloader.hpp"
 #include "esmstore.hpp"
 
+#include <memory>
+
 #include <components/esm/esmreader.hpp>
+#include <components/sceneutil/workqueue.hpp>
+#include <components/to_utf8/to_utf8.hpp>
 
 namespace MWWorld
 {
 
+/// Parses a content file on a worker thread, using its own reader and encoder.
+class ParseContentFileItem : public SceneUtil::WorkItem
+{
+public:
+    ParseContentFileItem(const ESMStore& store, const std::string& path, int index, ToUTF8::Utf8Encoder* encoder, bool memoryMapped)
+        : mStore(store)
+        , mPath(path)
+        , mIndex(index)
+        , mMemoryMapped(memoryMapped)
+        , mEncoder(encoder ? new ToUTF8::Utf8Encoder(*encoder) : NULL)
+    {
+    }
+
+    virtual void doWork()
+    {
+        try
+        {
+            ESM::ESMReader esm;
+            esm.setEncoder(mEncoder.get());
+            esm.setIndex(mIndex);
+            esm.setMemoryMapped(mMemoryMapped);
+            esm.open(mPath);
+
+            mStore.parse(esm, mParsed);
+        }
+        catch (std::exception& e)
+        {
+            mParsed.mError = e.what();
+        }
+    }
+
+    int getIndex() const
+    {
+        return mIndex;
+    }
+
+    ParsedContentFile& getParsed()
+    {
+        return mParsed;
+    }
+
+    const std::string& getPath() const
+    {
+        return mPath;
+    }
+
+private:
+    const ESMStore& mStore;
+    std::string mPath;
+    int mIndex;
+    bool mMemoryMapped;
+    std::auto_ptr<ToUTF8::Utf8Encoder> mEncoder;
+
+    ParsedContentFile mParsed;
+};
+
 EsmLoader::EsmLoader(MWWorld::ESMStore& store, std::vector<ESM::ESMReader>& readers,
-  ToUTF8::Utf8Encoder* encoder, Loading::Listener& listener)
+  ToUTF8::Utf8Encoder* encoder, Loading::Listener& listener, int numThreads)
   : ContentLoader(listener)
   , mEsm(readers)
   , mStore(store)
   , mEncoder(encoder)
+  , mHeadersOnly(false)
+  , mMemoryMapped(false)
+{
+  if (numThreads > 0)
+    mWorkQueue = new SceneUtil::WorkQueue(numThreads);
+}
+
+EsmLoader::~EsmLoader()
 {
 }
 
@@ -23,9 +91,58 @@ void EsmLoader::load(const boost::filesystem::path& filepath, int& index)
   lEsm.setEncoder(mEncoder);
   lEsm.setIndex(index);
   lEsm.setGlobalReaderList(&mEsm);
+  lEsm.setMemoryMapped(mMemoryMapped);
   lEsm.open(filepath.string());
   mEsm[index] = lEsm;
-  mStore.load(mEsm[index], &mListener);
+
+  if (mHeadersOnly)
+  {
+    mStore.resolveMasters(mEsm[index]);
+    return;
+  }
+
+  if (!mWorkQueue)
+  {
+    mStore.load(mEsm[index], &mListener);
+    return;
+  }
+
+  osg::ref_ptr<ParseContentFileItem> item (new ParseContentFileItem(mStore, filepath.string(), index, mEncoder, mMemoryMapped));
+  mWorkQueue->addWorkItem(item);
+  mParsing.push_back(item);
+
+  mergeParsed(false);
+}
+
+void EsmLoader::finish()
+{
+  mergeParsed(true);
+}
+
+void EsmLoader::setHeadersOnly(bool headersOnly)
+{
+  mHeadersOnly = headersOnly;
+}
+
+void EsmLoader::setMemoryMapped(bool mapped)
+{
+  mMemoryMapped = mapped;
+}
+
+void EsmLoader::mergeParsed(bool wait)
+{
+  while (!mParsing.empty())
+  {
+    osg::ref_ptr<ParseContentFileItem> item = mParsing.front();
+    if (!wait && !item->isDone())
+      return;
+
+    item->waitTillDone();
+    mParsing.pop_front();
+
+    mListener.setLabel(boost::filesystem::path(item->getPath()).filename().string());
+    mStore.merge(mEsm[item->getIndex()], item->getParsed(), &mListener);
+  }
 }
 
 } /* namespace MWWorld */
@@ -1,8 +1,11 @@
 #ifndef ESMLOADER_HPP
 #define ESMLOADER_HPP
 
+#include <deque>
 #include <vector>
 
+#include <osg/ref_ptr>
+
 #include "contentloader.hpp"
 
 namespace ToUTF8
@@ -15,22 +18,52 @@ namespace ESM
     class ESMReader;
 }
 
+namespace SceneUtil
+{
+    class WorkQueue;
+}
+
 namespace MWWorld
 {
 
 class ESMStore;
+class ParseContentFileItem;
 
 struct EsmLoader : public ContentLoader
 {
+    /// @param numThreads Number of threads to parse content files on. With 0, every content file is
+    /// loaded on the calling thread as soon as it is passed to load().
     EsmLoader(MWWorld::ESMStore& store, std::vector<ESM::ESMReader>& readers,
-      ToUTF8::Utf8Encoder* encoder, Loading::Listener& listener);
+      ToUTF8::Utf8Encoder* encoder, Loading::Listener& listener, int numThreads = 0);
+    ~EsmLoader();
 
     void load(const boost::filesystem::path& filepath, int& index);
 
+    /// Wait for the content files that are still being parsed and merge them into the store.
+    void finish();
+
+    /// Only open the content files without loading their records, for a store that has been
+    /// filled from a ContentSnapshot.
+    void setHeadersOnly(bool headersOnly);
+
+    /// Map the content files into memory instead of reading them through streams, see ESM::ESMReader::setMemoryMapped.
+    /// The readers are kept for loading cell references later, so the files stay mapped.
+    void setMemoryMapped(bool mapped);
+
     private:
+      /// Merge parsed content files into the store in load order.
+      /// @param wait Wait for content files that have not been parsed yet?
+      void mergeParsed(bool wait);
+
       std::vector<ESM::ESMReader>& mEsm;
       MWWorld::ESMStore& mStore;
       ToUTF8::Utf8Encoder* mEncoder;
+      bool mHeadersOnly;
+      bool mMemoryMapped;
+
+      osg::ref_ptr<SceneUtil::WorkQueue> mWorkQueue;
+      /// Content files being parsed, in load order
+      std::deque<osg::ref_ptr<ParseContentFileItem> > mParsing;
 };
 
 } /* namespace MWWorld */
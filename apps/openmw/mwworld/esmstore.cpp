@@ -2,6 +2,7 @@
 
 #include <set>
 #include <iostream>
+#include <memory>
 
 #include <boost/filesystem/operations.hpp>
 
@@ -13,6 +14,11 @@
 namespace MWWorld
 {
 
+static bool hasPayload(int id)
+{
+    return id == ESM::REC_SCPT || id == ESM::REC_BOOK || id == ESM::REC_INFO || id == ESM::REC_NPC_;
+}
+
 static bool isCacheableRecord(int id)
 {
     if (id == ESM::REC_ACTI || id == ESM::REC_ALCH || id == ESM::REC_APPA || id == ESM::REC_ARMO ||
@@ -27,12 +33,18 @@ static bool isCacheableRecord(int id)
     return false;
 }
 
-void ESMStore::load(ESM::ESMReader &esm, Loading::Listener* listener)
+ParsedContentFile::ParsedContentFile()
 {
-    listener->setProgressRange(1000);
+}
 
-    ESM::Dialogue *dialogue = 0;
+ParsedContentFile::~ParsedContentFile()
+{
+    for (std::vector<Record>::iterator it = mRecords.begin(); it != mRecords.end(); ++it)
+        delete it->mParsed;
+}
 
+void ESMStore::resolveMasters(ESM::ESMReader &esm)
+{
     // Land texture loading needs to use a separate internal store for each plugin.
     // We set the number of plugins here to avoid continual resizes during loading,
     // and so we can properly verify if valid plugin indices are being passed to the
@@ -66,6 +78,16 @@ void ESMStore::load(ESM::ESMReader &esm, Loading::Listener* listener)
         }
         mast.index = index;
     }
+}
+
+void ESMStore::load(ESM::ESMReader &esm, Loading::Listener* listener)
+{
+    listener->setProgressRange(1000);
+
+    ESM::Dialogue *dialogue = 0;
+
+    resolveMasters(esm);
+    mPayloads.addFile(esm);
 
     // Loop through all records
     while(esm.hasMoreRecs())
@@ -73,49 +95,248 @@ void ESMStore::load(ESM::ESMReader &esm, Loading::Listener* listener)
         ESM::NAME n = esm.getRecName();
         esm.getRecHeader();
 
-        // Look up the record type.
-        std::map<int, StoreBase *>::iterator it = mStores.find(n.intval);
+        loadRecord(esm, n.intval, dialogue, true);
 
-        if (it == mStores.end()) {
-            if (n.intval == ESM::REC_INFO) {
-                if (dialogue)
-                {
-                    dialogue->readInfo(esm, esm.getIndex() != 0);
-                }
-                else
-                {
-                    std::cerr << "error: info record without dialog" << std::endl;
-                    esm.skipRecord();
-                }
-            } else if (n.intval == ESM::REC_MGEF) {
-                mMagicEffects.load (esm);
-            } else if (n.intval == ESM::REC_SKIL) {
-                mSkills.load (esm);
+        listener->setProgress(static_cast<size_t>(esm.getFileOffset() / (float)esm.getFileSize() * 1000));
+    }
+}
+
+void ESMStore::loadRecord(ESM::ESMReader &esm, int type, ESM::Dialogue *&dialogue, bool fromContentFile)
+{
+    RecordLocation location;
+    if (fromContentFile)
+        location = locatePayload(esm, type);
+
+    // Look up the record type.
+    std::map<int, StoreBase *>::iterator it = mStores.find(type);
+
+    if (it == mStores.end()) {
+        if (type == ESM::REC_INFO) {
+            if (dialogue)
+            {
+                ESM::DialInfo info;
+                bool isDeleted = false;
+                info.load(esm, isDeleted);
+                addInfo(*dialogue, info, isDeleted, esm.getIndex() != 0, location);
+            }
+            else
+            {
+                std::cerr << "error: info record without dialog" << std::endl;
+                esm.skipRecord();
+            }
+        } else if (type == ESM::REC_MGEF) {
+            mMagicEffects.load (esm);
+        } else if (type == ESM::REC_SKIL) {
+            mSkills.load (esm);
+        }
+        else if (type==ESM::REC_FILT || type == ESM::REC_DBGP)
+        {
+            // ignore project file only records
+            esm.skipRecord();
+        }
+        else {
+            ESM::NAME n;
+            n.intval = type;
+            std::stringstream error;
+            error << "Unknown record: " << n.toString();
+            throw std::runtime_error(error.str());
+        }
+    } else {
+        onRecordLoaded(it, it->second->load(esm), dialogue, location);
+    }
+}
+
+void ESMStore::onRecordLoaded(std::map<int, StoreBase *>::iterator store, const RecordId &id, ESM::Dialogue *&dialogue,
+                              const RecordLocation &location)
+{
+    if (id.mIsDeleted)
+    {
+        store->second->eraseStatic(id.mId);
+        return;
+    }
+
+    if (location.mIndex >= 0)
+    {
+        const void *record = NULL;
+        switch (store->first)
+        {
+            case ESM::REC_SCPT: record = mScripts.search(id.mId); break;
+            case ESM::REC_BOOK: record = mBooks.search(id.mId); break;
+            case ESM::REC_NPC_: record = mNpcs.search(id.mId); break;
+        }
+        if (record)
+            mPayloads.addLocation(record, location);
+    }
+
+    if (store->first==ESM::REC_DIAL) {
+        dialogue = const_cast<ESM::Dialogue*>(mDialogs.find(id.mId));
+    } else {
+        dialogue = 0;
+    }
+}
+
+void ESMStore::addInfo(ESM::Dialogue &dialogue, const ESM::DialInfo &info, bool isDeleted, bool merge,
+                       const RecordLocation &location)
+{
+    dialogue.addInfo(info, isDeleted, merge);
+
+    if (location.mIndex >= 0)
+    {
+        ESM::Dialogue::LookupMap::const_iterator added = dialogue.mLookup.find(info.mId);
+        if (added != dialogue.mLookup.end())
+            mPayloads.addLocation(&*added->second.first, location);
+    }
+}
+
+RecordLocation ESMStore::locatePayload(ESM::ESMReader &esm, int type) const
+{
+    if (mPayloads.isEnabled() && hasPayload(type))
+        return RecordLocation(esm);
+    return RecordLocation();
+}
+
+void ESMStore::unloadPayloads()
+{
+    for (Store<ESM::Script>::iterator it = mScripts.begin(); it != mScripts.end(); ++it)
+        mPayloads.unload(const_cast<ESM::Script&>(*it));
+
+    for (Store<ESM::Book>::iterator it = mBooks.begin(); it != mBooks.end(); ++it)
+        mPayloads.unload(const_cast<ESM::Book&>(*it));
+
+    for (Store<ESM::NPC>::iterator it = mNpcs.begin(); it != mNpcs.end(); ++it)
+        mPayloads.unload(const_cast<ESM::NPC&>(*it));
+
+    for (Store<ESM::Dialogue>::iterator it = mDialogs.begin(); it != mDialogs.end(); ++it)
+    {
+        ESM::Dialogue &dialogue = const_cast<ESM::Dialogue&>(*it);
+        for (ESM::Dialogue::InfoContainer::iterator info = dialogue.mInfo.begin(); info != dialogue.mInfo.end(); ++info)
+            mPayloads.unload(*info);
+    }
+
+    mPayloads.finishUnload();
+}
+
+void ESMStore::parse(ESM::ESMReader &esm, ParsedContentFile &parsed) const
+{
+    try
+    {
+        while(esm.hasMoreRecs())
+        {
+            ESM::NAME n = esm.getRecName();
+            esm.getRecHeader();
+
+            ParsedContentFile::Record record;
+            record.mType = n.intval;
+            record.mParsed = NULL;
+            record.mLocation = locatePayload(esm, n.intval);
+
+            std::map<int, StoreBase *>::const_iterator it = mStores.find(n.intval);
+            if (it != mStores.end())
+                record.mParsed = it->second->parse(esm);
+            else if (n.intval == ESM::REC_INFO)
+            {
+                std::auto_ptr<ParsedRecordOf<ESM::DialInfo> > info (new ParsedRecordOf<ESM::DialInfo>);
+                info->mIsDeleted = false;
+                info->mRecord.load(esm, info->mIsDeleted);
+                record.mParsed = info.release();
             }
             else if (n.intval==ESM::REC_FILT || n.intval == ESM::REC_DBGP)
             {
                 // ignore project file only records
                 esm.skipRecord();
+                continue;
             }
-            else {
+            else if (n.intval != ESM::REC_MGEF && n.intval != ESM::REC_SKIL)
+            {
                 std::stringstream error;
                 error << "Unknown record: " << n.toString();
                 throw std::runtime_error(error.str());
             }
-        } else {
-            RecordId id = it->second->load(esm);
-            if (id.mIsDeleted)
+
+            if (!record.mParsed)
             {
-                it->second->eraseStatic(id.mId);
-                continue;
+                parsed.mContexts.push_back(esm.getContext());
+                esm.skipRecord();
             }
 
-            if (n.intval==ESM::REC_DIAL) {
-                dialogue = const_cast<ESM::Dialogue*>(mDialogs.find(id.mId));
-            } else {
-                dialogue = 0;
-            }
+            record.mProgress = static_cast<int>(esm.getFileOffset() / (float)esm.getFileSize() * 1000);
+            parsed.mRecords.push_back(record);
+        }
+    }
+    catch (std::exception& e)
+    {
+        parsed.mError = e.what();
+    }
+}
+
+void ESMStore::merge(ESM::ESMReader &esm, ParsedContentFile &parsed, Loading::Listener* listener)
+{
+    listener->setProgressRange(1000);
+
+    ESM::Dialogue *dialogue = 0;
+
+    resolveMasters(esm);
+    mPayloads.addFile(esm);
+
+    std::vector<ESM::ESM_Context>::const_iterator context = parsed.mContexts.begin();
+    for (std::vector<ParsedContentFile::Record>::iterator record = parsed.mRecords.begin(); record != parsed.mRecords.end(); ++record)
+    {
+        if (!record->mParsed)
+        {
+            esm.restoreContext(*context++);
+            loadRecord(esm, record->mType, dialogue, true);
+        }
+        else if (record->mType == ESM::REC_INFO)
+        {
+            const ParsedRecordOf<ESM::DialInfo> &info = static_cast<ParsedRecordOf<ESM::DialInfo>&>(*record->mParsed);
+            if (dialogue)
+                addInfo(*dialogue, info.mRecord, info.mIsDeleted, esm.getIndex() != 0, record->mLocation);
+            else
+                std::cerr << "error: info record without dialog" << std::endl;
+        }
+        else
+        {
+            std::map<int, StoreBase *>::iterator it = mStores.find(record->mType);
+            onRecordLoaded(it, it->second->loadParsed(*record->mParsed), dialogue, record->mLocation);
         }
+
+        // Don't keep the parsed records around until the whole file is merged
+        delete record->mParsed;
+        record->mParsed = NULL;
+
+        listener->setProgress(record->mProgress);
+    }
+
+    if (!parsed.mError.empty())
+        throw std::runtime_error(parsed.mError);
+}
+
+void ESMStore::writeStatic(ESM::ESMWriter &writer) const
+{
+    for (std::map<int, StoreBase *>::const_iterator it = mStores.begin(); it != mStores.end(); ++it)
+        it->second->writeStatic(writer);
+
+    mMagicEffects.writeStatic(writer);
+    mSkills.writeStatic(writer);
+}
+
+void ESMStore::readStatic(ESM::ESMReader &esm, Loading::Listener* listener)
+{
+    listener->setProgressRange(1000);
+
+    ESM::Dialogue *dialogue = 0;
+
+    while(esm.hasMoreRecs())
+    {
+        ESM::NAME n = esm.getRecName();
+        esm.getRecHeader();
+
+        std::map<int, StoreBase *>::iterator it = mStores.find(n.intval);
+        if (it != mStores.end())
+            onRecordLoaded(it, it->second->readStatic(esm), dialogue, RecordLocation());
+        else
+            loadRecord(esm, n.intval, dialogue, false);
+
         listener->setProgress(static_cast<size_t>(esm.getFileOffset() / (float)esm.getFileSize() * 1000));
     }
 }
@@ -134,13 +355,17 @@ void ESMStore::setUp()
             storeIt->second->listIdentifier(identifiers);
 
             for (std::vector<std::string>::const_iterator record = identifiers.begin(); record != identifiers.end(); ++record)
-                mIds[*record] = storeIt->first;
+                mIds[Misc::StringAtom(*record)] = storeIt->first;
         }
     }
     mSkills.setUp();
     mMagicEffects.setUp();
     mAttributes.setUp();
     mDialogs.setUp();
+    mDialogueIndex.build(mDialogs);
+
+    if (mPayloads.isEnabled())
+        unloadPayloads();
 }
 
     int ESMStore::countSavedGameRecords() const
@@ -6,6 +6,8 @@
 
 #include <components/esm/records.hpp>
 #include "store.hpp"
+#include "recordpayloads.hpp"
+#include "dialogueindex.hpp"
 
 namespace Loading
 {
@@ -14,6 +16,38 @@ namespace Loading
 
 namespace MWWorld
 {
+    /// @brief The records of one content file, parsed by ESMStore::parse to be merged into the store later.
+    class ParsedContentFile
+    {
+    public:
+        ParsedContentFile();
+        ~ParsedContentFile();
+
+        /// Set if parsing failed, the records parsed up to the error are kept.
+        std::string mError;
+
+    private:
+        // not implemented
+        ParsedContentFile(const ParsedContentFile&);
+        ParsedContentFile& operator=(const ParsedContentFile&);
+
+        friend class ESMStore;
+
+        struct Record
+        {
+            int mType;
+            /// NULL if the record has to be read again during the merge, from the next context in mContexts.
+            ParsedRecord *mParsed;
+            /// Loading progress at the end of this record, in 1/1000 of the file
+            int mProgress;
+            /// Set for records with a payload, see RecordPayloads
+            RecordLocation mLocation;
+        };
+
+        std::vector<Record> mRecords;
+        std::vector<ESM::ESM_Context> mContexts;
+    };
+
     class ESMStore
     {
         Store<ESM::Activator>       mActivators;
@@ -67,13 +101,35 @@ namespace MWWorld
 
         // Lookup of all IDs. Makes looking up references faster. Just
         // maps the id name to the record type.
-        std::map<std::string, int> mIds;
+        typedef boost::unordered_map<Misc::StringAtom, int> IdMap;
+        IdMap mIds;
         std::map<int, StoreBase *> mStores;
 
         ESM::NPC mPlayerTemplate;
 
         unsigned int mDynamicCount;
 
+        RecordPayloads mPayloads;
+
+        DialogueIndex mDialogueIndex;
+
+        /// Load the current record of \a esm, tracking the dialogue that following INFO records belong to.
+        /// @param fromContentFile Is \a esm reading a content file, rather than a content snapshot?
+        void loadRecord(ESM::ESMReader &esm, int type, ESM::Dialogue *&dialogue, bool fromContentFile);
+
+        /// @param location Where the record was read from, if it has a payload
+        void onRecordLoaded(std::map<int, StoreBase *>::iterator store, const RecordId &id, ESM::Dialogue *&dialogue,
+                            const RecordLocation &location);
+
+        void addInfo(ESM::Dialogue &dialogue, const ESM::DialInfo &info, bool isDeleted, bool merge,
+                     const RecordLocation &location);
+
+        /// Location of the current record of \a esm if it has a payload, otherwise an invalid location.
+        RecordLocation locatePayload(ESM::ESMReader &esm, int type) const;
+
+        /// Drop the payloads of all records loaded from content files, see RecordPayloads.
+        void unloadPayloads();
+
     public:
         /// \todo replace with SharedIterator<StoreBase>
         typedef std::map<int, StoreBase *>::const_iterator iterator;
@@ -87,10 +143,18 @@ namespace MWWorld
         }
 
         /// Look up the given ID in 'all'. Returns 0 if not found.
-        /// \note id must be in lower case.
         int find(const std::string &id) const
         {
-            std::map<std::string, int>::const_iterator it = mIds.find(id);
+            Misc::StringAtom atom;
+            if (!Misc::StringAtom::find(id, atom)) {
+                return 0;
+            }
+            return find(atom);
+        }
+
+        int find(const Misc::StringAtom &id) const
+        {
+            IdMap::const_iterator it = mIds.find(id);
             if (it == mIds.end()) {
                 return 0;
             }
@@ -154,12 +218,36 @@ namespace MWWorld
         void movePlayerRecord ()
         {
             mPlayerTemplate = *mNpcs.find("player");
+            mPlayerTemplate.mAiPackage = mPayloads.getAiPackages(*mNpcs.find("player"));
             mNpcs.eraseStatic(mPlayerTemplate.mId);
             mNpcs.insert(mPlayerTemplate);
         }
 
         void load(ESM::ESMReader &esm, Loading::Listener* listener);
 
+        /// Prepare loading records from the content file opened in \a esm, i.e. find its masters in the
+        /// global reader list. Done by load(), call it directly when the records are read with readStatic().
+        void resolveMasters(ESM::ESMReader &esm);
+
+        /// Write all records loaded from content files, so that readStatic() can restore them without
+        /// loading the content files again.
+        /// @note Must be called before setUp().
+        void writeStatic(ESM::ESMWriter &writer) const;
+
+        /// Read records written by writeStatic() into an empty store.
+        void readStatic(ESM::ESMReader &esm, Loading::Listener* listener);
+
+        /// Parse all records of the content file opened in \a esm without modifying the store.
+        /// Records that depend on previously loaded records (e.g. cells, that are merged across content files)
+        /// are only located, to be read during merge().
+        /// @note Thread safe, may run concurrently to other parse() and merge() calls.
+        void parse(ESM::ESMReader &esm, ParsedContentFile &parsed) const;
+
+        /// Insert the records of a content file parsed by parse(), with the same result as load().
+        /// Content files must be merged in load order.
+        /// @param esm The reader of the content file, as it would have been passed to load().
+        void merge(ESM::ESMReader &esm, ParsedContentFile &parsed, Loading::Listener* listener);
+
         template <class T>
         const Store<T> &get() const {
             throw std::runtime_error("Storage for this type not exist");
@@ -184,7 +272,7 @@ namespace MWWorld
             T *ptr = store.insert(record);
             for (iterator it = mStores.begin(); it != mStores.end(); ++it) {
                 if (it->second == &store) {
-                    mIds[ptr->mId] = it->first;
+                    mIds[Misc::StringAtom(ptr->mId)] = it->first;
                 }
             }
             return ptr;
@@ -198,7 +286,7 @@ namespace MWWorld
             T *ptr = store.insert(x);
             for (iterator it = mStores.begin(); it != mStores.end(); ++it) {
                 if (it->second == &store) {
-                    mIds[ptr->mId] = it->first;
+                    mIds[Misc::StringAtom(ptr->mId)] = it->first;
                 }
             }
             return ptr;
@@ -220,12 +308,26 @@ namespace MWWorld
             T *ptr = store.insertStatic(record);
             for (iterator it = mStores.begin(); it != mStores.end(); ++it) {
                 if (it->second == &store) {
-                    mIds[ptr->mId] = it->first;
+                    mIds[Misc::StringAtom(ptr->mId)] = it->first;
                 }
             }
             return ptr;
         }
 
+        /// Text, result scripts and AI packages of records, that may not be held by the records themselves.
+        const RecordPayloads &getPayloads() const {
+            return mPayloads;
+        }
+
+        RecordPayloads &getPayloads() {
+            return mPayloads;
+        }
+
+        /// Responses of each topic by actor, race, class, faction and cell. Built by setUp().
+        const DialogueIndex &getDialogueIndex() const {
+            return mDialogueIndex;
+        }
+
         // This method must be called once, after loading all master/plugin files. This can only be done
         //  from the outside, so it must be public.
         void setUp();
@@ -260,7 +362,7 @@ namespace MWWorld
         record.mId = id.str();
 
         ESM::NPC *ptr = mNpcs.insert(record);
-        mIds[ptr->mId] = ESM::REC_NPC_;
+        mIds[Misc::StringAtom(ptr->mId)] = ESM::REC_NPC_;
         return ptr;
     }
 
@@ -11,29 +11,32 @@
 
 namespace MWWorld
 {
-    Globals::Collection::const_iterator Globals::find (const std::string& name) const
+    const ESM::Global& Globals::find (const std::string& name) const
     {
-        Collection::const_iterator iter = mVariables.find (Misc::StringUtils::lowerCase (name));
-
-        if (iter==mVariables.end())
-            throw std::runtime_error ("unknown global variable: " + name);
-
-        return iter;
+        return const_cast<Globals&> (*this).find (name);
     }
 
-    Globals::Collection::iterator Globals::find (const std::string& name)
+    ESM::Global& Globals::find (const std::string& name)
     {
+        std::map<std::string, ESM::Global *>::const_iterator slot = mSlots.find (name);
+
+        if (slot!=mSlots.end())
+            return *slot->second;
+
         Collection::iterator iter = mVariables.find (Misc::StringUtils::lowerCase (name));
 
         if (iter==mVariables.end())
             throw std::runtime_error ("unknown global variable: " + name);
 
-        return iter;
+        mSlots.insert (std::make_pair (name, &iter->second));
+
+        return iter->second;
     }
 
     void Globals::fill (const MWWorld::ESMStore& store)
     {
         mVariables.clear();
+        mSlots.clear();
 
         const MWWorld::Store<ESM::Global>& globals = store.get<ESM::Global>();
 
@@ -46,12 +49,12 @@ namespace MWWorld
 
     const ESM::Variant& Globals::operator[] (const std::string& name) const
     {
-        return find (Misc::StringUtils::lowerCase (name))->second.mValue;
+        return find (name).mValue;
     }
 
     ESM::Variant& Globals::operator[] (const std::string& name)
     {
-        return find (Misc::StringUtils::lowerCase (name))->second.mValue;
+        return find (name).mValue;
     }
 
     char Globals::getType (const std::string& name) const
@@ -33,9 +33,13 @@ namespace MWWorld
 
             Collection mVariables; // type, value
 
-            Collection::const_iterator find (const std::string& name) const;
+            /// Variables by name as passed to find, so that names don't have to be converted to lower case again
+            /// \note Cleared by fill. The elements of mVariables don't move.
+            mutable std::map<std::string, ESM::Global *> mSlots;
 
-            Collection::iterator find (const std::string& name);
+            const ESM::Global& find (const std::string& name) const;
+
+            ESM::Global& find (const std::string& name);
 
         public:
 
@@ -1,7 +1,12 @@
 #include "localscripts.hpp"
 
+#include <algorithm>
 #include <iostream>
 
+#include <osg/Timer>
+
+#include <components/misc/stringops.hpp>
+
 #include "esmstore.hpp"
 #include "cellstore.hpp"
 
@@ -61,22 +66,68 @@ namespace
 
 }
 
-MWWorld::LocalScripts::LocalScripts (const MWWorld::ESMStore& store) : mStore (store)
+MWWorld::LocalScripts::Script::Script (const std::string& name, const Ptr& ptr, bool everyFrame)
+: mName (name), mPtr (ptr), mEveryFrame (everyFrame)
+{}
+
+MWWorld::LocalScripts::LocalScripts (const MWWorld::ESMStore& store)
+: mStore (store)
 {
     mIter = mScripts.end();
 }
 
-void MWWorld::LocalScripts::startIteration()
+void MWWorld::LocalScripts::setSchedule (float fullRateDistance, float maxInterval, double timeBudget,
+    const std::vector<std::string>& everyFrame)
+{
+    mSchedule.setSchedule (fullRateDistance, maxInterval, timeBudget);
+
+    mEveryFrame.resize (everyFrame.size());
+    std::transform (everyFrame.begin(), everyFrame.end(), mEveryFrame.begin(), Misc::StringUtils::lowerCase);
+    std::sort (mEveryFrame.begin(), mEveryFrame.end());
+
+    for (ScriptList::iterator iter = mScripts.begin(); iter!=mScripts.end(); ++iter)
+        iter->mEveryFrame = std::binary_search (mEveryFrame.begin(), mEveryFrame.end(),
+            Misc::StringUtils::lowerCase (iter->mName));
+}
+
+float MWWorld::LocalScripts::getInterval (const Script& script) const
+{
+    // Items in containers have no position of their own
+    if (script.mEveryFrame || !script.mPtr.isInCell())
+        return 0;
+
+    return mSchedule.getInterval ((script.mPtr.getRefData().getPosition().asVec3() - mPlayerPosition).length());
+}
+
+void MWWorld::LocalScripts::startIteration (float frameDuration, const osg::Vec3f& playerPosition)
 {
     mIter = mScripts.begin();
+
+    mSchedule.startFrame (frameDuration);
+    mPlayerPosition = playerPosition;
 }
 
-bool MWWorld::LocalScripts::getNext(std::pair<std::string, Ptr>& script)
+bool MWWorld::LocalScripts::getNext (std::pair<std::string, Ptr>& script, float& secondsPassed)
 {
+    double now = osg::Timer::instance()->time_s();
+
+    // The previous script has run by now
+    mSchedule.finishRun (now);
+
     while (mIter!=mScripts.end())
     {
-        std::list<std::pair<std::string, Ptr> >::iterator iter = mIter++;
-        script = *iter;
+        ScriptList::iterator iter = mIter++;
+
+        float interval = getInterval (*iter);
+
+        if (!mSchedule.isDue (iter->mSchedule, interval, now, secondsPassed))
+            continue;
+
+        // The scripts that are still waiting go first in the next frame
+        if (interval>0)
+            mScripts.splice (mScripts.end(), mScripts, iter);
+
+        script = std::make_pair (iter->mName, iter->mPtr);
         return true;
     }
     return false;
@@ -90,15 +141,16 @@ void MWWorld::LocalScripts::add (const std::string& scriptName, const Ptr& ptr)
         {
             ptr.getRefData().setLocals (*script);
 
-            for (std::list<std::pair<std::string, Ptr> >::iterator iter = mScripts.begin(); iter!=mScripts.end(); ++iter)
-                if (iter->second==ptr)
+            for (ScriptList::iterator iter = mScripts.begin(); iter!=mScripts.end(); ++iter)
+                if (iter->mPtr==ptr)
                 {
                     std::cerr << "warning, tried to add local script twice for " << ptr.getCellRef().getRefId() << std::endl;
                     remove(ptr);
                     break;
                 }
 
-            mScripts.push_back (std::make_pair (scriptName, ptr));
+            mScripts.push_back (Script (scriptName, ptr, std::binary_search (mEveryFrame.begin(), mEveryFrame.end(),
+                Misc::StringUtils::lowerCase (scriptName))));
         }
         catch (const std::exception& exception)
         {
@@ -131,11 +183,11 @@ void MWWorld::LocalScripts::clear()
 
 void MWWorld::LocalScripts::clearCell (CellStore *cell)
 {
-    std::list<std::pair<std::string, Ptr> >::iterator iter = mScripts.begin();
+    ScriptList::iterator iter = mScripts.begin();
 
     while (iter!=mScripts.end())
     {
-        if (iter->second.mCell==cell)
+        if (iter->mPtr.mCell==cell)
         {
             if (iter==mIter)
                ++mIter;
@@ -149,9 +201,8 @@ void MWWorld::LocalScripts::clearCell (CellStore *cell)
 
 void MWWorld::LocalScripts::remove (RefData *ref)
 {
-    for (std::list<std::pair<std::string, Ptr> >::iterator iter = mScripts.begin();
-        iter!=mScripts.end(); ++iter)
-        if (&(iter->second.getRefData()) == ref)
+    for (ScriptList::iterator iter = mScripts.begin(); iter!=mScripts.end(); ++iter)
+        if (&(iter->mPtr.getRefData()) == ref)
         {
             if (iter==mIter)
                 ++mIter;
@@ -163,9 +214,8 @@ void MWWorld::LocalScripts::remove (RefData *ref)
 
 void MWWorld::LocalScripts::remove (const Ptr& ptr)
 {
-    for (std::list<std::pair<std::string, Ptr> >::iterator iter = mScripts.begin();
-        iter!=mScripts.end(); ++iter)
-        if (iter->second==ptr)
+    for (ScriptList::iterator iter = mScripts.begin(); iter!=mScripts.end(); ++iter)
+        if (iter->mPtr==ptr)
         {
             if (iter==mIter)
                 ++mIter;
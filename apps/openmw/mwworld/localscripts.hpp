@@ -3,8 +3,12 @@
 
 #include <list>
 #include <string>
+#include <vector>
+
+#include <osg/Vec3f>
 
 #include "ptr.hpp"
+#include "scriptschedule.hpp"
 
 namespace MWWorld
 {
@@ -13,21 +17,60 @@ namespace MWWorld
     class RefData;
 
     /// \brief List of active local scripts
+    ///
+    /// Local scripts close to the player run every frame. Farther away, the time between two runs
+    /// grows with the distance. These scripts also share a time budget per frame; the ones that
+    /// don't fit run first in the next frame. See ScriptSchedule.
     class LocalScripts
     {
-            std::list<std::pair<std::string, Ptr> > mScripts;
-            std::list<std::pair<std::string, Ptr> >::iterator mIter;
+            struct Script
+            {
+                std::string mName;
+                Ptr mPtr;
+
+                /// Listed in mEveryFrame, don't run it less often
+                bool mEveryFrame;
+
+                ScriptSchedule::Entry mSchedule;
+
+                Script (const std::string& name, const Ptr& ptr, bool everyFrame);
+            };
+
+            typedef std::list<Script> ScriptList;
+
+            ScriptList mScripts;
+            ScriptList::iterator mIter;
             const MWWorld::ESMStore& mStore;
 
+            ScriptSchedule mSchedule;
+
+            /// Lower case script IDs, sorted
+            std::vector<std::string> mEveryFrame;
+
+            osg::Vec3f mPlayerPosition;
+
+            /// Minimum time between two runs of \a script
+            float getInterval (const Script& script) const;
+
         public:
 
             LocalScripts (const MWWorld::ESMStore& store);
 
-            void startIteration();
+            void setSchedule (float fullRateDistance, float maxInterval, double timeBudget,
+                const std::vector<std::string>& everyFrame);
+            ///< \param fullRateDistance Scripts within this distance of the player run every frame.
+            /// At twice the distance and farther away, they run every \a maxInterval seconds.
+            /// 0 runs all scripts every frame.
+            /// \param timeBudget Seconds per frame spent running the scripts outside of
+            /// \a fullRateDistance (0: unlimited). The first of them that is due runs in any case.
+            /// \param everyFrame IDs of scripts that are run every frame anyway.
+
+            void startIteration (float frameDuration, const osg::Vec3f& playerPosition);
             ///< Set the iterator to the begin of the script list.
 
-            bool getNext(std::pair<std::string, Ptr>& script);
-            ///< Get next local script
+            bool getNext (std::pair<std::string, Ptr>& script, float& secondsPassed);
+            ///< Get next local script that is due in this frame
+            /// @param secondsPassed Time since the script ran the last time
             /// @return Did we get a script?
 
             void add (const std::string& scriptName, const Ptr& ptr);
@@ -41,7 +84,7 @@ namespace MWWorld
 
             void clearCell (CellStore *cell);
             ///< Remove all scripts belonging to \a cell.
-            
+
             void remove (RefData *ref);
 
             void remove (const Ptr& ptr);
@@ -0,0 +1,237 @@
+#include "recordpayloads.hpp"
+
+#include <stdexcept>
+
+#include <OpenThreads/ScopedLock>
+
+#include <components/esm/defs.hpp>
+#include <components/esm/esmreader.hpp>
+#include <components/esm/readerpool.hpp>
+#include <components/esm/loadbook.hpp>
+#include <components/esm/loadinfo.hpp>
+#include <components/esm/loadnpc.hpp>
+#include <components/esm/loadscpt.hpp>
+
+namespace MWWorld
+{
+
+    RecordLocation::RecordLocation()
+        : mIndex(-1)
+        , mOffset(0)
+        , mSize(0)
+    {
+    }
+
+    RecordLocation::RecordLocation(ESM::ESMReader& esm)
+    {
+        ESM::ESM_Context context = esm.getContext();
+        mIndex = esm.getIndex();
+        mOffset = context.filePos;
+        mSize = context.leftRec;
+    }
+
+    RecordPayloads::RecordPayloads()
+        : mReaderPool(NULL)
+        , mCacheSize(0)
+    {
+    }
+
+    void RecordPayloads::setReaderPool(ESM::ReaderPool* pool, size_t cacheSize)
+    {
+        mReaderPool = pool;
+        mCacheSize = cacheSize;
+    }
+
+    bool RecordPayloads::isEnabled() const
+    {
+        return mReaderPool && mCacheSize > 0;
+    }
+
+    void RecordPayloads::addFile(ESM::ESMReader& esm)
+    {
+        if (!isEnabled())
+            return;
+
+        size_t index = static_cast<size_t>(esm.getIndex());
+        if (index >= mFiles.size())
+            mFiles.resize(index + 1);
+        mFiles[index] = esm.getContext().filename;
+    }
+
+    void RecordPayloads::addLocation(const void* record, const RecordLocation& location)
+    {
+        if (isEnabled())
+            mLoaded[record] = location;
+    }
+
+    bool RecordPayloads::markUnloaded(const void* record)
+    {
+        Locations::iterator it = mLoaded.find(record);
+        if (it == mLoaded.end())
+            return false;
+
+        mUnloaded[record] = it->second;
+        mLoaded.erase(it);
+        return true;
+    }
+
+    void RecordPayloads::unload(ESM::Script& script)
+    {
+        if (!script.mScriptText.empty() && markUnloaded(&script))
+            std::string().swap(script.mScriptText);
+    }
+
+    void RecordPayloads::unload(ESM::Book& book)
+    {
+        if (!book.mText.empty() && markUnloaded(&book))
+            std::string().swap(book.mText);
+    }
+
+    void RecordPayloads::unload(ESM::DialInfo& info)
+    {
+        if ((!info.mResponse.empty() || !info.mResultScript.empty()) && markUnloaded(&info))
+        {
+            std::string().swap(info.mResponse);
+            std::string().swap(info.mResultScript);
+        }
+    }
+
+    void RecordPayloads::unload(ESM::NPC& npc)
+    {
+        if (!npc.mAiPackage.mList.empty() && markUnloaded(&npc))
+            std::vector<ESM::AIPackage>().swap(npc.mAiPackage.mList);
+    }
+
+    void RecordPayloads::finishUnload()
+    {
+        Locations().swap(mLoaded);
+    }
+
+    std::string RecordPayloads::getScriptText(const ESM::Script& script) const
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+        const Payload* payload = getPayload(&script, ESM::REC_SCPT);
+        return payload ? payload->mText : script.mScriptText;
+    }
+
+    std::string RecordPayloads::getBookText(const ESM::Book& book) const
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+        const Payload* payload = getPayload(&book, ESM::REC_BOOK);
+        return payload ? payload->mText : book.mText;
+    }
+
+    std::string RecordPayloads::getResponse(const ESM::DialInfo& info) const
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+        const Payload* payload = getPayload(&info, ESM::REC_INFO);
+        return payload ? payload->mText : info.mResponse;
+    }
+
+    std::string RecordPayloads::getResultScript(const ESM::DialInfo& info) const
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+        const Payload* payload = getPayload(&info, ESM::REC_INFO);
+        return payload ? payload->mScript : info.mResultScript;
+    }
+
+    ESM::AIPackageList RecordPayloads::getAiPackages(const ESM::NPC& npc) const
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+        const Payload* payload = getPayload(&npc, ESM::REC_NPC_);
+        return payload ? payload->mAiPackages : npc.mAiPackage;
+    }
+
+    const RecordPayloads::Payload* RecordPayloads::getPayload(const void* record, int type) const
+    {
+        Locations::const_iterator location = mUnloaded.find(record);
+        if (location == mUnloaded.end())
+            return NULL;
+
+        CacheIndex::iterator cached = mCacheIndex.find(record);
+        if (cached != mCacheIndex.end())
+        {
+            mCache.splice(mCache.begin(), mCache, cached->second);
+            return &cached->second->second;
+        }
+
+        const RecordLocation& where = location->second;
+        if (where.mIndex < 0 || static_cast<size_t>(where.mIndex) >= mFiles.size())
+            throw std::runtime_error("Record payload refers to an unknown content file");
+
+        // Position the reader as if the record header had just been read
+        ESM::ESM_Context context;
+        context.filename = mFiles[where.mIndex];
+        context.leftRec = where.mSize;
+        context.leftSub = 0;
+        context.leftFile = 0;
+        context.recName.intval = type;
+        context.subName.intval = 0;
+        context.index = where.mIndex;
+        context.subCached = false;
+        context.filePos = where.mOffset;
+
+        mCache.push_front(std::make_pair(record, Payload()));
+        try
+        {
+            ESM::ReaderPool::ScopedReader reader(*mReaderPool, where.mIndex);
+            reader->restoreContext(context);
+            readPayload(*reader, type, mCache.front().second);
+        }
+        catch (...)
+        {
+            mCache.pop_front();
+            throw;
+        }
+        mCacheIndex[record] = mCache.begin();
+
+        while (mCache.size() > mCacheSize)
+        {
+            mCacheIndex.erase(mCache.back().first);
+            mCache.pop_back();
+        }
+
+        return &mCache.front().second;
+    }
+
+    void RecordPayloads::readPayload(ESM::ESMReader& esm, int type, Payload& payload)
+    {
+        bool isDeleted = false;
+
+        switch (type)
+        {
+            case ESM::REC_SCPT:
+            {
+                ESM::Script script;
+                script.load(esm, isDeleted);
+                payload.mText.swap(script.mScriptText);
+                break;
+            }
+            case ESM::REC_BOOK:
+            {
+                ESM::Book book;
+                book.load(esm, isDeleted);
+                payload.mText.swap(book.mText);
+                break;
+            }
+            case ESM::REC_INFO:
+            {
+                ESM::DialInfo info;
+                info.load(esm, isDeleted);
+                payload.mText.swap(info.mResponse);
+                payload.mScript.swap(info.mResultScript);
+                break;
+            }
+            case ESM::REC_NPC_:
+            {
+                ESM::NPC npc;
+                npc.load(esm, isDeleted);
+                payload.mAiPackages.mList.swap(npc.mAiPackage.mList);
+                break;
+            }
+            default:
+                throw std::runtime_error("Record type without a payload");
+        }
+    }
+
+}
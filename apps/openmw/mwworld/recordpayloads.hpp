@@ -0,0 +1,135 @@
+#ifndef OPENMW_MWWORLD_RECORDPAYLOADS_H
+#define OPENMW_MWWORLD_RECORDPAYLOADS_H
+
+#include <list>
+#include <string>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+#include <boost/unordered_map.hpp>
+
+#include <OpenThreads/Mutex>
+
+#include <components/esm/aipackage.hpp>
+
+namespace ESM
+{
+    class ESMReader;
+    class ReaderPool;
+    struct Book;
+    struct DialInfo;
+    struct NPC;
+    struct Script;
+}
+
+namespace MWWorld
+{
+    /// Position of a record in a content file
+    struct RecordLocation
+    {
+        /// Index of the content file
+        int mIndex;
+        /// File offset of the first subrecord
+        size_t mOffset;
+        /// Size of the record, without the record header
+        boost::uint32_t mSize;
+
+        RecordLocation();
+
+        /// Location of the current record of \a esm, whose header must just have been read.
+        explicit RecordLocation(ESM::ESMReader& esm);
+    };
+
+    /// @brief Bulky parts of records that are read from the content files on first access, rather than kept in memory.
+    /// @par These are the text and result script of dialogue infos, script source text, book text and NPC AI packages.
+    /// While loading the content files, ESMStore tells where each of these records came from. ESMStore::setUp then
+    /// drops the payloads of those records, and the accessors read them again through the ReaderPool. The most recently
+    /// used payloads are cached.
+    /// @par Records that were not loaded from a content file, i.e. dynamic records and records read from a content
+    /// snapshot, keep their payloads. The accessors return the record's own field for these.
+    /// @note The accessors are thread safe.
+    class RecordPayloads
+    {
+    public:
+        RecordPayloads();
+
+        /// Enable lazy loading of payloads, must be called before loading the content files.
+        /// @param pool Pool to read the content files with, must outlive this object.
+        /// @param cacheSize Maximum number of records whose payloads are cached.
+        void setReaderPool(ESM::ReaderPool* pool, size_t cacheSize);
+
+        bool isEnabled() const;
+
+        /// Remember the file name of the content file opened in \a esm.
+        void addFile(ESM::ESMReader& esm);
+
+        /// Remember where \a record was loaded from. A record at the same address that was loaded before is
+        /// replaced, i.e. overwritten by a later content file.
+        void addLocation(const void* record, const RecordLocation& location);
+
+        /// Drop the payload of \a record if it was loaded from a content file.
+        /// @note Not thread safe, only call this from ESMStore::setUp.
+        void unload(ESM::Script& script);
+        void unload(ESM::Book& book);
+        void unload(ESM::DialInfo& info);
+        void unload(ESM::NPC& npc);
+
+        /// Forget the locations of records that were not passed to unload(), because they have been removed
+        /// or replaced since.
+        void finishUnload();
+
+        std::string getScriptText(const ESM::Script& script) const;
+
+        std::string getBookText(const ESM::Book& book) const;
+
+        std::string getResponse(const ESM::DialInfo& info) const;
+
+        std::string getResultScript(const ESM::DialInfo& info) const;
+
+        ESM::AIPackageList getAiPackages(const ESM::NPC& npc) const;
+
+    private:
+        // not implemented
+        RecordPayloads(const RecordPayloads&);
+        RecordPayloads& operator=(const RecordPayloads&);
+
+        struct Payload
+        {
+            std::string mText;
+            std::string mScript;
+            ESM::AIPackageList mAiPackages;
+        };
+
+        typedef std::list<std::pair<const void*, Payload> > Cache;
+        typedef boost::unordered_map<const void*, Cache::iterator> CacheIndex;
+        typedef boost::unordered_map<const void*, RecordLocation> Locations;
+
+        /// @return Was the payload of \a record dropped?
+        bool markUnloaded(const void* record);
+
+        /// Look up the payload of an unloaded record of the given ESM::RecordTypes type, reading it if it isn't cached.
+        /// @return NULL if the record's payload was not unloaded.
+        /// @note mMutex must be locked, and the returned payload must be copied before unlocking.
+        const Payload* getPayload(const void* record, int type) const;
+
+        static void readPayload(ESM::ESMReader& esm, int type, Payload& payload);
+
+        ESM::ReaderPool* mReaderPool;
+        size_t mCacheSize;
+
+        /// File names of the content files, by index
+        std::vector<std::string> mFiles;
+
+        /// Locations of the records loaded from content files, before they are unloaded
+        Locations mLoaded;
+        /// Locations of the records whose payloads have been dropped
+        Locations mUnloaded;
+
+        mutable OpenThreads::Mutex mMutex;
+        /// Most recently used first
+        mutable Cache mCache;
+        mutable CacheIndex mCacheIndex;
+    };
+}
+
+#endif
@@ -0,0 +1,87 @@
+#include "refidindex.hpp"
+
+#include <algorithm>
+
+#include "contentrefs.hpp"
+#include "store.hpp"
+
+namespace
+{
+    void indexCell(boost::unordered_map<Misc::StringAtom, MWWorld::RefIdIndex::ContentCells>& index,
+                   const ESM::Cell& cell, ESM::ReaderPool& readers, std::vector<std::string>& ids)
+    {
+        ids.clear();
+        MWWorld::listContentRefIds(cell, readers, ids);
+        ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+        for (std::vector<std::string>::const_iterator it = ids.begin(); it != ids.end(); ++it)
+            index[Misc::StringAtom(*it)].push_back(&cell);
+    }
+}
+
+namespace MWWorld
+{
+
+    RefIdIndex::RefIdIndex()
+        : mPendingCells(NULL), mPendingReaders(NULL)
+    {
+    }
+
+    void RefIdIndex::build(const Store<ESM::Cell>& cells, ESM::ReaderPool& readers)
+    {
+        mPendingCells = NULL;
+        mPendingReaders = NULL;
+        mContent.clear();
+
+        std::vector<std::string> ids;
+        for (Store<ESM::Cell>::iterator it = cells.intBegin(); it != cells.intEnd(); ++it)
+            indexCell(mContent, *it, readers, ids);
+        for (Store<ESM::Cell>::iterator it = cells.extBegin(); it != cells.extEnd(); ++it)
+            indexCell(mContent, *it, readers, ids);
+    }
+
+    void RefIdIndex::buildLater(const Store<ESM::Cell>& cells, ESM::ReaderPool& readers)
+    {
+        mContent.clear();
+        mPendingCells = &cells;
+        mPendingReaders = &readers;
+    }
+
+    bool RefIdIndex::isPending() const
+    {
+        return mPendingCells != NULL;
+    }
+
+    void RefIdIndex::buildPending()
+    {
+        if (mPendingCells)
+            build(*mPendingCells, *mPendingReaders);
+    }
+
+    void RefIdIndex::add(const std::string& id, CellStore* cell)
+    {
+        DynamicCells& dynamicCells = mDynamic[Misc::StringAtom(id)];
+        if (std::find(dynamicCells.begin(), dynamicCells.end(), cell) == dynamicCells.end())
+            dynamicCells.push_back(cell);
+    }
+
+    void RefIdIndex::clearDynamic()
+    {
+        mDynamic.clear();
+    }
+
+    const RefIdIndex::ContentCells* RefIdIndex::getContentCells(const Misc::StringAtom& id)
+    {
+        buildPending();
+
+        boost::unordered_map<Misc::StringAtom, ContentCells>::const_iterator found = mContent.find(id);
+        return found != mContent.end() ? &found->second : NULL;
+    }
+
+    const RefIdIndex::DynamicCells* RefIdIndex::getDynamicCells(const Misc::StringAtom& id) const
+    {
+        boost::unordered_map<Misc::StringAtom, DynamicCells>::const_iterator found = mDynamic.find(id);
+        return found != mDynamic.end() ? &found->second : NULL;
+    }
+
+}
@@ -0,0 +1,74 @@
+#ifndef OPENMW_MWWORLD_REFIDINDEX_H
+#define OPENMW_MWWORLD_REFIDINDEX_H
+
+#include <string>
+#include <vector>
+
+#include <boost/unordered_map.hpp>
+
+#include <components/misc/stringatom.hpp>
+
+namespace ESM
+{
+    class ReaderPool;
+    struct Cell;
+}
+
+namespace MWWorld
+{
+    class CellStore;
+    template <class T> class Store;
+
+    /// @brief Tells which cells may hold a reference to a given object ID.
+    /// @par The references of the content files are listed once, on the first lookup after buildLater(). References
+    /// that enter a cell in any other way, i.e. references placed at runtime, moved between cells or read from a saved
+    /// game, are added by the CellStore they enter.
+    /// @par The index never forgets a cell, so it can name cells that no longer hold the reference, e.g. when the
+    /// reference was deleted or moved on. Search the cells to find the reference itself.
+    class RefIdIndex
+    {
+    public:
+        typedef std::vector<const ESM::Cell*> ContentCells;
+        typedef std::vector<CellStore*> DynamicCells;
+
+        RefIdIndex();
+
+        /// List the references of all cells in \a cells. Replaces the previous content index.
+        void build(const Store<ESM::Cell>& cells, ESM::ReaderPool& readers);
+
+        /// Like build(), but only on the first call to getContentCells(). Listing the references reads every cell in
+        /// the load order, this keeps it out of the startup.
+        /// @note \a cells and \a readers must outlive the index or the next call to build() or buildLater().
+        void buildLater(const Store<ESM::Cell>& cells, ESM::ReaderPool& readers);
+
+        /// Is the content index waiting for the first lookup?
+        bool isPending() const;
+
+        /// Build the content index now, if buildLater() left it pending.
+        /// @note Call before looking up IDs with Misc::StringAtom::find, the index interns the IDs it lists.
+        void buildPending();
+
+        /// Note that a reference to \a id has entered \a cell, after the content files were indexed.
+        void add(const std::string& id, CellStore* cell);
+
+        /// Forget the cells added with add(), e.g. when the CellStores are destroyed.
+        void clearDynamic();
+
+        /// Cells that have references to \a id in the content files. Builds the index if it is pending.
+        /// @return NULL if there are none.
+        const ContentCells* getContentCells(const Misc::StringAtom& id);
+
+        /// Cells that references to \a id have entered since.
+        /// @return NULL if there are none.
+        const DynamicCells* getDynamicCells(const Misc::StringAtom& id) const;
+
+    private:
+        const Store<ESM::Cell>* mPendingCells;
+        ESM::ReaderPool* mPendingReaders;
+
+        boost::unordered_map<Misc::StringAtom, ContentCells> mContent;
+        boost::unordered_map<Misc::StringAtom, DynamicCells> mDynamic;
+    };
+}
+
+#endif
@@ -3,6 +3,8 @@
 #include <limits>
 #include <iostream>
 
+#include <osg/Timer>
+
 #include <components/loadinglistener/loadinglistener.hpp>
 #include <components/misc/resourcehelpers.hpp>
 #include <components/settings/settings.hpp>
@@ -29,20 +31,37 @@
 namespace
 {
 
-    void addObject(const MWWorld::Ptr& ptr, MWPhysics::PhysicsSystem& physics,
-                   MWRender::RenderingManager& rendering)
+    std::string getModel(const MWWorld::Ptr& ptr, MWRender::RenderingManager& rendering)
     {
         std::string model = Misc::ResourceHelpers::correctActorModelPath(ptr.getClass().getModel(ptr), rendering.getResourceSystem()->getVFS());
         std::string id = ptr.getCellRef().getRefId();
         if (id == "prisonmarker" || id == "divinemarker" || id == "templemarker" || id == "northmarker")
             model = ""; // marker objects that have a hardcoded function in the game logic, should be hidden from the player
-        ptr.getClass().insertObjectRendering(ptr, model, rendering);
-        ptr.getClass().insertObject (ptr, model, physics);
+        return model;
+    }
+
+    void addObjectRendering(const MWWorld::Ptr& ptr, MWRender::RenderingManager& rendering)
+    {
+        ptr.getClass().insertObjectRendering(ptr, getModel(ptr, rendering), rendering);
 
         if (ptr.getClass().isActor())
             rendering.addWaterRippleEmitter(ptr);
     }
 
+    /// Add the object to the physics, and actors to the mechanics. The object must be rendered already.
+    void addObjectPhysics(const MWWorld::Ptr& ptr, MWPhysics::PhysicsSystem& physics,
+                          MWRender::RenderingManager& rendering)
+    {
+        ptr.getClass().insertObject (ptr, getModel(ptr, rendering), physics);
+    }
+
+    void addObject(const MWWorld::Ptr& ptr, MWPhysics::PhysicsSystem& physics,
+                   MWRender::RenderingManager& rendering)
+    {
+        addObjectRendering(ptr, rendering);
+        addObjectPhysics(ptr, physics, rendering);
+    }
+
     void updateObjectRotation (const MWWorld::Ptr& ptr, MWPhysics::PhysicsSystem& physics,
                                     MWRender::RenderingManager& rendering, bool inverseRotationOrder)
     {
@@ -79,6 +98,39 @@ namespace
         }
     }
 
+    /// @param addPhysics Add the object to the physics, too? Otherwise it is only rendered.
+    /// @return Was the object added to the scene?
+    bool insertObject(const MWWorld::Ptr& ptr, bool rescale, MWPhysics::PhysicsSystem& physics,
+                      MWRender::RenderingManager& rendering, bool addPhysics = true)
+    {
+        if (rescale)
+        {
+            if (ptr.getCellRef().getScale()<0.5)
+                ptr.getCellRef().setScale(0.5);
+            else if (ptr.getCellRef().getScale()>2)
+                ptr.getCellRef().setScale(2);
+        }
+
+        if (!ptr.getRefData().isDeleted() && ptr.getRefData().isEnabled())
+        {
+            try
+            {
+                if (addPhysics)
+                    addObject(ptr, physics, rendering);
+                else
+                    addObjectRendering(ptr, rendering);
+                updateObjectRotation(ptr, physics, rendering, false);
+                return true;
+            }
+            catch (const std::exception& e)
+            {
+                std::string error ("error during rendering '" + ptr.getCellRef().getRefId() + "': ");
+                std::cerr << error + e.what() << std::endl;
+            }
+        }
+        return false;
+    }
+
     struct InsertVisitor
     {
         MWWorld::CellStore& mCell;
@@ -116,28 +168,7 @@ namespace
     {
         for (std::vector<MWWorld::Ptr>::iterator it = mToInsert.begin(); it != mToInsert.end(); ++it)
         {
-            MWWorld::Ptr ptr = *it;
-            if (mRescale)
-            {
-                if (ptr.getCellRef().getScale()<0.5)
-                    ptr.getCellRef().setScale(0.5);
-                else if (ptr.getCellRef().getScale()>2)
-                    ptr.getCellRef().setScale(2);
-            }
-
-            if (!ptr.getRefData().isDeleted() && ptr.getRefData().isEnabled())
-            {
-                try
-                {
-                    addObject(ptr, mPhysics, mRendering);
-                    updateObjectRotation(ptr, mPhysics, mRendering, false);
-                }
-                catch (const std::exception& e)
-                {
-                    std::string error ("error during rendering '" + ptr.getCellRef().getRefId() + "': ");
-                    std::cerr << error + e.what() << std::endl;
-                }
-            }
+            insertObject(*it, mRescale, mPhysics, mRendering);
 
             mLoadingListener.increaseProgress (1);
         }
@@ -203,6 +234,9 @@ namespace MWWorld
             }
         }
 
+        if (!mPendingInsertions.empty())
+            insertPendingObjects(mInsertionBudget);
+
         mRendering.update (duration, paused);
 
         mPreloader->updateCache(mRendering.getReferenceTime());
@@ -211,6 +245,16 @@ namespace MWWorld
     void Scene::unloadCell (CellStoreCollection::iterator iter)
     {
         std::cout << "Unloading cell\n";
+
+        for (PendingInsertionList::iterator pending = mPendingInsertions.begin(); pending != mPendingInsertions.end(); ++pending)
+        {
+            if (pending->mCell == *iter)
+            {
+                mPendingInsertions.erase(pending);
+                break;
+            }
+        }
+
         ListAndResetObjectsVisitor visitor;
 
         (*iter)->forEach<ListAndResetObjectsVisitor>(visitor);
@@ -242,7 +286,7 @@ namespace MWWorld
         mActiveCells.erase(*iter);
     }
 
-    void Scene::loadCell (CellStore *cell, Loading::Listener* loadingListener, bool respawn)
+    void Scene::loadCell (CellStore *cell, Loading::Listener* loadingListener, bool respawn, bool deferInsertion)
     {
         std::pair<CellStoreCollection::iterator, bool> result = mActiveCells.insert(cell);
 
@@ -281,14 +325,16 @@ namespace MWWorld
 
             // register local scripts
             // do this before insertCell, to make sure we don't add scripts from levelled creature spawning twice
-            MWBase::Environment::get().getWorld()->getLocalScripts().addCell (cell);
+            // Deferred cells register their scripts once all objects are in the scene, see finishInsertion()
+            if (!deferInsertion)
+                MWBase::Environment::get().getWorld()->getLocalScripts().addCell (cell);
 
             if (respawn)
                 cell->respawn();
 
             // ... then references. This is important for adjustPosition to work correctly.
             /// \todo rescale depending on the state of a new GMST
-            insertCell (*cell, true, loadingListener);
+            insertCell (*cell, true, loadingListener, deferInsertion);
 
             mRendering.addCell(cell);
             bool waterEnabled = cell->getCell()->hasWater() || cell->isExterior();
@@ -304,11 +350,27 @@ namespace MWWorld
 
             if (!cell->isExterior() && !(cell->getCell()->mData.mFlags & ESM::Cell::QuasiEx))
                 mRendering.configureAmbient(cell->getCell());
+
+            // keep the preloaded objects until they are in the scene
+            if (deferInsertion)
+                return;
         }
 
         mPreloader->notifyLoaded(cell);
     }
 
+    void Scene::loadCellRefs (CellStore* cell)
+    {
+        if (cell->getState() == CellStore::State_Loaded)
+            return;
+
+        CellStore::ContentRefList refs;
+        if (mPreloader->takeRefs(cell, refs))
+            cell->load(refs);
+        else
+            cell->load();
+    }
+
     void Scene::changeToVoid()
     {
         CellStoreCollection::iterator active = mActiveCells.begin();
@@ -323,6 +385,8 @@ namespace MWWorld
         if (!mCurrentCell || !mCurrentCell->isExterior())
             return;
 
+        finishNearbyInsertions(pos);
+
         // figure out the center of the current cell grid (*not* necessarily mCurrentCell, which is the cell the player is in)
         int cellX, cellY;
         getGridCenter(cellX, cellY);
@@ -334,12 +398,12 @@ namespace MWWorld
         {
             int newX, newY;
             MWBase::Environment::get().getWorld()->positionToIndex(pos.x(), pos.y(), newX, newY);
-            changeCellGrid(newX, newY);
+            changeCellGrid(newX, newY, true, mInsertionBudget > 0);
             //mRendering.updateTerrain();
         }
     }
 
-    void Scene::changeCellGrid (int X, int Y, bool changeEvent)
+    void Scene::changeCellGrid (int X, int Y, bool changeEvent, bool deferInsertion)
     {
         Loading::Listener* loadingListener = MWBase::Environment::get().getWindowManager()->getLoadingScreen();
         Loading::ScopedLoad load(loadingListener);
@@ -366,6 +430,14 @@ namespace MWWorld
         }
 
         int refsToLoad = 0;
+
+        // objects of cells that are still being inserted are finished below
+        if (!deferInsertion)
+        {
+            for (PendingInsertionList::const_iterator pending = mPendingInsertions.begin(); pending != mPendingInsertions.end(); ++pending)
+                refsToLoad += pending->mObjects.size() - pending->mNext;
+        }
+
         // get the number of refs to load
         for (int x=X-mHalfGridSize; x<=X+mHalfGridSize; ++x)
         {
@@ -385,7 +457,12 @@ namespace MWWorld
                 }
 
                 if (iter==mActiveCells.end())
-                    refsToLoad += MWBase::Environment::get().getWorld()->getExterior(x, y)->count();
+                {
+                    CellStore *cell = MWBase::Environment::get().getWorld()->getExterior(x, y, false);
+                    loadCellRefs(cell);
+                    if (!deferInsertion)
+                        refsToLoad += cell->count();
+                }
             }
         }
 
@@ -413,11 +490,14 @@ namespace MWWorld
                 {
                     CellStore *cell = MWBase::Environment::get().getWorld()->getExterior(x, y);
 
-                    loadCell (cell, loadingListener, changeEvent);
+                    loadCell (cell, loadingListener, changeEvent, deferInsertion);
                 }
             }
         }
 
+        if (!deferInsertion)
+            finishInsertions(loadingListener);
+
         CellStore* current = MWBase::Environment::get().getWorld()->getExterior(X,Y);
         MWBase::Environment::get().getWindowManager()->changeCell(current);
 
@@ -457,7 +537,7 @@ namespace MWWorld
         MWBase::Environment::get().getWorld()->adjustSky();
     }
 
-    Scene::Scene (MWRender::RenderingManager& rendering, MWPhysics::PhysicsSystem *physics)
+    Scene::Scene (MWRender::RenderingManager& rendering, MWPhysics::PhysicsSystem *physics, ESM::ReaderPool& readers)
     : mCurrentCell (0), mCellChanged (false), mPhysics(physics), mRendering(rendering)
     , mPreloadTimer(0.f)
     , mHalfGridSize(Settings::Manager::getInt("exterior cell load distance", "Cells"))
@@ -467,8 +547,9 @@ namespace MWWorld
     , mPreloadExteriorGrid(Settings::Manager::getBool("preload exterior grid", "Cells"))
     , mPreloadDoors(Settings::Manager::getBool("preload doors", "Cells"))
     , mPreloadFastTravel(Settings::Manager::getBool("preload fast travel", "Cells"))
+    , mInsertionBudget(Settings::Manager::getFloat("cell insertion budget", "Cells"))
     {
-        mPreloader.reset(new CellPreloader(rendering.getResourceSystem(), physics->getShapeManager(), rendering.getTerrain()));
+        mPreloader.reset(new CellPreloader(rendering.getResourceSystem(), physics->getShapeManager(), rendering.getTerrain(), readers));
         mPreloader->setWorkQueue(mRendering.getWorkQueue());
 
         mPhysics->setUnrefQueue(rendering.getUnrefQueue());
@@ -585,10 +666,22 @@ namespace MWWorld
         mCellChanged = false;
     }
 
-    void Scene::insertCell (CellStore &cell, bool rescale, Loading::Listener* loadingListener)
+    void Scene::insertCell (CellStore &cell, bool rescale, Loading::Listener* loadingListener, bool deferInsertion)
     {
         InsertVisitor insertVisitor (cell, rescale, *loadingListener, *mPhysics, mRendering);
         cell.forEach (insertVisitor);
+
+        if (deferInsertion)
+        {
+            mPendingInsertions.push_back(PendingInsertion());
+            PendingInsertion& pending = mPendingInsertions.back();
+            pending.mCell = &cell;
+            pending.mRescale = rescale;
+            pending.mObjects.swap(insertVisitor.mToInsert);
+            pending.mNext = 0;
+            return;
+        }
+
         insertVisitor.insert();
 
         // do adjustPosition (snapping actors to ground) after objects are loaded, so we don't depend on the loading order
@@ -596,6 +689,102 @@ namespace MWWorld
         cell.forEach (adjustPosVisitor);
     }
 
+    void Scene::insertPendingObjects (float budget)
+    {
+        osg::Timer* timer = osg::Timer::instance();
+        osg::Timer_t start = timer->tick();
+        bool inserted = false;
+
+        while (!mPendingInsertions.empty())
+        {
+            PendingInsertion& pending = mPendingInsertions.front();
+            while (pending.mNext < pending.mObjects.size())
+            {
+                if (inserted && timer->delta_m(start, timer->tick()) >= budget)
+                    return;
+
+                const Ptr& ptr = pending.mObjects[pending.mNext++];
+
+                // the object may have been added already, e.g. by a script enabling it
+                if (!ptr.getRefData().getBaseNode() && insertObject(ptr, pending.mRescale, *mPhysics, mRendering, false))
+                    pending.mRendered.push_back(ptr);
+                inserted = true;
+            }
+
+            finishInsertion(mPendingInsertions.begin(), NULL);
+        }
+    }
+
+    void Scene::finishInsertion (PendingInsertionList::iterator iter, Loading::Listener* loadingListener)
+    {
+        for (; iter->mNext < iter->mObjects.size(); ++iter->mNext)
+        {
+            const Ptr& ptr = iter->mObjects[iter->mNext];
+            if (!ptr.getRefData().getBaseNode() && insertObject(ptr, iter->mRescale, *mPhysics, mRendering, false))
+                iter->mRendered.push_back(ptr);
+
+            if (loadingListener)
+                loadingListener->increaseProgress(1);
+        }
+
+        // The objects collide, and the actors act, only once the whole cell is in the scene
+        for (std::vector<Ptr>::const_iterator it = iter->mRendered.begin(); it != iter->mRendered.end(); ++it)
+        {
+            const Ptr& ptr = *it;
+
+            // skip objects removed from the scene since, and objects added to it again by other means, e.g. a script
+            if (!ptr.getRefData().getBaseNode() || mPhysics->getObject(ptr) || mPhysics->getActor(ptr))
+                continue;
+
+            try
+            {
+                addObjectPhysics(ptr, *mPhysics, mRendering);
+            }
+            catch (const std::exception& e)
+            {
+                std::cerr << "error during rendering '" << ptr.getCellRef().getRefId() << "': " << e.what() << std::endl;
+            }
+        }
+
+        // Objects spawned in the cell in the meantime, e.g. by levelled creature lists, registered their scripts
+        // already. Register the scripts of the whole cell in one go, so that none is added twice.
+        LocalScripts& localScripts = MWBase::Environment::get().getWorld()->getLocalScripts();
+        localScripts.clearCell (iter->mCell);
+        localScripts.addCell (iter->mCell);
+
+        // do adjustPosition (snapping actors to ground) after objects are loaded, so we don't depend on the loading order
+        AdjustPositionVisitor adjustPosVisitor;
+        iter->mCell->forEach (adjustPosVisitor);
+
+        mPreloader->notifyLoaded(iter->mCell);
+
+        mPendingInsertions.erase(iter);
+    }
+
+    void Scene::finishInsertions(Loading::Listener* loadingListener)
+    {
+        while (!mPendingInsertions.empty())
+            finishInsertion(mPendingInsertions.begin(), loadingListener);
+    }
+
+    void Scene::finishNearbyInsertions (const osg::Vec3f& pos)
+    {
+        const float maxDistance = 8192/2 + mCellLoadingThreshold; // 1/2 cell size + threshold
+
+        for (PendingInsertionList::iterator iter = mPendingInsertions.begin(); iter != mPendingInsertions.end();)
+        {
+            float centerX, centerY;
+            MWBase::Environment::get().getWorld()->indexToPosition(iter->mCell->getCell()->getGridX(),
+                iter->mCell->getCell()->getGridY(), centerX, centerY, true);
+            float distance = std::max(std::abs(centerX-pos.x()), std::abs(centerY-pos.y()));
+
+            if (distance < maxDistance)
+                finishInsertion(iter++, NULL);
+            else
+                ++iter;
+        }
+    }
+
     void Scene::addObjectToScene (const Ptr& ptr)
     {
         try
@@ -686,7 +875,7 @@ namespace MWWorld
                     {
                         int x,y;
                         MWBase::Environment::get().getWorld()->positionToIndex (door.getCellRef().getDoorDest().pos[0], door.getCellRef().getDoorDest().pos[1], x, y);
-                        preloadCell(MWBase::Environment::get().getWorld()->getExterior(x,y), true);
+                        preloadCell(MWBase::Environment::get().getWorld()->getExterior(x,y,false), true);
                     }
                 }
                 catch (std::exception& e)
@@ -727,7 +916,7 @@ namespace MWWorld
                 float loadDist = 8192/2 + 8192 - mCellLoadingThreshold + mPreloadDistance;
 
                 if (dist < loadDist)
-                    preloadCell(MWBase::Environment::get().getWorld()->getExterior(cellX+dx, cellY+dy));
+                    preloadCell(MWBase::Environment::get().getWorld()->getExterior(cellX+dx, cellY+dy, false));
             }
         }
     }
@@ -743,7 +932,7 @@ namespace MWWorld
             {
                 for (int dy = -mHalfGridSize; dy <= mHalfGridSize; ++dy)
                 {
-                    mPreloader->preload(MWBase::Environment::get().getWorld()->getExterior(x+dx, y+dy), mRendering.getReferenceTime());
+                    mPreloader->preload(MWBase::Environment::get().getWorld()->getExterior(x+dx, y+dy, false), mRendering.getReferenceTime());
                     if (++numpreloaded >= mPreloader->getMaxCacheSize())
                         break;
                 }
@@ -803,7 +992,7 @@ namespace MWWorld
             {
                 int x,y;
                 MWBase::Environment::get().getWorld()->positionToIndex( it->mPos.pos[0], it->mPos.pos[1], x, y);
-                preloadCell(MWBase::Environment::get().getWorld()->getExterior(x,y), true);
+                preloadCell(MWBase::Environment::get().getWorld()->getExterior(x,y,false), true);
             }
         }
     }
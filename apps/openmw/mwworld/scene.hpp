@@ -5,6 +5,8 @@
 #include "globals.hpp"
 
 #include <set>
+#include <list>
+#include <vector>
 #include <memory>
 
 namespace osg
@@ -15,6 +17,7 @@ namespace osg
 namespace ESM
 {
     struct Position;
+    class ReaderPool;
 }
 
 namespace Files
@@ -68,10 +71,46 @@ namespace MWWorld
             bool mPreloadDoors;
             bool mPreloadFastTravel;
 
-            void insertCell (CellStore &cell, bool rescale, Loading::Listener* loadingListener);
+            /// Objects of an active cell that have not been added to the scene yet
+            struct PendingInsertion
+            {
+                CellStore* mCell;
+                bool mRescale;
+                std::vector<Ptr> mObjects;
+                /// Index of the next object to add
+                size_t mNext;
+                /// Objects that were added to the rendering, but not to the physics yet
+                std::vector<Ptr> mRendered;
+            };
+            typedef std::list<PendingInsertion> PendingInsertionList;
+
+            PendingInsertionList mPendingInsertions;
+            /// Time per frame in milliseconds to spend on adding pending objects to the scene
+            float mInsertionBudget;
+
+            void insertCell (CellStore &cell, bool rescale, Loading::Listener* loadingListener, bool deferInsertion);
+            ///< @param deferInsertion Add the objects over the next frames in update(), instead of right away?
+
+            void insertPendingObjects (float budget);
+            ///< Render pending objects, until \a budget milliseconds have passed. At least one object is added, so
+            /// that the insertion always makes progress.
+
+            void finishInsertion (PendingInsertionList::iterator iter, Loading::Listener* loadingListener);
+            ///< Render all remaining objects of a cell, then add the cell's objects to the physics and register its
+            /// local scripts.
+            /// @param loadingListener Advanced by one for each remaining object, may be NULL.
+
+            void finishInsertions(Loading::Listener* loadingListener);
+
+            void finishNearbyInsertions (const osg::Vec3f& pos);
+            ///< Add all remaining objects of the cells close to \a pos, so that the player never enters an
+            /// incomplete cell.
+
+            /// Load the references of \a cell, using the ones read by the preloader if available.
+            void loadCellRefs (CellStore* cell);
 
             // Load and unload cells as necessary to create a cell grid with "X" and "Y" in the center
-            void changeCellGrid (int X, int Y, bool changeEvent = true);
+            void changeCellGrid (int X, int Y, bool changeEvent = true, bool deferInsertion = false);
 
             void getGridCenter(int& cellX, int& cellY);
 
@@ -84,13 +123,15 @@ namespace MWWorld
 
         public:
 
-            Scene (MWRender::RenderingManager& rendering, MWPhysics::PhysicsSystem *physics);
+            Scene (MWRender::RenderingManager& rendering, MWPhysics::PhysicsSystem *physics, ESM::ReaderPool& readers);
 
             ~Scene();
 
             void unloadCell (CellStoreCollection::iterator iter);
 
-            void loadCell (CellStore *cell, Loading::Listener* loadingListener, bool respawn);
+            void loadCell (CellStore *cell, Loading::Listener* loadingListener, bool respawn, bool deferInsertion = false);
+            ///< @param deferInsertion Add the objects of the cell to the scene over the next frames, instead of
+            /// all at once?
 
             void playerMoved (const osg::Vec3f& pos);
 
@@ -0,0 +1,76 @@
+#include "scriptschedule.hpp"
+
+#include <algorithm>
+
+MWWorld::ScriptSchedule::Entry::Entry()
+: mTimeSinceRun (0), mFrame (0)
+{}
+
+MWWorld::ScriptSchedule::ScriptSchedule()
+: mFullRateDistance (0), mMaxInterval (0), mTimeBudget (0), mFrame (0), mFrameDuration (0),
+  mThrottledTime (0), mThrottledRunning (false), mThrottledStart (0)
+{}
+
+void MWWorld::ScriptSchedule::setSchedule (float fullRateDistance, float maxInterval, double timeBudget)
+{
+    mFullRateDistance = fullRateDistance;
+    mMaxInterval = maxInterval;
+    mTimeBudget = timeBudget;
+}
+
+float MWWorld::ScriptSchedule::getInterval (float distance) const
+{
+    if (mFullRateDistance<=0 || distance<=mFullRateDistance)
+        return 0;
+
+    return mMaxInterval * std::min (1.f, (distance - mFullRateDistance) / mFullRateDistance);
+}
+
+void MWWorld::ScriptSchedule::startFrame (float frameDuration)
+{
+    ++mFrame;
+    mFrameDuration = frameDuration;
+    mThrottledTime = 0;
+    mThrottledRunning = false;
+}
+
+bool MWWorld::ScriptSchedule::isDue (Entry& entry, float interval, double now, float& secondsPassed)
+{
+    // Already looked at in this frame, e.g. before it was moved to the end of the list
+    if (entry.mFrame==mFrame)
+        return false;
+
+    entry.mFrame = mFrame;
+    entry.mTimeSinceRun += mFrameDuration;
+
+    if (interval>0)
+    {
+        if (entry.mTimeSinceRun<interval)
+            return false;
+
+        // mThrottledTime is 0 until the first throttled script has finished, so that one always runs
+        if (mTimeBudget>0 && mThrottledTime>=mTimeBudget)
+            return false;
+
+        mThrottledRunning = true;
+        mThrottledStart = now;
+    }
+
+    secondsPassed = entry.mTimeSinceRun;
+    entry.mTimeSinceRun = 0;
+    return true;
+}
+
+void MWWorld::ScriptSchedule::finishRun (double now)
+{
+    if (mThrottledRunning)
+    {
+        mThrottledTime += now - mThrottledStart;
+        mThrottledRunning = false;
+    }
+}
+
+double MWWorld::ScriptSchedule::getThrottledTime() const
+{
+    return mThrottledTime;
+}
@@ -0,0 +1,71 @@
+#ifndef GAME_MWWORLD_SCRIPTSCHEDULE_H
+#define GAME_MWWORLD_SCRIPTSCHEDULE_H
+
+namespace MWWorld
+{
+    /// \brief Decides which local scripts are due in a frame
+    ///
+    /// Scripts close to the player run every frame. Farther away, the time between two runs grows
+    /// with the distance. These throttled scripts share a time budget per frame, which only counts
+    /// the time spent running them. The first throttled script that is due runs in any case, so
+    /// that they can't be starved.
+    class ScriptSchedule
+    {
+        public:
+
+            /// Scheduling state of one script
+            struct Entry
+            {
+                float mTimeSinceRun;
+
+                /// Number of the last frame in which isDue() looked at this script
+                unsigned int mFrame;
+
+                Entry();
+            };
+
+            ScriptSchedule();
+
+            void setSchedule (float fullRateDistance, float maxInterval, double timeBudget);
+            ///< \param fullRateDistance Scripts within this distance of the player run every frame.
+            /// At twice the distance and farther away, they run every \a maxInterval seconds.
+            /// 0 runs all scripts every frame.
+            /// \param timeBudget Seconds per frame for the throttled scripts (0: unlimited).
+
+            float getInterval (float distance) const;
+            ///< Minimum time between two runs of a script at \a distance from the player
+
+            void startFrame (float frameDuration);
+
+            bool isDue (Entry& entry, float interval, double now, float& secondsPassed);
+            ///< Is the script due in this frame? Only the first call per script and frame can return true.
+            /// \param interval Minimum time between two runs of the script, 0 to run it every frame
+            /// \param now Current time in seconds. A throttled script that is due is taken to run from
+            /// now until the next call to finishRun().
+            /// \param secondsPassed Time since the script ran the last time, set if it is due
+
+            void finishRun (double now);
+            ///< The script that was due last has finished running at \a now (seconds).
+
+            double getThrottledTime() const;
+            ///< Seconds spent running throttled scripts in this frame
+            /// @note Doesn't include the script that is still running.
+
+        private:
+
+            float mFullRateDistance;
+            float mMaxInterval;
+            double mTimeBudget;
+
+            unsigned int mFrame;
+            float mFrameDuration;
+
+            double mThrottledTime;
+
+            /// Start of the run of the throttled script that is running, if any
+            bool mThrottledRunning;
+            double mThrottledStart;
+    };
+}
+
+#endif
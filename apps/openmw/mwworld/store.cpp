@@ -6,6 +6,8 @@
 #include <components/loadinglistener/loadinglistener.hpp>
 #include <components/misc/rng.hpp>
 
+#include <algorithm>
+#include <memory>
 #include <stdexcept>
 #include <sstream>
 
@@ -29,6 +31,21 @@ namespace
         }
     };
 
+    struct ParsedLandTexture : public MWWorld::ParsedRecordOf<ESM::LandTexture>
+    {
+        size_t mPlugin;
+    };
+
+    struct ParsedLand : public MWWorld::ParsedRecord
+    {
+        ParsedLand() : mLand(new ESM::Land), mIsDeleted(false) {}
+        ~ParsedLand() { delete mLand; }
+
+        /// Owned until taken by Store<ESM::Land>::loadParsed
+        ESM::Land *mLand;
+        bool mIsDeleted;
+    };
+
     struct Compare
     {
         bool operator()(const ESM::Land *x, const ESM::Land *y) {
@@ -38,6 +55,97 @@ namespace
             return x->mX < y->mX;
         }
     };
+
+    /// Flags of the record header that are read into a record, see Store::writeStatic.
+    template <typename T>
+    uint32_t getRecordFlags(const T &record)
+    {
+        return 0;
+    }
+
+    template <>
+    uint32_t getRecordFlags<ESM::NPC>(const ESM::NPC &record)
+    {
+        return record.mPersistent ? 0x0400 : 0;
+    }
+
+    template <>
+    uint32_t getRecordFlags<ESM::Creature>(const ESM::Creature &record)
+    {
+        return record.mPersistent ? 0x0400 : 0;
+    }
+
+    /// ESM::ESM_Context without the file name, as written by writeContext.
+    struct ContextData
+    {
+        uint32_t mLeftRec;
+        uint32_t mLeftSub;
+        uint64_t mLeftFile;
+        uint32_t mRecName;
+        uint32_t mSubName;
+        int32_t mIndex;
+        uint32_t mSubCached;
+        uint64_t mFilePos;
+    };
+
+    void writeContext(ESM::ESMWriter &writer, const ESM::ESM_Context &context)
+    {
+        ContextData data;
+        data.mLeftRec = context.leftRec;
+        data.mLeftSub = context.leftSub;
+        data.mLeftFile = context.leftFile;
+        data.mRecName = context.recName.intval;
+        data.mSubName = context.subName.intval;
+        data.mIndex = context.index;
+        data.mSubCached = context.subCached;
+        data.mFilePos = context.filePos;
+
+        writer.writeHNString("CTXF", context.filename);
+        writer.writeHNT("CTXD", data);
+    }
+
+    /// Read a context written by writeContext, the CTXF subrecord name must have been read already.
+    void readContext(ESM::ESMReader &esm, ESM::ESM_Context &context)
+    {
+        context.filename = esm.getHString();
+
+        ContextData data;
+        esm.getHNT(data, "CTXD");
+        context.leftRec = data.mLeftRec;
+        context.leftSub = data.mLeftSub;
+        context.leftFile = static_cast<size_t>(data.mLeftFile);
+        context.recName.intval = data.mRecName;
+        context.subName.intval = data.mSubName;
+        context.index = data.mIndex;
+        context.subCached = data.mSubCached != 0;
+        context.filePos = static_cast<size_t>(data.mFilePos);
+    }
+
+    void writeCell(ESM::ESMWriter &writer, const ESM::Cell &cell)
+    {
+        writer.startRecord(ESM::Cell::sRecordId);
+
+        writer.writeHNString("NAME", cell.mName);
+        writer.writeHNT("DATA", cell.mData, 12);
+        writer.writeHNString("RGNN", cell.mRegion);
+        writer.writeHNT("AMBI", cell.mAmbi, 16);
+        writer.writeHNT("WHGT", cell.mWater);
+        writer.writeHNT("WINT", static_cast<char>(cell.mWaterInt));
+        writer.writeHNT("NAM5", cell.mMapColor);
+        writer.writeHNT("NAM0", cell.mRefNumCounter);
+
+        for (std::vector<ESM::ESM_Context>::const_iterator it = cell.mContextList.begin(); it != cell.mContextList.end(); ++it)
+            writeContext(writer, *it);
+
+        for (ESM::MovedCellRefTracker::const_iterator it = cell.mMovedRefs.begin(); it != cell.mMovedRefs.end(); ++it)
+            writer.writeHNT("MVRF", *it);
+
+        // Leased references come last, they are read until the end of the record
+        for (ESM::CellRefTracker::const_iterator it = cell.mLeasedRefs.begin(); it != cell.mLeasedRefs.end(); ++it)
+            it->save(writer, true);
+
+        writer.endRecord(ESM::Cell::sRecordId);
+    }
 }
 
 namespace MWWorld
@@ -74,6 +182,16 @@ namespace MWWorld
             ret.first->second = record;
     }
     template<typename T>
+    void IndexedStore<T>::writeStatic(ESM::ESMWriter &writer) const
+    {
+        for (typename Static::const_iterator it = mStatic.begin(); it != mStatic.end(); ++it)
+        {
+            writer.startRecord(T::sRecordId);
+            it->second.save(writer);
+            writer.endRecord(T::sRecordId);
+        }
+    }
+    template<typename T>
     int IndexedStore<T>::getSize() const
     {
         return mStatic.size();
@@ -115,6 +233,8 @@ namespace MWWorld
     Store<T>::Store(const Store<T>& orig)
         : mStatic(orig.mStatic)
     {
+        for (typename Static::const_iterator it = mStatic.begin(); it != mStatic.end(); ++it)
+            mIndex[Misc::StringAtom(it->first)] = &it->second;
     }
 
     template<typename T>
@@ -123,25 +243,42 @@ namespace MWWorld
         // remove the dynamic part of mShared
         assert(mShared.size() >= mStatic.size());
         mShared.erase(mShared.begin() + mStatic.size(), mShared.end());
-        mDynamic.clear();
+
+        Dynamic dynamic;
+        dynamic.swap(mDynamic);
+        for (typename Dynamic::const_iterator it = dynamic.begin(); it != dynamic.end(); ++it)
+            unindexDynamic(it->first);
     }
 
     template<typename T>
-    const T *Store<T>::search(const std::string &id) const
+    void Store<T>::unindexDynamic(const std::string &key)
     {
-        T item;
-        item.mId = Misc::StringUtils::lowerCase(id);
+        Misc::StringAtom atom (key);
 
-        typename Dynamic::const_iterator dit = mDynamic.find(item.mId);
-        if (dit != mDynamic.end()) {
-            return &dit->second;
-        }
+        typename Static::const_iterator it = mStatic.find(key);
+        if (it != mStatic.end())
+            mIndex[atom] = &it->second;
+        else
+            mIndex.erase(atom);
+    }
+
+    template<typename T>
+    const T *Store<T>::search(const std::string &id) const
+    {
+        // IDs that were never interned can't belong to any record
+        Misc::StringAtom atom;
+        if (!Misc::StringAtom::find(id, atom))
+            return 0;
 
-        typename std::map<std::string, T>::const_iterator it = mStatic.find(item.mId);
+        return search(atom);
+    }
 
-        if (it != mStatic.end() && Misc::StringUtils::ciEqual(it->second.mId, id)) {
-            return &(it->second);
-        }
+    template<typename T>
+    const T *Store<T>::search(const Misc::StringAtom &id) const
+    {
+        typename Index::const_iterator it = mIndex.find(id);
+        if (it != mIndex.end())
+            return it->second;
 
         return 0;
     }
@@ -172,6 +309,17 @@ namespace MWWorld
         return ptr;
     }
     template<typename T>
+    const T *Store<T>::find(const Misc::StringAtom &id) const
+    {
+        const T *ptr = search(id);
+        if (ptr == 0) {
+            std::ostringstream msg;
+            msg << T::getRecordType() << " '" << id.str() << "' not found";
+            throw std::runtime_error(msg.str());
+        }
+        return ptr;
+    }
+    template<typename T>
     const T *Store<T>::findRandom(const std::string &id) const
     {
         const T *ptr = searchRandom(id);
@@ -192,9 +340,33 @@ namespace MWWorld
         record.load(esm, isDeleted);
         Misc::StringUtils::lowerCaseInPlace(record.mId);
 
+        return insertLoaded(record, isDeleted);
+    }
+    template<typename T>
+    ParsedRecord *Store<T>::parse(ESM::ESMReader &esm) const
+    {
+        std::auto_ptr<ParsedRecordOf<T> > parsed (new ParsedRecordOf<T>);
+        parsed->mIsDeleted = false;
+        parsed->mRecord.load(esm, parsed->mIsDeleted);
+        Misc::StringUtils::lowerCaseInPlace(parsed->mRecord.mId);
+        return parsed.release();
+    }
+    template<typename T>
+    RecordId Store<T>::loadParsed(ParsedRecord &record)
+    {
+        ParsedRecordOf<T> &parsed = static_cast<ParsedRecordOf<T>&>(record);
+        return insertLoaded(parsed.mRecord, parsed.mIsDeleted);
+    }
+    template<typename T>
+    RecordId Store<T>::insertLoaded(const T &record, bool isDeleted)
+    {
         std::pair<typename Static::iterator, bool> inserted = mStatic.insert(std::make_pair(record.mId, record));
         if (inserted.second)
+        {
             mShared.push_back(&inserted.first->second);
+            // a dynamic record with the same ID keeps precedence
+            mIndex.insert(std::make_pair(Misc::StringAtom(record.mId), &inserted.first->second));
+        }
         else
             inserted.first->second = record;
 
@@ -245,6 +417,7 @@ namespace MWWorld
         T *ptr = &result.first->second;
         if (result.second) {
             mShared.push_back(ptr);
+            mIndex[Misc::StringAtom(id)] = ptr;
         } else {
             *ptr = item;
         }
@@ -259,6 +432,7 @@ namespace MWWorld
         T *ptr = &result.first->second;
         if (result.second) {
             mShared.push_back(ptr);
+            mIndex.insert(std::make_pair(Misc::StringAtom(id), ptr));
         } else {
             *ptr = item;
         }
@@ -284,6 +458,11 @@ namespace MWWorld
                 }
                 ++sharedIter;
             }
+
+            typename Index::iterator indexed = mIndex.find(Misc::StringAtom(item.mId));
+            if (indexed != mIndex.end() && indexed->second == &it->second)
+                mIndex.erase(indexed);
+
             mStatic.erase(it);
         }
 
@@ -299,6 +478,7 @@ namespace MWWorld
             return false;
         }
         mDynamic.erase(it);
+        unindexDynamic(key);
 
         // have to reinit the whole shared part
         assert(mShared.size() >= mStatic.size());
@@ -335,6 +515,18 @@ namespace MWWorld
 
         return RecordId(record.mId, isDeleted);
     }
+    template<typename T>
+    void Store<T>::writeStatic(ESM::ESMWriter& writer) const
+    {
+        // The static part of mShared keeps the order of the content files
+        typename std::vector<T *>::const_iterator end = mShared.begin() + mStatic.size();
+        for (typename std::vector<T *>::const_iterator it = mShared.begin(); it != end; ++it)
+        {
+            writer.startRecord(T::sRecordId, getRecordFlags(**it));
+            (*it)->save(writer);
+            writer.endRecord(T::sRecordId);
+        }
+    }
 
     // LandTexture
     //=========================================================================
@@ -396,6 +588,63 @@ namespace MWWorld
     {
         return load(esm, esm.getIndex());
     }
+    ParsedRecord *Store<ESM::LandTexture>::parse(ESM::ESMReader &esm) const
+    {
+        std::auto_ptr<ParsedLandTexture> parsed (new ParsedLandTexture);
+        parsed->mIsDeleted = false;
+        parsed->mPlugin = esm.getIndex();
+        parsed->mRecord.load(esm, parsed->mIsDeleted);
+        return parsed.release();
+    }
+    RecordId Store<ESM::LandTexture>::loadParsed(ParsedRecord &record)
+    {
+        ParsedLandTexture &parsed = static_cast<ParsedLandTexture&>(record);
+        const ESM::LandTexture &lt = parsed.mRecord;
+
+        assert(parsed.mPlugin < mStatic.size());
+
+        LandTextureList &ltexl = mStatic[parsed.mPlugin];
+        if(lt.mIndex + 1 > (int)ltexl.size())
+            ltexl.resize(lt.mIndex+1);
+
+        ltexl[lt.mIndex] = lt;
+
+        return RecordId(lt.mId, parsed.mIsDeleted);
+    }
+    void Store<ESM::LandTexture>::writeStatic(ESM::ESMWriter &writer) const
+    {
+        for (size_t plugin = 0; plugin < mStatic.size(); ++plugin)
+        {
+            const LandTextureList &ltexl = mStatic[plugin];
+            for (size_t index = 0; index < ltexl.size(); ++index)
+            {
+                writer.startRecord(ESM::LandTexture::sRecordId);
+                writer.writeHNT("PLUG", static_cast<uint32_t>(plugin));
+                writer.writeHNT("SLOT", static_cast<uint32_t>(index));
+                ltexl[index].save(writer);
+                writer.endRecord(ESM::LandTexture::sRecordId);
+            }
+        }
+    }
+    RecordId Store<ESM::LandTexture>::readStatic(ESM::ESMReader &esm)
+    {
+        uint32_t plugin, index;
+        esm.getHNT(plugin, "PLUG");
+        esm.getHNT(index, "SLOT");
+
+        ESM::LandTexture lt;
+        bool isDeleted = false;
+        lt.load(esm, isDeleted);
+
+        resize(plugin + 1);
+        LandTextureList &ltexl = mStatic[plugin];
+        if (index + 1 > ltexl.size())
+            ltexl.resize(index + 1);
+
+        ltexl[index] = lt;
+
+        return RecordId(lt.mId, isDeleted);
+    }
     Store<ESM::LandTexture>::iterator Store<ESM::LandTexture>::begin(size_t plugin) const
     {
         assert(plugin < mStatic.size());
@@ -465,6 +714,60 @@ namespace MWWorld
 
         ptr->load(esm, isDeleted);
 
+        return insertLoaded(ptr, isDeleted);
+    }
+    ParsedRecord *Store<ESM::Land>::parse(ESM::ESMReader &esm) const
+    {
+        std::auto_ptr<ParsedLand> parsed (new ParsedLand);
+        parsed->mLand->load(esm, parsed->mIsDeleted);
+        return parsed.release();
+    }
+    RecordId Store<ESM::Land>::loadParsed(ParsedRecord &record)
+    {
+        ParsedLand &parsed = static_cast<ParsedLand&>(record);
+        ESM::Land *ptr = parsed.mLand;
+        parsed.mLand = NULL;
+        return insertLoaded(ptr, parsed.mIsDeleted);
+    }
+    void Store<ESM::Land>::writeStatic(ESM::ESMWriter &writer) const
+    {
+        for (std::vector<ESM::Land *>::const_iterator it = mStatic.begin(); it != mStatic.end(); ++it)
+        {
+            const ESM::Land &land = **it;
+
+            writer.startRecord(ESM::Land::sRecordId);
+            writer.startSubRecord("INTV");
+            writer.writeT(land.mX);
+            writer.writeT(land.mY);
+            writer.endRecord("INTV");
+            writer.writeHNT("DATA", land.mFlags);
+            writer.writeHNT("PLUG", land.mPlugin);
+            writer.writeHNT("DTYP", land.mDataTypes);
+            writeContext(writer, land.mContext);
+            writer.endRecord(ESM::Land::sRecordId);
+        }
+    }
+    RecordId Store<ESM::Land>::readStatic(ESM::ESMReader &esm)
+    {
+        std::auto_ptr<ESM::Land> land (new ESM::Land);
+
+        esm.getSubNameIs("INTV");
+        esm.getSubHeaderIs(8);
+        esm.getT(land->mX);
+        esm.getT(land->mY);
+        esm.getHNT(land->mFlags, "DATA");
+        esm.getHNT(land->mPlugin, "PLUG");
+        esm.getHNT(land->mDataTypes, "DTYP");
+        esm.getSubNameIs("CTXF");
+        readContext(esm, land->mContext);
+
+        // Written without duplicates, no need to search for an existing record
+        mStatic.push_back(land.release());
+
+        return RecordId();
+    }
+    RecordId Store<ESM::Land>::insertLoaded(ESM::Land *ptr, bool isDeleted)
+    {
         // Same area defined in multiple plugins? -> last plugin wins
         // Can't use search() because we aren't sorted yet - is there any other way to speed this up?
         for (std::vector<ESM::Land*>::iterator it = mStatic.begin(); it != mStatic.end(); ++it)
@@ -621,6 +924,33 @@ namespace MWWorld
         for (ExtIterator it = mExt.begin(); it != mExt.end(); ++it) {
             mSharedExt.push_back(&(it->second));
         }
+        std::sort(mSharedExt.begin(), mSharedExt.end(), DynamicExtCmp());
+
+        rebuildExtIndex();
+    }
+    void Store<ESM::Cell>::indexExt(const ESM::Cell *cell)
+    {
+        ExtIndex *indexes[] = { &mExtByName, &mExtByRegion };
+        const std::string *keys[] = { &cell->mName, &cell->mRegion };
+
+        for (int i = 0; i < 2; ++i) {
+            const ESM::Cell *&indexed = (*indexes[i])[Misc::StringAtom(*keys[i])];
+            if ( indexed == 0 ||
+                ( cell->mData.mX > indexed->mData.mX ) ||
+                ( cell->mData.mX == indexed->mData.mX && cell->mData.mY > indexed->mData.mY ) )
+            {
+                indexed = cell;
+            }
+        }
+    }
+    void Store<ESM::Cell>::rebuildExtIndex()
+    {
+        mExtByName.clear();
+        mExtByRegion.clear();
+
+        for (std::vector<ESM::Cell *>::const_iterator it = mSharedExt.begin(); it != mSharedExt.end(); ++it) {
+            indexExt(*it);
+        }
     }
     RecordId Store<ESM::Cell>::load(ESM::ESMReader &esm)
     {
@@ -707,6 +1037,58 @@ namespace MWWorld
 
         return RecordId(cell.mName, isDeleted);
     }
+    void Store<ESM::Cell>::writeStatic(ESM::ESMWriter &writer) const
+    {
+        for (DynamicInt::const_iterator it = mInt.begin(); it != mInt.end(); ++it)
+            writeCell(writer, it->second);
+
+        for (DynamicExt::const_iterator it = mExt.begin(); it != mExt.end(); ++it)
+            writeCell(writer, it->second);
+    }
+    RecordId Store<ESM::Cell>::readStatic(ESM::ESMReader &esm)
+    {
+        ESM::Cell cell;
+        bool isDeleted = false;
+
+        cell.loadNameAndData(esm, isDeleted);
+
+        cell.mRegion = esm.getHNString("RGNN");
+        esm.getHNT(cell.mAmbi, "AMBI", 16);
+        esm.getHNT(cell.mWater, "WHGT");
+        char waterInt;
+        esm.getHNT(waterInt, "WINT");
+        cell.mWaterInt = waterInt != 0;
+        esm.getHNT(cell.mMapColor, "NAM5");
+        esm.getHNT(cell.mRefNumCounter, "NAM0");
+
+        while (esm.isNextSub("CTXF"))
+        {
+            cell.mContextList.push_back(ESM::ESM_Context());
+            readContext(esm, cell.mContextList.back());
+        }
+
+        while (esm.isNextSub("MVRF"))
+        {
+            ESM::MovedCellRef movedRef;
+            esm.getHT(movedRef);
+            cell.mMovedRefs.push_back(movedRef);
+        }
+
+        while (esm.hasMoreSubs())
+        {
+            ESM::CellRef ref;
+            bool deleted = false;
+            ref.load(esm, deleted, true);
+            cell.mLeasedRefs.push_back(ref);
+        }
+
+        if (cell.mData.mFlags & ESM::Cell::Interior)
+            mInt[Misc::StringUtils::lowerCase(cell.mName)] = cell;
+        else
+            mExt[std::make_pair(cell.mData.mX, cell.mData.mY)] = cell;
+
+        return RecordId(cell.mName, isDeleted);
+    }
     Store<ESM::Cell>::iterator Store<ESM::Cell>::intBegin() const
     {
         return iterator(mSharedInt.begin());
@@ -725,35 +1107,21 @@ namespace MWWorld
     }
     const ESM::Cell *Store<ESM::Cell>::searchExtByName(const std::string &id) const
     {
-        ESM::Cell *cell = 0;
-        std::vector<ESM::Cell *>::const_iterator it = mSharedExt.begin();
-        for (; it != mSharedExt.end(); ++it) {
-            if (Misc::StringUtils::ciEqual((*it)->mName, id)) {
-                if ( cell == 0 ||
-                    ( (*it)->mData.mX > cell->mData.mX ) ||
-                    ( (*it)->mData.mX == cell->mData.mX && (*it)->mData.mY > cell->mData.mY ) )
-                {
-                    cell = *it;
-                }
-            }
-        }
-        return cell;
+        Misc::StringAtom atom;
+        if (!Misc::StringAtom::find(id, atom))
+            return 0;
+
+        ExtIndex::const_iterator it = mExtByName.find(atom);
+        return it != mExtByName.end() ? it->second : 0;
     }
     const ESM::Cell *Store<ESM::Cell>::searchExtByRegion(const std::string &id) const
     {
-        ESM::Cell *cell = 0;
-        std::vector<ESM::Cell *>::const_iterator it = mSharedExt.begin();
-        for (; it != mSharedExt.end(); ++it) {
-            if (Misc::StringUtils::ciEqual((*it)->mRegion, id)) {
-                if ( cell == 0 ||
-                    ( (*it)->mData.mX > cell->mData.mX ) ||
-                    ( (*it)->mData.mX == cell->mData.mX && (*it)->mData.mY > cell->mData.mY ) )
-                {
-                    cell = *it;
-                }
-            }
-        }
-        return cell;
+        Misc::StringAtom atom;
+        if (!Misc::StringAtom::find(id, atom))
+            return 0;
+
+        ExtIndex::const_iterator it = mExtByRegion.find(atom);
+        return it != mExtByRegion.end() ? it->second : 0;
     }
     size_t Store<ESM::Cell>::getSize() const
     {
@@ -788,6 +1156,7 @@ namespace MWWorld
 
             ptr = &result.first->second;
             mSharedExt.push_back(ptr);
+            indexExt(ptr);
         } else {
             std::string key = Misc::StringUtils::lowerCase(cell.mName);
 
@@ -815,15 +1184,11 @@ namespace MWWorld
         if (it == mDynamicInt.end()) {
             return false;
         }
-        mDynamicInt.erase(it);
         mSharedInt.erase(
-            mSharedInt.begin() + mSharedInt.size(),
+            std::remove(mSharedInt.begin(), mSharedInt.end(), &it->second),
             mSharedInt.end()
         );
-
-        for (it = mDynamicInt.begin(); it != mDynamicInt.end(); ++it) {
-            mSharedInt.push_back(&it->second);
-        }
+        mDynamicInt.erase(it);
 
         return true;
     }
@@ -835,15 +1200,13 @@ namespace MWWorld
         if (it == mDynamicExt.end()) {
             return false;
         }
-        mDynamicExt.erase(it);
         mSharedExt.erase(
-            mSharedExt.begin() + mSharedExt.size(),
+            std::remove(mSharedExt.begin(), mSharedExt.end(), &it->second),
             mSharedExt.end()
         );
+        mDynamicExt.erase(it);
 
-        for (it = mDynamicExt.begin(); it != mDynamicExt.end(); ++it) {
-            mSharedExt.push_back(&it->second);
-        }
+        rebuildExtIndex();
 
         return true;
     }
@@ -891,6 +1254,42 @@ namespace MWWorld
 
         return RecordId("", isDeleted);
     }
+    void Store<ESM::Pathgrid>::writeStatic(ESM::ESMWriter &writer) const
+    {
+        for (Interior::const_iterator it = mInt.begin(); it != mInt.end(); ++it)
+        {
+            writer.startRecord(ESM::Pathgrid::sRecordId);
+            writer.writeHNT("INTR", static_cast<char>(1));
+            it->second.save(writer);
+            writer.endRecord(ESM::Pathgrid::sRecordId);
+        }
+
+        for (Exterior::const_iterator it = mExt.begin(); it != mExt.end(); ++it)
+        {
+            writer.startRecord(ESM::Pathgrid::sRecordId);
+            writer.writeHNT("INTR", static_cast<char>(0));
+            it->second.save(writer);
+            writer.endRecord(ESM::Pathgrid::sRecordId);
+        }
+    }
+    RecordId Store<ESM::Pathgrid>::readStatic(ESM::ESMReader &esm)
+    {
+        // Whether the pathgrid belongs to an interior cell was decided when loading the content files,
+        // with only the cells loaded up to then. Don't guess again.
+        char interior;
+        esm.getHNT(interior, "INTR");
+
+        ESM::Pathgrid pathgrid;
+        bool isDeleted = false;
+        pathgrid.load(esm, isDeleted);
+
+        if (interior)
+            mInt[pathgrid.mCell] = pathgrid;
+        else
+            mExt[std::make_pair(pathgrid.mData.mX, pathgrid.mData.mY)] = pathgrid;
+
+        return RecordId("", isDeleted);
+    }
     size_t Store<ESM::Pathgrid>::getSize() const
     {
         return mInt.size() + mExt.size();
@@ -1040,6 +1439,13 @@ namespace MWWorld
         }
     }
 
+    template <>
+    ParsedRecord *Store<ESM::Dialogue>::parse(ESM::ESMReader &esm) const
+    {
+        // Merged with the existing record, needs to be read in load()
+        return NULL;
+    }
+
     template <>
     inline RecordId Store<ESM::Dialogue>::load(ESM::ESMReader &esm) {
         // The original letter case of a dialogue ID is saved, because it's printed
@@ -1053,7 +1459,8 @@ namespace MWWorld
         if (found == mStatic.end())
         {
             dialogue.loadData(esm, isDeleted);
-            mStatic.insert(std::make_pair(idLower, dialogue));
+            found = mStatic.insert(std::make_pair(idLower, dialogue)).first;
+            mIndex.insert(std::make_pair(Misc::StringAtom(idLower), &found->second));
         }
         else
         {
@@ -1064,6 +1471,31 @@ namespace MWWorld
         return RecordId(dialogue.mId, isDeleted);
     }
 
+    template <>
+    void Store<ESM::Dialogue>::writeStatic(ESM::ESMWriter& writer) const
+    {
+        for (Static::const_iterator it = mStatic.begin(); it != mStatic.end(); ++it)
+        {
+            const ESM::Dialogue &dialogue = it->second;
+
+            writer.startRecord(ESM::Dialogue::sRecordId);
+            dialogue.save(writer);
+            writer.endRecord(ESM::Dialogue::sRecordId);
+
+            for (ESM::Dialogue::InfoContainer::const_iterator info = dialogue.mInfo.begin(); info != dialogue.mInfo.end(); ++info)
+            {
+                // Deleted INFOs are only kept until setUp() to merge further INFOs, drop them here
+                ESM::Dialogue::LookupMap::const_iterator lookup = dialogue.mLookup.find(info->mId);
+                if (lookup != dialogue.mLookup.end() && lookup->second.second && &*lookup->second.first == &*info)
+                    continue;
+
+                writer.startRecord(ESM::DialInfo::sRecordId);
+                info->save(writer);
+                writer.endRecord(ESM::DialInfo::sRecordId);
+            }
+        }
+    }
+
 }
 
 template class MWWorld::Store<ESM::Activator>;
@@ -5,6 +5,10 @@
 #include <vector>
 #include <map>
 
+#include <boost/unordered_map.hpp>
+
+#include <components/misc/stringatom.hpp>
+
 #include "recordcmp.hpp"
 
 namespace ESM
@@ -27,6 +31,19 @@ namespace MWWorld
         RecordId(const std::string &id = "", bool isDeleted = false);
     };
 
+    /// @brief A record parsed without access to the Store it belongs to, see StoreBase::parse.
+    struct ParsedRecord
+    {
+        virtual ~ParsedRecord() {}
+    };
+
+    template <class T>
+    struct ParsedRecordOf : public ParsedRecord
+    {
+        T mRecord;
+        bool mIsDeleted;
+    };
+
     class StoreBase
     {
     public:
@@ -41,6 +58,14 @@ namespace MWWorld
         virtual int getDynamicSize() const { return 0; }
         virtual RecordId load(ESM::ESMReader &esm) = 0;
 
+        /// Parse the current record of \a esm without accessing the store, so that it can be done on any thread.
+        /// @return the record to pass to loadParsed(), or NULL if records of this store depend on
+        /// previously loaded records and have to be read with load() instead. In that case nothing is read.
+        virtual ParsedRecord *parse(ESM::ESMReader &esm) const { return NULL; }
+
+        /// Insert a record returned by parse(), with the same effect load() would have had.
+        virtual RecordId loadParsed(ParsedRecord &record) { return RecordId(); }
+
         virtual bool eraseStatic(const std::string &id) {return false;}
         virtual void clearDynamic() {}
 
@@ -48,6 +73,12 @@ namespace MWWorld
 
         virtual RecordId read (ESM::ESMReader& reader) { return RecordId(); }
         ///< Read into dynamic storage
+
+        /// Write the static records, as merged from all content files loaded so far. See ESMStore::writeStatic.
+        virtual void writeStatic(ESM::ESMWriter& writer) const = 0;
+
+        /// Read a record written by writeStatic() into static storage.
+        virtual RecordId readStatic(ESM::ESMReader& esm) { return load(esm); }
     };
 
     template <class T>
@@ -66,6 +97,7 @@ namespace MWWorld
         iterator end() const;
 
         void load(ESM::ESMReader &esm);
+        void writeStatic(ESM::ESMWriter& writer) const;
 
         int getSize() const;
         void setUp();
@@ -147,6 +179,10 @@ namespace MWWorld
         typedef std::map<std::string, T> Dynamic;
         typedef std::map<std::string, T> Static;
 
+        // Records by ID, dynamic records take precedence over static records with the same ID
+        typedef boost::unordered_map<Misc::StringAtom, const T *> Index;
+        Index mIndex;
+
         friend class ESMStore;
 
     public:
@@ -161,6 +197,9 @@ namespace MWWorld
 
         const T *search(const std::string &id) const;
 
+        /// Faster than searching by string, for IDs that are looked up often.
+        const T *search(const Misc::StringAtom &id) const;
+
         /**
          * Does the record with this ID come from the dynamic store?
          */
@@ -170,6 +209,7 @@ namespace MWWorld
         const T *searchRandom(const std::string &id) const;
 
         const T *find(const std::string &id) const;
+        const T *find(const Misc::StringAtom &id) const;
 
         /** Returns a random record that starts with the named ID. An exception is thrown if none
          * are found. */
@@ -192,8 +232,17 @@ namespace MWWorld
         bool erase(const T &item);
 
         RecordId load(ESM::ESMReader &esm);
+        ParsedRecord *parse(ESM::ESMReader &esm) const;
+        RecordId loadParsed(ParsedRecord &record);
         void write(ESM::ESMWriter& writer, Loading::Listener& progress) const;
         RecordId read(ESM::ESMReader& reader);
+        void writeStatic(ESM::ESMWriter& writer) const;
+
+    private:
+        RecordId insertLoaded(const T &record, bool isDeleted);
+
+        /// Update mIndex for the record with ID \a key (in lower case), after it was removed from mDynamic.
+        void unindexDynamic(const std::string &key);
     };
 
     template <>
@@ -221,6 +270,10 @@ namespace MWWorld
 
         RecordId load(ESM::ESMReader &esm, size_t plugin);
         RecordId load(ESM::ESMReader &esm);
+        ParsedRecord *parse(ESM::ESMReader &esm) const;
+        RecordId loadParsed(ParsedRecord &record);
+        void writeStatic(ESM::ESMWriter& writer) const;
+        RecordId readStatic(ESM::ESMReader& esm);
 
         iterator begin(size_t plugin) const;
         iterator end(size_t plugin) const;
@@ -246,7 +299,14 @@ namespace MWWorld
         ESM::Land *find(int x, int y) const;
 
         RecordId load(ESM::ESMReader &esm);
+        ParsedRecord *parse(ESM::ESMReader &esm) const;
+        RecordId loadParsed(ParsedRecord &record);
+        void writeStatic(ESM::ESMWriter& writer) const;
+        RecordId readStatic(ESM::ESMReader& esm);
         void setUp();
+
+    private:
+        RecordId insertLoaded(ESM::Land *land, bool isDeleted);
     };
 
     template <>
@@ -254,22 +314,26 @@ namespace MWWorld
     {
         struct DynamicExtCmp
         {
-            bool operator()(const std::pair<int, int> &left, const std::pair<int, int> &right) const {
-                if (left.first == right.first && left.second == right.second)
+            bool operator()(const ESM::Cell *left, const ESM::Cell *right) const {
+                if (left->mData.mX == right->mData.mX && left->mData.mY == right->mData.mY)
                     return false;
 
-                if (left.first == right.first)
-                    return left.second > right.second;
+                if (left->mData.mX == right->mData.mX)
+                    return left->mData.mY > right->mData.mY;
 
                 // Exterior cells are listed in descending, row-major order,
                 // this is a workaround for an ambiguous chargen_plank reference in the vanilla game.
                 // there is one at -22,16 and one at -2,-9, the latter should be used.
-                return left.first > right.first;
+                return left->mData.mX > right->mData.mX;
             }
         };
 
         typedef std::map<std::string, ESM::Cell>                           DynamicInt;
-        typedef std::map<std::pair<int, int>, ESM::Cell, DynamicExtCmp>    DynamicExt;
+        /// Grid index, element addresses are stable
+        typedef boost::unordered_map<std::pair<int, int>, ESM::Cell>       DynamicExt;
+
+        /// Northernmost cell in the easternmost column, by lower case name or region
+        typedef boost::unordered_map<Misc::StringAtom, const ESM::Cell *>  ExtIndex;
 
         DynamicInt      mInt;
         DynamicExt      mExt;
@@ -280,9 +344,16 @@ namespace MWWorld
         DynamicInt mDynamicInt;
         DynamicExt mDynamicExt;
 
+        ExtIndex mExtByName;
+        ExtIndex mExtByRegion;
+
         const ESM::Cell *search(const ESM::Cell &cell) const;
         void handleMovedCellRefs(ESM::ESMReader& esm, ESM::Cell* cell);
 
+        /// Add an exterior cell to mExtByName and mExtByRegion.
+        void indexExt(const ESM::Cell *cell);
+        void rebuildExtIndex();
+
     public:
         typedef SharedIterator<ESM::Cell> iterator;
 
@@ -296,6 +367,8 @@ namespace MWWorld
         void setUp();
 
         RecordId load(ESM::ESMReader &esm);
+        void writeStatic(ESM::ESMWriter& writer) const;
+        RecordId readStatic(ESM::ESMReader& esm);
 
         iterator intBegin() const;
         iterator intEnd() const;
@@ -338,6 +411,8 @@ namespace MWWorld
 
         void setCells(Store<ESM::Cell>& cells);
         RecordId load(ESM::ESMReader &esm);
+        void writeStatic(ESM::ESMWriter& writer) const;
+        RecordId readStatic(ESM::ESMReader& esm);
         size_t getSize() const;
 
         void setUp();
@@ -1,8 +1,13 @@
 #include "worldimp.hpp"
 
+#include <set>
+#include <memory>
+
 #include <osg/Group>
 #include <osg/ComputeBoundsVisitor>
 
+#include <OpenThreads/Thread>
+
 #include <components/esm/esmreader.hpp>
 #include <components/esm/esmwriter.hpp>
 #include <components/esm/cellid.hpp>
@@ -54,6 +59,7 @@
 
 #include "contentloader.hpp"
 #include "esmloader.hpp"
+#include "contentsnapshot.hpp"
 
 namespace
 {
@@ -99,6 +105,16 @@ namespace MWWorld
             }
         }
 
+        void finish()
+        {
+            std::set<ContentLoader*> finished;
+            for (LoadersContainer::iterator it = mLoaders.begin(); it != mLoaders.end(); ++it)
+            {
+                if (finished.insert(it->second).second)
+                    it->second->finish();
+            }
+        }
+
         private:
           typedef std::map<std::string, ContentLoader*> LoadersContainer;
           LoadersContainer mLoaders;
@@ -145,9 +161,10 @@ namespace MWWorld
         const std::vector<std::string>& contentFiles,
         ToUTF8::Utf8Encoder* encoder, const std::map<std::string,std::string>& fallbackMap,
         int activationDistanceOverride, const std::string& startCell, const std::string& startupScript,
-            const std::string& resourcePath)
-    : mResourceSystem(resourceSystem), mFallback(fallbackMap), mPlayer (0), mLocalScripts (mStore),
-      mSky (true), mCells (mStore, mEsm),
+            const std::string& resourcePath, const std::string& contentSnapshotFile)
+    : mResourceSystem(resourceSystem), mFallback(fallbackMap), mPlayer (0),
+      mReaderPool (mEsm, Settings::Manager::getInt("max open content files", "Cells")), mLocalScripts (mStore),
+      mSky (true), mCells (mStore, mReaderPool), mReferenceGeneration (0),
       mGodMode(false), mScriptsEnabled(true), mContentFiles (contentFiles),
       mActivationDistanceOverride (activationDistanceOverride), mStartupScript(startupScript),
       mStartCell (startCell), mTeleportEnabled(true),
@@ -161,8 +178,24 @@ namespace MWWorld
         Loading::Listener* listener = MWBase::Environment::get().getWindowManager()->getLoadingScreen();
         listener->loadingOn();
 
+        std::vector<boost::filesystem::path> contentPaths = findContentFiles(fileCollections, contentFiles);
+
+        int payloadCacheSize = Settings::Manager::getInt("record payload cache size", "General");
+        mStore.getPayloads().setReaderPool(&mReaderPool, std::max(0, payloadCacheSize));
+
+        std::auto_ptr<ContentSnapshot> snapshot;
+        if (!contentSnapshotFile.empty())
+            snapshot.reset(new ContentSnapshot(contentSnapshotFile, contentPaths, encoder->getSourceEncoding()));
+        bool snapshotLoaded = snapshot.get() && snapshot->load(mStore, *listener);
+
         GameContentLoader gameContentLoader(*listener);
-        EsmLoader esmLoader(mStore, mEsm, encoder, *listener);
+        int loadingThreads = Settings::Manager::getInt("content loading threads", "General");
+        if (loadingThreads < 0)
+            loadingThreads = OpenThreads::GetNumberOfProcessors();
+        // With a snapshot, the content files only need to be opened
+        EsmLoader esmLoader(mStore, mEsm, encoder, *listener, snapshotLoaded ? 0 : loadingThreads);
+        esmLoader.setHeadersOnly(snapshotLoaded);
+        esmLoader.setMemoryMapped(Settings::Manager::getBool("memory map content files", "General"));
 
         gameContentLoader.addLoader(".esm", &esmLoader);
         gameContentLoader.addLoader(".esp", &esmLoader);
@@ -170,7 +203,10 @@ namespace MWWorld
         gameContentLoader.addLoader(".omwaddon", &esmLoader);
         gameContentLoader.addLoader(".project", &esmLoader);
 
-        loadContentFiles(fileCollections, contentFiles, gameContentLoader);
+        loadContentFiles(contentPaths, gameContentLoader);
+
+        if (snapshot.get() && !snapshotLoaded)
+            snapshot->save(mStore);
 
         listener->loadingOff();
 
@@ -183,11 +219,16 @@ namespace MWWorld
         mStore.setUp();
         mStore.movePlayerRecord();
 
+        mCells.indexRefs();
+
+        // From now on, content files are only read through the reader pool, which keeps the number of open files bounded
+        mReaderPool.closePrototypes();
+
         mSwimHeightScale = mStore.get<ESM::GameSetting>().find("fSwimHeightScale")->getFloat();
 
         mWeatherManager = new MWWorld::WeatherManager(*mRendering, mFallback, mStore);
 
-        mWorldScene = new Scene(*mRendering, mPhysics);
+        mWorldScene = new Scene(*mRendering, mPhysics, mReaderPool);
     }
 
     void World::fillGlobalVariables()
@@ -263,6 +304,7 @@ namespace MWWorld
                 pos.rot[1] = 0;
                 pos.rot[2] = 0;
                 mWorldScene->changeToExteriorCell(pos, true);
+                ++mReferenceGeneration;
             }
         }
 
@@ -289,6 +331,7 @@ namespace MWWorld
         mLocalScripts.clear();
 
         mWorldScene->changeToVoid();
+        ++mReferenceGeneration;
 
         mStore.clearDynamic();
         mStore.setUp();
@@ -508,9 +551,9 @@ namespace MWWorld
         return &mFallback;
     }
 
-    CellStore *World::getExterior (int x, int y)
+    CellStore *World::getExterior (int x, int y, bool load)
     {
-        return mCells.getExterior (x, y);
+        return mCells.getExterior (x, y, load);
     }
 
     CellStore *World::getInterior (const std::string& name)
@@ -634,7 +677,6 @@ namespace MWWorld
         for (Scene::CellStoreCollection::const_iterator iter (mWorldScene->getActiveCells().begin());
             iter!=mWorldScene->getActiveCells().end(); ++iter)
         {
-            // TODO: caching still doesn't work efficiently here (only works for the one CellStore that the reference is in)
             CellStore* cellstore = *iter;
             Ptr ptr = mCells.getPtr (lowerCaseName, *cellstore, false);
 
@@ -672,6 +714,11 @@ namespace MWWorld
         throw std::runtime_error ("unknown ID: " + name);
     }
 
+    unsigned int World::getReferenceGeneration() const
+    {
+        return mReferenceGeneration;
+    }
+
     Ptr World::searchPtrViaActorId (int actorId)
     {
         // The player is not registered in any CellStore so must be checked manually
@@ -965,6 +1012,7 @@ namespace MWWorld
 
         removeContainerScripts(getPlayerPtr());
         mWorldScene->changeToInteriorCell(cellName, position, adjustPlayerPos, changeEvent);
+        ++mReferenceGeneration;
         addContainerScripts(getPlayerPtr(), getPlayerPtr().getCell());
     }
 
@@ -980,6 +1028,7 @@ namespace MWWorld
         }
         removeContainerScripts(getPlayerPtr());
         mWorldScene->changeToExteriorCell(position, adjustPlayerPos, changeEvent);
+        ++mReferenceGeneration;
         addContainerScripts(getPlayerPtr(), getPlayerPtr().getCell());
     }
 
@@ -1070,6 +1119,7 @@ namespace MWWorld
                 throw std::runtime_error("can not delete player object");
 
             ptr.getRefData().setCount(0);
+            ++mReferenceGeneration;
 
             if (ptr.isInCell()
                 && mWorldScene->getActiveCells().find(ptr.getCell()) != mWorldScene->getActiveCells().end()
@@ -1089,6 +1139,7 @@ namespace MWWorld
         if (ptr.getRefData().isDeleted())
         {
             ptr.getRefData().setCount(1);
+            ++mReferenceGeneration;
             if (mWorldScene->getActiveCells().find(ptr.getCell()) != mWorldScene->getActiveCells().end()
                     && ptr.getRefData().isEnabled())
             {
@@ -1120,6 +1171,7 @@ namespace MWWorld
 
         if (currCell != newCell)
         {
+            ++mReferenceGeneration;
             removeContainerScripts(ptr);
 
             if (isPlayer)
@@ -1195,6 +1247,9 @@ namespace MWWorld
         if (isPlayer)
         {
             mWorldScene->playerMoved(vec);
+            // The active cells may have changed
+            if (mWorldScene->hasCellChanged())
+                ++mReferenceGeneration;
         }
         return newPtr;
     }
@@ -1901,6 +1956,7 @@ namespace MWWorld
 
         MWWorld::Ptr dropped =
             object.getClass().copyToCell(object, *cell, pos, count);
+        ++mReferenceGeneration;
 
         // Reset some position values that could be uninitialized if this item came from a container
         dropped.getCellRef().setPosition(pos);
@@ -2526,18 +2582,22 @@ namespace MWWorld
         return mScriptsEnabled;
     }
 
-    void World::loadContentFiles(const Files::Collections& fileCollections,
-        const std::vector<std::string>& content, ContentLoader& contentLoader)
+    const VFS::Manager* World::getVFS() const
     {
-        std::vector<std::string>::const_iterator it(content.begin());
-        std::vector<std::string>::const_iterator end(content.end());
-        for (int idx = 0; it != end; ++it, ++idx)
+        return mResourceSystem->getVFS();
+    }
+
+    std::vector<boost::filesystem::path> World::findContentFiles(const Files::Collections& fileCollections,
+        const std::vector<std::string>& content) const
+    {
+        std::vector<boost::filesystem::path> paths;
+        for (std::vector<std::string>::const_iterator it = content.begin(); it != content.end(); ++it)
         {
             boost::filesystem::path filename(*it);
             const Files::MultiDirCollection& col = fileCollections.getCollection(filename.extension().string());
             if (col.doesExist(*it))
             {
-                contentLoader.load(col.getPath(*it), idx);
+                paths.push_back(col.getPath(*it));
             }
             else
             {
@@ -2546,6 +2606,17 @@ namespace MWWorld
                 throw std::runtime_error(msg.str());
             }
         }
+        return paths;
+    }
+
+    void World::loadContentFiles(const std::vector<boost::filesystem::path>& content, ContentLoader& contentLoader)
+    {
+        std::vector<boost::filesystem::path>::const_iterator it(content.begin());
+        std::vector<boost::filesystem::path>::const_iterator end(content.end());
+        for (int idx = 0; it != end; ++it, ++idx)
+            contentLoader.load(*it, idx);
+
+        contentLoader.finish();
     }
 
     bool World::startSpellCast(const Ptr &actor)
@@ -7,6 +7,7 @@
 
 #include <components/settings/settings.hpp>
 #include <components/fallback/fallback.hpp>
+#include <components/esm/readerpool.hpp>
 
 #include "../mwbase/world.hpp"
 
@@ -78,6 +79,8 @@ namespace MWWorld
             MWWorld::Scene *mWorldScene;
             MWWorld::Player *mPlayer;
             std::vector<ESM::ESMReader> mEsm;
+            /// Readers for loading cells, copied from mEsm
+            ESM::ReaderPool mReaderPool;
             MWWorld::ESMStore mStore;
             LocalScripts mLocalScripts;
             MWWorld::Globals mGlobalVariables;
@@ -93,6 +96,9 @@ namespace MWWorld
 
             Cells mCells;
 
+            /// See getReferenceGeneration()
+            unsigned int mReferenceGeneration;
+
             std::string mCurrentWorldSpace;
 
             boost::shared_ptr<ProjectileManager> mProjectileManager;
@@ -145,13 +151,19 @@ namespace MWWorld
             void fillGlobalVariables();
 
             /**
-             * @brief loadContentFiles - Loads content files (esm,esp,omwgame,omwaddon)
+             * @brief findContentFiles - Finds the paths of content files, throws if a file does not exist
              * @param fileCollections- Container which holds content file names and their paths
              * @param content - Container which holds content file names
+             */
+            std::vector<boost::filesystem::path> findContentFiles(const Files::Collections& fileCollections,
+                const std::vector<std::string>& content) const;
+
+            /**
+             * @brief loadContentFiles - Loads content files (esm,esp,omwgame,omwaddon)
+             * @param content - Paths of the content files, in load order
              * @param contentLoader -
              */
-            void loadContentFiles(const Files::Collections& fileCollections,
-                const std::vector<std::string>& content, ContentLoader& contentLoader);
+            void loadContentFiles(const std::vector<boost::filesystem::path>& content, ContentLoader& contentLoader);
 
             float mSwimHeightScale;
             bool isUnderwater(const MWWorld::ConstPtr &object, const float heightRatio) const;
@@ -176,7 +188,9 @@ namespace MWWorld
                 const Files::Collections& fileCollections,
                 const std::vector<std::string>& contentFiles,
                 ToUTF8::Utf8Encoder* encoder, const std::map<std::string,std::string>& fallbackMap,
-                int activationDistanceOverride, const std::string& startCell, const std::string& startupScript, const std::string& resourcePath);
+                int activationDistanceOverride, const std::string& startCell, const std::string& startupScript, const std::string& resourcePath,
+                const std::string& contentSnapshotFile);
+            ///< \param contentSnapshotFile Where to cache the records of the content files, see ContentSnapshot. Empty to disable.
 
             virtual ~World();
 
@@ -195,7 +209,7 @@ namespace MWWorld
             virtual void readRecord (ESM::ESMReader& reader, uint32_t type,
                 const std::map<int, int>& contentFileMap);
 
-            virtual CellStore *getExterior (int x, int y);
+            virtual CellStore *getExterior (int x, int y, bool load = true);
 
             virtual CellStore *getInterior (const std::string& name);
 
@@ -270,6 +284,11 @@ namespace MWWorld
             virtual Ptr searchPtrViaActorId (int actorId);
             ///< Search is limited to the active cells.
 
+            virtual unsigned int getReferenceGeneration() const;
+            ///< Changes whenever searchPtr may find a different reference than before, i.e. when the active
+            /// cells change or references are placed, deleted or moved to another cell. Enabling or disabling
+            /// a reference doesn't change it.
+
             virtual MWWorld::Ptr findContainer (const MWWorld::ConstPtr& ptr);
             ///< Return a pointer to a liveCellRef which contains \a ptr.
             /// \note Search is limited to the active cells.
@@ -573,6 +592,8 @@ namespace MWWorld
             virtual bool toggleScripts();
             virtual bool getScriptsEnabled() const;
 
+            virtual const VFS::Manager* getVFS() const;
+
             /**
              * @brief startSpellCast attempt to start casting a spell. Might fail immediately if conditions are not met.
              * @param actor
@@ -0,0 +1,132 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <iterator>
+#include <stdexcept>
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+#include "components/bsa/package_file.hpp"
+
+namespace
+{
+    std::vector<char> readAll(std::istream& stream)
+    {
+        return std::vector<char>((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+    }
+}
+
+struct PackageFileTest : public ::testing::Test
+{
+  protected:
+    virtual void SetUp()
+    {
+        mDirectory = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("openmw-test-%%%%-%%%%");
+        boost::filesystem::create_directories(mDirectory);
+        mPackage = (mDirectory / "test.omwpkg").string();
+
+        mNames.push_back("Meshes\\x\\Ex_Common_Door.nif");
+        mContents.push_back(std::vector<char>(20000, 'a'));
+
+        // Random data doesn't compress and is stored as is
+        mNames.push_back("Textures\\tx_noise.dds");
+        std::srand(42);
+        std::vector<char> noise;
+        for (int i = 0; i < 5000; ++i)
+            noise.push_back(static_cast<char>(std::rand()));
+        mContents.push_back(noise);
+
+        mNames.push_back("Sound\\empty.wav");
+        mContents.push_back(std::vector<char>());
+
+        mNames.push_back("Icons\\m\\Tx_Gold.dds");
+        std::string text = "The quick brown fox jumps over the lazy dog. ";
+        std::vector<char> repeated;
+        for (int i = 0; i < 100; ++i)
+            repeated.insert(repeated.end(), text.begin(), text.end());
+        mContents.push_back(repeated);
+    }
+
+    virtual void TearDown()
+    {
+        boost::filesystem::remove_all(mDirectory);
+    }
+
+    void writePackage()
+    {
+        Bsa::PackageWriter writer(mPackage, mNames);
+        for (size_t i = 0; i < mContents.size(); ++i)
+            writer.addFile(mContents[i]);
+        writer.finish();
+    }
+
+    boost::filesystem::path mDirectory;
+    std::string mPackage;
+    std::vector<std::string> mNames;
+    std::vector<std::vector<char> > mContents;
+};
+
+TEST_F(PackageFileTest, round_trip)
+{
+    writePackage();
+
+    Bsa::PackageFile package;
+    package.open(mPackage);
+
+    ASSERT_EQ(mNames.size(), package.getList().size());
+
+    for (size_t i = 0; i < mNames.size(); ++i)
+    {
+        const Bsa::PackageFile::Entry* entry = package.search(mNames[i].c_str());
+        ASSERT_TRUE(entry != NULL) << mNames[i];
+        EXPECT_EQ(mNames[i], package.getName(*entry));
+        EXPECT_EQ(mContents[i].size(), entry->mSize);
+        EXPECT_EQ(mContents[i], readAll(*package.getFile(entry))) << mNames[i];
+    }
+
+    // Every entry of the list can be read back, too
+    for (Bsa::PackageFile::FileList::const_iterator it = package.getList().begin(); it != package.getList().end(); ++it)
+    {
+        std::vector<std::string>::const_iterator name = std::find(mNames.begin(), mNames.end(), package.getName(*it));
+        ASSERT_TRUE(name != mNames.end());
+        EXPECT_EQ(mContents[name - mNames.begin()], readAll(*package.getFile(&*it)));
+    }
+
+    EXPECT_LT(package.search("meshes\\x\\ex_common_door.nif")->mCompressedSize, mContents[0].size());
+    EXPECT_EQ(mContents[1].size(), package.search("textures\\tx_noise.dds")->mCompressedSize);
+}
+
+TEST_F(PackageFileTest, search_ignores_case_and_slashes)
+{
+    writePackage();
+
+    Bsa::PackageFile package;
+    package.open(mPackage);
+
+    EXPECT_TRUE(package.exists("meshes/X/EX_COMMON_DOOR.NIF"));
+    EXPECT_TRUE(package.exists("icons/m/tx_gold.dds"));
+    EXPECT_FALSE(package.exists("meshes\\x\\ex_common_door"));
+    EXPECT_THROW(package.getFile("textures\\missing.dds"), std::runtime_error);
+}
+
+TEST_F(PackageFileTest, unfinished_package_is_deleted)
+{
+    // An existing package must survive a failed attempt to replace it
+    writePackage();
+    uintmax_t size = boost::filesystem::file_size(mPackage);
+
+    {
+        Bsa::PackageWriter writer(mPackage, mNames);
+        writer.addFile(mContents[0]);
+        EXPECT_THROW(writer.finish(), std::runtime_error);
+    }
+
+    EXPECT_EQ(size, boost::filesystem::file_size(mPackage));
+    EXPECT_FALSE(boost::filesystem::exists(mPackage + ".tmp"));
+
+    Bsa::PackageFile package;
+    package.open(mPackage);
+    EXPECT_EQ(mNames.size(), package.getList().size());
+}
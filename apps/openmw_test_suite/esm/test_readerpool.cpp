@@ -0,0 +1,193 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <sstream>
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+#include <OpenThreads/Thread>
+
+#include "components/esm/esmwriter.hpp"
+#include "components/esm/loadbook.hpp"
+#include "components/esm/readerpool.hpp"
+
+namespace
+{
+    const int sFileCount = 4;
+    const int sMaxOpenFiles = 2;
+
+    /// Number of file descriptors of this process, -1 if unknown
+    int countOpenFiles()
+    {
+#ifdef __linux__
+        int count = 0;
+        for (boost::filesystem::directory_iterator it ("/proc/self/fd"), end; it != end; ++it)
+            ++count;
+        return count;
+#else
+        return -1;
+#endif
+    }
+
+    /// Reads the first record of a file again and again, checking the open file limit while holding the reader
+    class ReadThread : public OpenThreads::Thread
+    {
+    public:
+        ReadThread(ESM::ReaderPool& pool, const std::vector<ESM::ESM_Context>& contexts, int offset)
+            : mPool(pool), mContexts(contexts), mOffset(offset), mMaxOpenFiles(0), mErrors(0)
+        {
+        }
+
+        virtual void run()
+        {
+            for (int i = 0; i < 200; ++i)
+            {
+                int index = (i + mOffset) % sFileCount;
+                ESM::ReaderPool::ScopedReader reader (mPool, index);
+                reader->restoreContext(mContexts[index]);
+                if (!reader->hasMoreRecs() || reader->getRecName() != ESM::Book::sRecordId)
+                    ++mErrors;
+                mMaxOpenFiles = std::max(mMaxOpenFiles, mPool.getOpenFiles());
+            }
+        }
+
+        ESM::ReaderPool& mPool;
+        const std::vector<ESM::ESM_Context>& mContexts;
+        int mOffset;
+        int mMaxOpenFiles;
+        int mErrors;
+    };
+}
+
+struct ReaderPoolTest : public ::testing::Test
+{
+  protected:
+    virtual void SetUp()
+    {
+        mDirectory = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("openmw-test-%%%%-%%%%");
+        boost::filesystem::create_directories(mDirectory);
+
+        for (int i = 0; i < sFileCount; ++i)
+        {
+            std::ostringstream name;
+            name << "file" << i << ".esp";
+            mPaths.push_back((mDirectory / name.str()).string());
+
+            boost::filesystem::ofstream stream (mPaths.back(), std::ios::binary);
+            ESM::ESMWriter writer;
+            writer.setFormat(0);
+            writer.save(stream);
+
+            ESM::Book book;
+            book.blank();
+            book.mId = name.str();
+            writer.startRecord(ESM::Book::sRecordId);
+            book.save(writer);
+            writer.endRecord(ESM::Book::sRecordId);
+            writer.close();
+        }
+    }
+
+    virtual void TearDown()
+    {
+        mReaders.clear();
+        boost::filesystem::remove_all(mDirectory);
+    }
+
+    void openPrototypes(bool memoryMapped)
+    {
+        mReaders.resize(sFileCount);
+        for (int i = 0; i < sFileCount; ++i)
+        {
+            mReaders[i].setMemoryMapped(memoryMapped);
+            mReaders[i].setIndex(i);
+            mReaders[i].open(mPaths[i]);
+            mContexts.push_back(mReaders[i].getContext());
+        }
+    }
+
+    boost::filesystem::path mDirectory;
+    std::vector<std::string> mPaths;
+    std::vector<ESM::ESMReader> mReaders;
+    std::vector<ESM::ESM_Context> mContexts;
+};
+
+TEST_F(ReaderPoolTest, open_files_are_capped)
+{
+    int filesBefore = countOpenFiles();
+
+    openPrototypes(false);
+    ESM::ReaderPool pool (mReaders, sMaxOpenFiles);
+
+    if (filesBefore != -1)
+        EXPECT_EQ(filesBefore + sFileCount, countOpenFiles());
+
+    pool.closePrototypes();
+
+    if (filesBefore != -1)
+        EXPECT_EQ(filesBefore, countOpenFiles());
+
+    for (int round = 0; round < 2; ++round)
+    {
+        for (int i = 0; i < sFileCount; ++i)
+        {
+            ESM::ReaderPool::ScopedReader reader (pool, i);
+            reader->restoreContext(mContexts[i]);
+            ASSERT_TRUE(reader->hasMoreRecs());
+            EXPECT_EQ(ESM::Book::sRecordId, reader->getRecName().intval);
+
+            EXPECT_LE(pool.getOpenFiles(), sMaxOpenFiles);
+            if (filesBefore != -1)
+                EXPECT_LE(countOpenFiles(), filesBefore + sMaxOpenFiles);
+        }
+    }
+
+    pool.clear();
+    EXPECT_EQ(0, pool.getOpenFiles());
+    if (filesBefore != -1)
+        EXPECT_EQ(filesBefore, countOpenFiles());
+}
+
+TEST_F(ReaderPoolTest, open_files_are_capped_across_threads)
+{
+    openPrototypes(false);
+    ESM::ReaderPool pool (mReaders, sMaxOpenFiles);
+    pool.closePrototypes();
+
+    std::vector<ReadThread*> threads;
+    for (int i = 0; i < 4; ++i)
+        threads.push_back(new ReadThread(pool, mContexts, i));
+    for (size_t i = 0; i < threads.size(); ++i)
+        threads[i]->startThread();
+
+    for (size_t i = 0; i < threads.size(); ++i)
+    {
+        threads[i]->join();
+        EXPECT_EQ(0, threads[i]->mErrors);
+        EXPECT_LE(threads[i]->mMaxOpenFiles, sMaxOpenFiles);
+        delete threads[i];
+    }
+}
+
+TEST_F(ReaderPoolTest, idle_mapped_readers_are_capped)
+{
+    openPrototypes(true);
+    ESM::ReaderPool pool (mReaders, sMaxOpenFiles);
+    pool.closePrototypes();
+
+    {
+        // Readers of mapped files never wait, so holding several of them is fine
+        ESM::ReaderPool::ScopedReader reader0 (pool, 0);
+        ESM::ReaderPool::ScopedReader reader1 (pool, 1);
+        ESM::ReaderPool::ScopedReader reader2 (pool, 2);
+        ESM::ReaderPool::ScopedReader reader3 (pool, 3);
+
+        reader3->restoreContext(mContexts[3]);
+        ASSERT_TRUE(reader3->hasMoreRecs());
+        EXPECT_EQ(ESM::Book::sRecordId, reader3->getRecName().intval);
+        EXPECT_EQ(0, pool.getOpenFiles());
+    }
+
+    EXPECT_EQ(static_cast<size_t>(sMaxOpenFiles), pool.getIdleReaders());
+}
@@ -0,0 +1,439 @@
+#include <gtest/gtest.h>
+
+#include <ctime>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+#include <components/compiler/context.hpp>
+#include <components/compiler/extensions.hpp>
+#include <components/compiler/fileparser.hpp>
+#include <components/compiler/locals.hpp>
+#include <components/compiler/optimizer.hpp>
+#include <components/compiler/scanner.hpp>
+#include <components/compiler/streamerrorhandler.hpp>
+
+#include <components/interpreter/context.hpp>
+#include <components/interpreter/installopcodes.hpp>
+#include <components/interpreter/interpreter.hpp>
+
+namespace
+{
+    const int sRuns = 200;
+
+    /// Arithmetic, comparisons, branches and local variables, like the per-frame part of a typical mod script
+    const char *sScript =
+        "begin benchmark\n"
+        "short i\n"
+        "long sum\n"
+        "float f\n"
+        "set i to 0\n"
+        "while ( i < 1000 )\n"
+        "    set sum to sum + i * 3 - ( i / 7 )\n"
+        "    set f to f + 0.5\n"
+        "    if ( sum > 100000 )\n"
+        "        set sum to sum - 100000\n"
+        "    elseif ( sum < 0 )\n"
+        "        set sum to 0\n"
+        "    endif\n"
+        "    set i to i + 1\n"
+        "endwhile\n"
+        "end\n";
+
+    /// Constant expressions, constant conditions, early returns and conversions
+    const char *sScripts[] =
+    {
+        sScript,
+
+        "begin constants\n"
+        "short s\n"
+        "long l\n"
+        "float f\n"
+        "float g\n"
+        "set s to 2 + 3 * 4\n"
+        "set l to -7 / 2\n"
+        "set f to 1.5 * 4 - 0.25\n"
+        "set g to 10 / 4\n"
+        "if ( 1 )\n"
+        "    set s to s + 1\n"
+        "endif\n"
+        "if ( 0 )\n"
+        "    set s to 100\n"
+        "else\n"
+        "    set l to l * 1000000\n"
+        "endif\n"
+        "if ( 2 > 3 )\n"
+        "    set f to 0\n"
+        "elseif ( 3.5 >= 3 )\n"
+        "    set g to g + 0.1\n"
+        "endif\n"
+        "while ( 0 )\n"
+        "    set s to 0\n"
+        "endwhile\n"
+        "set l to l + 16777216\n"
+        "set s to -s\n"
+        "set f to -( -f )\n"
+        "set s to s + 7.9\n"
+        "set f to f + 2 * 3\n"
+        "end\n",
+
+        "begin early\n"
+        "short count\n"
+        "short done\n"
+        "float timer\n"
+        "set count to count + 1\n"
+        "set timer to timer + 0.5 * count\n"
+        "if ( count < 3 )\n"
+        "    return\n"
+        "endif\n"
+        "while ( 1 )\n"
+        "    set done to done + 1\n"
+        "    if ( done >= 10 )\n"
+        "        return\n"
+        "    endif\n"
+        "endwhile\n"
+        "end\n"
+    };
+
+    double elapsedMs(std::clock_t start)
+    {
+        return (std::clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+    }
+
+    class CompilerContext : public Compiler::Context
+    {
+        public:
+
+            virtual bool canDeclareLocals() const { return true; }
+
+            virtual char getGlobalType (const std::string& name) const { return ' '; }
+
+            virtual std::pair<char, bool> getMemberType (const std::string& name, const std::string& id) const
+            {
+                return std::make_pair (' ', false);
+            }
+
+            virtual bool isId (const std::string& name) const { return false; }
+
+            virtual bool isJournalId (const std::string& name) const { return false; }
+    };
+
+    /// Only provides local variables
+    class TestContext : public Interpreter::Context
+    {
+        public:
+
+            std::vector<int> mShorts;
+            std::vector<int> mLongs;
+            std::vector<float> mFloats;
+
+            explicit TestContext (const Compiler::Locals& locals)
+            : mShorts (locals.get ('s').size()), mLongs (locals.get ('l').size()), mFloats (locals.get ('f').size())
+            {}
+
+            virtual int getLocalShort (int index) const { return mShorts.at (index); }
+
+            virtual int getLocalLong (int index) const { return mLongs.at (index); }
+
+            virtual float getLocalFloat (int index) const { return mFloats.at (index); }
+
+            virtual void setLocalShort (int index, int value) { mShorts.at (index) = value; }
+
+            virtual void setLocalLong (int index, int value) { mLongs.at (index) = value; }
+
+            virtual void setLocalFloat (int index, float value) { mFloats.at (index) = value; }
+
+            virtual void messageBox (const std::string& message, const std::vector<std::string>& buttons) {}
+
+            virtual void report (const std::string& message) {}
+
+            virtual bool menuMode() { return false; }
+
+            virtual int getGlobalShort (const std::string& name) const { return 0; }
+
+            virtual int getGlobalLong (const std::string& name) const { return 0; }
+
+            virtual float getGlobalFloat (const std::string& name) const { return 0; }
+
+            virtual void setGlobalShort (const std::string& name, int value) {}
+
+            virtual void setGlobalLong (const std::string& name, int value) {}
+
+            virtual void setGlobalFloat (const std::string& name, float value) {}
+
+            virtual std::vector<std::string> getGlobals () const { return std::vector<std::string>(); }
+
+            virtual char getGlobalType (const std::string& name) const { return ' '; }
+
+            virtual std::string getActionBinding(const std::string& action) const { return ""; }
+
+            virtual std::string getNPCName() const { return ""; }
+
+            virtual std::string getNPCRace() const { return ""; }
+
+            virtual std::string getNPCClass() const { return ""; }
+
+            virtual std::string getNPCFaction() const { return ""; }
+
+            virtual std::string getNPCRank() const { return ""; }
+
+            virtual std::string getPCName() const { return ""; }
+
+            virtual std::string getPCRace() const { return ""; }
+
+            virtual std::string getPCClass() const { return ""; }
+
+            virtual std::string getPCRank() const { return ""; }
+
+            virtual std::string getPCNextRank() const { return ""; }
+
+            virtual int getPCBounty() const { return 0; }
+
+            virtual std::string getCurrentCellName() const { return ""; }
+
+            virtual bool isScriptRunning (const std::string& name) const { return false; }
+
+            virtual void startScript (const std::string& name, const std::string& targetId = "") {}
+
+            virtual void stopScript (const std::string& name) {}
+
+            virtual float getDistance (const std::string& name, const std::string& id = "") const { return 0; }
+
+            virtual float getSecondsPassed() const { return 0; }
+
+            virtual bool isDisabled (const std::string& id = "") const { return false; }
+
+            virtual void enable (const std::string& id = "") {}
+
+            virtual void disable (const std::string& id = "") {}
+
+            virtual int getMemberShort (const std::string& id, const std::string& name, bool global) const { return 0; }
+
+            virtual int getMemberLong (const std::string& id, const std::string& name, bool global) const { return 0; }
+
+            virtual float getMemberFloat (const std::string& id, const std::string& name, bool global) const { return 0; }
+
+            virtual void setMemberShort (const std::string& id, const std::string& name, int value, bool global) {}
+
+            virtual void setMemberLong (const std::string& id, const std::string& name, int value, bool global) {}
+
+            virtual void setMemberFloat (const std::string& id, const std::string& name, float value, bool global) {}
+
+            virtual std::string getTargetId() const { return ""; }
+    };
+
+    /// Counts the instructions and checks that begin and end calls are balanced
+    class CountingProfiler : public Interpreter::Profiler
+    {
+        public:
+
+            int mInstructions;
+            int mDepth;
+
+            CountingProfiler() : mInstructions (0), mDepth (0) {}
+
+            virtual void beginInstruction (int segment, int opcode)
+            {
+                ++mInstructions;
+                ++mDepth;
+            }
+
+            virtual void endInstruction()
+            {
+                --mDepth;
+            }
+    };
+
+    void compile (const std::string& text, std::vector<Interpreter::Type_Code>& code, Compiler::Locals& locals,
+        bool optimize = false)
+    {
+        Compiler::Extensions extensions;
+        CompilerContext context;
+        context.setExtensions (&extensions);
+
+        Compiler::StreamErrorHandler errorHandler (std::cerr);
+        Compiler::FileParser parser (errorHandler, context);
+
+        std::istringstream input (text);
+        Compiler::Scanner scanner (errorHandler, input, context.getExtensions());
+        scanner.scan (parser);
+
+        ASSERT_TRUE (errorHandler.isGood());
+
+        parser.getCode (code);
+        locals = parser.getLocals();
+
+        if (optimize)
+            Compiler::optimize (code);
+    }
+}
+
+/// Running decoded code must have the same effect as running the bytecode.
+TEST(InterpreterTest, decoded_code_gives_same_results)
+{
+    std::vector<Interpreter::Type_Code> code;
+    Compiler::Locals locals;
+    compile (sScript, code, locals);
+
+    Interpreter::Interpreter interpreter;
+    Interpreter::installOpcodes (interpreter);
+
+    TestContext encodedContext (locals);
+    interpreter.run (&code[0], code.size(), encodedContext);
+
+    Interpreter::DecodedCode decoded;
+    interpreter.decode (&code[0], code.size(), decoded);
+    ASSERT_EQ (code[0], decoded.size());
+
+    TestContext decodedContext (locals);
+    interpreter.run (&code[0], code.size(), decoded, decodedContext);
+
+    ASSERT_EQ (1000, decodedContext.mShorts.at (locals.getIndex ("i")));
+    ASSERT_EQ (encodedContext.mShorts, decodedContext.mShorts);
+    ASSERT_EQ (encodedContext.mLongs, decodedContext.mLongs);
+    ASSERT_EQ (encodedContext.mFloats, decodedContext.mFloats);
+}
+
+/// Opcodes that aren't installed are reported when they are executed, not when the code is decoded.
+TEST(InterpreterTest, unknown_opcodes_fail_on_execution)
+{
+    std::vector<Interpreter::Type_Code> code (4, 0);
+    code[0] = 1;
+    code.push_back (0xc8000000 | 0x3ffffff); // segment 5, last extension opcode
+
+    Interpreter::Interpreter interpreter;
+    Interpreter::installOpcodes (interpreter);
+
+    Interpreter::DecodedCode decoded;
+    interpreter.decode (&code[0], code.size(), decoded);
+
+    Compiler::Locals locals;
+    TestContext context (locals);
+    ASSERT_THROW (interpreter.run (&code[0], code.size(), context), std::runtime_error);
+    ASSERT_THROW (interpreter.run (&code[0], code.size(), decoded, context), std::runtime_error);
+}
+
+/// The profiler is told about every instruction, also about one that fails.
+TEST(InterpreterTest, profiler_sees_every_instruction)
+{
+    std::vector<Interpreter::Type_Code> code;
+    Compiler::Locals locals;
+    compile (sScript, code, locals);
+
+    Interpreter::Interpreter interpreter;
+    Interpreter::installOpcodes (interpreter);
+
+    TestContext context (locals);
+    CountingProfiler encodedProfiler;
+    interpreter.setProfiler (&encodedProfiler);
+    interpreter.run (&code[0], code.size(), context);
+
+    Interpreter::DecodedCode decoded;
+    interpreter.decode (&code[0], code.size(), decoded);
+
+    CountingProfiler decodedProfiler;
+    interpreter.setProfiler (&decodedProfiler);
+    interpreter.run (&code[0], code.size(), decoded, context);
+
+    ASSERT_GT (encodedProfiler.mInstructions, 1000);
+    ASSERT_EQ (encodedProfiler.mInstructions, decodedProfiler.mInstructions);
+    ASSERT_EQ (0, encodedProfiler.mDepth);
+    ASSERT_EQ (0, decodedProfiler.mDepth);
+
+    std::vector<Interpreter::Type_Code> unknown (4, 0);
+    unknown[0] = 1;
+    unknown.push_back (0xc8000000 | 0x3ffffff);
+
+    CountingProfiler failingProfiler;
+    interpreter.setProfiler (&failingProfiler);
+    ASSERT_THROW (interpreter.run (&unknown[0], unknown.size(), context), std::runtime_error);
+    ASSERT_EQ (1, failingProfiler.mInstructions);
+    ASSERT_EQ (0, failingProfiler.mDepth);
+}
+
+/// Optimised scripts must leave the same values in the locals as the original ones, run after run.
+TEST(InterpreterTest, optimized_code_gives_same_results)
+{
+    Interpreter::Interpreter interpreter;
+    Interpreter::installOpcodes (interpreter);
+
+    for (std::size_t i = 0; i < sizeof (sScripts) / sizeof (sScripts[0]); ++i)
+    {
+        std::vector<Interpreter::Type_Code> code;
+        Compiler::Locals locals;
+        compile (sScripts[i], code, locals);
+
+        std::vector<Interpreter::Type_Code> optimized;
+        compile (sScripts[i], optimized, locals, true);
+        ASSERT_LT (optimized[0], code[0]);
+
+        TestContext context (locals);
+        TestContext optimizedContext (locals);
+
+        Interpreter::DecodedCode decoded;
+        interpreter.decode (&optimized[0], optimized.size(), decoded);
+
+        for (int run = 0; run < 4; ++run)
+        {
+            interpreter.run (&code[0], code.size(), context);
+            interpreter.run (&optimized[0], optimized.size(), decoded, optimizedContext);
+
+            ASSERT_EQ (context.mShorts, optimizedContext.mShorts);
+            ASSERT_EQ (context.mLongs, optimizedContext.mLongs);
+            ASSERT_EQ (context.mFloats, optimizedContext.mFloats);
+        }
+    }
+}
+
+/// Expressions that fail when they are run are not evaluated by the optimizer.
+TEST(InterpreterTest, optimized_code_keeps_errors)
+{
+    std::vector<Interpreter::Type_Code> code;
+    Compiler::Locals locals;
+    compile ("begin errors\nlong l\nset l to 5 / ( 2 - 2 )\nend\n", code, locals, true);
+
+    Interpreter::Interpreter interpreter;
+    Interpreter::installOpcodes (interpreter);
+
+    TestContext context (locals);
+    ASSERT_THROW (interpreter.run (&code[0], code.size(), context), std::runtime_error);
+}
+
+/// Compares running the bytecode, which decodes every instruction it executes, with running decoded code.
+TEST(InterpreterBenchmark, run_encoded_and_decoded)
+{
+    std::vector<Interpreter::Type_Code> code;
+    Compiler::Locals locals;
+    compile (sScript, code, locals);
+
+    Interpreter::Interpreter interpreter;
+    Interpreter::installOpcodes (interpreter);
+
+    TestContext context (locals);
+
+    std::clock_t start = std::clock();
+    for (int run = 0; run < sRuns; ++run)
+        interpreter.run (&code[0], code.size(), context);
+    double encodedMs = elapsedMs(start);
+
+    Interpreter::DecodedCode decoded;
+    start = std::clock();
+    interpreter.decode (&code[0], code.size(), decoded);
+    for (int run = 0; run < sRuns; ++run)
+        interpreter.run (&code[0], code.size(), decoded, context);
+    double decodedMs = elapsedMs(start);
+
+    std::vector<Interpreter::Type_Code> optimized;
+    compile (sScript, optimized, locals, true);
+
+    Interpreter::DecodedCode optimizedDecoded;
+    start = std::clock();
+    interpreter.decode (&optimized[0], optimized.size(), optimizedDecoded);
+    for (int run = 0; run < sRuns; ++run)
+        interpreter.run (&optimized[0], optimized.size(), optimizedDecoded, context);
+    double optimizedMs = elapsedMs(start);
+
+    std::cout << sRuns << " runs of a " << code[0] << " instruction script: bytecode " << encodedMs
+              << " ms, decoded " << decodedMs << " ms, optimized (" << optimized[0] << " instructions) "
+              << optimizedMs << " ms" << std::endl;
+}
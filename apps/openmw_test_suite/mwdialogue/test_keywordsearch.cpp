@@ -1,6 +1,142 @@
 #include <gtest/gtest.h>
+
+#include <cctype>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <map>
+#include <sstream>
+
 #include "apps/openmw/mwdialogue/keywordsearch.hpp"
 
+namespace
+{
+    typedef MWDialogue::KeywordSearch<std::string, int> Search;
+
+    /// The search KeywordSearch used to do: walk a trie from every word start, keep the longest keyword.
+    class ReferenceSearch
+    {
+        struct Node
+        {
+            int mValue;
+            std::map<char, Node> mChildren;
+
+            Node() : mValue(-1) {}
+        };
+
+        Node mRoot;
+
+    public:
+        void seed(const std::string& keyword, int value)
+        {
+            Node* node = &mRoot;
+            for (std::string::const_iterator it = keyword.begin(); it != keyword.end(); ++it)
+                node = &node->mChildren[Misc::StringUtils::toLower(*it)];
+            node->mValue = value;
+        }
+
+        void highlightKeywords(Search::Point beg, Search::Point end, std::vector<Search::Match>& out) const
+        {
+            std::vector<Search::Match> matches;
+            for (Search::Point i = beg; i != end; ++i)
+            {
+                if (i != beg && isalpha(*(i - 1)))
+                    continue;
+
+                Search::Match match;
+                match.mValue = -1;
+
+                const Node* node = &mRoot;
+                for (Search::Point j = i; j != end; ++j)
+                {
+                    std::map<char, Node>::const_iterator child = node->mChildren.find(Misc::StringUtils::toLower(*j));
+                    if (child == node->mChildren.end())
+                        break;
+
+                    node = &child->second;
+                    if (node->mValue != -1)
+                    {
+                        match.mBeg = i;
+                        match.mEnd = j + 1;
+                        match.mValue = node->mValue;
+                    }
+                }
+
+                if (match.mValue != -1)
+                    matches.push_back(match);
+            }
+
+            // resolve overlapping keywords, see KeywordSearch::highlightKeywords
+            while (!matches.empty())
+            {
+                std::vector<Search::Match>::iterator longestKeyword = matches.begin();
+                for (std::vector<Search::Match>::iterator it = matches.begin(); it != matches.end(); ++it)
+                {
+                    if (it->mEnd - it->mBeg > longestKeyword->mEnd - longestKeyword->mBeg)
+                        longestKeyword = it;
+
+                    if (it + 1 == matches.end() || it->mEnd <= (it + 1)->mBeg)
+                        break;
+                }
+
+                Search::Match keyword = *longestKeyword;
+                matches.erase(longestKeyword);
+                out.push_back(keyword);
+
+                for (std::vector<Search::Match>::iterator it = matches.begin(); it != matches.end();)
+                {
+                    if (it->mBeg < keyword.mEnd && it->mEnd > keyword.mBeg)
+                        it = matches.erase(it);
+                    else
+                        ++it;
+                }
+            }
+
+            std::sort(out.begin(), out.end(), Search::sortMatches);
+        }
+    };
+
+    /// Matches as "begin-end:value", separated by spaces
+    std::string describe(const std::string& text, const std::vector<Search::Match>& matches)
+    {
+        std::ostringstream stream;
+        for (std::vector<Search::Match>::const_iterator it = matches.begin(); it != matches.end(); ++it)
+            stream << (it->mBeg - text.begin()) << "-" << (it->mEnd - text.begin()) << ":" << it->mValue << " ";
+        return stream.str();
+    }
+
+    std::string randomWord(const char* const* words, int count)
+    {
+        std::string word = words[std::rand() % count];
+        if (std::rand() % 4 == 0)
+            word[0] = std::toupper(word[0]);
+        return word;
+    }
+
+    /// Topic name made of syllables, like "Vivec" or "Dagoth Ur"
+    std::string makeTopic(int index)
+    {
+        static const char* syllables[] = { "ba", "dra", "el", "fa", "gu", "ha", "ka", "lo", "mo", "nu", "or", "ra",
+                                           "sa", "te", "ul", "vi", "ya", "zu" };
+        const int count = sizeof(syllables) / sizeof(syllables[0]);
+
+        std::string topic;
+        int words = 1 + index % 3;
+        for (int word = 0; word < words; ++word)
+        {
+            if (word > 0)
+                topic += ' ';
+            int value = index * 7 + word;
+            for (int syllable = 0; syllable < 2 + word % 2; ++syllable)
+            {
+                topic += syllables[value % count];
+                value = value / count + 1;
+            }
+        }
+        return topic;
+    }
+}
+
 struct KeywordSearchTest : public ::testing::Test
 {
   protected:
@@ -65,3 +201,116 @@ TEST_F(KeywordSearchTest, keyword_test_conflict_resolution3)
     ASSERT_TRUE (matches.size() == 1);
     ASSERT_TRUE (std::string(matches.front().mBeg, matches.front().mEnd) == "bar lock");
 }
+
+TEST_F(KeywordSearchTest, keyword_test_word_start)
+{
+    // keywords are found at the start of words only, and ignoring case
+    MWDialogue::KeywordSearch<std::string, int> search;
+    search.seed("bar", 1);
+    search.seed("Dwemer", 2);
+
+    std::string text = "foobar Bar dwemerology, (DWEMER)";
+
+    std::vector<MWDialogue::KeywordSearch<std::string, int>::Match> matches;
+    search.highlightKeywords(text.begin(), text.end(), matches);
+
+    ASSERT_EQ ("7-10:1 11-17:2 25-31:2 ", describe(text, matches));
+
+    int value = 0;
+    ASSERT_TRUE (search.containsKeyword("BAR", value));
+    ASSERT_EQ (1, value);
+    ASSERT_FALSE (search.containsKeyword("ba", value));
+
+    ASSERT_THROW (search.seed("DWEMER", 3), std::runtime_error);
+}
+
+TEST_F(KeywordSearchTest, keyword_test_same_as_reference)
+{
+    // random texts over a few words, so that keywords overlap and are prefixes and suffixes of each other
+    const char* words[] = { "the", "dwemer", "dwe", "language", "foo", "bar", "barlock", "lock", "so", "oo", "ar" };
+    const int wordCount = sizeof(words) / sizeof(words[0]);
+    const char* separators[] = { " ", " ", ", ", "-", "" };
+    const int separatorCount = sizeof(separators) / sizeof(separators[0]);
+
+    std::srand(42);
+    for (int round = 0; round < 500; ++round)
+    {
+        Search search;
+        ReferenceSearch reference;
+
+        std::map<std::string, int> keywords;
+        for (int i = 0; i < 1 + round % 12; ++i)
+        {
+            std::string keyword = randomWord(words, wordCount);
+            for (int extra = std::rand() % 3; extra > 0; --extra)
+                keyword += " " + randomWord(words, wordCount);
+            keywords.insert(std::make_pair(Misc::StringUtils::lowerCase(keyword), i));
+        }
+
+        for (std::map<std::string, int>::const_iterator it = keywords.begin(); it != keywords.end(); ++it)
+        {
+            search.seed(it->first, it->second);
+            reference.seed(it->first, it->second);
+        }
+
+        std::string text;
+        for (int i = 0; i < 20; ++i)
+            text += randomWord(words, wordCount) + separators[std::rand() % separatorCount];
+
+        std::vector<Search::Match> matches, expected;
+        search.highlightKeywords(text.begin(), text.end(), matches);
+        reference.highlightKeywords(text.begin(), text.end(), expected);
+
+        ASSERT_EQ (describe(text, expected), describe(text, matches)) << text;
+    }
+}
+
+/// Compares the automaton with the trie walk from every word start, for as many topics as a game with mods has.
+TEST_F(KeywordSearchTest, keyword_benchmark)
+{
+    const int topicCount = 5000;
+    const int rounds = 200;
+
+    Search search;
+    ReferenceSearch reference;
+    for (int i = 0; i < topicCount; ++i)
+    {
+        int value = 0;
+        std::string topic = makeTopic(i);
+        if (search.containsKeyword(topic, value))
+            continue;
+
+        search.seed(topic, i);
+        reference.seed(topic, i);
+    }
+
+    // a long response, mentioning a topic now and then
+    std::string text;
+    for (int i = 0; i < 200; ++i)
+        text += (i % 10 == 0 ? makeTopic(i * 13) : makeTopic(i * 7 + topicCount).substr(0, 5)) + " ";
+
+    std::vector<Search::Match> matches, expected;
+    search.highlightKeywords(text.begin(), text.end(), matches);
+    reference.highlightKeywords(text.begin(), text.end(), expected);
+    ASSERT_EQ (describe(text, expected), describe(text, matches));
+    ASSERT_FALSE (matches.empty());
+
+    std::clock_t start = std::clock();
+    for (int round = 0; round < rounds; ++round)
+    {
+        expected.clear();
+        reference.highlightKeywords(text.begin(), text.end(), expected);
+    }
+    double referenceMs = (std::clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+
+    start = std::clock();
+    for (int round = 0; round < rounds; ++round)
+    {
+        matches.clear();
+        search.highlightKeywords(text.begin(), text.end(), matches);
+    }
+    double searchMs = (std::clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+
+    std::cout << rounds << " searches of " << text.size() << " characters for " << topicCount
+              << " topics: trie per word " << referenceMs << " ms, automaton " << searchMs << " ms" << std::endl;
+}
@@ -0,0 +1,175 @@
+#include <gtest/gtest.h>
+
+#include <list>
+#include <string>
+#include <vector>
+
+#include "apps/openmw/mwworld/scriptschedule.hpp"
+
+namespace
+{
+    /// Local scripts with a fixed distance to the player and a clock that only moves when told to, iterated the way
+    /// LocalScripts::getNext does.
+    class Scripts
+    {
+        struct Script
+        {
+            std::string mName;
+            float mDistance;
+            MWWorld::ScriptSchedule::Entry mEntry;
+        };
+
+        std::list<Script> mScripts;
+        std::list<Script>::iterator mIter;
+
+    public:
+        MWWorld::ScriptSchedule mSchedule;
+        double mNow;
+
+        Scripts() : mNow(0) {}
+
+        void add(const std::string& name, float distance)
+        {
+            Script script;
+            script.mName = name;
+            script.mDistance = distance;
+            mScripts.push_back(script);
+        }
+
+        void startIteration(float frameDuration)
+        {
+            mIter = mScripts.begin();
+            mSchedule.startFrame(frameDuration);
+        }
+
+        bool getNext(std::string& name, float& secondsPassed)
+        {
+            mSchedule.finishRun(mNow);
+
+            while (mIter != mScripts.end())
+            {
+                std::list<Script>::iterator iter = mIter++;
+
+                float interval = mSchedule.getInterval(iter->mDistance);
+
+                if (!mSchedule.isDue(iter->mEntry, interval, mNow, secondsPassed))
+                    continue;
+
+                if (interval > 0)
+                    mScripts.splice(mScripts.end(), mScripts, iter);
+
+                name = iter->mName;
+                return true;
+            }
+            return false;
+        }
+
+        /// Run a frame in which each script takes \a runTime seconds.
+        std::vector<std::string> frame(float frameDuration, double runTime)
+        {
+            std::vector<std::string> names;
+            startIteration(frameDuration);
+
+            std::string name;
+            float secondsPassed;
+            while (getNext(name, secondsPassed))
+            {
+                names.push_back(name);
+                mNow += runTime;
+            }
+            return names;
+        }
+    };
+
+    std::string join(const std::vector<std::string>& names)
+    {
+        std::string joined;
+        for (std::vector<std::string>::const_iterator it = names.begin(); it != names.end(); ++it)
+            joined += (it == names.begin() ? "" : " ") + *it;
+        return joined;
+    }
+}
+
+TEST(ScriptScheduleTest, interval_grows_with_distance)
+{
+    MWWorld::ScriptSchedule schedule;
+    ASSERT_EQ(0.f, schedule.getInterval(100000));
+
+    schedule.setSchedule(1000, 2, 0);
+    ASSERT_EQ(0.f, schedule.getInterval(0));
+    ASSERT_EQ(0.f, schedule.getInterval(1000));
+    ASSERT_FLOAT_EQ(1.f, schedule.getInterval(1500));
+    ASSERT_FLOAT_EQ(2.f, schedule.getInterval(2000));
+    ASSERT_FLOAT_EQ(2.f, schedule.getInterval(100000));
+}
+
+TEST(ScriptScheduleTest, far_scripts_run_once_per_interval)
+{
+    Scripts scripts;
+    scripts.mSchedule.setSchedule(1000, 1, 0);
+    scripts.add("near", 500);
+    scripts.add("far", 5000);
+
+    // The far script has to wait a full interval first, and gets the time since its last run
+    for (int i = 0; i < 7; ++i)
+        ASSERT_EQ("near", join(scripts.frame(0.125f, 0)));
+
+    scripts.startIteration(0.125f);
+    std::string name;
+    float secondsPassed = 0;
+    ASSERT_TRUE(scripts.getNext(name, secondsPassed));
+    ASSERT_EQ("near", name);
+    ASSERT_FLOAT_EQ(0.125f, secondsPassed);
+    ASSERT_TRUE(scripts.getNext(name, secondsPassed));
+    ASSERT_EQ("far", name);
+    ASSERT_FLOAT_EQ(1.f, secondsPassed);
+    ASSERT_FALSE(scripts.getNext(name, secondsPassed));
+
+    ASSERT_EQ("near", join(scripts.frame(0.125f, 0)));
+}
+
+TEST(ScriptScheduleTest, budget_counts_throttled_scripts_only)
+{
+    Scripts scripts;
+    scripts.mSchedule.setSchedule(1000, 0.1f, 0.01);
+    scripts.add("near", 500);
+    scripts.add("far1", 5000);
+    scripts.add("far2", 5000);
+    scripts.add("far3", 5000);
+
+    // The near script takes far longer than the budget, the far ones still run
+    scripts.startIteration(1);
+    std::string name;
+    float secondsPassed;
+    ASSERT_TRUE(scripts.getNext(name, secondsPassed));
+    ASSERT_EQ("near", name);
+    scripts.mNow += 1;
+    ASSERT_TRUE(scripts.getNext(name, secondsPassed));
+    ASSERT_EQ("far1", name);
+    scripts.mNow += 0.004;
+    ASSERT_TRUE(scripts.getNext(name, secondsPassed));
+    ASSERT_EQ("far2", name);
+    ASSERT_NEAR(0.004, scripts.mSchedule.getThrottledTime(), 1e-6);
+
+    // far2 uses up the budget, far3 has to wait for the next frame
+    scripts.mNow += 0.008;
+    ASSERT_FALSE(scripts.getNext(name, secondsPassed));
+    ASSERT_NEAR(0.012, scripts.mSchedule.getThrottledTime(), 1e-6);
+
+    // far3 waited longest and runs first
+    ASSERT_EQ("near far3 far1", join(scripts.frame(1, 0.006)));
+}
+
+TEST(ScriptScheduleTest, one_throttled_script_runs_per_frame)
+{
+    Scripts scripts;
+    scripts.mSchedule.setSchedule(1000, 0.1f, 0.001);
+    scripts.add("near", 500);
+    scripts.add("far1", 5000);
+    scripts.add("far2", 5000);
+
+    // Each far script alone takes longer than the budget, they take turns
+    ASSERT_EQ("near far1", join(scripts.frame(1, 0.01)));
+    ASSERT_EQ("near far2", join(scripts.frame(1, 0.01)));
+    ASSERT_EQ("near far1", join(scripts.frame(1, 0.01)));
+}
@@ -1,13 +1,17 @@
 #include <gtest/gtest.h>
 
 #include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
 
 #include <components/files/configurationmanager.hpp>
 #include <components/esm/esmreader.hpp>
 #include <components/esm/esmwriter.hpp>
+#include <components/esm/readerpool.hpp>
 #include <components/loadinglistener/loadinglistener.hpp>
 
 #include "apps/openmw/mwworld/esmstore.hpp"
+#include "apps/openmw/mwworld/contentrefs.hpp"
+#include "apps/openmw/mwworld/refidindex.hpp"
 
 static Loading::Listener dummyListener;
 
@@ -313,3 +317,445 @@ TEST_F(StoreTest, overwrite_test)
 
     ASSERT_TRUE (overwrittenRec && overwrittenRec->mModel == "the_new_model");
 }
+
+/// Tests that parsing content files separately and merging them gives the same result as loading them.
+TEST_F(StoreTest, parse_and_merge_test)
+{
+    typedef ESM::Apparatus RecordType;
+
+    RecordType record;
+    record.blank();
+    record.mId = "foobar";
+
+    ESM::ESMReader reader;
+    std::vector<ESM::ESMReader> readerList;
+    readerList.push_back(reader);
+    reader.setGlobalReaderList(&readerList);
+
+    MWWorld::ESMStore loadedStore;
+
+    // insert, delete, insert again
+    bool deleted[] = { false, true, false };
+    for (int i = 0; i < 3; ++i)
+    {
+        reader.open(getEsmFile(record, deleted[i]), "filename");
+        loadedStore.load(reader, &dummyListener);
+
+        ESM::ESMReader parseReader;
+        parseReader.open(getEsmFile(record, deleted[i]), "filename");
+        MWWorld::ParsedContentFile parsed;
+        mEsmStore.parse(parseReader, parsed);
+        ASSERT_TRUE (parsed.mError.empty());
+
+        reader.open(getEsmFile(record, deleted[i]), "filename");
+        mEsmStore.merge(reader, parsed, &dummyListener);
+
+        loadedStore.setUp();
+        mEsmStore.setUp();
+
+        ASSERT_EQ (loadedStore.get<RecordType>().getSize(), mEsmStore.get<RecordType>().getSize());
+        ASSERT_EQ (deleted[i] ? 0u : 1u, mEsmStore.get<RecordType>().getSize());
+    }
+}
+
+/// Tests that the records written by ESMStore::writeStatic are read back unchanged.
+TEST_F(StoreTest, write_and_read_static_test)
+{
+    typedef ESM::Apparatus RecordType;
+
+    RecordType record;
+    record.blank();
+    record.mId = "Foobar";
+    record.mModel = "the_model";
+
+    ESM::ESMReader reader;
+    std::vector<ESM::ESMReader> readerList;
+    readerList.push_back(reader);
+    reader.setGlobalReaderList(&readerList);
+
+    reader.open(getEsmFile(record, false), "filename");
+    mEsmStore.load(reader, &dummyListener);
+
+    ESM::ESMWriter writer;
+    std::stringstream* stream = new std::stringstream;
+    writer.setFormat(0);
+    writer.save(*stream);
+    mEsmStore.writeStatic(writer);
+    writer.close();
+
+    MWWorld::ESMStore readStore;
+    ESM::ESMReader staticReader;
+    staticReader.open(Files::IStreamPtr(stream), "snapshot");
+    readStore.readStatic(staticReader, &dummyListener);
+
+    mEsmStore.setUp();
+    readStore.setUp();
+
+    ASSERT_EQ (1u, readStore.get<RecordType>().getSize());
+
+    const RecordType* readRecord = readStore.get<RecordType>().search("foobar");
+    ASSERT_TRUE (readRecord != NULL);
+    ASSERT_EQ (mEsmStore.get<RecordType>().find("foobar")->mId, readRecord->mId);
+    ASSERT_EQ (record.mModel, readRecord->mModel);
+}
+
+/// Tests that the payloads of records loaded from a content file are dropped, and read again when accessed.
+TEST_F(StoreTest, lazy_payload_test)
+{
+    const boost::filesystem::path path = boost::filesystem::temp_directory_path() / "openmw_lazy_payload_test.esp";
+
+    const char* ids[] = { "book_a", "book_b" };
+    {
+        boost::filesystem::ofstream stream (path, std::ios::binary);
+        ESM::ESMWriter writer;
+        writer.setFormat(0);
+        writer.save(stream);
+        for (int i = 0; i < 2; ++i)
+        {
+            ESM::Book book;
+            book.blank();
+            book.mId = ids[i];
+            book.mText = std::string("The text of ") + ids[i];
+            writer.startRecord(ESM::Book::sRecordId);
+            book.save(writer);
+            writer.endRecord(ESM::Book::sRecordId);
+        }
+        writer.close();
+    }
+
+    ESM::ESMReader reader;
+    std::vector<ESM::ESMReader> readerList;
+    readerList.push_back(reader);
+    reader.setGlobalReaderList(&readerList);
+
+    // Cache a single payload, so that reading the other one evicts it
+    ESM::ReaderPool pool (readerList, 1);
+    mEsmStore.getPayloads().setReaderPool(&pool, 1);
+
+    reader.open(path.string());
+    mEsmStore.load(reader, &dummyListener);
+    mEsmStore.setUp();
+
+    const MWWorld::RecordPayloads& payloads = mEsmStore.getPayloads();
+    for (int round = 0; round < 2; ++round)
+    {
+        for (int i = 0; i < 2; ++i)
+        {
+            const ESM::Book* book = mEsmStore.get<ESM::Book>().find(ids[i]);
+            ASSERT_TRUE (book->mText.empty());
+            ASSERT_EQ (std::string("The text of ") + ids[i], payloads.getBookText(*book));
+        }
+    }
+
+    boost::filesystem::remove(path);
+}
+
+/// Tests that the references of a cell are read from the content files as they are, except for moved references.
+TEST_F(StoreTest, content_refs_test)
+{
+    const boost::filesystem::path path = boost::filesystem::temp_directory_path() / "openmw_content_refs_test.esp";
+
+    const char* ids[] = { "ref_a", "ref_b", "ref_c" };
+    {
+        boost::filesystem::ofstream stream (path, std::ios::binary);
+        ESM::ESMWriter writer;
+        writer.setFormat(0);
+        writer.save(stream);
+
+        ESM::Cell cell;
+        cell.blank();
+        cell.mName = "Test Cell";
+        cell.mData.mFlags = ESM::Cell::Interior;
+        writer.startRecord(ESM::Cell::sRecordId);
+        cell.save(writer);
+        for (int i = 0; i < 3; ++i)
+        {
+            ESM::CellRef ref;
+            ref.blank();
+            ref.mRefNum.mIndex = i + 1;
+            ref.mRefID = ids[i];
+            // ref_b is deleted
+            ref.save(writer, false, false, i == 1);
+        }
+        writer.endRecord(ESM::Cell::sRecordId);
+        writer.close();
+    }
+
+    ESM::ESMReader reader;
+    std::vector<ESM::ESMReader> readerList;
+    readerList.push_back(reader);
+    reader.setGlobalReaderList(&readerList);
+    reader.setIndex(0);
+    reader.open(path.string());
+    mEsmStore.load(reader, &dummyListener);
+    mEsmStore.setUp();
+
+    ESM::ReaderPool pool (readerList, 1);
+
+    ESM::Cell cell = *mEsmStore.get<ESM::Cell>().find("test cell");
+
+    MWWorld::ContentRefList refs;
+    MWWorld::readContentRefs(cell, pool, refs);
+    ASSERT_EQ (3u, refs.size());
+    for (int i = 0; i < 3; ++i)
+    {
+        ASSERT_EQ (std::string(ids[i]), refs[i].first.mRefID);
+        ASSERT_EQ (0, refs[i].first.mRefNum.mContentFile);
+        ASSERT_EQ (i == 1, refs[i].second);
+    }
+
+    // ref_c moves to another cell, ref_z comes in from one
+    ESM::MovedCellRef moved;
+    moved.mRefNum = refs[2].first.mRefNum;
+    cell.mMovedRefs.push_back(moved);
+
+    ESM::CellRef leased;
+    leased.blank();
+    leased.mRefID = "Ref_Z";
+    cell.mLeasedRefs.push_back(leased);
+
+    refs.clear();
+    MWWorld::readContentRefs(cell, pool, refs);
+    ASSERT_EQ (2u, refs.size());
+    ASSERT_EQ (std::string("ref_a"), refs[0].first.mRefID);
+    ASSERT_EQ (std::string("ref_b"), refs[1].first.mRefID);
+
+    // Leased references are listed, deleted ones are not
+    std::vector<std::string> listed;
+    MWWorld::listContentRefIds(cell, pool, listed);
+    ASSERT_EQ (2u, listed.size());
+    ASSERT_EQ (std::string("ref_a"), listed[0]);
+    ASSERT_EQ (std::string("ref_z"), listed[1]);
+
+    boost::filesystem::remove(path);
+}
+
+/// Tests that the references of the content files are indexed by ID on the first lookup
+TEST_F(StoreTest, ref_id_index_test)
+{
+    const boost::filesystem::path path = boost::filesystem::temp_directory_path() / "openmw_ref_id_index_test.esp";
+
+    // cell, ID, deleted
+    const char* refs[][3] = {
+        { "Cell A", "ref_index_a", "" },
+        { "Cell A", "ref_b", "" },
+        { "Cell B", "Ref_B", "" },
+        { "Cell B", "ref_b", "" },
+        { "Cell B", "ref_c", "deleted" }
+    };
+    const int refCount = sizeof(refs) / sizeof(refs[0]);
+    {
+        boost::filesystem::ofstream stream (path, std::ios::binary);
+        ESM::ESMWriter writer;
+        writer.setFormat(0);
+        writer.save(stream);
+
+        for (int i = 0; i < refCount; ++i)
+        {
+            if (i == 0 || std::string(refs[i][0]) != refs[i-1][0])
+            {
+                if (i != 0)
+                    writer.endRecord(ESM::Cell::sRecordId);
+
+                ESM::Cell cell;
+                cell.blank();
+                cell.mName = refs[i][0];
+                cell.mData.mFlags = ESM::Cell::Interior;
+                writer.startRecord(ESM::Cell::sRecordId);
+                cell.save(writer);
+            }
+
+            ESM::CellRef ref;
+            ref.blank();
+            ref.mRefNum.mIndex = i + 1;
+            ref.mRefID = refs[i][1];
+            ref.save(writer, false, false, *refs[i][2] != 0);
+        }
+        writer.endRecord(ESM::Cell::sRecordId);
+        writer.close();
+    }
+
+    ESM::ESMReader reader;
+    std::vector<ESM::ESMReader> readerList;
+    readerList.push_back(reader);
+    reader.setGlobalReaderList(&readerList);
+    reader.setIndex(0);
+    reader.open(path.string());
+    mEsmStore.load(reader, &dummyListener);
+    mEsmStore.setUp();
+
+    ESM::ReaderPool pool (readerList, 1);
+
+    const MWWorld::Store<ESM::Cell>& cells = mEsmStore.get<ESM::Cell>();
+    const ESM::Cell* cellA = cells.find("cell a");
+    const ESM::Cell* cellB = cells.find("cell b");
+
+    MWWorld::RefIdIndex index;
+    ASSERT_FALSE (index.isPending());
+
+    index.buildLater(cells, pool);
+    ASSERT_TRUE (index.isPending());
+
+    // IDs are interned when the index is built, not before
+    Misc::StringAtom atom;
+    ASSERT_FALSE (Misc::StringAtom::find("ref_index_a", atom));
+    index.buildPending();
+    ASSERT_FALSE (index.isPending());
+    ASSERT_TRUE (Misc::StringAtom::find("ref_index_a", atom));
+
+    index.buildLater(cells, pool);
+
+    // ref_b is listed once per cell, however many references a cell has
+    const MWWorld::RefIdIndex::ContentCells* found = index.getContentCells(Misc::StringAtom("ref_b"));
+    ASSERT_FALSE (index.isPending());
+    ASSERT_TRUE (found != NULL);
+    ASSERT_EQ (2u, found->size());
+    ASSERT_EQ (cellA, (*found)[0]);
+    ASSERT_EQ (cellB, (*found)[1]);
+
+    found = index.getContentCells(Misc::StringAtom("ref_index_a"));
+    ASSERT_TRUE (found != NULL);
+    ASSERT_EQ (1u, found->size());
+    ASSERT_EQ (cellA, (*found)[0]);
+
+    // Deleted references are not indexed
+    ASSERT_TRUE (index.getContentCells(Misc::StringAtom("ref_c")) == NULL);
+    ASSERT_TRUE (index.getContentCells(Misc::StringAtom("ref_d")) == NULL);
+
+    // build() replaces the pending index right away
+    index.buildLater(cells, pool);
+    index.build(cells, pool);
+    ASSERT_FALSE (index.isPending());
+    found = index.getContentCells(Misc::StringAtom("ref_b"));
+    ASSERT_TRUE (found != NULL);
+    ASSERT_EQ (2u, found->size());
+
+    boost::filesystem::remove(path);
+}
+
+/// Tests that exterior cells looked up by name or region are the northernmost cells in the easternmost column.
+TEST_F(StoreTest, exterior_cell_by_name_test)
+{
+    MWWorld::Store<ESM::Cell>& cells = const_cast<MWWorld::Store<ESM::Cell>&>(mEsmStore.get<ESM::Cell>());
+
+    const int coordinates[][2] = { { 0, 0 }, { 2, 3 }, { 2, -1 } };
+    for (int i = 0; i < 3; ++i)
+    {
+        ESM::Cell cell;
+        cell.blank();
+        cell.mName = "Foo Town";
+        cell.mRegion = "Foo Region";
+        cell.mData.mFlags = 0;
+        cell.mData.mX = coordinates[i][0];
+        cell.mData.mY = coordinates[i][1];
+        cells.insert(cell);
+    }
+
+    ASSERT_EQ (cells.search(2, 3), cells.searchExtByName("FOO TOWN"));
+    ASSERT_EQ (cells.search(2, 3), cells.searchExtByRegion("foo region"));
+    ASSERT_TRUE (cells.searchExtByName("Bar Town") == NULL);
+
+    cells.erase(2, 3);
+    ASSERT_EQ (cells.search(2, -1), cells.searchExtByName("Foo Town"));
+    ASSERT_EQ (cells.search(2, -1), cells.searchExtByRegion("Foo Region"));
+}
+
+/// IDs of the candidate responses of \a dialogue for \a query, separated by spaces.
+static std::string getCandidateIds(const MWWorld::ESMStore& store, const ESM::Dialogue& dialogue,
+                                   const MWWorld::DialogueIndex::Query& query)
+{
+    std::vector<const ESM::DialInfo*> candidates;
+    store.getDialogueIndex().getCandidates(dialogue, query, candidates);
+
+    std::string ids;
+    for (std::vector<const ESM::DialInfo*>::const_iterator it = candidates.begin(); it != candidates.end(); ++it)
+        ids += (ids.empty() ? "" : " ") + (*it)->mId;
+    return ids;
+}
+
+/// Tests that the dialogue index skips responses for other actors, and keeps the order of the topic.
+TEST_F(StoreTest, dialogue_index_test)
+{
+    // ID, actor, race, class, faction, cell
+    const char* infos[][6] = {
+        { "any", "", "", "", "", "" },
+        { "actor", "fargoth", "", "", "", "" },
+        { "race", "", "Wood Elf", "", "", "" },
+        { "class", "", "", "Guard", "", "" },
+        { "faction", "", "", "", "Fighters Guild", "" },
+        { "factionless", "", "", "", "FFFF", "" },
+        { "cell", "", "", "", "", "Balmora" },
+        { "actor_race", "fargoth", "Dark Elf", "", "", "" }
+    };
+    const int count = sizeof(infos) / sizeof(infos[0]);
+
+    std::stringstream* stream = new std::stringstream;
+    {
+        ESM::ESMWriter writer;
+        writer.setFormat(0);
+        writer.save(*stream);
+
+        ESM::Dialogue dialogue;
+        dialogue.blank();
+        dialogue.mId = "topic";
+        dialogue.mType = ESM::Dialogue::Topic;
+        writer.startRecord(ESM::Dialogue::sRecordId);
+        dialogue.save(writer);
+        writer.endRecord(ESM::Dialogue::sRecordId);
+
+        for (int i = 0; i < count; ++i)
+        {
+            ESM::DialInfo info;
+            info.blank();
+            info.mId = infos[i][0];
+            info.mPrev = i > 0 ? infos[i - 1][0] : "";
+            info.mNext = i + 1 < count ? infos[i + 1][0] : "";
+            info.mActor = infos[i][1];
+            info.mRace = infos[i][2];
+            info.mClass = infos[i][3];
+            info.mFaction = infos[i][4];
+            info.mCell = infos[i][5];
+            writer.startRecord(ESM::DialInfo::sRecordId);
+            info.save(writer);
+            writer.endRecord(ESM::DialInfo::sRecordId);
+        }
+    }
+
+    ESM::ESMReader reader;
+    std::vector<ESM::ESMReader> readerList;
+    readerList.push_back(reader);
+    reader.setGlobalReaderList(&readerList);
+
+    reader.open(Files::IStreamPtr(stream), "filename");
+    mEsmStore.load(reader, &dummyListener);
+    mEsmStore.setUp();
+
+    const ESM::Dialogue& dialogue = *mEsmStore.get<ESM::Dialogue>().find("topic");
+
+    MWWorld::DialogueIndex::Query query;
+    query.mActor = "Fargoth";
+    query.mRace = "wood elf";
+    query.mClass = "Commoner";
+    query.mCell = "Seyda Neen";
+    ASSERT_EQ ("any actor race factionless actor_race", getCandidateIds(mEsmStore, dialogue, query));
+
+    query.mCreature = true;
+    ASSERT_EQ ("actor actor_race", getCandidateIds(mEsmStore, dialogue, query));
+
+    query.mActor = "mudcrab";
+    ASSERT_EQ ("", getCandidateIds(mEsmStore, dialogue, query));
+
+    query.mCreature = false;
+    query.mActor = "guard_01";
+    query.mRace = "Dark Elf";
+    query.mClass = "guard";
+    query.mFaction = "Fighters Guild";
+    query.mCell = "Balmora, Guild of Fighters";
+    ASSERT_EQ ("any class faction factionless cell", getCandidateIds(mEsmStore, dialogue, query));
+
+    query.mCell = "Vivec";
+    ASSERT_EQ ("any class faction factionless", getCandidateIds(mEsmStore, dialogue, query));
+
+    query.mAnyCell = true;
+    ASSERT_EQ ("any class faction factionless cell", getCandidateIds(mEsmStore, dialogue, query));
+}
@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+
+#include <ctime>
+#include <iostream>
+#include <map>
+#include <sstream>
+
+#include <components/misc/stringatom.hpp>
+#include <components/misc/stringops.hpp>
+
+#include "apps/openmw/mwworld/esmstore.hpp"
+
+namespace
+{
+    const int sRecordCount = 20000;
+    const int sLookupRounds = 20;
+
+    std::string makeId(int index)
+    {
+        std::ostringstream id;
+        id << "Benchmark_Static_" << index;
+        return id.str();
+    }
+
+    double elapsedMs(std::clock_t start)
+    {
+        return (std::clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+    }
+
+    /// The lookup MWWorld::Store::search used to do
+    template <class T>
+    const T *searchMaps(const std::map<std::string, T> &dynamic, const std::map<std::string, T> &stat, const std::string &id)
+    {
+        T item;
+        item.mId = Misc::StringUtils::lowerCase(id);
+
+        typename std::map<std::string, T>::const_iterator it = dynamic.find(item.mId);
+        if (it != dynamic.end())
+            return &it->second;
+
+        it = stat.find(item.mId);
+        if (it != stat.end() && Misc::StringUtils::ciEqual(it->second.mId, id))
+            return &it->second;
+
+        return NULL;
+    }
+}
+
+TEST(StringAtomTest, atoms_ignore_case)
+{
+    Misc::StringAtom atom ("StringAtomTest_Id");
+
+    ASSERT_EQ (atom, Misc::StringAtom("stringatomtest_id"));
+    ASSERT_EQ ("stringatomtest_id", atom.str());
+    ASSERT_NE (atom, Misc::StringAtom("StringAtomTest_Other"));
+
+    Misc::StringAtom found;
+    ASSERT_TRUE (Misc::StringAtom::find("STRINGATOMTEST_ID", found));
+    ASSERT_EQ (atom, found);
+
+    ASSERT_FALSE (Misc::StringAtom::find("StringAtomTest_NeverInterned", found));
+    ASSERT_EQ (atom, found);
+}
+
+/// Dynamic records take precedence over static records with the same ID, until they are erased.
+TEST(StoreIndexTest, dynamic_records_override_static_records)
+{
+    MWWorld::Store<ESM::Static> store;
+
+    ESM::Static record;
+    record.mId = "StoreIndexTest_Static";
+    record.mModel = "static.nif";
+    store.insertStatic(record);
+
+    record.mModel = "dynamic.nif";
+    store.insert(record);
+
+    Misc::StringAtom atom ("storeindextest_static");
+    ASSERT_EQ ("dynamic.nif", store.find(atom)->mModel);
+    ASSERT_EQ ("dynamic.nif", store.find("STOREINDEXTEST_STATIC")->mModel);
+
+    store.erase(record.mId);
+    ASSERT_EQ ("static.nif", store.find(atom)->mModel);
+
+    store.insert(record);
+    store.clearDynamic();
+    ASSERT_EQ ("static.nif", store.find(atom)->mModel);
+
+    store.eraseStatic(record.mId);
+    ASSERT_TRUE (store.search(atom) == NULL);
+    ASSERT_TRUE (store.search("StoreIndexTest_Unknown") == NULL);
+}
+
+/// Compares looking up records by string, by interned ID and with the std::map lookups the store used before.
+TEST(StoreBenchmark, search_by_string_and_atom)
+{
+    MWWorld::Store<ESM::Static> store;
+    std::map<std::string, ESM::Static> dynamic, map;
+
+    std::vector<std::string> ids;
+    std::vector<Misc::StringAtom> atoms;
+    for (int i = 0; i < sRecordCount; ++i)
+    {
+        ESM::Static record;
+        record.mId = makeId(i);
+        store.insertStatic(record);
+        map[Misc::StringUtils::lowerCase(record.mId)] = record;
+
+        ids.push_back(record.mId);
+        atoms.push_back(Misc::StringAtom(record.mId));
+    }
+
+    int found = 0;
+    std::clock_t start = std::clock();
+    for (int round = 0; round < sLookupRounds; ++round)
+        for (std::vector<std::string>::const_iterator it = ids.begin(); it != ids.end(); ++it)
+            found += searchMaps(dynamic, map, *it) != NULL;
+    double mapMs = elapsedMs(start);
+    ASSERT_EQ (sRecordCount * sLookupRounds, found);
+
+    found = 0;
+    start = std::clock();
+    for (int round = 0; round < sLookupRounds; ++round)
+        for (std::vector<std::string>::const_iterator it = ids.begin(); it != ids.end(); ++it)
+            found += store.search(*it) != NULL;
+    double stringMs = elapsedMs(start);
+    ASSERT_EQ (sRecordCount * sLookupRounds, found);
+
+    found = 0;
+    start = std::clock();
+    for (int round = 0; round < sLookupRounds; ++round)
+        for (std::vector<Misc::StringAtom>::const_iterator it = atoms.begin(); it != atoms.end(); ++it)
+            found += store.search(*it) != NULL;
+    double atomMs = elapsedMs(start);
+    ASSERT_EQ (sRecordCount * sLookupRounds, found);
+
+    std::cout << sRecordCount * sLookupRounds << " lookups: std::map " << mapMs << " ms, Store by string "
+              << stringMs << " ms, Store by atom " << atomMs << " ms" << std::endl;
+}
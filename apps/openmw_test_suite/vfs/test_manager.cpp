@@ -0,0 +1,224 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <OpenThreads/Thread>
+
+#include "components/vfs/manager.hpp"
+#include "components/vfs/archive.hpp"
+#include "components/vfs/iostats.hpp"
+
+namespace
+{
+    class TestFile : public VFS::File
+    {
+    public:
+        virtual Files::IStreamPtr open()
+        {
+            return Files::IStreamPtr(new std::istringstream(std::string(10000, 'x')));
+        }
+    };
+
+    /// Archive with a synthetic list of file names, nothing is ever read from disk
+    class TestArchive : public VFS::Archive
+    {
+    public:
+        TestArchive(const std::vector<std::string>& names)
+            : mNames(names)
+            , mFiles(names.size())
+        {
+        }
+
+        virtual void listResources(std::map<std::string, VFS::File*>& out, char (*normalize_function) (char))
+        {
+            for (size_t i = 0; i < mNames.size(); ++i)
+            {
+                std::string name = mNames[i];
+                std::transform(name.begin(), name.end(), name.begin(), normalize_function);
+                out[name] = &mFiles[i];
+            }
+        }
+
+        virtual std::string getDescription() const
+        {
+            return "test";
+        }
+
+        std::vector<std::string> mNames;
+        std::vector<TestFile> mFiles;
+    };
+
+    std::vector<std::string> makeNames(size_t count)
+    {
+        static const char* dirs[] = { "Meshes\\x\\", "Textures\\Tx_", "Sound\\Fx\\magic\\", "Icons\\m\\Tx_" };
+        std::vector<std::string> names;
+        for (size_t i = 0; i < count; ++i)
+        {
+            std::ostringstream stream;
+            stream << dirs[i % 4] << "Ex_Common_Item_" << i << ".dds";
+            names.push_back(stream.str());
+        }
+        return names;
+    }
+}
+
+struct VFSManagerTest : public ::testing::Test
+{
+  protected:
+    virtual void SetUp()
+    {
+        mNames = makeNames(50000);
+        mManager.reset(new VFS::Manager(false));
+        mArchive = new TestArchive(mNames);
+        mManager->addArchive(mArchive);
+        mManager->buildIndex();
+    }
+
+    std::vector<std::string> mNames;
+    std::auto_ptr<VFS::Manager> mManager;
+    TestArchive* mArchive;
+};
+
+TEST_F(VFSManagerTest, lookup_is_case_and_slash_insensitive)
+{
+    ASSERT_EQ(&mArchive->mFiles[4], mManager->search("meshes/x/ex_common_item_4.dds", 29));
+
+    std::string name = "TEXTURES/TX_EX_COMMON_ITEM_1.DDS";
+    ASSERT_TRUE(mManager->exists(name));
+    ASSERT_TRUE(mManager->exists(name.c_str(), name.size()));
+    ASSERT_EQ(&mArchive->mFiles[1], mManager->search(name.c_str(), name.size()));
+}
+
+TEST_F(VFSManagerTest, lookup_of_missing_files)
+{
+    ASSERT_FALSE(mManager->exists("meshes\\x\\ex_common_item_50000.dds"));
+    ASSERT_FALSE(mManager->exists("meshes\\x\\ex_common_item_5.dd"));
+    ASSERT_FALSE(mManager->exists(""));
+    ASSERT_THROW(mManager->get("meshes\\x\\missing.nif"), std::runtime_error);
+}
+
+TEST_F(VFSManagerTest, all_files_are_found)
+{
+    for (size_t i = 0; i < mNames.size(); ++i)
+        ASSERT_EQ(&mArchive->mFiles[i], mManager->search(mNames[i].c_str(), mNames[i].size()));
+}
+
+TEST_F(VFSManagerTest, strict_lookup_is_case_sensitive)
+{
+    VFS::Manager manager(true);
+    std::vector<std::string> names;
+    names.push_back("Meshes\\Foo.nif");
+    manager.addArchive(new TestArchive(names));
+    manager.buildIndex();
+
+    ASSERT_TRUE(manager.exists("Meshes/Foo.nif"));
+    ASSERT_FALSE(manager.exists("meshes/foo.nif"));
+}
+
+TEST_F(VFSManagerTest, io_stats_are_counted_per_archive_and_category)
+{
+    VFS::Manager manager(false);
+    std::vector<std::string> names;
+    names.push_back("meshes\\a.nif");
+    manager.addArchive(new TestArchive(names));
+    names[0] = "textures\\b.dds";
+    manager.addArchive(new TestArchive(names));
+    manager.buildIndex();
+
+    ASSERT_TRUE(manager.getIOStats() == NULL);
+    manager.enableIOStats();
+
+    {
+        Files::IStreamPtr stream = manager.get("meshes/a.nif", VFS::IOCategory_Nif);
+        std::string contents((std::istreambuf_iterator<char>(*stream)), std::istreambuf_iterator<char>());
+        ASSERT_EQ(10000u, contents.size());
+    }
+    {
+        Files::IStreamPtr stream = manager.get("textures/b.dds", VFS::IOCategory_Image);
+        char buffer[100];
+        stream->seekg(5000);
+        stream->read(buffer, sizeof(buffer));
+        ASSERT_EQ(5100, stream->tellg());
+    }
+
+    const VFS::IOStats* stats = manager.getIOStats();
+    VFS::IOCounters nif = stats->get(0, VFS::IOCategory_Nif);
+    ASSERT_EQ(1u, nif.mOpens);
+    ASSERT_EQ(10000u, nif.mBytesRead);
+    VFS::IOCounters image = stats->get(1, VFS::IOCategory_Image);
+    ASSERT_EQ(1u, image.mOpens);
+    ASSERT_EQ(0u, stats->get(1, VFS::IOCategory_Nif).mOpens);
+    ASSERT_EQ(2u, stats->getTotal().mOpens);
+
+    std::ostringstream csv;
+    stats->writeCsv(csv);
+    ASSERT_NE(std::string::npos, csv.str().find("\"test\",image,1,"));
+}
+
+TEST_F(VFSManagerTest, io_stats_count_prefetch_hits_and_overridden_files)
+{
+    VFS::Manager manager(false);
+    std::vector<std::string> names;
+    names.push_back("meshes\\a.nif");
+    manager.addArchive(new TestArchive(names));
+    names.push_back("meshes\\b.nif");
+    manager.addArchive(new TestArchive(names));
+    manager.buildIndex();
+    manager.enableIOStats();
+    manager.enablePrefetch(1024 * 1024);
+
+    std::vector<std::string> prefetch (1, "meshes/b.nif");
+    manager.prefetch(prefetch);
+    for (int i = 0; i < 1000 && manager.getPrefetchStats().mCachedBytes == 0; ++i)
+        OpenThreads::Thread::microSleep(1000);
+    ASSERT_EQ(10000u, manager.getPrefetchStats().mCachedBytes);
+
+    manager.get("meshes/a.nif", VFS::IOCategory_Nif);
+    manager.get("meshes/b.nif", VFS::IOCategory_Nif);
+
+    // a.nif is overridden by the second archive
+    const VFS::IOStats* stats = manager.getIOStats();
+    ASSERT_EQ(0u, stats->get(0, VFS::IOCategory_Nif).mOpens);
+    VFS::IOCounters nif = stats->get(1, VFS::IOCategory_Nif);
+    ASSERT_EQ(2u, nif.mOpens);
+    ASSERT_EQ(1u, nif.mPrefetchHits);
+
+    // the read of b.nif is accounted to the I/O thread only
+    VFS::IOCounters prefetched = stats->get(1, VFS::IOCategory_Prefetch);
+    ASSERT_EQ(1u, prefetched.mOpens);
+    ASSERT_EQ(10000u, prefetched.mBytesRead);
+    ASSERT_EQ(10000u, stats->getTotal().mBytesRead);
+}
+
+TEST_F(VFSManagerTest, benchmark_hash_index_against_map)
+{
+    const int rounds = 10;
+    const std::map<std::string, VFS::File*>& index = mManager->getIndex();
+
+    boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+    size_t found = 0;
+    for (int round = 0; round < rounds; ++round)
+        for (std::vector<std::string>::const_iterator it = mNames.begin(); it != mNames.end(); ++it)
+        {
+            // what Manager::exists used to do
+            std::string normalized = *it;
+            mManager->normalizeFilename(normalized);
+            found += index.find(normalized) != index.end();
+        }
+    boost::posix_time::time_duration mapTime = boost::posix_time::microsec_clock::universal_time() - start;
+
+    start = boost::posix_time::microsec_clock::universal_time();
+    for (int round = 0; round < rounds; ++round)
+        for (std::vector<std::string>::const_iterator it = mNames.begin(); it != mNames.end(); ++it)
+            found += mManager->exists(it->c_str(), it->size());
+    boost::posix_time::time_duration hashTime = boost::posix_time::microsec_clock::universal_time() - start;
+
+    ASSERT_EQ(2 * rounds * mNames.size(), found);
+
+    std::cout << rounds * mNames.size() << " lookups: std::map " << mapTime.total_microseconds()
+              << " us, hash index " << hashTime.total_microseconds() << " us" << std::endl;
+}
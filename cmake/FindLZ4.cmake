@@ -0,0 +1,14 @@
+# Locate LZ4
+# This module defines
+# LZ4_FOUND, if false, do not try to link to LZ4
+# LZ4_INCLUDE_DIRS, where to find lz4.h
+# LZ4_LIBRARIES, the libraries to link against
+
+include(LibFindMacros)
+
+libfind_pkg_detect(LZ4 liblz4
+    FIND_PATH lz4.h
+    FIND_LIBRARY lz4
+    )
+
+libfind_process(LZ4)
@@ -28,6 +28,8 @@
 #include <boost/filesystem/path.hpp>
 #include <boost/filesystem/fstream.hpp>
 
+#include <components/files/memorystream.hpp>
+
 using namespace std;
 using namespace Bsa;
 
@@ -160,10 +162,27 @@ int BSAFile::getIndex(const char *str) const
 }
 
 /// Open an archive file.
-void BSAFile::open(const string &file)
+void BSAFile::open(const string &file, bool memoryMapped)
 {
     filename = file;
     readHeader();
+
+    if (memoryMapped)
+    {
+        mapping.open(filename.c_str());
+
+        // readHeader() only validated the offsets against the file size it saw
+        for (FileList::const_iterator it = files.begin(); it != files.end(); ++it)
+            if (it->offset + it->fileSize > mapping.size())
+                fail("Archive changed while it was being opened");
+    }
+}
+
+const char* BSAFile::getFileData(const FileStruct *file) const
+{
+    if (!mapping.isOpen())
+        return NULL;
+    return mapping.data() + file->offset;
 }
 
 Files::IStreamPtr BSAFile::getFile(const char *file)
@@ -173,12 +192,13 @@ Files::IStreamPtr BSAFile::getFile(const char *file)
     if(i == -1)
         fail("File not found: " + string(file));
 
-    const FileStruct &fs = files[i];
-
-    return Files::openConstrainedFileStream (filename.c_str (), fs.offset, fs.fileSize);
+    return getFile(&files[i]);
 }
 
 Files::IStreamPtr BSAFile::getFile(const FileStruct *file)
 {
+    if (mapping.isOpen())
+        return Files::IStreamPtr(new Files::IMemStream(mapping.data() + file->offset, file->fileSize));
+
     return Files::openConstrainedFileStream (filename.c_str (), file->offset, file->fileSize);
 }
@@ -32,6 +32,7 @@
 #include <components/misc/stringops.hpp>
 
 #include <components/files/constrainedfilestream.hpp>
+#include <components/files/memorymappedfile.hpp>
 
 
 namespace Bsa
@@ -69,6 +70,9 @@ private:
     /// Used for error messages
     std::string filename;
 
+    /// Mapping of the whole archive, only open in memory mapped mode
+    Files::MemoryMappedFile mapping;
+
     /// Case insensitive string comparison
     struct iltstr
     {
@@ -104,7 +108,13 @@ public:
     { }
 
     /// Open an archive file.
-    void open(const std::string &file);
+    /// @param memoryMapped Map the whole archive into memory once, so that opening a contained
+    /// file does not need any system calls and reads directly from the mapping.
+    void open(const std::string &file, bool memoryMapped = false);
+
+    /// Is the archive mapped into memory?
+    bool isMemoryMapped() const
+    { return mapping.isOpen(); }
 
     /* -----------------------------------
      * Archive file routines
@@ -126,6 +136,13 @@ public:
     */
     Files::IStreamPtr getFile(const FileStruct* file);
 
+    /** Get a pointer to the contents of a file contained in the archive,
+        valid for the lifetime of this object. Returns NULL if the archive
+        is not memory mapped.
+     * @note Thread safe.
+    */
+    const char* getFileData(const FileStruct* file) const;
+
     /// Get a list of all files
     /// @note Thread safe.
     const FileList &getList() const
@@ -0,0 +1,266 @@
+#include "package_file.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include <boost/filesystem/operations.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <lz4.h>
+
+#include <components/files/memorystream.hpp>
+#include <components/misc/stringops.hpp>
+
+namespace
+{
+
+    char normalizeChar(char ch)
+    {
+        return ch == '\\' ? '/' : Misc::StringUtils::toLower(ch);
+    }
+
+    bool equalNames(const char* name1, const char* name2)
+    {
+        for (; *name1 && *name2; ++name1, ++name2)
+            if (normalizeChar(*name1) != normalizeChar(*name2))
+                return false;
+        return *name1 == *name2;
+    }
+
+    struct EntryHashLess
+    {
+        bool operator()(const Bsa::PackageFile::Entry& entry, uint64_t hash) const
+        { return entry.mHash < hash; }
+
+        bool operator()(const Bsa::PackageFile::Entry& left, const Bsa::PackageFile::Entry& right) const
+        { return left.mHash < right.mHash; }
+    };
+
+}
+
+namespace Bsa
+{
+
+uint64_t PackageFile::hashName(const char* name)
+{
+    // FNV-1a
+    uint64_t hash = 14695981039346656037ULL;
+    for (; *name; ++name)
+    {
+        hash ^= static_cast<unsigned char>(normalizeChar(*name));
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+PackageFile::PackageFile()
+{
+}
+
+void PackageFile::fail(const std::string& msg) const
+{
+    throw std::runtime_error("Package Error: " + msg + "\nArchive: " + mFilename);
+}
+
+void PackageFile::open(const std::string& file)
+{
+    mFilename = file;
+    mMapping.open(file.c_str());
+
+    const char* data = mMapping.data();
+    const size_t size = mMapping.size();
+
+    Header header;
+    if (size < sizeof(header))
+        fail("File too small to be a valid package");
+    std::memcpy(&header, data, sizeof(header));
+
+    if (header.mMagic != sMagic)
+        fail("Unrecognized package header");
+    if (header.mVersion != sVersion)
+        fail("Unsupported package version");
+
+    const uint64_t tableEnd = sizeof(Header) + uint64_t(header.mFileCount) * sizeof(Entry) + header.mNameTableSize;
+    if (tableEnd > size || header.mNameTableSize == 0)
+        fail("Table of contents larger than entire package");
+
+    mFiles.resize(header.mFileCount);
+    if (!mFiles.empty())
+        std::memcpy(&mFiles[0], data + sizeof(Header), mFiles.size() * sizeof(Entry));
+
+    const char* names = data + sizeof(Header) + mFiles.size() * sizeof(Entry);
+    mNames.assign(names, names + header.mNameTableSize);
+    // Make sure every name is terminated
+    mNames.back() = 0;
+
+    for (FileList::const_iterator it = mFiles.begin(); it != mFiles.end(); ++it)
+    {
+        if (it->mNameOffset >= mNames.size())
+            fail("Package contains a name outside of the name table");
+        if (uint64_t(it->mOffset) + it->mCompressedSize > size)
+            fail("Package contains offsets outside itself");
+        if (it->mCompressedSize > it->mSize)
+            fail("Package contains a corrupt entry");
+        if (it != mFiles.begin() && it->mHash < (it-1)->mHash)
+            fail("Package table of contents is not sorted");
+    }
+}
+
+const PackageFile::Entry* PackageFile::search(const char* file) const
+{
+    const uint64_t hash = hashName(file);
+    FileList::const_iterator it = std::lower_bound(mFiles.begin(), mFiles.end(), hash, EntryHashLess());
+    for (; it != mFiles.end() && it->mHash == hash; ++it)
+    {
+        if (equalNames(getName(*it), file))
+            return &*it;
+    }
+    return NULL;
+}
+
+Files::IStreamPtr PackageFile::getFile(const char* file) const
+{
+    const Entry* entry = search(file);
+    if (!entry)
+        fail("File not found: " + std::string(file));
+    return getFile(entry);
+}
+
+Files::IStreamPtr PackageFile::getFile(const Entry* file) const
+{
+    const char* source = mMapping.data() + file->mOffset;
+
+    if (file->mCompressedSize == file->mSize)
+        return Files::IStreamPtr(new Files::IMemStream(source, file->mSize));
+
+    boost::shared_ptr<std::vector<char> > buffer (new std::vector<char>(file->mSize));
+    if (file->mSize != 0)
+    {
+        int size = LZ4_decompress_safe(source, &(*buffer)[0], file->mCompressedSize, file->mSize);
+        if (size < 0 || static_cast<uint32_t>(size) != file->mSize)
+            fail("Failed to decompress " + std::string(getName(*file)));
+    }
+    return Files::IStreamPtr(new Files::ISharedMemStream(buffer));
+}
+
+// ------------------------------------------------------------------------------
+
+PackageWriter::PackageWriter(const std::string& file, const std::vector<std::string>& names)
+    : mFilename(file)
+    , mTempFilename(file + ".tmp")
+    , mStream(boost::filesystem::path(mTempFilename), std::ios::binary | std::ios::trunc)
+    , mFinished(false)
+    , mNames(names)
+    , mNameTableSize(0)
+    , mNextNameOffset(0)
+    , mOffset(0)
+{
+    if (!mStream.is_open())
+        fail("Failed to open for writing");
+
+    for (std::vector<std::string>::const_iterator it = mNames.begin(); it != mNames.end(); ++it)
+        mNameTableSize += it->size() + 1;
+    // An empty package still has a (zero terminated) name table
+    if (mNameTableSize == 0)
+        mNameTableSize = 1;
+
+    // Leave room for the header and entry table, they are written by finish()
+    mOffset = sizeof(PackageFile::Header) + uint64_t(mNames.size()) * sizeof(PackageFile::Entry);
+    mStream.seekp(mOffset);
+
+    for (std::vector<std::string>::const_iterator it = mNames.begin(); it != mNames.end(); ++it)
+        mStream.write(it->c_str(), it->size() + 1);
+    if (mNames.empty())
+        mStream.put(0);
+    mOffset += mNameTableSize;
+
+    mFiles.reserve(mNames.size());
+}
+
+PackageWriter::~PackageWriter()
+{
+    if (mFinished)
+        return;
+
+    mStream.close();
+    boost::system::error_code ec;
+    boost::filesystem::remove(mTempFilename, ec);
+}
+
+void PackageWriter::fail(const std::string& msg) const
+{
+    throw std::runtime_error("Package Error: " + msg + "\nArchive: " + mFilename);
+}
+
+void PackageWriter::addFile(const std::vector<char>& data)
+{
+    if (mFiles.size() >= mNames.size())
+        fail("More files added than declared");
+
+    PackageFile::Entry entry;
+    entry.mHash = PackageFile::hashName(mNames[mFiles.size()].c_str());
+    entry.mNameOffset = mNextNameOffset;
+    mNextNameOffset += mNames[mFiles.size()].size() + 1;
+    entry.mOffset = static_cast<uint32_t>(mOffset);
+    entry.mSize = data.size();
+
+    std::vector<char> compressed;
+    int compressedSize = 0;
+    if (!data.empty())
+    {
+        compressed.resize(LZ4_compressBound(data.size()));
+        compressedSize = LZ4_compress_default(&data[0], &compressed[0], data.size(), compressed.size());
+    }
+
+    // Store incompressible files as they are, they can then be read without a copy
+    if (compressedSize > 0 && static_cast<size_t>(compressedSize) < data.size())
+    {
+        entry.mCompressedSize = compressedSize;
+        mStream.write(&compressed[0], compressedSize);
+    }
+    else
+    {
+        entry.mCompressedSize = entry.mSize;
+        if (!data.empty())
+            mStream.write(&data[0], data.size());
+    }
+
+    mOffset += entry.mCompressedSize;
+    if (mOffset > 0xFFFFFFFFULL)
+        fail("Packages larger than 4GB are not supported");
+
+    mFiles.push_back(entry);
+}
+
+void PackageWriter::finish()
+{
+    if (mFiles.size() != mNames.size())
+        fail("Not all declared files were added");
+
+    std::stable_sort(mFiles.begin(), mFiles.end(), EntryHashLess());
+
+    PackageFile::Header header;
+    header.mMagic = PackageFile::sMagic;
+    header.mVersion = PackageFile::sVersion;
+    header.mFileCount = mFiles.size();
+    header.mNameTableSize = mNameTableSize;
+
+    mStream.seekp(0);
+    mStream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    if (!mFiles.empty())
+        mStream.write(reinterpret_cast<const char*>(&mFiles[0]), mFiles.size() * sizeof(PackageFile::Entry));
+
+    mStream.close();
+    if (mStream.fail())
+        fail("Failed to write");
+
+    boost::system::error_code ec;
+    boost::filesystem::rename(mTempFilename, mFilename, ec);
+    if (ec)
+        fail("Failed to rename " + mTempFilename + ": " + ec.message());
+
+    mFinished = true;
+}
+
+}
@@ -0,0 +1,149 @@
+#ifndef BSA_PACKAGE_FILE_H
+#define BSA_PACKAGE_FILE_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem/fstream.hpp>
+
+#include <components/files/constrainedfilestream.hpp>
+#include <components/files/memorymappedfile.hpp>
+
+namespace Bsa
+{
+
+/**
+   OpenMW package archives (.omwpkg): an archive format with per-file LZ4
+   compression and a table of contents sorted by name hash.
+
+   The layout of a package is as follows, all values are little endian:
+
+   - Header
+
+   - Entry table, one Entry per file, sorted by hash
+
+   - Name table, zero terminated file names indexed by Entry::mNameOffset
+
+   - File data, in the order chosen by the packer. Each file is stored as an
+     LZ4 block, or uncompressed if mCompressedSize equals mSize.
+ */
+class PackageFile
+{
+public:
+    struct Header
+    {
+        uint32_t mMagic;
+        uint32_t mVersion;
+        uint32_t mFileCount;
+        uint32_t mNameTableSize;
+    };
+
+    struct Entry
+    {
+        /// hashName() of the file name
+        uint64_t mHash;
+        uint32_t mNameOffset;
+        /// Offset of the file data from the beginning of the package
+        uint32_t mOffset;
+        uint32_t mCompressedSize;
+        uint32_t mSize;
+    };
+    typedef std::vector<Entry> FileList;
+
+    static const uint32_t sMagic = 0x504d574f; // "OMWP"
+    static const uint32_t sVersion = 1;
+
+    /// Hash of a file name, ignoring case and treating slashes and backslashes alike.
+    static uint64_t hashName(const char* name);
+
+    PackageFile();
+
+    /// Open a package file. Throws an exception on failure.
+    void open(const std::string& file);
+
+    /// Check if a file exists
+    bool exists(const char* file) const
+    { return search(file) != NULL; }
+
+    /// Find the entry of a file, or NULL if not found
+    /// @note Thread safe.
+    const Entry* search(const char* file) const;
+
+    /** Open a file contained in the package. Throws an exception if the
+        file doesn't exist.
+     * @note Thread safe.
+    */
+    Files::IStreamPtr getFile(const char* file) const;
+
+    /** Open a file contained in the package. Uncompressed files are read
+        directly from the mapped package, compressed files are decompressed
+        into memory.
+     * @note Thread safe.
+    */
+    Files::IStreamPtr getFile(const Entry* file) const;
+
+    /// Get the name of a file contained in the package
+    /// @note Thread safe.
+    const char* getName(const Entry& file) const
+    { return &mNames[file.mNameOffset]; }
+
+    /// Get a list of all files, sorted by hash
+    /// @note Thread safe.
+    const FileList& getList() const
+    { return mFiles; }
+
+private:
+    void fail(const std::string& msg) const;
+
+    std::string mFilename;
+
+    Files::MemoryMappedFile mMapping;
+
+    FileList mFiles;
+
+    std::vector<char> mNames;
+};
+
+/**
+   Writes an OpenMW package archive. All file names have to be known up front,
+   file contents are then added one by one and written in that order.
+
+   The package is written to a temporary file next to the target, which is
+   only renamed to the target by finish(). A package that is not finished
+   (e.g. because of an error) is deleted, leaving any existing target alone.
+ */
+class PackageWriter
+{
+public:
+    /// Create the package and reserve space for the table of contents. Throws an exception on failure.
+    PackageWriter(const std::string& file, const std::vector<std::string>& names);
+
+    /// Delete the temporary file, unless finish() succeeded.
+    ~PackageWriter();
+
+    /// Add the contents of the next file in the order given to the constructor.
+    void addFile(const std::vector<char>& data);
+
+    /// Write the table of contents and move the package to its final name. Must be called once all
+    /// files have been added.
+    void finish();
+
+private:
+    void fail(const std::string& msg) const;
+
+    std::string mFilename;
+    std::string mTempFilename;
+    boost::filesystem::ofstream mStream;
+    bool mFinished;
+
+    std::vector<std::string> mNames;
+    std::vector<PackageFile::Entry> mFiles;
+    uint32_t mNameTableSize;
+    uint32_t mNextNameOffset;
+    uint64_t mOffset;
+};
+
+}
+
+#endif
@@ -1,6 +1,7 @@
 #include "extensions.hpp"
 
 #include <cassert>
+#include <ostream>
 #include <stdexcept>
 
 #include "generator.hpp"
@@ -213,4 +214,58 @@ namespace Compiler
             iter!=mKeywords.end(); ++iter)
             keywords.push_back (iter->first);
     }
+
+    std::string Extensions::findKeyword (int segment, int opcode, bool& explicitReference) const
+    {
+        for (std::map<std::string, int>::const_iterator iter (mKeywords.begin());
+            iter!=mKeywords.end(); ++iter)
+        {
+            std::map<int, Function>::const_iterator function = mFunctions.find (iter->second);
+
+            if (function!=mFunctions.end() && function->second.mSegment==segment &&
+                (function->second.mCode==opcode || function->second.mCodeExplicit==opcode))
+            {
+                explicitReference = function->second.mCode!=opcode;
+                return iter->first;
+            }
+
+            std::map<int, Instruction>::const_iterator instruction = mInstructions.find (iter->second);
+
+            if (instruction!=mInstructions.end() && instruction->second.mSegment==segment &&
+                (instruction->second.mCode==opcode || instruction->second.mCodeExplicit==opcode))
+            {
+                explicitReference = instruction->second.mCode!=opcode;
+                return iter->first;
+            }
+        }
+
+        return "";
+    }
+
+    void Extensions::write (std::ostream& stream) const
+    {
+        for (std::map<std::string, int>::const_iterator iter (mKeywords.begin());
+            iter!=mKeywords.end(); ++iter)
+        {
+            stream << iter->first;
+
+            std::map<int, Function>::const_iterator function = mFunctions.find (iter->second);
+
+            if (function!=mFunctions.end())
+                stream
+                    << " function " << function->second.mReturn << " " << function->second.mArguments
+                    << " " << function->second.mSegment << " " << function->second.mCode
+                    << " " << function->second.mCodeExplicit;
+
+            std::map<int, Instruction>::const_iterator instruction = mInstructions.find (iter->second);
+
+            if (instruction!=mInstructions.end())
+                stream
+                    << " instruction " << instruction->second.mArguments
+                    << " " << instruction->second.mSegment << " " << instruction->second.mCode
+                    << " " << instruction->second.mCodeExplicit;
+
+            stream << "\n";
+        }
+    }
 }
@@ -4,6 +4,7 @@
 #include <string>
 #include <map>
 #include <vector>
+#include <iosfwd>
 
 #include <components/interpreter/types.hpp>
 
@@ -109,6 +110,14 @@ namespace Compiler
 
             void listKeywords (std::vector<std::string>& keywords) const;
             ///< Append all known keywords to \a kaywords.
+
+            std::string findKeyword (int segment, int opcode, bool& explicitReference) const;
+            ///< Return the keyword that compiles to \a opcode in \a segment (empty string: none).
+            /// \param explicitReference Out: is \a opcode the variant with an explicit reference?
+
+            void write (std::ostream& stream) const;
+            ///< Write all keywords with their argument types and opcodes, e.g. to tell whether code
+            /// compiled with another set of extensions is still valid.
     };
 }
 
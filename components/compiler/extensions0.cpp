@@ -305,6 +305,10 @@ namespace Compiler
             extensions.registerInstruction("tgm", "", opcodeToggleGodMode);
             extensions.registerInstruction("togglegodmode", "", opcodeToggleGodMode);
             extensions.registerInstruction("togglescripts", "", opcodeToggleScripts);
+            extensions.registerInstruction("dumpiostats", "", opcodeDumpIOStats);
+            extensions.registerInstruction("togglescriptprofiler", "", opcodeToggleScriptProfiler);
+            extensions.registerInstruction("dumpscriptprofile", "", opcodeDumpScriptProfile);
+            extensions.registerInstruction("clearscriptprofile", "", opcodeClearScriptProfile);
             extensions.registerInstruction ("disablelevitation", "", opcodeDisableLevitation);
             extensions.registerInstruction ("enablelevitation", "", opcodeEnableLevitation);
             extensions.registerFunction ("getpcinjail", 'l', "", opcodeGetPcInJail);
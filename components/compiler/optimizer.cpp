@@ -0,0 +1,884 @@
+#include "optimizer.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include "generator.hpp"
+
+namespace
+{
+    typedef Interpreter::Type_Code Type_Code;
+    typedef Interpreter::Type_Integer Type_Integer;
+    typedef Interpreter::Type_Float Type_Float;
+
+    /// Segment 0 opcodes (see components/interpreter/docs/vmformat.txt)
+    enum
+    {
+        opPushInt = 0,
+        opJumpForward = 1,
+        opJumpBackward = 2,
+        opPushLocalShort = 3,
+        opPushLocalLong = 4,
+        opPushLocalFloat = 5,
+        opPopLocalShort = 6,
+        opPopLocalLong = 7,
+        opPopLocalFloat = 8
+    };
+
+    /// Segment 5 opcodes (see components/interpreter/docs/vmformat.txt)
+    enum
+    {
+        opStoreLocalShort = 0,
+        opStoreLocalLong = 1,
+        opStoreLocalFloat = 2,
+        opIntToFloat = 3,
+        opFetchIntLiteral = 4,
+        opFetchFloatLiteral = 5,
+        opFloatToInt = 6,
+        opNegateInt = 7,
+        opNegateFloat = 8,
+        opAddInt = 9,
+        opAddFloat = 10,
+        opSubInt = 11,
+        opSubFloat = 12,
+        opMulInt = 13,
+        opMulFloat = 14,
+        opDivInt = 15,
+        opDivFloat = 16,
+        opIntToFloat1 = 17,
+        opFloatToInt1 = 18,
+        opSquareRoot = 19,
+        opReturn = 20,
+        opFetchLocalShort = 21,
+        opFetchLocalLong = 22,
+        opFetchLocalFloat = 23,
+        opSkipOnZero = 24,
+        opSkipOnNonZero = 25,
+        opEqualInt = 26,
+        opNonEqualInt = 27,
+        opLessThanInt = 28,
+        opLessOrEqualInt = 29,
+        opGreaterThanInt = 30,
+        opGreaterOrEqualInt = 31,
+        opEqualFloat = 32,
+        opNonEqualFloat = 33,
+        opLessThanFloat = 34,
+        opLessOrEqualFloat = 35,
+        opGreaterThanFloat = 36,
+        opGreaterOrEqualFloat = 37,
+        opMenuMode = 38,
+        opStoreGlobalShort = 39,
+        opStoreGlobalLong = 40,
+        opStoreGlobalFloat = 41,
+        opFetchGlobalShort = 42,
+        opFetchGlobalLong = 43,
+        opFetchGlobalFloat = 44,
+        opGetSecondsPassed = 50
+    };
+
+    /// Upper limit for the number of times all passes are run
+    const int sMaxPasses = 8;
+
+    /// \return Opcode of a segment 0 instruction, -1 for other segments
+    int getSegment0 (Type_Code code)
+    {
+        return (code>>30)==0 ? static_cast<int> (code>>24) : -1;
+    }
+
+    /// \return Opcode of a segment 5 instruction, -1 for other segments
+    int getSegment5 (Type_Code code)
+    {
+        return (code>>26)==0x32 ? static_cast<int> (code & 0x3ffffff) : -1;
+    }
+
+    unsigned int getArg0 (Type_Code code)
+    {
+        return code & 0xffffff;
+    }
+
+    /// Number of values an instruction takes from the stack and puts on the stack
+    /// \return Is the instruction known to leave the rest of the stack alone?
+    bool getStackEffect (Type_Code code, int& pops, int& pushes)
+    {
+        switch (getSegment0 (code))
+        {
+            case opPushInt:
+            case opPushLocalShort:
+            case opPushLocalLong:
+            case opPushLocalFloat:
+
+                pops = 0; pushes = 1;
+                return true;
+
+            case opPopLocalShort:
+            case opPopLocalLong:
+            case opPopLocalFloat:
+
+                pops = 1; pushes = 0;
+                return true;
+        }
+
+        int opcode = getSegment5 (code);
+
+        if (opcode==opIntToFloat || opcode==opFetchIntLiteral || opcode==opFetchFloatLiteral ||
+            opcode==opFloatToInt || opcode==opNegateInt || opcode==opNegateFloat ||
+            opcode==opSquareRoot || (opcode>=opFetchLocalShort && opcode<=opFetchLocalFloat) ||
+            (opcode>=opFetchGlobalShort && opcode<=opFetchGlobalFloat))
+        {
+            pops = 1; pushes = 1;
+            return true;
+        }
+
+        if ((opcode>=opAddInt && opcode<=opDivFloat) ||
+            (opcode>=opEqualInt && opcode<=opGreaterOrEqualFloat))
+        {
+            pops = 2; pushes = 1;
+            return true;
+        }
+
+        if (opcode==opIntToFloat1 || opcode==opFloatToInt1)
+        {
+            pops = 2; pushes = 2;
+            return true;
+        }
+
+        if (opcode==opMenuMode || opcode==opGetSecondsPassed)
+        {
+            pops = 0; pushes = 1;
+            return true;
+        }
+
+        if ((opcode>=opStoreLocalShort && opcode<=opStoreLocalFloat) ||
+            (opcode>=opStoreGlobalShort && opcode<=opStoreGlobalFloat))
+        {
+            pops = 2; pushes = 0;
+            return true;
+        }
+
+        return false;
+    }
+
+    /// Value on the stack that is known when compiling
+    struct Value
+    {
+        bool mFloat;
+        Type_Integer mInteger;
+        Type_Float mFloatValue;
+
+        static Value makeInteger (Type_Integer value)
+        {
+            Value result;
+            result.mFloat = false;
+            result.mInteger = value;
+            result.mFloatValue = 0;
+            return result;
+        }
+
+        static Value makeFloat (Type_Float value)
+        {
+            Value result;
+            result.mFloat = true;
+            result.mInteger = 0;
+            result.mFloatValue = value;
+            return result;
+        }
+    };
+
+    /// Evaluate the segment 5 instruction \a opcode on a value
+    /// \return Can the result be computed without changing the behaviour of the script?
+    bool foldUnary (int opcode, const Value& value, Value& result)
+    {
+        switch (opcode)
+        {
+            case opIntToFloat:
+
+                if (value.mFloat)
+                    return false;
+
+                result = Value::makeFloat (static_cast<Type_Float> (value.mInteger));
+                return true;
+
+            case opFloatToInt:
+
+                // out of range and NaN are undefined
+                if (!value.mFloat || !(value.mFloatValue>=-2147483648.0f && value.mFloatValue<2147483648.0f))
+                    return false;
+
+                result = Value::makeInteger (static_cast<Type_Integer> (value.mFloatValue));
+                return true;
+
+            case opNegateInt:
+
+                if (value.mFloat || value.mInteger==std::numeric_limits<Type_Integer>::min())
+                    return false;
+
+                result = Value::makeInteger (-value.mInteger);
+                return true;
+
+            case opNegateFloat:
+
+                if (!value.mFloat)
+                    return false;
+
+                result = Value::makeFloat (-value.mFloatValue);
+                return true;
+
+            case opSquareRoot:
+
+                // a negative value throws when the script is run
+                if (!value.mFloat || !(value.mFloatValue>=0))
+                    return false;
+
+                result = Value::makeFloat (std::sqrt (value.mFloatValue));
+                return true;
+        }
+
+        return false;
+    }
+
+    /// Evaluate the segment 5 instruction \a opcode on two values
+    /// \param left stack[1]
+    /// \param right stack[0]
+    /// \return Can the result be computed without changing the behaviour of the script?
+    bool foldBinary (int opcode, const Value& left, const Value& right, Value& result)
+    {
+        const Type_Integer max = std::numeric_limits<Type_Integer>::max();
+        const Type_Integer min = std::numeric_limits<Type_Integer>::min();
+
+        if ((opcode>=opAddInt && opcode<=opDivInt && opcode%2==1) ||
+            (opcode>=opEqualInt && opcode<=opGreaterOrEqualInt))
+        {
+            if (left.mFloat || right.mFloat)
+                return false;
+
+            Type_Integer a = left.mInteger;
+            Type_Integer b = right.mInteger;
+
+            switch (opcode)
+            {
+                case opAddInt:
+
+                    if ((b>0 && a>max-b) || (b<0 && a<min-b))
+                        return false;
+
+                    result = Value::makeInteger (a+b);
+                    return true;
+
+                case opSubInt:
+
+                    if ((b<0 && a>max+b) || (b>0 && a<min+b))
+                        return false;
+
+                    result = Value::makeInteger (a-b);
+                    return true;
+
+                case opMulInt:
+                {
+                    // exact, the product of two 32 bit integers fits into the mantissa or is far out of range
+                    double product = static_cast<double> (a) * b;
+
+                    if (product>max || product<min)
+                        return false;
+
+                    result = Value::makeInteger (a*b);
+                    return true;
+                }
+
+                case opDivInt:
+
+                    if (b==0 || (a==min && b==-1))
+                        return false;
+
+                    result = Value::makeInteger (a/b);
+                    return true;
+
+                case opEqualInt: result = Value::makeInteger (a==b); return true;
+                case opNonEqualInt: result = Value::makeInteger (a!=b); return true;
+                case opLessThanInt: result = Value::makeInteger (a<b); return true;
+                case opLessOrEqualInt: result = Value::makeInteger (a<=b); return true;
+                case opGreaterThanInt: result = Value::makeInteger (a>b); return true;
+                case opGreaterOrEqualInt: result = Value::makeInteger (a>=b); return true;
+            }
+        }
+        else if ((opcode>=opAddFloat && opcode<=opDivFloat && opcode%2==0) ||
+            (opcode>=opEqualFloat && opcode<=opGreaterOrEqualFloat))
+        {
+            if (!left.mFloat || !right.mFloat)
+                return false;
+
+            Type_Float a = left.mFloatValue;
+            Type_Float b = right.mFloatValue;
+
+            switch (opcode)
+            {
+                case opAddFloat: result = Value::makeFloat (a+b); return true;
+                case opSubFloat: result = Value::makeFloat (a-b); return true;
+                case opMulFloat: result = Value::makeFloat (a*b); return true;
+
+                case opDivFloat:
+
+                    if (b==0)
+                        return false;
+
+                    result = Value::makeFloat (a/b);
+                    return true;
+
+                case opEqualFloat: result = Value::makeInteger (a==b); return true;
+                case opNonEqualFloat: result = Value::makeInteger (a!=b); return true;
+                case opLessThanFloat: result = Value::makeInteger (a<b); return true;
+                case opLessOrEqualFloat: result = Value::makeInteger (a<=b); return true;
+                case opGreaterThanFloat: result = Value::makeInteger (a>b); return true;
+                case opGreaterOrEqualFloat: result = Value::makeInteger (a>=b); return true;
+            }
+        }
+
+        return false;
+    }
+
+    struct Instruction
+    {
+        Type_Code mCode;
+
+        /// Index of the instruction a jump leads to (the size of the code block for the end of the
+        /// script), -1 for instructions other than jumps
+        int mTarget;
+
+        explicit Instruction (Type_Code code, int target = -1) : mCode (code), mTarget (target) {}
+    };
+
+    class Optimizer
+    {
+            std::vector<Instruction> mCode;
+            std::vector<Type_Integer> mIntegers;
+            std::vector<Type_Float> mFloats;
+            std::vector<Type_Code> mStrings;
+
+            /// Instructions that are reached from somewhere else than the instruction before them
+            std::vector<bool> mTargets;
+
+            void findTargets();
+
+            /// Is the instruction at \a index skipped by a skip instruction? It must stay a single instruction.
+            bool isSkipped (int index) const;
+
+            /// \return Is the instruction at \a index pushing a constant?
+            /// \param length Number of instructions pushing the constant
+            bool getConstant (int index, Value& value, int& length) const;
+
+            void addConstant (std::vector<Instruction>& code, const Value& value);
+
+            /// Optimise the instructions starting at \a index
+            /// \return Number of instructions replaced by the instructions added to \a code (0: none)
+            int simplify (int index, std::vector<Instruction>& code);
+
+            /// Use \a code instead of mCode.
+            /// \param map Index in \a code for each index in mCode (followed by one for the end of the code)
+            /// \return Has mCode been replaced? Not if a jump would lead to itself.
+            bool replace (std::vector<Instruction>& code, const std::vector<int>& map);
+
+        public:
+
+            bool read (const std::vector<Type_Code>& code);
+            ///< \return Can \a code be optimised?
+
+            void write (std::vector<Type_Code>& code) const;
+
+            bool simplify();
+            ///< Constant folding, dead branches, jumps and fetching locals
+
+            bool fuseStores();
+            ///< Local variable index and the store instruction
+
+            bool removeUnreachable();
+    };
+
+    void Optimizer::findTargets()
+    {
+        int size = static_cast<int> (mCode.size());
+
+        mTargets.assign (size+1, false);
+
+        for (int i=0; i<size; ++i)
+            if (mCode[i].mTarget>=0)
+                mTargets[mCode[i].mTarget] = true;
+            else
+            {
+                int opcode = getSegment5 (mCode[i].mCode);
+                if (opcode==opSkipOnZero || opcode==opSkipOnNonZero)
+                    mTargets[i+2] = true;
+            }
+    }
+
+    bool Optimizer::isSkipped (int index) const
+    {
+        if (index==0)
+            return false;
+
+        int opcode = getSegment5 (mCode[index-1].mCode);
+        return opcode==opSkipOnZero || opcode==opSkipOnNonZero;
+    }
+
+    bool Optimizer::getConstant (int index, Value& value, int& length) const
+    {
+        int size = static_cast<int> (mCode.size());
+
+        if (index>=size || getSegment0 (mCode[index].mCode)!=opPushInt)
+            return false;
+
+        unsigned int arg0 = getArg0 (mCode[index].mCode);
+
+        if (index+1<size && !mTargets[index+1])
+        {
+            int opcode = getSegment5 (mCode[index+1].mCode);
+
+            if (opcode==opFetchIntLiteral)
+            {
+                if (arg0>=mIntegers.size())
+                    return false;
+
+                value = Value::makeInteger (mIntegers[arg0]);
+                length = 2;
+                return true;
+            }
+
+            if (opcode==opFetchFloatLiteral)
+            {
+                if (arg0>=mFloats.size())
+                    return false;
+
+                value = Value::makeFloat (mFloats[arg0]);
+                length = 2;
+                return true;
+            }
+        }
+
+        value = Value::makeInteger (static_cast<Type_Integer> (arg0));
+        length = 1;
+        return true;
+    }
+
+    void Optimizer::addConstant (std::vector<Instruction>& code, const Value& value)
+    {
+        if (!value.mFloat && value.mInteger>=0 && value.mInteger<=0xffffff)
+        {
+            code.push_back (Instruction (Compiler::Generator::segment0 (opPushInt, value.mInteger)));
+            return;
+        }
+
+        std::size_t index = 0;
+
+        if (value.mFloat)
+        {
+            // compare the bits, to tell 0 and -0 apart
+            while (index<mFloats.size() &&
+                std::memcmp (&mFloats[index], &value.mFloatValue, sizeof (Type_Float)))
+                ++index;
+
+            if (index==mFloats.size())
+                mFloats.push_back (value.mFloatValue);
+        }
+        else
+        {
+            while (index<mIntegers.size() && mIntegers[index]!=value.mInteger)
+                ++index;
+
+            if (index==mIntegers.size())
+                mIntegers.push_back (value.mInteger);
+        }
+
+        code.push_back (Instruction (Compiler::Generator::segment0 (opPushInt, index)));
+        code.push_back (Instruction (Compiler::Generator::segment5 (
+            value.mFloat ? opFetchFloatLiteral : opFetchIntLiteral)));
+    }
+
+    int Optimizer::simplify (int index, std::vector<Instruction>& code)
+    {
+        int size = static_cast<int> (mCode.size());
+        const Instruction& instruction = mCode[index];
+
+        if (instruction.mTarget>=0)
+        {
+            // follow jumps to jumps (a loop of jumps stops at the last jump before this one)
+            int target = instruction.mTarget;
+
+            for (int i=0; i<size && target<size && mCode[target].mTarget>=0 && mCode[target].mTarget!=index; ++i)
+                target = mCode[target].mTarget;
+
+            if (target==index+1 && !isSkipped (index))
+                return 1;
+
+            if (target!=instruction.mTarget)
+            {
+                code.push_back (Instruction (instruction.mCode, target));
+                return 1;
+            }
+
+            return 0;
+        }
+
+        // Everything below changes the number of instructions.
+        if (isSkipped (index))
+            return 0;
+
+        bool last = index+1>=size || mTargets[index+1];
+        int opcode = getSegment5 (instruction.mCode);
+
+        if ((opcode==opNegateInt || opcode==opNegateFloat) && !last &&
+            mCode[index+1].mCode==instruction.mCode)
+            return 2;
+
+        if (getSegment0 (instruction.mCode)==opPushInt && !last)
+        {
+            int next = getSegment5 (mCode[index+1].mCode);
+
+            if (next>=opFetchLocalShort && next<=opFetchLocalFloat)
+            {
+                code.push_back (Instruction (Compiler::Generator::segment0 (
+                    opPushLocalShort + next - opFetchLocalShort, getArg0 (instruction.mCode))));
+                return 2;
+            }
+        }
+
+        Value left;
+        int leftLength = 0;
+
+        if (!getConstant (index, left, leftLength))
+            return 0;
+
+        int operation = index + leftLength;
+
+        if (operation<size && !mTargets[operation])
+        {
+            opcode = getSegment5 (mCode[operation].mCode);
+
+            Value result;
+            if (foldUnary (opcode, left, result))
+            {
+                addConstant (code, result);
+                return leftLength + 1;
+            }
+
+            if ((opcode==opSkipOnZero || opcode==opSkipOnNonZero) && !left.mFloat)
+            {
+                bool skip = (left.mInteger==0)==(opcode==opSkipOnZero);
+
+                if (!skip)
+                    return leftLength + 1;
+
+                if (operation+1<size && !mTargets[operation+1])
+                    return leftLength + 2;
+            }
+
+            Value right;
+            int rightLength = 0;
+
+            if (getConstant (operation, right, rightLength))
+            {
+                operation += rightLength;
+
+                if (operation<size && !mTargets[operation])
+                {
+                    opcode = getSegment5 (mCode[operation].mCode);
+
+                    if (foldBinary (opcode, left, right, result))
+                    {
+                        addConstant (code, result);
+                        return leftLength + rightLength + 1;
+                    }
+
+                    if (opcode==opIntToFloat1 && !left.mFloat)
+                    {
+                        addConstant (code, Value::makeFloat (static_cast<Type_Float> (left.mInteger)));
+                        addConstant (code, right);
+                        return leftLength + rightLength + 1;
+                    }
+                }
+            }
+        }
+
+        // push small integers directly instead of through the literals
+        if (leftLength==2 && !left.mFloat && left.mInteger>=0 && left.mInteger<=0xffffff)
+        {
+            addConstant (code, left);
+            return 2;
+        }
+
+        return 0;
+    }
+
+    bool Optimizer::replace (std::vector<Instruction>& code, const std::vector<int>& map)
+    {
+        for (std::size_t i=0; i<code.size(); ++i)
+            if (code[i].mTarget>=0)
+            {
+                code[i].mTarget = map[code[i].mTarget];
+
+                // an empty loop; the original code loops forever, a jump by 0 throws
+                if (code[i].mTarget==static_cast<int> (i))
+                    return false;
+            }
+
+        mCode.swap (code);
+        return true;
+    }
+
+    bool Optimizer::read (const std::vector<Type_Code>& code)
+    {
+        if (code.size()<4 || code.size()!=4+code[0]+code[1]+code[2]+code[3])
+            return false;
+
+        int size = static_cast<int> (code[0]);
+        const Type_Code *literals = &code[4+size];
+
+        mCode.clear();
+        mCode.reserve (size);
+
+        for (int i=0; i<size; ++i)
+        {
+            Type_Code instruction = code[4+i];
+            int target = -1;
+
+            switch (getSegment0 (instruction))
+            {
+                case opJumpForward: target = i + getArg0 (instruction); break;
+                case opJumpBackward: target = i - getArg0 (instruction); break;
+            }
+
+            if (target==i || target>size)
+                return false;
+
+            int opcode = getSegment5 (instruction);
+            if ((opcode==opSkipOnZero || opcode==opSkipOnNonZero) && i+2>size)
+                return false;
+
+            // target<0: not a jump or a jump out of the script
+            if (target<0 && getSegment0 (instruction)==opJumpBackward)
+                return false;
+
+            mCode.push_back (Instruction (instruction, target));
+        }
+
+        mIntegers.clear();
+        for (Type_Code i=0; i<code[1]; ++i)
+            mIntegers.push_back (*reinterpret_cast<const Type_Integer *> (literals++));
+
+        mFloats.clear();
+        for (Type_Code i=0; i<code[2]; ++i)
+            mFloats.push_back (*reinterpret_cast<const Type_Float *> (literals++));
+
+        mStrings.assign (literals, literals+code[3]);
+
+        return true;
+    }
+
+    void Optimizer::write (std::vector<Type_Code>& code) const
+    {
+        code.clear();
+
+        code.push_back (static_cast<Type_Code> (mCode.size()));
+        code.push_back (static_cast<Type_Code> (mIntegers.size()));
+        code.push_back (static_cast<Type_Code> (mFloats.size()));
+        code.push_back (static_cast<Type_Code> (mStrings.size()));
+
+        for (std::size_t i=0; i<mCode.size(); ++i)
+        {
+            int offset = mCode[i].mTarget - static_cast<int> (i);
+
+            if (mCode[i].mTarget<0)
+                code.push_back (mCode[i].mCode);
+            else if (offset>0)
+                code.push_back (Compiler::Generator::segment0 (opJumpForward, offset));
+            else
+                code.push_back (Compiler::Generator::segment0 (opJumpBackward, -offset));
+        }
+
+        for (std::vector<Type_Integer>::const_iterator iter (mIntegers.begin()); iter!=mIntegers.end(); ++iter)
+            code.push_back (*reinterpret_cast<const Type_Code *> (&*iter));
+
+        for (std::vector<Type_Float>::const_iterator iter (mFloats.begin()); iter!=mFloats.end(); ++iter)
+            code.push_back (*reinterpret_cast<const Type_Code *> (&*iter));
+
+        code.insert (code.end(), mStrings.begin(), mStrings.end());
+    }
+
+    bool Optimizer::simplify()
+    {
+        findTargets();
+
+        int size = static_cast<int> (mCode.size());
+        std::vector<Instruction> code;
+        std::vector<int> map (size+1);
+        bool changed = false;
+
+        for (int i=0; i<size; )
+        {
+            int start = static_cast<int> (code.size());
+            int length = simplify (i, code);
+
+            if (length)
+                changed = true;
+            else
+            {
+                code.push_back (mCode[i]);
+                length = 1;
+            }
+
+            for (int j=0; j<length; ++j)
+                map[i+j] = start;
+
+            i += length;
+        }
+
+        map[size] = static_cast<int> (code.size());
+
+        return changed && replace (code, map);
+    }
+
+    bool Optimizer::fuseStores()
+    {
+        findTargets();
+
+        int size = static_cast<int> (mCode.size());
+        std::vector<bool> removed (size, false);
+        std::vector<Instruction> replaced (mCode);
+        bool changed = false;
+
+        for (int i=0; i<size; ++i)
+        {
+            int opcode = getSegment5 (mCode[i].mCode);
+
+            if (opcode<opStoreLocalShort || opcode>opStoreLocalFloat)
+                continue;
+
+            // Find the instruction that pushed the index (stack[1]), in straight code.
+            int depth = 2;
+            int index = i-1;
+
+            for (; index>=0 && !mTargets[index+1]; --index)
+            {
+                int pops = 0;
+                int pushes = 0;
+
+                if (!getStackEffect (mCode[index].mCode, pops, pushes))
+                {
+                    index = -1;
+                    break;
+                }
+
+                if (depth<=pushes)
+                    break;
+
+                depth += pops - pushes;
+            }
+
+            if (index<0 || depth!=1 || getSegment0 (mCode[index].mCode)!=opPushInt || isSkipped (index))
+                continue;
+
+            removed[index] = true;
+            replaced[i] = Instruction (Compiler::Generator::segment0 (
+                opPopLocalShort + opcode - opStoreLocalShort, getArg0 (mCode[index].mCode)));
+            changed = true;
+        }
+
+        if (!changed)
+            return false;
+
+        std::vector<Instruction> code;
+        std::vector<int> map (size+1);
+
+        for (int i=0; i<size; ++i)
+        {
+            map[i] = static_cast<int> (code.size());
+
+            if (!removed[i])
+                code.push_back (replaced[i]);
+        }
+
+        map[size] = static_cast<int> (code.size());
+
+        return replace (code, map);
+    }
+
+    bool Optimizer::removeUnreachable()
+    {
+        int size = static_cast<int> (mCode.size());
+        std::vector<bool> reachable (size, false);
+        std::vector<int> open (1, 0);
+
+        while (!open.empty())
+        {
+            int index = open.back();
+            open.pop_back();
+
+            if (index>=size || reachable[index])
+                continue;
+
+            reachable[index] = true;
+
+            int opcode = getSegment5 (mCode[index].mCode);
+
+            if (mCode[index].mTarget>=0)
+                open.push_back (mCode[index].mTarget);
+            else if (opcode==opSkipOnZero || opcode==opSkipOnNonZero)
+            {
+                open.push_back (index+1);
+                open.push_back (index+2);
+            }
+            else if (opcode!=opReturn)
+                open.push_back (index+1);
+        }
+
+        std::vector<Instruction> code;
+        std::vector<int> map (size+1);
+
+        for (int i=0; i<size; ++i)
+        {
+            map[i] = static_cast<int> (code.size());
+
+            if (reachable[i])
+                code.push_back (mCode[i]);
+        }
+
+        map[size] = static_cast<int> (code.size());
+
+        if (code.size()==mCode.size())
+            return false;
+
+        return replace (code, map);
+    }
+}
+
+namespace Compiler
+{
+    bool optimize (std::vector<Interpreter::Type_Code>& code)
+    {
+        Optimizer optimizer;
+
+        if (!optimizer.read (code))
+            return false;
+
+        bool changed = false;
+
+        for (int i=0; i<sMaxPasses; ++i)
+        {
+            bool passChanged = optimizer.simplify();
+
+            if (optimizer.fuseStores())
+                passChanged = true;
+
+            if (optimizer.removeUnreachable())
+                passChanged = true;
+
+            if (!passChanged)
+                break;
+
+            changed = true;
+        }
+
+        if (changed)
+            optimizer.write (code);
+
+        return changed;
+    }
+}
@@ -0,0 +1,28 @@
+#ifndef COMPILER_OPTIMIZER_H_INCLUDED
+#define COMPILER_OPTIMIZER_H_INCLUDED
+
+#include <vector>
+
+#include <components/interpreter/types.hpp>
+
+namespace Compiler
+{
+    /// \brief Peephole optimisation of compiled scripts
+    ///
+    /// The generator emits each expression and statement on its own. This pass works on the result:
+    /// - constant expressions are evaluated, small integer constants are pushed without a literal
+    /// - branches on constant conditions, jumps to the next instruction and unreachable code are
+    ///   removed, jumps to jumps lead to the final target
+    /// - pushing a local variable's index followed by fetching or storing the local is replaced by
+    ///   a single instruction with the index as argument
+    ///
+    /// Expressions that would fail when run (division by zero, square root of a negative number) or
+    /// overflow are left alone, so that the optimised script behaves exactly like the original one.
+    ///
+    /// \param code Header, code block and literals, as returned by Output::getCode. Code that can't
+    /// be analysed (e.g. a jump out of the code block) is left unchanged.
+    /// \return Has \a code been changed?
+    bool optimize (std::vector<Interpreter::Type_Code>& code);
+}
+
+#endif
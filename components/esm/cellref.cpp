@@ -45,7 +45,7 @@ void ESM::CellRef::loadId (ESMReader& esm, bool wideRefNum)
 
     mRefNum.load (esm, wideRefNum);
 
-    mRefID = esm.getHNOString ("NAME");
+    esm.getHNOStringView("NAME").assignTo(mRefID);
     if (mRefID.empty())
     {
         std::ios::fmtflags f(std::cerr.flags());
@@ -71,16 +71,16 @@ void ESM::CellRef::loadData(ESMReader &esm, bool &isDeleted)
                 esm.getHT(mScale);
                 break;
             case ESM::FourCC<'A','N','A','M'>::value:
-                mOwner = esm.getHString();
+                esm.getHStringView().assignTo(mOwner);
                 break;
             case ESM::FourCC<'B','N','A','M'>::value:
-                mGlobalVariable = esm.getHString();
+                esm.getHStringView().assignTo(mGlobalVariable);
                 break;
             case ESM::FourCC<'X','S','O','L'>::value:
-                mSoul = esm.getHString();
+                esm.getHStringView().assignTo(mSoul);
                 break;
             case ESM::FourCC<'C','N','A','M'>::value:
-                mFaction = esm.getHString();
+                esm.getHStringView().assignTo(mFaction);
                 break;
             case ESM::FourCC<'I','N','D','X'>::value:
                 esm.getHT(mFactionRank);
@@ -99,16 +99,16 @@ void ESM::CellRef::loadData(ESMReader &esm, bool &isDeleted)
                 mTeleport = true;
                 break;
             case ESM::FourCC<'D','N','A','M'>::value:
-                mDestCell = esm.getHString();
+                esm.getHStringView().assignTo(mDestCell);
                 break;
             case ESM::FourCC<'F','L','T','V'>::value:
                 esm.getHT(mLockLevel);
                 break;
             case ESM::FourCC<'K','N','A','M'>::value:
-                mKey = esm.getHString();
+                esm.getHStringView().assignTo(mKey);
                 break;
             case ESM::FourCC<'T','N','A','M'>::value:
-                mTrap = esm.getHString();
+                esm.getHStringView().assignTo(mTrap);
                 break;
             case ESM::FourCC<'D','A','T','A'>::value:
                 esm.getHT(mPos, 24);
@@ -229,3 +229,9 @@ bool ESM::operator< (const RefNum& left, const RefNum& right)
 
     return left.mContentFile<right.mContentFile;
 }
+
+std::size_t ESM::hash_value (const RefNum& refNum)
+{
+    // The index only uses the low 24 bits for references from content files
+    return refNum.mIndex ^ (static_cast<std::size_t>(refNum.mContentFile) << 24);
+}
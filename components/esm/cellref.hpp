@@ -113,6 +113,9 @@ namespace ESM
 
     bool operator== (const RefNum& left, const RefNum& right);
     bool operator< (const RefNum& left, const RefNum& right);
+
+    /// Hash function for boost::unordered containers keyed by RefNum
+    std::size_t hash_value (const RefNum& refNum);
 }
 
 #endif
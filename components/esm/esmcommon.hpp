@@ -108,6 +108,31 @@ typedef FIXED_STRING<32> NAME32;
 typedef FIXED_STRING<64> NAME64;
 typedef FIXED_STRING<256> NAME256;
 
+/// Non-owning reference to a string that is not necessarily zero terminated,
+/// see ESMReader::getHStringView() for the lifetime of the referenced data.
+class StringView
+{
+public:
+    StringView() : mData(""), mSize(0) {}
+    StringView(const char* data, size_t size) : mData(data), mSize(size) {}
+
+    const char* data() const { return mData; }
+    size_t size() const { return mSize; }
+    bool empty() const { return mSize == 0; }
+
+    std::string toString() const { return std::string(mData, mSize); }
+
+    /// Copy into \a str, reusing its storage if possible.
+    void assignTo(std::string& str) const { str.assign(mData, mSize); }
+
+    bool operator==(const std::string& str) const { return str.size() == mSize && str.compare(0, mSize, mData, mSize) == 0; }
+    bool operator!=(const std::string& str) const { return !(*this == str); }
+
+private:
+    const char* mData;
+    size_t mSize;
+};
+
 /* This struct defines a file 'context' which can be saved and later
    restored by an ESMReader instance. It will save the position within
    a file, and when restored will let you read from that position as
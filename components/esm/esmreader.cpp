@@ -2,6 +2,8 @@
 
 #include <stdexcept>
 
+#include <components/files/memorymappedfile.hpp>
+
 namespace ESM
 {
 
@@ -15,12 +17,14 @@ using namespace Misc;
 ESM_Context ESMReader::getContext()
 {
     // Update the file position before returning
-    mCtx.filePos = mEsm->tellg();
+    mCtx.filePos = getFileOffset();
     return mCtx;
 }
 
 ESMReader::ESMReader()
     : mIdx(0)
+    , mMapOffset(0)
+    , mMemoryMapped(false)
     , mRecordFlags(0)
     , mBuffer(50*1024)
     , mGlobalReaderList(NULL)
@@ -44,12 +48,17 @@ void ESMReader::restoreContext(const ESM_Context &rc)
     mCtx = rc;
 
     // Make sure we seek to the right place
-    mEsm->seekg(mCtx.filePos);
+    if (mMapping)
+        mMapOffset = mCtx.filePos;
+    else
+        mEsm->seekg(mCtx.filePos);
 }
 
 void ESMReader::close()
 {
     mEsm.reset();
+    mMapping.reset();
+    mMapOffset = 0;
     mCtx.filename.clear();
     mCtx.leftFile = 0;
     mCtx.leftRec = 0;
@@ -71,13 +80,35 @@ void ESMReader::openRaw(Files::IStreamPtr _esm, const std::string& name)
 
 void ESMReader::openRaw(const std::string& filename)
 {
-    openRaw(Files::openConstrainedFileStream(filename.c_str()), filename);
+    if (!mMemoryMapped)
+    {
+        openRaw(Files::openConstrainedFileStream(filename.c_str()), filename);
+        return;
+    }
+
+    boost::shared_ptr<Files::MemoryMappedFile> mapping(new Files::MemoryMappedFile);
+    mapping->open(filename.c_str());
+
+    close();
+    mMapping = mapping;
+    mCtx.filename = filename;
+    mCtx.leftFile = mFileSize = mMapping->size();
 }
 
 void ESMReader::open(Files::IStreamPtr _esm, const std::string &name)
 {
     openRaw(_esm, name);
+    loadHeader();
+}
 
+void ESMReader::open(const std::string &file)
+{
+    openRaw(file);
+    loadHeader();
+}
+
+void ESMReader::loadHeader()
+{
     if (getRecName() != "TES3")
         fail("Not a valid Morrowind file");
 
@@ -86,11 +117,6 @@ void ESMReader::open(Files::IStreamPtr _esm, const std::string &name)
     mHeader.load (*this);
 }
 
-void ESMReader::open(const std::string &file)
-{
-    open (Files::openConstrainedFileStream (file.c_str ()), file);
-}
-
 int64_t ESMReader::getHNLong(const char *name)
 {
     int64_t val;
@@ -112,6 +138,24 @@ std::string ESMReader::getHNString(const char* name)
 }
 
 std::string ESMReader::getHString()
+{
+    return getHStringView().toString();
+}
+
+StringView ESMReader::getHNOStringView(const char* name)
+{
+    if (isNextSub(name))
+        return getHStringView();
+    return StringView();
+}
+
+StringView ESMReader::getHNStringView(const char* name)
+{
+    getSubNameIs(name);
+    return getHStringView();
+}
+
+StringView ESMReader::getHStringView()
 {
     getSubHeader();
 
@@ -126,10 +170,10 @@ std::string ESMReader::getHString()
         mCtx.leftRec--;
         char c;
         getExact(&c, 1);
-        return "";
+        return StringView();
     }
 
-    return getString(mCtx.leftSub);
+    return getStringView(mCtx.leftSub);
 }
 
 void ESMReader::getHExact(void*p, int size)
@@ -315,6 +359,12 @@ void ESMReader::getRecHeader(uint32_t &flags)
 
 void ESMReader::getExact(void*x, int size)
 {
+    if (mMapping)
+    {
+        memcpy(x, getMapped(size), size);
+        return;
+    }
+
     try
     {
         mEsm->read((char*)x, size);
@@ -327,26 +377,46 @@ void ESMReader::getExact(void*x, int size)
 
 std::string ESMReader::getString(int size)
 {
-    size_t s = size;
-    if (mBuffer.size() <= s)
-        // Add some extra padding to reduce the chance of having to resize
-        // again later.
-        mBuffer.resize(3*s);
-
-    // And make sure the string is zero terminated
-    mBuffer[s] = 0;
+    return getStringView(size).toString();
+}
 
-    // read ESM data
-    char *ptr = &mBuffer[0];
-    getExact(ptr, size);
+StringView ESMReader::getStringView(int size)
+{
+    const char *ptr;
+    if (mMapping)
+        // Point straight into the file
+        ptr = getMapped(size);
+    else
+    {
+        size_t s = size;
+        if (mBuffer.size() < s)
+            // Add some extra padding to reduce the chance of having to resize
+            // again later.
+            mBuffer.resize(3*s);
+
+        // read ESM data
+        char *buffer = &mBuffer[0];
+        getExact(buffer, size);
+        ptr = buffer;
+    }
 
-    size = strnlen(ptr, size);
+    size_t length = strnlen(ptr, size);
 
-    // Convert to UTF8 and return
+    // Convert to UTF8, this only copies strings that aren't pure ascii
     if (mEncoder)
-        return mEncoder->getUtf8(ptr, size);
+        ptr = mEncoder->convertToUtf8(ptr, length);
+
+    return StringView(ptr, length);
+}
+
+const char* ESMReader::getMapped(int size)
+{
+    if (size < 0 || static_cast<size_t>(size) > mMapping->size() - mMapOffset)
+        fail("Read error: unexpected end of file");
 
-    return std::string (ptr, size);
+    const char* ptr = mMapping->data() + mMapOffset;
+    mMapOffset += size;
+    return ptr;
 }
 
 void ESMReader::fail(const std::string &msg)
@@ -359,8 +429,8 @@ void ESMReader::fail(const std::string &msg)
     ss << "\n  File: " << mCtx.filename;
     ss << "\n  Record: " << mCtx.recName.toString();
     ss << "\n  Subrecord: " << mCtx.subName.toString();
-    if (mEsm.get())
-        ss << "\n  Offset: 0x" << hex << mEsm->tellg();
+    if (mEsm.get() || mMapping)
+        ss << "\n  Offset: 0x" << hex << getFileOffset();
     throw std::runtime_error(ss.str());
 }
 
@@ -371,12 +441,17 @@ void ESMReader::setEncoder(ToUTF8::Utf8Encoder* encoder)
 
 size_t ESMReader::getFileOffset()
 {
+    if (mMapping)
+        return mMapOffset;
     return mEsm->tellg();
 }
 
 void ESMReader::skip(int bytes)
 {
-    mEsm->seekg(getFileOffset()+bytes);
+    if (mMapping)
+        getMapped(bytes);
+    else
+        mEsm->seekg(getFileOffset()+bytes);
 }
 
 }
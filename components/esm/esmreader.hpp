@@ -16,6 +16,11 @@
 #include "esmcommon.hpp"
 #include "loadtes3.hpp"
 
+namespace Files
+{
+  class MemoryMappedFile;
+}
+
 namespace ESM {
 
 class ESMReader
@@ -73,6 +78,14 @@ public:
 
   void openRaw(const std::string &filename);
 
+  /// Map files opened by name into memory instead of reading them through a stream. The
+  /// string view accessors then point directly into the mapping for most strings.
+  /// @note Affects files opened after the call, including a file reopened by restoreContext().
+  void setMemoryMapped(bool mapped) { mMemoryMapped = mapped; }
+
+  /// Is the open file read from a memory mapping? Copies of the reader share the mapping.
+  bool hasMappedFile() const { return mMapping.get() != NULL; }
+
   /// Get the current position in the file. Make sure that the file has been opened!
   size_t getFileOffset();
 
@@ -161,6 +174,12 @@ public:
   // Read a string, including the sub-record header (but not the name)
   std::string getHString();
 
+  // Versions of the string accessors above that avoid copying the string. The view is only
+  // valid until the next read from this reader, copy it if it is needed for longer.
+  StringView getHNOStringView(const char* name);
+  StringView getHNStringView(const char* name);
+  StringView getHStringView();
+
   // Read the given number of bytes from a subrecord
   void getHExact(void*p, int size);
 
@@ -255,6 +274,9 @@ public:
   // them from native encoding to UTF8 in the process.
   std::string getString(int size);
 
+  // Version of getString() returning a view, see getHStringView()
+  StringView getStringView(int size);
+
   void skip(int bytes);
 
   /// Used for error handling
@@ -262,6 +284,7 @@ public:
 
   /// Sets font encoder for ESM strings
   void setEncoder(ToUTF8::Utf8Encoder* encoder);
+  ToUTF8::Utf8Encoder* getEncoder() const { return mEncoder; }
 
   /// Get record flags of last record
   unsigned int getRecordFlags() { return mRecordFlags; }
@@ -269,8 +292,18 @@ public:
   size_t getFileSize() const { return mFileSize; }
 
 private:
+  void loadHeader();
+
+  // Advance the position in the mapped file, returning the data read
+  const char* getMapped(int size);
+
   Files::IStreamPtr mEsm;
 
+  // Set instead of mEsm while a mapped file is open, shared between copies of the reader
+  boost::shared_ptr<Files::MemoryMappedFile> mMapping;
+  size_t mMapOffset;
+  bool mMemoryMapped;
+
   ESM_Context mCtx;
 
   unsigned int mRecordFlags;
@@ -80,6 +80,11 @@ namespace ESM
         bool isDeleted = false;
         info.load(esm, isDeleted);
 
+        addInfo(info, isDeleted, merge);
+    }
+
+    void Dialogue::addInfo(const ESM::DialInfo& info, bool isDeleted, bool merge)
+    {
         if (!merge || mInfo.empty())
         {
             mLookup[info.mId] = std::make_pair(mInfo.insert(mInfo.end(), info), isDeleted);
@@ -10,15 +10,15 @@ namespace ESM
 
     void DialInfo::load(ESMReader &esm, bool &isDeleted)
     {
-        mId = esm.getHNString("INAM");
+        esm.getHNStringView("INAM").assignTo(mId);
 
         isDeleted = false;
 
         mQuestStatus = QS_None;
         mFactionLess = false;
 
-        mPrev = esm.getHNString("PNAM");
-        mNext = esm.getHNString("NNAM");
+        esm.getHNStringView("PNAM").assignTo(mPrev);
+        esm.getHNStringView("NNAM").assignTo(mNext);
 
         while (esm.hasMoreSubs())
         {
@@ -29,17 +29,17 @@ namespace ESM
                     esm.getHT(mData, 12);
                     break;
                 case ESM::FourCC<'O','N','A','M'>::value:
-                    mActor = esm.getHString();
+                    esm.getHStringView().assignTo(mActor);
                     break;
                 case ESM::FourCC<'R','N','A','M'>::value:
-                    mRace = esm.getHString();
+                    esm.getHStringView().assignTo(mRace);
                     break;
                 case ESM::FourCC<'C','N','A','M'>::value:
-                    mClass = esm.getHString();
+                    esm.getHStringView().assignTo(mClass);
                     break;
                 case ESM::FourCC<'F','N','A','M'>::value:
                 {
-                    mFaction = esm.getHString();
+                    esm.getHStringView().assignTo(mFaction);
                     if (mFaction == "FFFF")
                     {
                         mFactionLess = true;
@@ -47,27 +47,27 @@ namespace ESM
                     break;
                 }
                 case ESM::FourCC<'A','N','A','M'>::value:
-                    mCell = esm.getHString();
+                    esm.getHStringView().assignTo(mCell);
                     break;
                 case ESM::FourCC<'D','N','A','M'>::value:
-                    mPcFaction = esm.getHString();
+                    esm.getHStringView().assignTo(mPcFaction);
                     break;
                 case ESM::FourCC<'S','N','A','M'>::value:
-                    mSound = esm.getHString();
+                    esm.getHStringView().assignTo(mSound);
                     break;
                 case ESM::SREC_NAME:
-                    mResponse = esm.getHString();
+                    esm.getHStringView().assignTo(mResponse);
                     break;
                 case ESM::FourCC<'S','C','V','R'>::value:
                 {
                     SelectStruct ss;
-                    ss.mSelectRule = esm.getHString();
+                    esm.getHStringView().assignTo(ss.mSelectRule);
                     ss.mValue.read(esm, Variant::Format_Info);
                     mSelects.push_back(ss);
                     break;
                 }
                 case ESM::FourCC<'B','N','A','M'>::value:
-                    mResultScript = esm.getHString();
+                    esm.getHStringView().assignTo(mResultScript);
                     break;
                 case ESM::FourCC<'Q','S','T','N'>::value:
                     mQuestStatus = QS_Name;
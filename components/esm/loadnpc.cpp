@@ -29,32 +29,32 @@ namespace ESM
             switch (esm.retSubName().intval)
             {
                 case ESM::SREC_NAME:
-                    mId = esm.getHString();
+                    esm.getHStringView().assignTo(mId);
                     hasName = true;
                     break;
                 case ESM::FourCC<'M','O','D','L'>::value:
-                    mModel = esm.getHString();
+                    esm.getHStringView().assignTo(mModel);
                     break;
                 case ESM::FourCC<'F','N','A','M'>::value:
-                    mName = esm.getHString();
+                    esm.getHStringView().assignTo(mName);
                     break;
                 case ESM::FourCC<'R','N','A','M'>::value:
-                    mRace = esm.getHString();
+                    esm.getHStringView().assignTo(mRace);
                     break;
                 case ESM::FourCC<'C','N','A','M'>::value:
-                    mClass = esm.getHString();
+                    esm.getHStringView().assignTo(mClass);
                     break;
                 case ESM::FourCC<'A','N','A','M'>::value:
-                    mFaction = esm.getHString();
+                    esm.getHStringView().assignTo(mFaction);
                     break;
                 case ESM::FourCC<'B','N','A','M'>::value:
-                    mHead = esm.getHString();
+                    esm.getHStringView().assignTo(mHead);
                     break;
                 case ESM::FourCC<'K','N','A','M'>::value:
-                    mHair = esm.getHString();
+                    esm.getHStringView().assignTo(mHair);
                     break;
                 case ESM::FourCC<'S','C','R','I'>::value:
-                    mScript = esm.getHString();
+                    esm.getHStringView().assignTo(mScript);
                     break;
                 case ESM::FourCC<'N','P','D','T'>::value:
                     hasNpdt = true;
@@ -0,0 +1,160 @@
+#include "readerpool.hpp"
+
+#include <algorithm>
+
+#include <OpenThreads/ScopedLock>
+
+namespace ESM
+{
+
+    ReaderPool::PooledReader::PooledReader(int index, const ESMReader& prototype, bool usesFile)
+        : mIndex(index)
+        , mUsesFile(usesFile)
+        , mReader(prototype)
+    {
+        // The encoder keeps its output buffer between calls, so it can't be shared with other threads
+        if (ToUTF8::Utf8Encoder* encoder = prototype.getEncoder())
+        {
+            mEncoder.reset(new ToUTF8::Utf8Encoder(*encoder));
+            mReader.setEncoder(mEncoder.get());
+        }
+
+        // Don't share the stream of the prototype, restoreContext() opens the file again
+        if (usesFile)
+            mReader.close();
+    }
+
+    ReaderPool::ScopedReader::ScopedReader(ReaderPool& pool, int index)
+        : mPool(pool)
+        , mReader(pool.acquire(index))
+    {
+    }
+
+    ReaderPool::ScopedReader::~ScopedReader()
+    {
+        mPool.release(mReader);
+    }
+
+    ESMReader& ReaderPool::ScopedReader::operator*() const
+    {
+        return mReader->mReader;
+    }
+
+    ESMReader* ReaderPool::ScopedReader::operator->() const
+    {
+        return &mReader->mReader;
+    }
+
+    ReaderPool::ReaderPool(std::vector<ESMReader>& readers, int maxOpenFiles)
+        : mPrototypes(readers)
+        , mOpenFiles(0)
+        , mMaxOpenFiles(std::max(1, maxOpenFiles))
+    {
+    }
+
+    ReaderPool::~ReaderPool()
+    {
+        clear();
+    }
+
+    void ReaderPool::closePrototypes()
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+
+        for (std::vector<ESMReader>::iterator it = mPrototypes.begin(); it != mPrototypes.end(); ++it)
+        {
+            if (!it->hasMappedFile())
+                it->close();
+        }
+    }
+
+    void ReaderPool::clear()
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+
+        for (std::list<PooledReader*>::iterator it = mIdle.begin(); it != mIdle.end(); ++it)
+        {
+            if ((*it)->mUsesFile)
+                --mOpenFiles;
+            delete *it;
+        }
+        mIdle.clear();
+    }
+
+    int ReaderPool::getOpenFiles() const
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+        return mOpenFiles;
+    }
+
+    size_t ReaderPool::getIdleReaders() const
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+        return mIdle.size();
+    }
+
+    ReaderPool::PooledReader* ReaderPool::acquire(int index)
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+
+        const ESMReader& prototype = mPrototypes.at(index);
+        bool usesFile = !prototype.hasMappedFile();
+
+        while (true)
+        {
+            // Reuse an idle reader of the same file, the most recently used one is the most likely to be cached
+            for (std::list<PooledReader*>::reverse_iterator it = mIdle.rbegin(); it != mIdle.rend(); ++it)
+            {
+                if ((*it)->mIndex == index)
+                {
+                    PooledReader* reader = *it;
+                    mIdle.erase(--it.base());
+                    return reader;
+                }
+            }
+
+            if (!usesFile || mOpenFiles < mMaxOpenFiles)
+                break;
+
+            // Close the least recently used idle reader that holds a file
+            std::list<PooledReader*>::iterator evict = mIdle.begin();
+            while (evict != mIdle.end() && !(*evict)->mUsesFile)
+                ++evict;
+
+            if (evict != mIdle.end())
+            {
+                delete *evict;
+                mIdle.erase(evict);
+                --mOpenFiles;
+                break;
+            }
+
+            // All files are in use, wait for a reader to be released
+            mCondition.wait(&mMutex);
+        }
+
+        PooledReader* reader = new PooledReader(index, prototype, usesFile);
+        if (usesFile)
+            ++mOpenFiles;
+        return reader;
+    }
+
+    void ReaderPool::release(PooledReader* reader)
+    {
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+            mIdle.push_back(reader);
+
+            // Readers of memory mapped files don't count towards the file limit, but shouldn't pile up either
+            while (mIdle.size() > static_cast<size_t>(mMaxOpenFiles))
+            {
+                if (mIdle.front()->mUsesFile)
+                    --mOpenFiles;
+                delete mIdle.front();
+                mIdle.pop_front();
+            }
+        }
+        mCondition.broadcast();
+    }
+
+}
@@ -0,0 +1,107 @@
+#ifndef OPENMW_ESM_READERPOOL_H
+#define OPENMW_ESM_READERPOOL_H
+
+#include <list>
+#include <memory>
+#include <vector>
+
+#include <OpenThreads/Mutex>
+#include <OpenThreads/Condition>
+
+#include "esmreader.hpp"
+
+namespace ESM
+{
+
+    /// @brief Hands out readers for the content files, so that references can be read on any thread.
+    /// @par Each reader is a copy of the reader the content file was loaded with, but has its own file handle
+    /// and encoder. Readers of memory mapped content files share the mapping and need no file handle at all.
+    /// The number of files the pool keeps open is bounded, idle readers are closed when more are needed. Once the
+    /// content files are loaded, closePrototypes() makes the pool the only one keeping content files open.
+    /// @note All methods are thread safe.
+    class ReaderPool
+    {
+        struct PooledReader;
+
+    public:
+        /// @param readers Readers the content files were loaded with, by content file index. Only the
+        /// header information of these is used, they must stay unchanged while readers are handed out.
+        /// @param maxOpenFiles Maximum number of files the pool keeps open at the same time, and of idle readers
+        /// it keeps around.
+        ReaderPool(std::vector<ESMReader>& readers, int maxOpenFiles);
+        ~ReaderPool();
+
+        /// @brief Reader leased from the pool while in scope.
+        /// @par The reader is not positioned, use ESMReader::restoreContext() before reading. If the file limit
+        /// is reached, the constructor waits for another thread to release a reader.
+        /// @note Do not hold more than one ScopedReader per thread at a time, that could deadlock.
+        class ScopedReader
+        {
+        public:
+            ScopedReader(ReaderPool& pool, int index);
+            ~ScopedReader();
+
+            ESMReader& operator*() const;
+            ESMReader* operator->() const;
+
+        private:
+            // not implemented
+            ScopedReader(const ScopedReader&);
+            ScopedReader& operator=(const ScopedReader&);
+
+            ReaderPool& mPool;
+            PooledReader* mReader;
+        };
+
+        /// Close the files of the readers the content files were loaded with, keeping their header information.
+        /// Memory mapped files stay mapped, they are shared with the readers handed out.
+        /// @note Call once all content files are loaded and indexed.
+        void closePrototypes();
+
+        /// Close all idle readers. Readers in use are not affected.
+        void clear();
+
+        /// Number of files currently held open by the pool's readers, idle or not.
+        int getOpenFiles() const;
+
+        /// Number of readers that are not in use.
+        size_t getIdleReaders() const;
+
+    private:
+        struct PooledReader
+        {
+            PooledReader(int index, const ESMReader& prototype, bool usesFile);
+
+            int mIndex;
+            /// Does the reader hold a file handle, rather than sharing a memory mapping?
+            bool mUsesFile;
+            ESMReader mReader;
+            std::auto_ptr<ToUTF8::Utf8Encoder> mEncoder;
+
+        private:
+            // not implemented
+            PooledReader(const PooledReader&);
+            PooledReader& operator=(const PooledReader&);
+        };
+
+        // not implemented
+        ReaderPool(const ReaderPool&);
+        ReaderPool& operator=(const ReaderPool&);
+
+        PooledReader* acquire(int index);
+        void release(PooledReader* reader);
+
+        std::vector<ESMReader>& mPrototypes;
+
+        mutable OpenThreads::Mutex mMutex;
+        OpenThreads::Condition mCondition;
+
+        /// Readers not in use, least recently used first, at most mMaxOpenFiles
+        std::list<PooledReader*> mIdle;
+        int mOpenFiles;
+        int mMaxOpenFiles;
+    };
+
+}
+
+#endif
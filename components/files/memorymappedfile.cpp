@@ -0,0 +1,263 @@
+#include "memorymappedfile.hpp"
+
+#include <stdexcept>
+#include <sstream>
+#include <cassert>
+
+#if FILE_API == FILE_API_POSIX
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <string.h>
+#elif FILE_API == FILE_API_WIN32
+#include <boost/locale.hpp>
+#endif
+
+namespace Files
+{
+
+    bool MemoryMappedFile::isOpen() const
+    {
+        return mOpen;
+    }
+
+    const char* MemoryMappedFile::data() const
+    {
+        return mData;
+    }
+
+    size_t MemoryMappedFile::size() const
+    {
+        return mSize;
+    }
+
+#if FILE_API == FILE_API_STDIO
+/*
+ *
+ *  Fallback implementation reading the whole file into memory using c stdio
+ *
+ */
+
+    MemoryMappedFile::MemoryMappedFile()
+        : mData(NULL)
+        , mSize(0)
+        , mOpen(false)
+    {
+    }
+
+    MemoryMappedFile::~MemoryMappedFile()
+    {
+    }
+
+    void MemoryMappedFile::open(const char* filename)
+    {
+        assert(!mOpen);
+
+        LowLevelFile file;
+        file.open(filename);
+
+        mBuffer.resize(file.size());
+        size_t got = 0;
+        while (got < mBuffer.size())
+        {
+            size_t read = file.read(&mBuffer[got], mBuffer.size() - got);
+            if (read == 0)
+                throw std::runtime_error("A read operation on a file failed.");
+            got += read;
+        }
+
+        mData = mBuffer.empty() ? NULL : &mBuffer[0];
+        mSize = mBuffer.size();
+        mOpen = true;
+    }
+
+    void MemoryMappedFile::close()
+    {
+        assert(mOpen);
+
+        std::vector<char>().swap(mBuffer);
+        mData = NULL;
+        mSize = 0;
+        mOpen = false;
+    }
+
+#elif FILE_API == FILE_API_POSIX
+/*
+ *
+ *  Implementation of MemoryMappedFile methods using posix mmap
+ *
+ */
+
+    MemoryMappedFile::MemoryMappedFile()
+        : mData(NULL)
+        , mSize(0)
+        , mOpen(false)
+    {
+    }
+
+    MemoryMappedFile::~MemoryMappedFile()
+    {
+        if (mOpen)
+            close();
+    }
+
+    void MemoryMappedFile::open(const char* filename)
+    {
+        assert(!mOpen);
+
+#ifdef O_BINARY
+        static const int openFlags = O_RDONLY | O_BINARY;
+#else
+        static const int openFlags = O_RDONLY;
+#endif
+
+        int handle = ::open(filename, openFlags, 0);
+        if (handle == -1)
+        {
+            std::ostringstream os;
+            os << "Failed to open '" << filename << "' for reading: " << strerror(errno);
+            throw std::runtime_error(os.str());
+        }
+
+        struct stat info;
+        if (::fstat(handle, &info) == -1)
+        {
+            std::ostringstream os;
+            os << "An fstat() call failed: " << strerror(errno);
+            ::close(handle);
+            throw std::runtime_error(os.str());
+        }
+
+        size_t size = static_cast<size_t>(info.st_size);
+        void* data = NULL;
+        if (size != 0)
+        {
+            data = ::mmap(NULL, size, PROT_READ, MAP_PRIVATE, handle, 0);
+            if (data == MAP_FAILED)
+            {
+                std::ostringstream os;
+                os << "Failed to map '" << filename << "': " << strerror(errno);
+                ::close(handle);
+                throw std::runtime_error(os.str());
+            }
+        }
+
+        // The mapping stays valid after the descriptor is closed.
+        ::close(handle);
+
+        mData = static_cast<const char*>(data);
+        mSize = size;
+        mOpen = true;
+    }
+
+    void MemoryMappedFile::close()
+    {
+        assert(mOpen);
+
+        if (mData != NULL)
+            ::munmap(const_cast<char*>(mData), mSize);
+
+        mData = NULL;
+        mSize = 0;
+        mOpen = false;
+    }
+
+#elif FILE_API == FILE_API_WIN32
+/*
+ *
+ *  Implementation of MemoryMappedFile methods using Win32 file mappings
+ *
+ */
+
+    MemoryMappedFile::MemoryMappedFile()
+        : mData(NULL)
+        , mSize(0)
+        , mOpen(false)
+        , mHandle(INVALID_HANDLE_VALUE)
+        , mMapping(NULL)
+    {
+    }
+
+    MemoryMappedFile::~MemoryMappedFile()
+    {
+        if (mOpen)
+            close();
+    }
+
+    void MemoryMappedFile::open(const char* filename)
+    {
+        assert(!mOpen);
+
+        std::wstring wname = boost::locale::conv::utf_to_utf<wchar_t>(filename);
+        HANDLE handle = CreateFileW(wname.c_str(), GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, 0, 0);
+
+        if (handle == INVALID_HANDLE_VALUE)
+        {
+            std::ostringstream os;
+            os << "Failed to open '" << filename << "' for reading.";
+            throw std::runtime_error(os.str());
+        }
+
+        BY_HANDLE_FILE_INFORMATION info;
+        if (!GetFileInformationByHandle(handle, &info))
+        {
+            CloseHandle(handle);
+            throw std::runtime_error("A query operation on a file failed.");
+        }
+
+        if (info.nFileSizeHigh != 0)
+        {
+            CloseHandle(handle);
+            throw std::runtime_error("Files greater that 4GB are not supported.");
+        }
+
+        HANDLE mapping = NULL;
+        const void* data = NULL;
+        if (info.nFileSizeLow != 0)
+        {
+            mapping = CreateFileMappingW(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+            if (mapping == NULL)
+            {
+                CloseHandle(handle);
+                throw std::runtime_error("Failed to create a file mapping.");
+            }
+
+            data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            if (data == NULL)
+            {
+                CloseHandle(mapping);
+                CloseHandle(handle);
+                throw std::runtime_error("Failed to map a view of a file.");
+            }
+        }
+
+        mHandle = handle;
+        mMapping = mapping;
+        mData = static_cast<const char*>(data);
+        mSize = info.nFileSizeLow;
+        mOpen = true;
+    }
+
+    void MemoryMappedFile::close()
+    {
+        assert(mOpen);
+
+        if (mData != NULL)
+            UnmapViewOfFile(mData);
+        if (mMapping != NULL)
+            CloseHandle(mMapping);
+        CloseHandle(mHandle);
+
+        mHandle = INVALID_HANDLE_VALUE;
+        mMapping = NULL;
+        mData = NULL;
+        mSize = 0;
+        mOpen = false;
+    }
+
+#endif
+
+}
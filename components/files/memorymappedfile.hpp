@@ -0,0 +1,50 @@
+#ifndef COMPONENTS_FILES_MEMORYMAPPEDFILE_HPP
+#define COMPONENTS_FILES_MEMORYMAPPEDFILE_HPP
+
+#include <cstdlib>
+#include <vector>
+
+#include "lowlevelfile.hpp"
+
+namespace Files
+{
+
+    /// @brief Read-only view of a whole file mapped into the address space of the process.
+    /// @par On platforms without a mapping API the file contents are read into memory instead.
+    /// @note Once opened, data() may be accessed from any thread.
+    class MemoryMappedFile
+    {
+    public:
+        MemoryMappedFile();
+        ~MemoryMappedFile();
+
+        /// Map the given file. Throws an exception on failure.
+        void open(const char* filename);
+        void close();
+
+        bool isOpen() const;
+
+        /// Start of the mapped file, or NULL for an empty file.
+        const char* data() const;
+        size_t size() const;
+
+    private:
+        // not implemented
+        MemoryMappedFile(const MemoryMappedFile&);
+        MemoryMappedFile& operator=(const MemoryMappedFile&);
+
+        const char* mData;
+        size_t mSize;
+        bool mOpen;
+
+#if FILE_API == FILE_API_STDIO
+        std::vector<char> mBuffer;
+#elif FILE_API == FILE_API_WIN32
+        HANDLE mHandle;
+        HANDLE mMapping;
+#endif
+    };
+
+}
+
+#endif
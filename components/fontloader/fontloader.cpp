@@ -209,7 +209,7 @@ namespace Gui
 
     void FontLoader::loadFont(const std::string &fileName, bool exportToFile)
     {
-        Files::IStreamPtr file = mVFS->get(fileName);
+        Files::IStreamPtr file = mVFS->get(fileName, VFS::IOCategory_Font);
 
         float fontSize;
         file->read((char*)&fontSize, sizeof(fontSize));
@@ -247,7 +247,7 @@ namespace Gui
         // Create the font texture
         std::string bitmapFilename = "Fonts/" + std::string(name) + ".tex";
 
-        Files::IStreamPtr bitmapFile = mVFS->get(bitmapFilename);
+        Files::IStreamPtr bitmapFile = mVFS->get(bitmapFilename, VFS::IOCategory_Font);
 
         int width, height;
         bitmapFile->read((char*)&width, sizeof(int));
@@ -33,6 +33,12 @@ namespace Interpreter
         interpreter.installSegment5 (21, new OpFetchLocalShort);
         interpreter.installSegment5 (22, new OpFetchLocalLong);
         interpreter.installSegment5 (23, new OpFetchLocalFloat);
+        interpreter.installSegment0 (3, new OpPushLocalShort);
+        interpreter.installSegment0 (4, new OpPushLocalLong);
+        interpreter.installSegment0 (5, new OpPushLocalFloat);
+        interpreter.installSegment0 (6, new OpPopLocalShort);
+        interpreter.installSegment0 (7, new OpPopLocalLong);
+        interpreter.installSegment0 (8, new OpPopLocalFloat);
         interpreter.installSegment5 (39, new OpStoreGlobalShort);
         interpreter.installSegment5 (40, new OpStoreGlobalLong);
         interpreter.installSegment5 (41, new OpStoreGlobalFloat);
@@ -8,8 +8,12 @@
 
 namespace Interpreter
 {
-    void Interpreter::execute (Type_Code code)
+    void Interpreter::decode (Type_Code code, DecodedInstruction& instruction) const
     {
+        instruction.mCode = code;
+        instruction.mArg0 = 0;
+        instruction.mArg1 = 0;
+
         unsigned int segSpec = code>>30;
 
         switch (segSpec)
@@ -17,46 +21,34 @@ namespace Interpreter
             case 0:
             {
                 int opcode = code>>24;
-                unsigned int arg0 = code & 0xffffff;
-
-                std::map<int, Opcode1 *>::iterator iter = mSegment0.find (opcode);
-
-                if (iter==mSegment0.end())
-                    abortUnknownCode (0, opcode);
-
-                iter->second->execute (mRuntime, arg0);
-
+                instruction.mSegment = 0;
+                instruction.mOpcode = opcode;
+                instruction.mArg0 = code & 0xffffff;
+                instruction.mOpcode1 = mSegment0.find (opcode);
+                instruction.mArguments = instruction.mOpcode1 ? 1 : -1;
                 return;
             }
 
             case 1:
             {
                 int opcode = (code>>24) & 0x3f;
-                unsigned int arg0 = (code>>16) & 0xfff;
-                unsigned int arg1 = code & 0xfff;
-
-                std::map<int, Opcode2 *>::iterator iter = mSegment1.find (opcode);
-
-                if (iter==mSegment1.end())
-                    abortUnknownCode (1, opcode);
-
-                iter->second->execute (mRuntime, arg0, arg1);
-
+                instruction.mSegment = 1;
+                instruction.mOpcode = opcode;
+                instruction.mArg0 = (code>>16) & 0xfff;
+                instruction.mArg1 = code & 0xfff;
+                instruction.mOpcode2 = mSegment1.find (opcode);
+                instruction.mArguments = instruction.mOpcode2 ? 2 : -1;
                 return;
             }
 
             case 2:
             {
                 int opcode = (code>>20) & 0x3ff;
-                unsigned int arg0 = code & 0xfffff;
-
-                std::map<int, Opcode1 *>::iterator iter = mSegment2.find (opcode);
-
-                if (iter==mSegment2.end())
-                    abortUnknownCode (2, opcode);
-
-                iter->second->execute (mRuntime, arg0);
-
+                instruction.mSegment = 2;
+                instruction.mOpcode = opcode;
+                instruction.mArg0 = code & 0xfffff;
+                instruction.mOpcode1 = mSegment2.find (opcode);
+                instruction.mArguments = instruction.mOpcode1 ? 1 : -1;
                 return;
             }
         }
@@ -68,50 +60,73 @@ namespace Interpreter
             case 0x30:
             {
                 int opcode = (code>>8) & 0x3ffff;
-                unsigned int arg0 = code & 0xff;
-
-                std::map<int, Opcode1 *>::iterator iter = mSegment3.find (opcode);
-
-                if (iter==mSegment3.end())
-                    abortUnknownCode (3, opcode);
-
-                iter->second->execute (mRuntime, arg0);
-
+                instruction.mSegment = 3;
+                instruction.mOpcode = opcode;
+                instruction.mArg0 = code & 0xff;
+                instruction.mOpcode1 = mSegment3.find (opcode);
+                instruction.mArguments = instruction.mOpcode1 ? 1 : -1;
                 return;
             }
 
             case 0x31:
             {
                 int opcode = (code>>16) & 0x3ff;
-                unsigned int arg0 = (code>>8) & 0xff;
-                unsigned int arg1 = code & 0xff;
-
-                std::map<int, Opcode2 *>::iterator iter = mSegment4.find (opcode);
-
-                if (iter==mSegment4.end())
-                    abortUnknownCode (4, opcode);
-
-                iter->second->execute (mRuntime, arg0, arg1);
-
+                instruction.mSegment = 4;
+                instruction.mOpcode = opcode;
+                instruction.mArg0 = (code>>8) & 0xff;
+                instruction.mArg1 = code & 0xff;
+                instruction.mOpcode2 = mSegment4.find (opcode);
+                instruction.mArguments = instruction.mOpcode2 ? 2 : -1;
                 return;
             }
 
             case 0x32:
             {
                 int opcode = code & 0x3ffffff;
+                instruction.mSegment = 5;
+                instruction.mOpcode = opcode;
+                instruction.mOpcode0 = mSegment5.find (opcode);
+                instruction.mArguments = instruction.mOpcode0 ? 0 : -1;
+                return;
+            }
+        }
 
-                std::map<int, Opcode0 *>::iterator iter = mSegment5.find (opcode);
+        instruction.mSegment = -1;
+        instruction.mOpcode = -1;
+        instruction.mOpcode0 = 0;
+        instruction.mArguments = -1;
+    }
 
-                if (iter==mSegment5.end())
-                    abortUnknownCode (5, opcode);
+    void Interpreter::execute (const DecodedInstruction& instruction)
+    {
+        switch (instruction.mArguments)
+        {
+            case 0: instruction.mOpcode0->execute (mRuntime); return;
+            case 1: instruction.mOpcode1->execute (mRuntime, instruction.mArg0); return;
+            case 2: instruction.mOpcode2->execute (mRuntime, instruction.mArg0, instruction.mArg1); return;
+        }
 
-                iter->second->execute (mRuntime);
+        if (instruction.mSegment!=-1)
+            abortUnknownCode (instruction.mSegment, instruction.mOpcode);
 
-                return;
-            }
+        abortUnknownSegment (instruction.mCode);
+    }
+
+    void Interpreter::executeProfiled (const DecodedInstruction& instruction)
+    {
+        mProfiler->beginInstruction (instruction.mSegment, instruction.mOpcode);
+
+        try
+        {
+            execute (instruction);
+        }
+        catch (...)
+        {
+            mProfiler->endInstruction();
+            throw;
         }
 
-        abortUnknownSegment (code);
+        mProfiler->endInstruction();
     }
 
     void Interpreter::abortUnknownCode (int segment, int opcode)
@@ -159,70 +174,71 @@ namespace Interpreter
         }
     }
 
-    Interpreter::Interpreter() : mRunning (false)
+    Interpreter::Interpreter()
+    : mRunning (false), mSegment0 (32), mSegment1 (32), mSegment2 (512), mSegment3 (131072),
+      mSegment4 (512), mSegment5 (33554432), mProfiler (0)
     {}
 
     Interpreter::~Interpreter()
-    {
-        for (std::map<int, Opcode1 *>::iterator iter (mSegment0.begin());
-            iter!=mSegment0.end(); ++iter)
-            delete iter->second;
-
-        for (std::map<int, Opcode2 *>::iterator iter (mSegment1.begin());
-            iter!=mSegment1.end(); ++iter)
-            delete iter->second;
-
-        for (std::map<int, Opcode1 *>::iterator iter (mSegment2.begin());
-            iter!=mSegment2.end(); ++iter)
-            delete iter->second;
-
-        for (std::map<int, Opcode1 *>::iterator iter (mSegment3.begin());
-            iter!=mSegment3.end(); ++iter)
-            delete iter->second;
-
-        for (std::map<int, Opcode2 *>::iterator iter (mSegment4.begin());
-            iter!=mSegment4.end(); ++iter)
-            delete iter->second;
-
-        for (std::map<int, Opcode0 *>::iterator iter (mSegment5.begin());
-            iter!=mSegment5.end(); ++iter)
-            delete iter->second;
-    }
+    {}
 
     void Interpreter::installSegment0 (int code, Opcode1 *opcode)
     {
-        assert(mSegment0.find(code) == mSegment0.end());
-        mSegment0.insert (std::make_pair (code, opcode));
+        bool installed = mSegment0.install (code, opcode);
+        assert (installed);
+        (void)installed;
     }
 
     void Interpreter::installSegment1 (int code, Opcode2 *opcode)
     {
-        assert(mSegment1.find(code) == mSegment1.end());
-        mSegment1.insert (std::make_pair (code, opcode));
+        bool installed = mSegment1.install (code, opcode);
+        assert (installed);
+        (void)installed;
     }
 
     void Interpreter::installSegment2 (int code, Opcode1 *opcode)
     {
-        assert(mSegment2.find(code) == mSegment2.end());
-        mSegment2.insert (std::make_pair (code, opcode));
+        bool installed = mSegment2.install (code, opcode);
+        assert (installed);
+        (void)installed;
     }
 
     void Interpreter::installSegment3 (int code, Opcode1 *opcode)
     {
-        assert(mSegment3.find(code) == mSegment3.end());
-        mSegment3.insert (std::make_pair (code, opcode));
+        bool installed = mSegment3.install (code, opcode);
+        assert (installed);
+        (void)installed;
     }
 
     void Interpreter::installSegment4 (int code, Opcode2 *opcode)
     {
-        assert(mSegment4.find(code) == mSegment4.end());
-        mSegment4.insert (std::make_pair (code, opcode));
+        bool installed = mSegment4.install (code, opcode);
+        assert (installed);
+        (void)installed;
     }
 
     void Interpreter::installSegment5 (int code, Opcode0 *opcode)
     {
-        assert(mSegment5.find(code) == mSegment5.end());
-        mSegment5.insert (std::make_pair (code, opcode));
+        bool installed = mSegment5.install (code, opcode);
+        assert (installed);
+        (void)installed;
+    }
+
+    void Interpreter::decode (const Type_Code *code, int codeSize, DecodedCode& decoded) const
+    {
+        assert (codeSize>=4);
+
+        int opcodes = static_cast<int> (code[0]);
+
+        decoded.resize (opcodes);
+
+        for (int i=0; i<opcodes; ++i)
+            decode (code[4+i], decoded[i]);
+    }
+
+    void Interpreter::setProfiler (Profiler *profiler)
+    {
+        mProfiler = profiler;
     }
 
     void Interpreter::run (const Type_Code *code, int codeSize, Context& context)
@@ -239,11 +255,51 @@ namespace Interpreter
 
             const Type_Code *codeBlock = code + 4;
 
+            DecodedInstruction instruction;
+
             while (mRuntime.getPC()>=0 && mRuntime.getPC()<opcodes)
             {
                 Type_Code code = codeBlock[mRuntime.getPC()];
                 mRuntime.setPC (mRuntime.getPC()+1);
-                execute (code);
+                decode (code, instruction);
+
+                if (mProfiler)
+                    executeProfiled (instruction);
+                else
+                    execute (instruction);
+            }
+        }
+        catch (...)
+        {
+            end();
+            throw;
+        }
+
+        end();
+    }
+
+    void Interpreter::run (const Type_Code *code, int codeSize, const DecodedCode& decoded, Context& context)
+    {
+        assert (codeSize>=4);
+        assert (decoded.size()==code[0]);
+
+        begin();
+
+        try
+        {
+            mRuntime.configure (code, codeSize, context);
+
+            int opcodes = static_cast<int> (decoded.size());
+
+            while (mRuntime.getPC()>=0 && mRuntime.getPC()<opcodes)
+            {
+                const DecodedInstruction& instruction = decoded[mRuntime.getPC()];
+                mRuntime.setPC (mRuntime.getPC()+1);
+
+                if (mProfiler)
+                    executeProfiled (instruction);
+                else
+                    execute (instruction);
             }
         }
         catch (...)
@@ -1,8 +1,8 @@
 #ifndef INTERPRETER_INTERPRETER_H_INCLUDED
 #define INTERPRETER_INTERPRETER_H_INCLUDED
 
-#include <map>
 #include <stack>
+#include <vector>
 
 #include "runtime.hpp"
 #include "types.hpp"
@@ -13,23 +13,121 @@ namespace Interpreter
     class Opcode1;
     class Opcode2;
 
+    /// Opcodes of a segment, in arrays indexed by opcode. The opcodes of the interpreter start at 0 and
+    /// those reserved for extensions at \a extensionBase, so each range has its own array.
+    template<typename T>
+    class OpcodeTable
+    {
+            int mExtensionBase;
+            std::vector<T *> mOpcodes;
+            std::vector<T *> mExtensionOpcodes;
+
+            // not implemented
+            OpcodeTable (const OpcodeTable&);
+            OpcodeTable& operator= (const OpcodeTable&);
+
+        public:
+
+            explicit OpcodeTable (int extensionBase) : mExtensionBase (extensionBase) {}
+
+            ~OpcodeTable()
+            {
+                for (typename std::vector<T *>::iterator iter (mOpcodes.begin()); iter!=mOpcodes.end(); ++iter)
+                    delete *iter;
+
+                for (typename std::vector<T *>::iterator iter (mExtensionOpcodes.begin());
+                    iter!=mExtensionOpcodes.end(); ++iter)
+                    delete *iter;
+            }
+
+            /// \return 0-pointer, if no opcode is installed for \a code.
+            T *find (int code) const
+            {
+                const std::vector<T *>& opcodes = code<mExtensionBase ? mOpcodes : mExtensionOpcodes;
+                std::size_t index = code<mExtensionBase ? code : code-mExtensionBase;
+
+                return index<opcodes.size() ? opcodes[index] : 0;
+            }
+
+            /// ownership of \a opcode is transferred to *this.
+            bool install (int code, T *opcode)
+            {
+                std::vector<T *>& opcodes = code<mExtensionBase ? mOpcodes : mExtensionOpcodes;
+                std::size_t index = code<mExtensionBase ? code : code-mExtensionBase;
+
+                if (index>=opcodes.size())
+                    opcodes.resize (index+1, 0);
+                else if (opcodes[index])
+                    return false;
+
+                opcodes[index] = opcode;
+                return true;
+            }
+    };
+
+    /// An instruction with its opcode looked up, see Interpreter::decode().
+    struct DecodedInstruction
+    {
+        /// Number of arguments of the opcode, or -1 if the opcode is not installed.
+        int mArguments;
+
+        union
+        {
+            Opcode0 *mOpcode0;
+            Opcode1 *mOpcode1;
+            Opcode2 *mOpcode2;
+        };
+
+        unsigned int mArg0;
+        unsigned int mArg1;
+
+        /// Segment and opcode of the instruction, -1 if \a mCode is outside of the allocated segments
+        int mSegment;
+        int mOpcode;
+
+        /// The instruction as it was encoded
+        Type_Code mCode;
+    };
+
+    typedef std::vector<DecodedInstruction> DecodedCode;
+
+    /// Is told about every instruction an Interpreter executes, see Interpreter::setProfiler().
+    class Profiler
+    {
+        public:
+
+            virtual ~Profiler() {}
+
+            virtual void beginInstruction (int segment, int opcode) = 0;
+            ///< Called before an instruction is executed.
+
+            virtual void endInstruction() = 0;
+            ///< Called after the instruction of the matching beginInstruction() call has been executed,
+            /// also when it threw. Instructions that run other scripts lead to nested calls.
+    };
+
     class Interpreter
     {
             std::stack<Runtime> mCallstack;
             bool mRunning;
             Runtime mRuntime;
-            std::map<int, Opcode1 *> mSegment0;
-            std::map<int, Opcode2 *> mSegment1;
-            std::map<int, Opcode1 *> mSegment2;
-            std::map<int, Opcode1 *> mSegment3;
-            std::map<int, Opcode2 *> mSegment4;
-            std::map<int, Opcode0 *> mSegment5;
+            OpcodeTable<Opcode1> mSegment0;
+            OpcodeTable<Opcode2> mSegment1;
+            OpcodeTable<Opcode1> mSegment2;
+            OpcodeTable<Opcode1> mSegment3;
+            OpcodeTable<Opcode2> mSegment4;
+            OpcodeTable<Opcode0> mSegment5;
+            Profiler *mProfiler;
 
             // not implemented
             Interpreter (const Interpreter&);
             Interpreter& operator= (const Interpreter&);
 
-            void execute (Type_Code code);
+            void decode (Type_Code code, DecodedInstruction& instruction) const;
+
+            void execute (const DecodedInstruction& instruction);
+
+            void executeProfiled (const DecodedInstruction& instruction);
 
             void abortUnknownCode (int segment, int opcode);
 
@@ -63,7 +161,18 @@ namespace Interpreter
             void installSegment5 (int code, Opcode0 *opcode);
             ///< ownership of \a opcode is transferred to *this.
 
+            void decode (const Type_Code *code, int codeSize, DecodedCode& decoded) const;
+            ///< Look up the opcodes of all instructions in \a code, for running it repeatedly.
+            /// \note \a decoded is only valid for this interpreter. Opcodes installed later are not picked up.
+            /// Unknown opcodes are only reported when they are executed, just like when running \a code directly.
+
+            void setProfiler (Profiler *profiler);
+            ///< Report the executed instructions to \a profiler (0: don't). Ownership is not transferred.
+
             void run (const Type_Code *code, int codeSize, Context& context);
+
+            void run (const Type_Code *code, int codeSize, const DecodedCode& decoded, Context& context);
+            ///< Run \a code, executing the instructions that decode() has stored in \a decoded.
     };
 }
 
@@ -113,6 +113,78 @@ namespace Interpreter
             }
     };
 
+    class OpPushLocalShort : public Opcode1
+    {
+        public:
+
+            virtual void execute (Runtime& runtime, unsigned int arg0)
+            {
+                runtime.push (runtime.getContext().getLocalShort (arg0));
+            }
+    };
+
+    class OpPushLocalLong : public Opcode1
+    {
+        public:
+
+            virtual void execute (Runtime& runtime, unsigned int arg0)
+            {
+                runtime.push (runtime.getContext().getLocalLong (arg0));
+            }
+    };
+
+    class OpPushLocalFloat : public Opcode1
+    {
+        public:
+
+            virtual void execute (Runtime& runtime, unsigned int arg0)
+            {
+                runtime.push (runtime.getContext().getLocalFloat (arg0));
+            }
+    };
+
+    class OpPopLocalShort : public Opcode1
+    {
+        public:
+
+            virtual void execute (Runtime& runtime, unsigned int arg0)
+            {
+                Type_Integer data = runtime[0].mInteger;
+
+                runtime.getContext().setLocalShort (arg0, data);
+
+                runtime.pop();
+            }
+    };
+
+    class OpPopLocalLong : public Opcode1
+    {
+        public:
+
+            virtual void execute (Runtime& runtime, unsigned int arg0)
+            {
+                Type_Integer data = runtime[0].mInteger;
+
+                runtime.getContext().setLocalLong (arg0, data);
+
+                runtime.pop();
+            }
+    };
+
+    class OpPopLocalFloat : public Opcode1
+    {
+        public:
+
+            virtual void execute (Runtime& runtime, unsigned int arg0)
+            {
+                Type_Float data = runtime[0].mFloat;
+
+                runtime.getContext().setLocalFloat (arg0, data);
+
+                runtime.pop();
+            }
+    };
+
     class OpStoreGlobalShort : public Opcode0
     {
         public:
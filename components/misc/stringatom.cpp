@@ -0,0 +1,124 @@
+#include "stringatom.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include <boost/cstdint.hpp>
+#include <boost/unordered_set.hpp>
+
+#include "stringops.hpp"
+
+namespace
+{
+
+    typedef boost::uint64_t Chunk;
+
+    const Chunk sOnes = 0x0101010101010101ull;
+
+    /// Lower-case the ASCII letters in all 8 bytes of \a chunk at once, same as Misc::StringUtils::toLower for each byte
+    inline Chunk toLower(Chunk chunk)
+    {
+        // no carries between the bytes: each byte of low7 is at most 0x7f, and at most 0x3f is added
+        Chunk low7 = chunk & (0x7f * sOnes);
+        Chunk aboveA = low7 + (0x80 - 'A') * sOnes;
+        Chunk aboveZ = low7 + (0x80 - 'Z' - 1) * sOnes;
+        Chunk upper = aboveA & ~aboveZ & ~chunk & (0x80 * sOnes);
+        return chunk | (upper >> 2);
+    }
+
+    /// Read the next up to 8 bytes of a string, lower-cased. Missing bytes are 0.
+    inline Chunk readChunk(const char* data, std::size_t size)
+    {
+        Chunk chunk = 0;
+        std::memcpy(&chunk, data, std::min<std::size_t>(size, sizeof(Chunk)));
+        return toLower(chunk);
+    }
+
+    struct CiHash
+    {
+        std::size_t operator()(const std::string& str) const
+        {
+            // FNV-1a over 8 byte chunks
+            Chunk hash = 14695981039346656037ull ^ str.size();
+            for (std::size_t i = 0; i < str.size(); i += sizeof(Chunk))
+            {
+                hash ^= readChunk(str.data() + i, str.size() - i);
+                hash *= 1099511628211ull;
+                hash ^= hash >> 29;
+            }
+            return static_cast<std::size_t>(hash);
+        }
+    };
+
+    struct CiEqual
+    {
+        bool operator()(const std::string& left, const std::string& right) const
+        {
+            if (left.size() != right.size())
+                return false;
+
+            for (std::size_t i = 0; i < left.size(); i += sizeof(Chunk))
+            {
+                if (readChunk(left.data() + i, left.size() - i) != readChunk(right.data() + i, right.size() - i))
+                    return false;
+            }
+            return true;
+        }
+    };
+
+    typedef boost::unordered_set<std::string, CiHash, CiEqual> AtomTable;
+
+    AtomTable& getTable()
+    {
+        // Constructed on first use, atoms may be interned by the constructors of other static objects.
+        // The elements of an unordered_set stay in place when it grows.
+        static AtomTable table;
+        return table;
+    }
+
+    const std::string* intern(const std::string& str)
+    {
+        AtomTable& table = getTable();
+
+        AtomTable::const_iterator found = table.find(str);
+        if (found != table.end())
+            return &*found;
+
+        return &*table.insert(Misc::StringUtils::lowerCase(str)).first;
+    }
+
+}
+
+namespace Misc
+{
+
+    StringAtom::StringAtom()
+    {
+        static const std::string* empty = intern(std::string());
+        mString = empty;
+    }
+
+    StringAtom::StringAtom(const std::string& str)
+        : mString(intern(str))
+    {
+    }
+
+    bool StringAtom::find(const std::string& str, StringAtom& atom)
+    {
+        const AtomTable& table = getTable();
+
+        AtomTable::const_iterator found = table.find(str);
+        if (found == table.end())
+            return false;
+
+        atom.mString = &*found;
+        return true;
+    }
+
+    std::size_t hash_value(const StringAtom& atom)
+    {
+        // Atoms are at least aligned to the size of a pointer, drop the bits that are always 0
+        return reinterpret_cast<std::size_t>(atom.mString) / sizeof(std::string*);
+    }
+
+}
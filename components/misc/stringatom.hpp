@@ -0,0 +1,44 @@
+#ifndef OPENMW_COMPONENTS_MISC_STRINGATOM_H
+#define OPENMW_COMPONENTS_MISC_STRINGATOM_H
+
+#include <cstddef>
+#include <string>
+
+namespace Misc
+{
+
+/// @brief A string interned in a global table, ignoring case.
+/// @par Atoms of strings that only differ in case are equal. Atoms are compared and hashed by address, so they make
+/// cheap keys for identifiers that are looked up often: intern the identifier once and keep the atom around.
+/// @note Interned strings are never freed. Not thread safe, like the record stores that use atoms.
+class StringAtom
+{
+public:
+    /// Atom of the empty string
+    StringAtom();
+
+    /// Intern \a str, if it isn't interned already.
+    explicit StringAtom(const std::string& str);
+
+    /// Look up the atom of \a str, without interning it.
+    /// @return Was \a str interned before? If not, \a atom is left unchanged.
+    static bool find(const std::string& str, StringAtom& atom);
+
+    /// The interned string, in lower case.
+    const std::string& str() const { return *mString; }
+
+    bool operator==(const StringAtom& other) const { return mString == other.mString; }
+    bool operator!=(const StringAtom& other) const { return mString != other.mString; }
+
+    /// Arbitrary but consistent order, not alphabetical.
+    bool operator<(const StringAtom& other) const { return mString < other.mString; }
+
+    friend std::size_t hash_value(const StringAtom& atom);
+
+private:
+    const std::string* mString;
+};
+
+}
+
+#endif
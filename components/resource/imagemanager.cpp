@@ -91,7 +91,7 @@ namespace Resource
             Files::IStreamPtr stream;
             try
             {
-                stream = mVFS->get(normalized.c_str());
+                stream = mVFS->get(normalized, VFS::IOCategory_Image);
             }
             catch (std::exception& e)
             {
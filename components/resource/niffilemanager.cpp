@@ -48,7 +48,7 @@ namespace Resource
             return static_cast<NifFileHolder*>(obj.get())->mNifFile;
         else
         {
-            Nif::NIFFilePtr file (new Nif::NIFFile(mVFS->getNormalized(name), name));
+            Nif::NIFFilePtr file (new Nif::NIFFile(mVFS->getNormalized(name, VFS::IOCategory_Nif), name));
             obj = new NifFileHolder(file);
             mCache->addEntryToObjectCache(name, obj);
             return file;
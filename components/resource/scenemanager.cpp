@@ -336,6 +336,14 @@ namespace Resource
         }
     }
 
+    bool SceneManager::isTemplateCached(const std::string &name)
+    {
+        std::string normalized = name;
+        mVFS->normalizeFilename(normalized);
+
+        return mCache->getRefFromObjectCache(normalized).valid();
+    }
+
     osg::ref_ptr<const osg::Node> SceneManager::getTemplate(const std::string &name)
     {
         std::string normalized = name;
@@ -349,7 +357,7 @@ namespace Resource
             osg::ref_ptr<osg::Node> loaded;
             try
             {
-                Files::IStreamPtr file = mVFS->get(normalized);
+                Files::IStreamPtr file = mVFS->get(normalized, VFS::IOCategory_Scene);
 
                 loaded = load(file, normalized, mImageManager, mNifFileManager);
             }
@@ -363,7 +371,7 @@ namespace Resource
                     if (mVFS->exists(normalized))
                     {
                         std::cerr << "Failed to load '" << name << "': " << e.what() << ", using marker_error." << sMeshTypes[i] << " instead" << std::endl;
-                        Files::IStreamPtr file = mVFS->get(normalized);
+                        Files::IStreamPtr file = mVFS->get(normalized, VFS::IOCategory_Scene);
                         loaded = load(file, normalized, mImageManager, mNifFileManager);
                         break;
                     }
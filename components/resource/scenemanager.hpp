@@ -78,6 +78,10 @@ namespace Resource
         /// @note Thread safe.
         osg::ref_ptr<const osg::Node> getTemplate(const std::string& name);
 
+        /// Is the scene template of the given file in the cache already, so that getTemplate() wouldn't read the file?
+        /// @note Thread safe.
+        bool isTemplateCached(const std::string& name);
+
         /// Create an instance of the given scene template and cache it for later use, so that future calls to getInstance() can simply
         /// return this cached object instead of creating a new one.
         /// @note The returned ref_ptr may be kept around by the caller to ensure that the object stays in cache for as long as needed.
@@ -45,7 +45,8 @@
 using namespace ToUTF8;
 
 Utf8Encoder::Utf8Encoder(const FromType sourceEncoding):
-    mOutput(50*1024)
+    mOutput(50*1024),
+    mSourceEncoding(sourceEncoding)
 {
     switch (sourceEncoding)
     {
@@ -118,6 +119,34 @@ std::string Utf8Encoder::getUtf8(const char* input, size_t size)
     return std::string(&mOutput[0], outlen);
 }
 
+const char* Utf8Encoder::convertToUtf8(const char* input, size_t& size)
+{
+    const char* end = input + size;
+
+    // Skip the ascii part of the string first, usually that is all of it.
+    const char* ptr = input;
+    while (ptr != end && static_cast<unsigned char>(*ptr) < 128)
+        ++ptr;
+
+    if (ptr == end)
+        return input;
+
+    size_t outlen = ptr - input;
+    for (const char* it = ptr; it != end; ++it)
+        outlen += translationArray[static_cast<unsigned char>(*it)*6];
+
+    resize(outlen);
+    char *out = &mOutput[0];
+
+    for (const char* it = input; it != end; ++it)
+        copyFromArray(*it, out);
+
+    assert((out-&mOutput[0]) == (int)outlen);
+
+    size = outlen;
+    return &mOutput[0];
+}
+
 std::string Utf8Encoder::getLegacyEnc(const char *input, size_t size)
 {
     // Double check that the input string stops at some point (it might
@@ -27,6 +27,8 @@ namespace ToUTF8
         public:
             Utf8Encoder(FromType sourceEncoding);
 
+            FromType getSourceEncoding() const { return mSourceEncoding; }
+
             // Convert to UTF8 from the previously given code page.
             std::string getUtf8(const char *input, size_t size);
             inline std::string getUtf8(const std::string &str)
@@ -34,6 +36,12 @@ namespace ToUTF8
                 return getUtf8(str.c_str(), str.size());
             }
 
+            // Convert to UTF8 without creating a string. Unlike getUtf8(), the input does not need
+            // to be zero terminated, but must not contain a zero byte. Returns the input itself if
+            // it is pure ascii, otherwise an internal buffer that is valid until the next call.
+            // 'size' is updated to the converted length.
+            const char* convertToUtf8(const char *input, size_t &size);
+
             std::string getLegacyEnc(const char *input, size_t size);
             inline std::string getLegacyEnc(const std::string &str)
             {
@@ -49,6 +57,7 @@ namespace ToUTF8
 
             std::vector<char> mOutput;
             signed char* translationArray;
+            FromType mSourceEncoding;
     };
 }
 
@@ -23,6 +23,9 @@ namespace VFS
 
         /// List all resources contained in this archive, and run the resource names through the given normalize function.
         virtual void listResources(std::map<std::string, File*>& out, char (*normalize_function) (char)) = 0;
+
+        /// A human readable name of this archive, e.g. its path.
+        virtual std::string getDescription() const = 0;
     };
 
 }
@@ -4,9 +4,10 @@ namespace VFS
 {
 
 
-BsaArchive::BsaArchive(const std::string &filename)
+BsaArchive::BsaArchive(const std::string &filename, bool memoryMapped)
+    : mFilename(filename)
 {
-    mFile.open(filename);
+    mFile.open(filename, memoryMapped);
 
     const Bsa::BSAFile::FileList &filelist = mFile.getList();
     for(Bsa::BSAFile::FileList::const_iterator it = filelist.begin();it != filelist.end();++it)
@@ -26,6 +27,11 @@ void BsaArchive::listResources(std::map<std::string, File *> &out, char (*normal
     }
 }
 
+std::string BsaArchive::getDescription() const
+{
+    return mFilename;
+}
+
 // ------------------------------------------------------------------------------
 
 BsaArchiveFile::BsaArchiveFile(const Bsa::BSAFile::FileStruct *info, Bsa::BSAFile* bsa)
@@ -22,11 +22,15 @@ namespace VFS
     class BsaArchive : public Archive
     {
     public:
-        BsaArchive(const std::string& filename);
+        /// @param memoryMapped Map the whole archive into memory, see Bsa::BSAFile::open
+        BsaArchive(const std::string& filename, bool memoryMapped = false);
 
         virtual void listResources(std::map<std::string, File*>& out, char (*normalize_function) (char));
 
+        virtual std::string getDescription() const;
+
     private:
+        std::string mFilename;
         Bsa::BSAFile mFile;
 
         std::vector<BsaArchiveFile> mResources;
@@ -1,13 +1,87 @@
 #include "filesystemarchive.hpp"
 
+#include <iostream>
+
 #include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+namespace
+{
+
+    const char sIndexCacheMagic[] = "OMWVFSIDX";
+    const unsigned int sIndexCacheVersion = 1;
+
+    /// Directory modification times have a resolution of up to two seconds on some file systems.
+    const std::time_t sModificationTimeSlack = 2;
+
+    void writeUInt(std::ostream& stream, unsigned int value)
+    {
+        stream.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    void writeTime(std::ostream& stream, std::time_t value)
+    {
+        long long converted = value;
+        stream.write(reinterpret_cast<const char*>(&converted), sizeof(converted));
+    }
+
+    void writeString(std::ostream& stream, const std::string& value)
+    {
+        writeUInt(stream, value.size());
+        stream.write(value.c_str(), value.size());
+    }
+
+    void writeStrings(std::ostream& stream, const std::vector<std::string>& values)
+    {
+        writeUInt(stream, values.size());
+        for (std::vector<std::string>::const_iterator it = values.begin(); it != values.end(); ++it)
+            writeString(stream, *it);
+    }
+
+    bool readUInt(std::istream& stream, unsigned int& value)
+    {
+        return stream.read(reinterpret_cast<char*>(&value), sizeof(value)).good();
+    }
+
+    bool readTime(std::istream& stream, std::time_t& value)
+    {
+        long long converted;
+        if (!stream.read(reinterpret_cast<char*>(&converted), sizeof(converted)))
+            return false;
+        value = static_cast<std::time_t>(converted);
+        return true;
+    }
+
+    bool readString(std::istream& stream, std::string& value)
+    {
+        unsigned int size;
+        if (!readUInt(stream, size))
+            return false;
+        value.resize(size);
+        return size == 0 || stream.read(&value[0], size).good();
+    }
+
+    bool readStrings(std::istream& stream, std::vector<std::string>& values)
+    {
+        unsigned int count;
+        if (!readUInt(stream, count))
+            return false;
+        values.resize(count);
+        for (unsigned int i = 0; i < count; ++i)
+            if (!readString(stream, values[i]))
+                return false;
+        return true;
+    }
+
+}
 
 namespace VFS
 {
 
-    FileSystemArchive::FileSystemArchive(const std::string &path)
+    FileSystemArchive::FileSystemArchive(const std::string &path, const std::string &indexCacheFile)
         : mBuiltIndex(false)
         , mPath(path)
+        , mIndexCacheFile(indexCacheFile)
     {
 
     }
@@ -16,31 +90,37 @@ namespace VFS
     {
         if (!mBuiltIndex)
         {
-            typedef boost::filesystem::recursive_directory_iterator directory_iterator;
-
-            directory_iterator end;
-
-            size_t prefix = mPath.size ();
+            DirectoryCache cache;
+            if (!mIndexCacheFile.empty() && !readIndexCache(cache))
+                cache.clear();
 
-            if (mPath.size () > 0 && mPath [prefix - 1] != '\\' && mPath [prefix - 1] != '/')
-                ++prefix;
+            DirectoryCache listings;
+            size_t reused = 0;
+            scanDirectory(std::string(), cache, listings, reused);
 
-            for (directory_iterator i (mPath); i != end; ++i)
+            for (DirectoryCache::const_iterator dir = listings.begin(); dir != listings.end(); ++dir)
             {
-                if(boost::filesystem::is_directory (*i))
-                    continue;
+                boost::filesystem::path dirPath (mPath);
+                if (!dir->first.empty())
+                    dirPath /= dir->first;
 
-                std::string proper = i->path ().string ();
+                for (std::vector<std::string>::const_iterator name = dir->second.mFiles.begin(); name != dir->second.mFiles.end(); ++name)
+                {
+                    FileSystemArchiveFile file((dirPath / *name).string());
 
-                FileSystemArchiveFile file(proper);
+                    std::string relative = dir->first.empty() ? *name : dir->first + '/' + *name;
 
-                std::string searchable;
+                    std::string searchable;
 
-                std::transform(proper.begin() + prefix, proper.end(), std::back_inserter(searchable), normalize_function);
+                    std::transform(relative.begin(), relative.end(), std::back_inserter(searchable), normalize_function);
 
-                mIndex.insert (std::make_pair (searchable, file));
+                    mIndex.insert (std::make_pair (searchable, file));
+                }
             }
 
+            if (!mIndexCacheFile.empty() && (reused != listings.size() || cache.size() != listings.size()))
+                writeIndexCache(listings);
+
             mBuiltIndex = true;
         }
 
@@ -50,6 +130,134 @@ namespace VFS
         }
     }
 
+    std::string FileSystemArchive::getDescription() const
+    {
+        return mPath;
+    }
+
+    void FileSystemArchive::scanDirectory(const std::string &relativePath, const DirectoryCache &cache,
+                                          DirectoryCache &listings, size_t &reused)
+    {
+        boost::filesystem::path fullPath (mPath);
+        if (!relativePath.empty())
+            fullPath /= relativePath;
+
+        std::time_t modified = boost::filesystem::last_write_time(fullPath);
+
+        DirectoryListing& listing = listings[relativePath];
+
+        // Adding or removing an entry updates the modification time of the directory, but only
+        // trust the cached listing if it was taken well after the last modification.
+        DirectoryCache::const_iterator cached = cache.find(relativePath);
+        if (cached != cache.end() && cached->second.mModified == modified
+                && modified + sModificationTimeSlack < cached->second.mListed)
+        {
+            listing = cached->second;
+            ++reused;
+        }
+        else
+        {
+            listing.mModified = modified;
+            listing.mListed = std::time(NULL);
+
+            boost::filesystem::directory_iterator end;
+            for (boost::filesystem::directory_iterator it (fullPath); it != end; ++it)
+            {
+                std::string name = it->path().filename().string();
+
+                if (boost::filesystem::is_directory(*it))
+                {
+                    // Symlinked directories are not followed, just like with a recursive_directory_iterator
+                    if (!boost::filesystem::is_symlink(it->symlink_status()))
+                        listing.mDirectories.push_back(name);
+                }
+                else
+                    listing.mFiles.push_back(name);
+            }
+        }
+
+        for (std::vector<std::string>::const_iterator it = listing.mDirectories.begin(); it != listing.mDirectories.end(); ++it)
+            scanDirectory(relativePath.empty() ? *it : relativePath + '/' + *it, cache, listings, reused);
+    }
+
+    bool FileSystemArchive::readIndexCache(DirectoryCache &cache) const
+    {
+        boost::filesystem::ifstream stream (boost::filesystem::path(mIndexCacheFile), std::ios_base::binary);
+        if (!stream.is_open())
+            return false;
+
+        char magic[sizeof(sIndexCacheMagic)];
+        if (!stream.read(magic, sizeof(magic)) || std::string(magic, sizeof(magic)) != std::string(sIndexCacheMagic, sizeof(sIndexCacheMagic)))
+            return false;
+
+        unsigned int version;
+        if (!readUInt(stream, version) || version != sIndexCacheVersion)
+            return false;
+
+        std::string path;
+        if (!readString(stream, path) || path != mPath)
+            return false;
+
+        unsigned int count;
+        if (!readUInt(stream, count))
+            return false;
+
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            std::string relativePath;
+            DirectoryListing listing;
+            if (!readString(stream, relativePath)
+                    || !readTime(stream, listing.mModified)
+                    || !readTime(stream, listing.mListed)
+                    || !readStrings(stream, listing.mFiles)
+                    || !readStrings(stream, listing.mDirectories))
+                return false;
+
+            cache[relativePath] = listing;
+        }
+
+        return true;
+    }
+
+    void FileSystemArchive::writeIndexCache(const DirectoryCache &cache) const
+    {
+        try
+        {
+            boost::filesystem::path cacheFile (mIndexCacheFile);
+            if (cacheFile.has_parent_path())
+                boost::filesystem::create_directories(cacheFile.parent_path());
+
+            // Write to a temporary file first, so that an interrupted write can not leave a truncated cache behind
+            boost::filesystem::path tempFile (mIndexCacheFile + ".tmp");
+            {
+                boost::filesystem::ofstream stream (tempFile, std::ios_base::binary | std::ios_base::trunc);
+
+                stream.write(sIndexCacheMagic, sizeof(sIndexCacheMagic));
+                writeUInt(stream, sIndexCacheVersion);
+                writeString(stream, mPath);
+                writeUInt(stream, cache.size());
+
+                for (DirectoryCache::const_iterator it = cache.begin(); it != cache.end(); ++it)
+                {
+                    writeString(stream, it->first);
+                    writeTime(stream, it->second.mModified);
+                    writeTime(stream, it->second.mListed);
+                    writeStrings(stream, it->second.mFiles);
+                    writeStrings(stream, it->second.mDirectories);
+                }
+
+                if (!stream.good())
+                    throw std::runtime_error("Failed to write '" + tempFile.string() + "'");
+            }
+
+            boost::filesystem::rename(tempFile, cacheFile);
+        }
+        catch (std::exception& e)
+        {
+            std::cerr << "Failed to write file index cache for '" << mPath << "': " << e.what() << std::endl;
+        }
+    }
+
     // ----------------------------------------------------------------------------------
 
     FileSystemArchiveFile::FileSystemArchiveFile(const std::string &path)
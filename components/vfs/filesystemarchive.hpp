@@ -3,6 +3,9 @@
 
 #include "archive.hpp"
 
+#include <ctime>
+#include <vector>
+
 namespace VFS
 {
 
@@ -21,17 +24,40 @@ namespace VFS
     class FileSystemArchive : public Archive
     {
     public:
-        FileSystemArchive(const std::string& path);
+        /// @param indexCacheFile If not empty, the directory listing is persisted to this file and
+        /// only directories whose modification time changed since then are listed again.
+        FileSystemArchive(const std::string& path, const std::string& indexCacheFile = std::string());
 
         virtual void listResources(std::map<std::string, File*>& out, char (*normalize_function) (char));
 
+        virtual std::string getDescription() const;
+
 
     private:
+        /// Contents of a single directory, not including its subdirectories.
+        struct DirectoryListing
+        {
+            std::time_t mModified;
+            std::time_t mListed;
+            std::vector<std::string> mFiles;
+            std::vector<std::string> mDirectories;
+        };
+
+        /// Keyed by the directory path relative to mPath.
+        typedef std::map<std::string, DirectoryListing> DirectoryCache;
+
+        void scanDirectory(const std::string& relativePath, const DirectoryCache& cache,
+                           DirectoryCache& listings, size_t& reused);
+
+        bool readIndexCache(DirectoryCache& cache) const;
+        void writeIndexCache(const DirectoryCache& cache) const;
+
         typedef std::map <std::string, FileSystemArchiveFile> index;
         index mIndex;
 
         bool mBuiltIndex;
         std::string mPath;
+        std::string mIndexCacheFile;
 
     };
 
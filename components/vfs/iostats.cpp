@@ -0,0 +1,201 @@
+#include "iostats.hpp"
+
+#include <streambuf>
+
+#include <osg/Timer>
+
+namespace
+{
+
+    // Same as the buffer size of Files::ConstrainedFileStream
+    const size_t sBufferSize = 4096;
+
+    /// Reads through to another stream, accounting every read to an IOStats entry.
+    class InstrumentedStreamBuf : public std::streambuf
+    {
+    public:
+        InstrumentedStreamBuf(Files::IStreamPtr source, VFS::IOStats& stats, size_t archive, VFS::IOCategory category, double openLatency)
+            : mSource(source)
+            , mStats(stats)
+            , mArchive(archive)
+            , mCategory(category)
+        {
+            mCounters.mOpens = 1;
+            mCounters.mLatency = openLatency;
+            setg(0, 0, 0);
+        }
+
+        ~InstrumentedStreamBuf()
+        {
+            flush();
+        }
+
+        virtual int_type underflow()
+        {
+            if (gptr() == egptr())
+            {
+                osg::Timer_t start = osg::Timer::instance()->tick();
+                std::streamsize got = mSource->rdbuf()->sgetn(mBuffer, sBufferSize);
+                mCounters.mLatency += osg::Timer::instance()->delta_s(start, osg::Timer::instance()->tick());
+                ++mCounters.mReads;
+                mCounters.mBytesRead += got;
+
+                setg(&mBuffer[0], &mBuffer[0], &mBuffer[0] + got);
+
+                // Long lived streams, e.g. for music, should not only show up once they are closed
+                if (mCounters.mReads % 64 == 0)
+                    flush();
+            }
+            if (gptr() == egptr())
+                return traits_type::eof();
+
+            return traits_type::to_int_type(*gptr());
+        }
+
+        virtual pos_type seekoff(off_type offset, std::ios_base::seekdir whence, std::ios_base::openmode mode)
+        {
+            // The source is ahead of us by the data we have buffered
+            if (whence == std::ios_base::cur)
+                offset -= egptr() - gptr();
+
+            setg(0, 0, 0);
+            return mSource->rdbuf()->pubseekoff(offset, whence, mode);
+        }
+
+        virtual pos_type seekpos(pos_type pos, std::ios_base::openmode mode)
+        {
+            setg(0, 0, 0);
+            return mSource->rdbuf()->pubseekpos(pos, mode);
+        }
+
+    private:
+        void flush()
+        {
+            mStats.add(mArchive, mCategory, mCounters);
+            mCounters = VFS::IOCounters();
+        }
+
+        Files::IStreamPtr mSource;
+        VFS::IOStats& mStats;
+        size_t mArchive;
+        VFS::IOCategory mCategory;
+        VFS::IOCounters mCounters;
+
+        char mBuffer[sBufferSize];
+    };
+
+    class InstrumentedStream : public std::istream
+    {
+    public:
+        InstrumentedStream(Files::IStreamPtr source, VFS::IOStats& stats, size_t archive, VFS::IOCategory category, double openLatency)
+            : std::istream(new InstrumentedStreamBuf(source, stats, archive, category, openLatency))
+        {
+        }
+
+        virtual ~InstrumentedStream()
+        {
+            delete rdbuf();
+        }
+    };
+
+}
+
+namespace VFS
+{
+
+    const char* getIOCategoryName(IOCategory category)
+    {
+        switch (category)
+        {
+            case IOCategory_Other: return "other";
+            case IOCategory_Scene: return "scene";
+            case IOCategory_Nif: return "nif";
+            case IOCategory_Keyframe: return "keyframe";
+            case IOCategory_Image: return "image";
+            case IOCategory_Sound: return "sound";
+            case IOCategory_Video: return "video";
+            case IOCategory_Font: return "font";
+            case IOCategory_Prefetch: return "prefetch";
+            default: return "unknown";
+        }
+    }
+
+    IOCounters::IOCounters()
+        : mOpens(0)
+        , mBytesRead(0)
+        , mReads(0)
+        , mLatency(0.0)
+        , mPrefetchHits(0)
+    {
+    }
+
+    void IOCounters::add(const IOCounters& other)
+    {
+        mOpens += other.mOpens;
+        mBytesRead += other.mBytesRead;
+        mReads += other.mReads;
+        mLatency += other.mLatency;
+        mPrefetchHits += other.mPrefetchHits;
+    }
+
+    IOStats::IOStats(const std::vector<std::string>& archiveNames)
+        : mArchiveNames(archiveNames)
+        , mCounters(archiveNames.size() * IOCategory_Count)
+    {
+    }
+
+    void IOStats::add(size_t archive, IOCategory category, const IOCounters& counters)
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+        mCounters[archive * IOCategory_Count + category].add(counters);
+    }
+
+    IOCounters IOStats::get(size_t archive, IOCategory category) const
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+        return mCounters[archive * IOCategory_Count + category];
+    }
+
+    IOCounters IOStats::getTotal() const
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+        IOCounters total;
+        for (std::vector<IOCounters>::const_iterator it = mCounters.begin(); it != mCounters.end(); ++it)
+            total.add(*it);
+        return total;
+    }
+
+    void IOStats::writeCsv(std::ostream& stream) const
+    {
+        std::vector<IOCounters> counters;
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+            counters = mCounters;
+        }
+
+        stream << "archive,category,opens,bytes,reads,latency_ms,prefetch_hits\n";
+        for (size_t archive = 0; archive < mArchiveNames.size(); ++archive)
+        {
+            for (int category = 0; category < IOCategory_Count; ++category)
+            {
+                const IOCounters& entry = counters[archive * IOCategory_Count + category];
+                if (entry.mOpens == 0 && entry.mReads == 0)
+                    continue;
+
+                stream << '"' << mArchiveNames[archive] << "\","
+                       << getIOCategoryName(static_cast<IOCategory>(category)) << ','
+                       << entry.mOpens << ','
+                       << entry.mBytesRead << ','
+                       << entry.mReads << ','
+                       << entry.mLatency * 1000.0 << ','
+                       << entry.mPrefetchHits << '\n';
+            }
+        }
+    }
+
+    Files::IStreamPtr IOStats::instrument(Files::IStreamPtr stream, size_t archive, IOCategory category, double openLatency)
+    {
+        return Files::IStreamPtr(new InstrumentedStream(stream, *this, archive, category, openLatency));
+    }
+
+}
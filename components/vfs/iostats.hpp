@@ -0,0 +1,85 @@
+#ifndef OPENMW_COMPONENTS_VFS_IOSTATS_H
+#define OPENMW_COMPONENTS_VFS_IOSTATS_H
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <OpenThreads/Mutex>
+
+#include <components/files/constrainedfilestream.hpp>
+
+namespace VFS
+{
+
+    /// @brief The subsystems reading files through the VFS, used to break down I/O statistics.
+    enum IOCategory
+    {
+        IOCategory_Other = 0,
+        IOCategory_Scene,
+        IOCategory_Nif,
+        IOCategory_Keyframe,
+        IOCategory_Image,
+        IOCategory_Sound,
+        IOCategory_Video,
+        IOCategory_Font,
+        IOCategory_Prefetch,
+
+        IOCategory_Count
+    };
+
+    const char* getIOCategoryName(IOCategory category);
+
+    struct IOCounters
+    {
+        IOCounters();
+
+        void add(const IOCounters& other);
+
+        /// Number of files opened
+        unsigned int mOpens;
+        /// Number of bytes read from the archive
+        unsigned long long mBytesRead;
+        /// Number of read calls into the archive's stream. For file system and uncompressed BSA
+        /// archives that are not memory mapped, each of them is a system call.
+        unsigned int mReads;
+        /// Cumulative time spent opening files and reading from them, in seconds
+        double mLatency;
+        /// Number of opens served from the prefetch cache, see Manager::prefetch. These are included in
+        /// mOpens; the reads from the archive are accounted to IOCategory_Prefetch instead.
+        unsigned int mPrefetchHits;
+    };
+
+    /// @brief I/O counters per archive and per calling subsystem.
+    /// @note Thread safe.
+    class IOStats
+    {
+    public:
+        IOStats(const std::vector<std::string>& archiveNames);
+
+        void add(size_t archive, IOCategory category, const IOCounters& counters);
+
+        IOCounters get(size_t archive, IOCategory category) const;
+
+        /// Sum of the counters of all archives and categories.
+        IOCounters getTotal() const;
+
+        /// Write one line per archive and category with the columns archive, category, opens, bytes, reads, latency_ms,
+        /// prefetch_hits.
+        void writeCsv(std::ostream& stream) const;
+
+        /// Wrap the given stream so that reads and seeks on it are accounted to the given archive and category.
+        /// @param openLatency Time spent opening the stream, in seconds.
+        Files::IStreamPtr instrument(Files::IStreamPtr stream, size_t archive, IOCategory category, double openLatency);
+
+    private:
+        std::vector<std::string> mArchiveNames;
+
+        mutable OpenThreads::Mutex mMutex;
+        /// Indexed by archive * IOCategory_Count + category
+        std::vector<IOCounters> mCounters;
+    };
+
+}
+
+#endif
@@ -3,9 +3,12 @@
 #include <cctype>
 #include <stdexcept>
 
+#include <osg/Timer>
+
 #include <components/misc/stringops.hpp>
 
 #include "archive.hpp"
+#include "prefetcher.hpp"
 
 namespace
 {
@@ -26,6 +29,29 @@ namespace
         std::transform(path.begin(), path.end(), path.begin(), normalize_char);
     }
 
+    struct StrictNormalize
+    {
+        char operator()(char ch) const { return strict_normalize_char(ch); }
+    };
+
+    struct NonstrictNormalize
+    {
+        char operator()(char ch) const { return nonstrict_normalize_char(ch); }
+    };
+
+    // FNV-1a
+    template <class Normalize>
+    size_t hash_path(const char* path, size_t length, Normalize normalize)
+    {
+        size_t hash = 2166136261u;
+        for (size_t i = 0; i < length; ++i)
+        {
+            hash ^= static_cast<unsigned char>(normalize(path[i]));
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
 }
 
 namespace VFS
@@ -33,12 +59,20 @@ namespace VFS
 
     Manager::Manager(bool strict)
         : mStrict(strict)
+        , mIOStats(NULL)
+        , mPrefetcher(NULL)
     {
 
     }
 
     Manager::~Manager()
     {
+        delete mPrefetcher;
+        mPrefetcher = NULL;
+
+        delete mIOStats;
+        mIOStats = NULL;
+
         for (std::vector<Archive*>::iterator it = mArchives.begin(); it != mArchives.end(); ++it)
             delete *it;
         mArchives.clear();
@@ -55,30 +89,193 @@ namespace VFS
 
         for (std::vector<Archive*>::const_iterator it = mArchives.begin(); it != mArchives.end(); ++it)
             (*it)->listResources(mIndex, mStrict ? &strict_normalize_char : &nonstrict_normalize_char);
+
+        // Keep the load factor at or below one half
+        size_t tableSize = 16;
+        while (tableSize < mIndex.size() * 2)
+            tableSize *= 2;
+
+        HashEntry empty = { 0, NULL, NULL, 0 };
+        mHashIndex.assign(tableSize, empty);
+
+        const size_t mask = tableSize - 1;
+        for (std::map<std::string, File*>::const_iterator it = mIndex.begin(); it != mIndex.end(); ++it)
+        {
+            // Keys in mIndex are already normalized
+            size_t hash = hash_path(it->first.c_str(), it->first.size(), StrictNormalize());
+
+            size_t slot = hash & mask;
+            while (mHashIndex[slot].mFile)
+                slot = (slot + 1) & mask;
+
+            HashEntry& entry = mHashIndex[slot];
+            entry.mHash = hash;
+            entry.mName = &it->first;
+            entry.mFile = it->second;
+        }
+    }
+
+    File* Manager::search(const char *name, size_t length) const
+    {
+        const HashEntry* entry = searchEntry(name, length);
+        return entry ? entry->mFile : NULL;
     }
 
-    Files::IStreamPtr Manager::get(const std::string &name) const
+    const Manager::HashEntry* Manager::searchEntry(const char *name, size_t length) const
     {
-        std::string normalized = name;
-        normalize_path(normalized, mStrict);
+        if (mHashIndex.empty())
+            return NULL;
 
-        return getNormalized(normalized);
+        if (mStrict)
+            return searchHashIndex(name, length, StrictNormalize());
+        else
+            return searchHashIndex(name, length, NonstrictNormalize());
     }
 
-    Files::IStreamPtr Manager::getNormalized(const std::string &normalizedName) const
+    template <class Normalize>
+    const Manager::HashEntry* Manager::searchHashIndex(const char *name, size_t length, Normalize normalize) const
     {
-        std::map<std::string, File*>::const_iterator found = mIndex.find(normalizedName);
-        if (found == mIndex.end())
+        const size_t hash = hash_path(name, length, normalize);
+        const size_t mask = mHashIndex.size() - 1;
+
+        for (size_t slot = hash & mask; mHashIndex[slot].mFile; slot = (slot + 1) & mask)
+        {
+            const HashEntry& entry = mHashIndex[slot];
+            if (entry.mHash != hash || entry.mName->size() != length)
+                continue;
+
+            const char* stored = entry.mName->c_str();
+            size_t i = 0;
+            while (i < length && stored[i] == normalize(name[i]))
+                ++i;
+            if (i == length)
+                return &entry;
+        }
+        return NULL;
+    }
+
+    Files::IStreamPtr Manager::get(const std::string &name, IOCategory category) const
+    {
+        const HashEntry* entry = searchEntry(name.c_str(), name.size());
+        if (!entry)
+        {
+            std::string normalized = name;
+            normalize_path(normalized, mStrict);
+            throw std::runtime_error("Resource '" + normalized + "' not found");
+        }
+        return open(*entry, category);
+    }
+
+    Files::IStreamPtr Manager::getNormalized(const std::string &normalizedName, IOCategory category) const
+    {
+        const HashEntry* entry = searchEntry(normalizedName.c_str(), normalizedName.size());
+        if (!entry)
             throw std::runtime_error("Resource '" + normalizedName + "' not found");
-        return found->second->open();
+        return open(*entry, category);
+    }
+
+    Files::IStreamPtr Manager::open(const HashEntry& entry, IOCategory category) const
+    {
+        if (mPrefetcher)
+        {
+            Files::IStreamPtr prefetched = mPrefetcher->take(entry.mFile);
+            if (prefetched)
+            {
+                // The I/O thread has accounted the read from the archive already
+                if (mIOStats)
+                {
+                    IOCounters counters;
+                    counters.mOpens = 1;
+                    counters.mPrefetchHits = 1;
+                    mIOStats->add(entry.mArchive, category, counters);
+                }
+                return prefetched;
+            }
+        }
+
+        if (!mIOStats)
+            return entry.mFile->open();
+
+        osg::Timer_t start = osg::Timer::instance()->tick();
+        Files::IStreamPtr stream = entry.mFile->open();
+        double latency = osg::Timer::instance()->delta_s(start, osg::Timer::instance()->tick());
+        return mIOStats->instrument(stream, entry.mArchive, category, latency);
+    }
+
+    void Manager::enableIOStats()
+    {
+        if (mIOStats)
+            return;
+
+        // Tell which archive each indexed file comes from. Later archives override earlier ones,
+        // so only the archive that provided the indexed File counts.
+        std::map<File*, size_t> archives;
+        std::vector<std::string> names;
+        for (size_t i = 0; i < mArchives.size(); ++i)
+        {
+            names.push_back(mArchives[i]->getDescription());
+
+            std::map<std::string, File*> files;
+            mArchives[i]->listResources(files, mStrict ? &strict_normalize_char : &nonstrict_normalize_char);
+            for (std::map<std::string, File*>::const_iterator it = files.begin(); it != files.end(); ++it)
+                archives[it->second] = i;
+        }
+
+        for (std::vector<HashEntry>::iterator it = mHashIndex.begin(); it != mHashIndex.end(); ++it)
+        {
+            if (it->mFile)
+                it->mArchive = archives[it->mFile];
+        }
+
+        mIOStats = new IOStats(names);
+    }
+
+    const IOStats* Manager::getIOStats() const
+    {
+        return mIOStats;
+    }
+
+    void Manager::enablePrefetch(size_t cacheSize)
+    {
+        if (!mPrefetcher)
+            mPrefetcher = new Prefetcher(cacheSize, mIOStats);
+    }
+
+    void Manager::prefetch(const std::vector<std::string> &names) const
+    {
+        if (!mPrefetcher)
+            return;
+
+        std::vector<Prefetcher::Request> files;
+        files.reserve(names.size());
+        for (std::vector<std::string>::const_iterator it = names.begin(); it != names.end(); ++it)
+        {
+            const HashEntry* entry = searchEntry(it->c_str(), it->size());
+            if (entry)
+            {
+                Prefetcher::Request request = { entry->mFile, entry->mArchive };
+                files.push_back(request);
+            }
+        }
+
+        mPrefetcher->prefetch(files);
+    }
+
+    PrefetchStats Manager::getPrefetchStats() const
+    {
+        if (!mPrefetcher)
+            return PrefetchStats();
+        return mPrefetcher->getStats();
     }
 
     bool Manager::exists(const std::string &name) const
     {
-        std::string normalized = name;
-        normalize_path(normalized, mStrict);
+        return search(name.c_str(), name.size()) != NULL;
+    }
 
-        return mIndex.find(normalized) != mIndex.end();
+    bool Manager::exists(const char *name, size_t length) const
+    {
+        return search(name, length) != NULL;
     }
 
     const std::map<std::string, File*>& Manager::getIndex() const
@@ -3,6 +3,8 @@
 
 #include <components/files/constrainedfilestream.hpp>
 
+#include "iostats.hpp"
+
 #include <vector>
 #include <map>
 
@@ -11,6 +13,27 @@ namespace VFS
 
     class Archive;
     class File;
+    class Prefetcher;
+    class IOStats;
+
+    /// @brief Counters of the prefetch cache, see Manager::prefetch.
+    struct PrefetchStats
+    {
+        PrefetchStats();
+
+        /// Files queued for prefetching.
+        unsigned int mRequested;
+        /// Files that were requested after they had been prefetched.
+        unsigned int mHits;
+        /// Files that were requested while still waiting to be prefetched.
+        unsigned int mMisses;
+        /// Prefetched files that were dropped from the cache before being requested.
+        unsigned int mEvicted;
+        /// Total number of bytes read by the I/O thread.
+        size_t mBytesRead;
+        /// Number of bytes currently held in the cache.
+        size_t mCachedBytes;
+    };
 
     /// @brief The main class responsible for loading files from a virtual file system.
     /// @par Various archive types (e.g. directories on the filesystem, or compressed archives)
@@ -37,6 +60,10 @@ namespace VFS
         /// @note May be called from any thread once the index has been built.
         bool exists(const std::string& name) const;
 
+        /// Does a file with this name exist? Does not allocate memory, the name is normalized during the lookup.
+        /// @note May be called from any thread once the index has been built.
+        bool exists(const char* name, size_t length) const;
+
         /// Get a complete list of files from all archives
         /// @note May be called from any thread once the index has been built.
         const std::map<std::string, File*>& getIndex() const;
@@ -46,21 +73,74 @@ namespace VFS
         void normalizeFilename(std::string& name) const;
 
         /// Retrieve a file by name.
+        /// @param category The subsystem requesting the file, used for I/O statistics.
         /// @note Throws an exception if the file can not be found.
         /// @note May be called from any thread once the index has been built.
-        Files::IStreamPtr get(const std::string& name) const;
+        Files::IStreamPtr get(const std::string& name, IOCategory category = IOCategory_Other) const;
 
         /// Retrieve a file by name (name is already normalized).
+        /// @param category The subsystem requesting the file, used for I/O statistics.
         /// @note Throws an exception if the file can not be found.
         /// @note May be called from any thread once the index has been built.
-        Files::IStreamPtr getNormalized(const std::string& normalizedName) const;
+        Files::IStreamPtr getNormalized(const std::string& normalizedName, IOCategory category = IOCategory_Other) const;
+
+        /// Find a file by name without allocating memory, the name is normalized during the lookup.
+        /// @return the file, or NULL if it can not be found.
+        /// @note May be called from any thread once the index has been built.
+        File* search(const char* name, size_t length) const;
+
+        /// Count opens, reads and time spent reading files, per archive and per IOCategory.
+        /// @note Must be called after buildIndex() and before enablePrefetch(). Lists the archives once
+        /// more to tell which archive each file comes from, so that buildIndex() doesn't have to.
+        void enableIOStats();
+
+        /// @return the I/O statistics, or NULL if they have not been enabled.
+        /// @note May be called from any thread.
+        const IOStats* getIOStats() const;
+
+        /// Start a background I/O thread for prefetch(), keeping up to @a cacheSize bytes of prefetched files in memory.
+        /// @note Must be called after buildIndex() and before any prefetch() call.
+        void enablePrefetch(size_t cacheSize);
+
+        /// Hint that the given files will be needed soon. The files are read on a background thread,
+        /// so that a following get() call does not have to wait for the disk. Files that do not exist are ignored.
+        /// Does nothing if prefetching has not been enabled.
+        /// @note May be called from any thread once the index has been built.
+        void prefetch(const std::vector<std::string>& names) const;
+
+        /// @note May be called from any thread.
+        PrefetchStats getPrefetchStats() const;
 
     private:
+        struct HashEntry
+        {
+            size_t mHash;
+            const std::string* mName;
+            File* mFile;
+            /// Index of the archive providing the file in mArchives, only set once I/O statistics are enabled
+            size_t mArchive;
+        };
+
+        Files::IStreamPtr open(const HashEntry& entry, IOCategory category) const;
+
+        const HashEntry* searchEntry(const char* name, size_t length) const;
+
         bool mStrict;
 
         std::vector<Archive*> mArchives;
 
         std::map<std::string, File*> mIndex;
+
+        /// Open addressing hash table over mIndex, keyed by the hash of the normalized name.
+        /// Empty slots have a NULL mFile. The size is always a power of two.
+        std::vector<HashEntry> mHashIndex;
+
+        template <class Normalize>
+        const HashEntry* searchHashIndex(const char* name, size_t length, Normalize normalize) const;
+
+        IOStats* mIOStats;
+
+        Prefetcher* mPrefetcher;
     };
 
 }
@@ -0,0 +1,51 @@
+#include "packagearchive.hpp"
+
+#include <algorithm>
+
+namespace VFS
+{
+
+
+PackageArchive::PackageArchive(const std::string &filename)
+    : mFilename(filename)
+{
+    mFile.open(filename);
+
+    const Bsa::PackageFile::FileList &filelist = mFile.getList();
+    for(Bsa::PackageFile::FileList::const_iterator it = filelist.begin();it != filelist.end();++it)
+    {
+        mResources.push_back(PackageArchiveFile(&*it, &mFile));
+    }
+}
+
+void PackageArchive::listResources(std::map<std::string, File *> &out, char (*normalize_function)(char))
+{
+    for (std::vector<PackageArchiveFile>::iterator it = mResources.begin(); it != mResources.end(); ++it)
+    {
+        std::string ent = mFile.getName(*it->mInfo);
+        std::transform(ent.begin(), ent.end(), ent.begin(), normalize_function);
+
+        out[ent] = &*it;
+    }
+}
+
+std::string PackageArchive::getDescription() const
+{
+    return mFilename;
+}
+
+// ------------------------------------------------------------------------------
+
+PackageArchiveFile::PackageArchiveFile(const Bsa::PackageFile::Entry *info, const Bsa::PackageFile* package)
+    : mInfo(info)
+    , mFile(package)
+{
+
+}
+
+Files::IStreamPtr PackageArchiveFile::open()
+{
+    return mFile->getFile(mInfo);
+}
+
+}
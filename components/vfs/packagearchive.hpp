@@ -0,0 +1,41 @@
+#ifndef VFS_PACKAGEARCHIVE_HPP_
+#define VFS_PACKAGEARCHIVE_HPP_
+
+#include "archive.hpp"
+
+#include <components/bsa/package_file.hpp>
+
+namespace VFS
+{
+
+    class PackageArchiveFile : public File
+    {
+    public:
+        PackageArchiveFile(const Bsa::PackageFile::Entry* info, const Bsa::PackageFile* package);
+
+        virtual Files::IStreamPtr open();
+
+        const Bsa::PackageFile::Entry* mInfo;
+        const Bsa::PackageFile* mFile;
+    };
+
+    /// @brief An OpenMW package archive (.omwpkg), see Bsa::PackageFile.
+    class PackageArchive : public Archive
+    {
+    public:
+        PackageArchive(const std::string& filename);
+
+        virtual void listResources(std::map<std::string, File*>& out, char (*normalize_function) (char));
+
+        virtual std::string getDescription() const;
+
+    private:
+        std::string mFilename;
+        Bsa::PackageFile mFile;
+
+        std::vector<PackageArchiveFile> mResources;
+    };
+
+}
+
+#endif
@@ -0,0 +1,171 @@
+#include "prefetcher.hpp"
+
+#include <osg/Timer>
+
+#include <components/files/memorystream.hpp>
+
+#include "archive.hpp"
+#include "iostats.hpp"
+
+namespace
+{
+
+    const size_t sReadChunkSize = 64 * 1024;
+
+}
+
+namespace VFS
+{
+
+    PrefetchStats::PrefetchStats()
+        : mRequested(0)
+        , mHits(0)
+        , mMisses(0)
+        , mEvicted(0)
+        , mBytesRead(0)
+        , mCachedBytes(0)
+    {
+    }
+
+    Prefetcher::Prefetcher(size_t cacheLimit, IOStats* ioStats)
+        : mQuit(false)
+        , mCacheSize(0)
+        , mCacheLimit(cacheLimit)
+        , mIOStats(ioStats)
+    {
+        startThread();
+    }
+
+    Prefetcher::~Prefetcher()
+    {
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+            mQuit = true;
+            mCondition.broadcast();
+        }
+        join();
+    }
+
+    void Prefetcher::prefetch(const std::vector<Request>& files)
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+        for (std::vector<Request>::const_iterator it = files.begin(); it != files.end(); ++it)
+        {
+            if (mCache.find(it->mFile) != mCache.end() || !mPending.insert(it->mFile).second)
+                continue;
+
+            mQueue.push_back(*it);
+            ++mStats.mRequested;
+        }
+        mCondition.signal();
+    }
+
+    Files::IStreamPtr Prefetcher::take(File* file)
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+
+        std::map<File*, CacheEntry>::iterator found = mCache.find(file);
+        if (found != mCache.end())
+        {
+            boost::shared_ptr<Buffer> data = found->second.mData;
+            mCacheSize -= data->size();
+            mCacheOrder.erase(found->second.mOrder);
+            mCache.erase(found);
+            ++mStats.mHits;
+            return Files::IStreamPtr(new Files::ISharedMemStream(data));
+        }
+
+        // Requested before the I/O thread got to it, the caller will read the file itself.
+        if (mPending.erase(file))
+            ++mStats.mMisses;
+
+        return Files::IStreamPtr();
+    }
+
+    PrefetchStats Prefetcher::getStats() const
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+        PrefetchStats stats = mStats;
+        stats.mCachedBytes = mCacheSize;
+        return stats;
+    }
+
+    void Prefetcher::addToCache(File* file, boost::shared_ptr<Buffer> data)
+    {
+        if (data->size() > mCacheLimit)
+            return;
+
+        while (mCacheSize + data->size() > mCacheLimit)
+        {
+            std::map<File*, CacheEntry>::iterator oldest = mCache.find(mCacheOrder.front());
+            mCacheSize -= oldest->second.mData->size();
+            mCache.erase(oldest);
+            mCacheOrder.pop_front();
+            ++mStats.mEvicted;
+        }
+
+        CacheEntry& entry = mCache[file];
+        entry.mData = data;
+        entry.mOrder = mCacheOrder.insert(mCacheOrder.end(), file);
+        mCacheSize += data->size();
+    }
+
+    void Prefetcher::run()
+    {
+        while (true)
+        {
+            Request request;
+            {
+                OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+                while (mQueue.empty() && !mQuit)
+                    mCondition.wait(&mMutex);
+                if (mQuit)
+                    return;
+
+                request = mQueue.front();
+                mQueue.pop_front();
+
+                // Already requested, nothing to do
+                if (mPending.find(request.mFile) == mPending.end())
+                    continue;
+            }
+
+            File* file = request.mFile;
+
+            boost::shared_ptr<Buffer> data (new Buffer);
+            try
+            {
+                Files::IStreamPtr stream;
+                if (mIOStats)
+                {
+                    osg::Timer_t start = osg::Timer::instance()->tick();
+                    stream = file->open();
+                    double latency = osg::Timer::instance()->delta_s(start, osg::Timer::instance()->tick());
+                    stream = mIOStats->instrument(stream, request.mArchive, IOCategory_Prefetch, latency);
+                }
+                else
+                    stream = file->open();
+                while (stream->good())
+                {
+                    size_t size = data->size();
+                    data->resize(size + sReadChunkSize);
+                    stream->read(&(*data)[size], sReadChunkSize);
+                    data->resize(size + static_cast<size_t>(stream->gcount()));
+                }
+            }
+            catch (std::exception&)
+            {
+                // The error will be reported when the file is actually requested
+                OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+                mPending.erase(file);
+                continue;
+            }
+
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+            mStats.mBytesRead += data->size();
+            if (mPending.erase(file))
+                addToCache(file, data);
+        }
+    }
+
+}
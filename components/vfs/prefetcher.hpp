@@ -0,0 +1,88 @@
+#ifndef OPENMW_COMPONENTS_VFS_PREFETCHER_H
+#define OPENMW_COMPONENTS_VFS_PREFETCHER_H
+
+#include <deque>
+#include <list>
+#include <map>
+#include <set>
+#include <vector>
+
+#include <OpenThreads/Mutex>
+#include <OpenThreads/Condition>
+#include <OpenThreads/Thread>
+
+#include <components/files/constrainedfilestream.hpp>
+
+#include "manager.hpp"
+
+namespace VFS
+{
+
+    class File;
+    class IOStats;
+
+    /// @brief Reads files ahead of time on a dedicated I/O thread and keeps their contents in a bounded memory cache.
+    /// @par Prefetched contents are handed out once, then dropped from the cache. When the cache is full, the oldest
+    /// prefetched files are evicted.
+    /// @note Used internally by the VFS::Manager, all methods are thread safe.
+    class Prefetcher : public OpenThreads::Thread
+    {
+    public:
+        struct Request
+        {
+            File* mFile;
+            /// Index of the archive providing the file, for the I/O statistics
+            size_t mArchive;
+        };
+
+        /// @param cacheLimit Maximum number of bytes of prefetched file contents to keep in memory.
+        /// @param ioStats Statistics to account the reads of the I/O thread to, may be NULL.
+        Prefetcher(size_t cacheLimit, IOStats* ioStats);
+        ~Prefetcher();
+
+        /// Queue the given files to be read by the I/O thread. Files that are already queued or cached are skipped.
+        void prefetch(const std::vector<Request>& files);
+
+        /// Take the prefetched contents of the given file out of the cache.
+        /// @return a stream over the contents, or an empty pointer if the file has not been prefetched (yet).
+        Files::IStreamPtr take(File* file);
+
+        PrefetchStats getStats() const;
+
+        virtual void run();
+
+    private:
+        typedef std::vector<char> Buffer;
+
+        struct CacheEntry
+        {
+            boost::shared_ptr<Buffer> mData;
+            std::list<File*>::iterator mOrder;
+        };
+
+        void addToCache(File* file, boost::shared_ptr<Buffer> data);
+
+        mutable OpenThreads::Mutex mMutex;
+        OpenThreads::Condition mCondition;
+        bool mQuit;
+
+        std::deque<Request> mQueue;
+
+        /// Files that are queued or being read. A file that is removed from this set while being read
+        /// has been requested in the meantime, and its contents are discarded.
+        std::set<File*> mPending;
+
+        std::map<File*, CacheEntry> mCache;
+        /// Cached files, oldest first
+        std::list<File*> mCacheOrder;
+        size_t mCacheSize;
+        size_t mCacheLimit;
+
+        PrefetchStats mStats;
+
+        IOStats* mIOStats;
+    };
+
+}
+
+#endif
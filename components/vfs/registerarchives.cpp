@@ -3,14 +3,22 @@
 #include <iostream>
 #include <sstream>
 
+#include <boost/functional/hash.hpp>
+
+#include <components/misc/stringops.hpp>
+
 #include <components/vfs/manager.hpp>
 #include <components/vfs/bsaarchive.hpp>
+#ifdef OPENMW_USE_LZ4
+#include <components/vfs/packagearchive.hpp>
+#endif
 #include <components/vfs/filesystemarchive.hpp>
 
 namespace VFS
 {
 
-    void registerArchives(VFS::Manager *vfs, const Files::Collections &collections, const std::vector<std::string> &archives, bool useLooseFiles)
+    void registerArchives(VFS::Manager *vfs, const Files::Collections &collections, const std::vector<std::string> &archives, bool useLooseFiles, bool memoryMapArchives,
+                          const std::string &indexCacheDir)
     {
         const Files::PathContainer& dataDirs = collections.getPaths();
 
@@ -20,9 +28,21 @@ namespace VFS
             {
                 // Last BSA has the highest priority
                 const std::string archivePath = collections.getPath(*archive).string();
-                std::cout << "Adding BSA archive " << archivePath << std::endl;
 
-                vfs->addArchive(new BsaArchive(archivePath));
+                if (Misc::StringUtils::ciEqual(boost::filesystem::path(*archive).extension().string(), ".omwpkg"))
+                {
+#ifdef OPENMW_USE_LZ4
+                    std::cout << "Adding package archive " << archivePath << std::endl;
+                    vfs->addArchive(new PackageArchive(archivePath));
+#else
+                    throw std::runtime_error("Archive '" + *archive + "' is an OpenMW package, but OpenMW was built without LZ4 support");
+#endif
+                }
+                else
+                {
+                    std::cout << "Adding BSA archive " << archivePath << std::endl;
+                    vfs->addArchive(new BsaArchive(archivePath, memoryMapArchives));
+                }
             }
             else
             {
@@ -36,8 +56,18 @@ namespace VFS
             for (Files::PathContainer::const_iterator iter = dataDirs.begin(); iter != dataDirs.end(); ++iter)
             {
                 std::cout << "Adding data directory " << iter->string() << std::endl;
+
+                std::string indexCacheFile;
+                if (!indexCacheDir.empty())
+                {
+                    // The cache file stores the directory path it belongs to, so hash collisions are harmless
+                    std::stringstream name;
+                    name << "vfsindex-" << std::hex << boost::hash<std::string>()(iter->string());
+                    indexCacheFile = (boost::filesystem::path(indexCacheDir) / name.str()).string();
+                }
+
                 // Last data dir has the highest priority
-                vfs->addArchive(new FileSystemArchive(iter->string()));
+                vfs->addArchive(new FileSystemArchive(iter->string(), indexCacheFile));
             }
 
         vfs->buildIndex();
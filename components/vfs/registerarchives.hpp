@@ -8,8 +8,11 @@ namespace VFS
     class Manager;
 
     /// @brief Register BSA and file system archives based on the given OpenMW configuration.
+    /// @param memoryMapArchives Map BSA archives into memory instead of opening a file handle for every read.
+    /// @param indexCacheDir If not empty, directory listings of the data directories are cached in this directory.
     void registerArchives (VFS::Manager* vfs, const Files::Collections& collections,
-        const std::vector<std::string>& archives, bool useLooseFiles);
+        const std::vector<std::string>& archives, bool useLooseFiles, bool memoryMapArchives = false,
+        const std::string& indexCacheDir = std::string());
 }
 
 #endif